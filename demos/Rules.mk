@@ -43,6 +43,9 @@ include $(dir)/Rules.mk
 dir := $(d)/rect_test
 include $(dir)/Rules.mk
 
+dir := $(d)/blurred_rect_test
+include $(dir)/Rules.mk
+
 dir := $(d)/item_path_test
 include $(dir)/Rules.mk
 
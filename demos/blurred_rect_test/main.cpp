@@ -0,0 +1,416 @@
+/*!
+ * \file main.cpp
+ * \brief main.cpp
+ *
+ * Copyright 2020 by InvisionApp.
+ *
+ * Contact kevinrogovin@invisionapp.com
+ *
+ * This Source Code Form is subject to the
+ * terms of the Mozilla Public License, v. 2.0.
+ * If a copy of the MPL was not distributed with
+ * this file, You can obtain one at
+ * http://mozilla.org/MPL/2.0/.
+ *
+ */
+#include <string>
+#include <sstream>
+
+#include <astral/util/ostream_utility.hpp>
+#include <astral/path.hpp>
+#include <astral/renderer/gl3/render_target_gl3.hpp>
+#include <astral/renderer/renderer.hpp>
+
+#include "sdl_demo.hpp"
+#include "render_engine_gl3_demo.hpp"
+#include "PanZoomTracker.hpp"
+#include "simple_time.hpp"
+#include "UniformScaleTranslate.hpp"
+#include "cycle_value.hpp"
+#include "command_line_list.hpp"
+#include "text_helper.hpp"
+#include "demo_macros.hpp"
+
+/* Draws a grid of blurred rounded rects, one row per sigma and
+ * one column per corner radius, either with the analytic shader
+ * of RenderEncoderBase::draw_blurred_rounded_rect() or by filling
+ * the rounded rect into a layer blurred by the Gaussian blur effect.
+ * The difference mode draws both with the second one blended with
+ * blend_mode_difference, so where the two agree the result is black.
+ */
+class BlurredRectTest:public render_engine_gl3_demo
+{
+public:
+  BlurredRectTest(void);
+
+protected:
+  virtual
+  void
+  init_gl(int, int) override final;
+
+  virtual
+  void
+  draw_frame(void) override final;
+
+  virtual
+  void
+  handle_event(const SDL_Event &ev) override final;
+
+private:
+  enum
+    {
+      basic_hud,
+      detail_level1_hud,
+
+      number_hud_modes,
+    };
+
+  enum show_mode_t
+    {
+      show_analytic_blur,
+      show_effect_blur,
+      show_difference,
+
+      number_show_modes
+    };
+
+  enum grid_size_t:uint32_t
+    {
+      number_sigmas = 3,
+      number_corner_radii = 3,
+    };
+
+  static
+  astral::c_string
+  label(enum show_mode_t v)
+  {
+    const static astral::c_string labels[number_show_modes] =
+      {
+        [show_analytic_blur] = "show_analytic_blur",
+        [show_effect_blur] = "show_effect_blur",
+        [show_difference] = "show_difference",
+      };
+
+    ASTRALassert(v < number_show_modes);
+    return labels[v];
+  }
+
+  float
+  update_smooth_values(void);
+
+  void
+  draw_hud(astral::RenderEncoderSurface encoder, float frame_ms);
+
+  /* the rounded rect of the grid cell (col, row) */
+  astral::RoundedRect
+  rounded_rect(unsigned int col, unsigned int row) const;
+
+  float
+  sigma(unsigned int row) const
+  {
+    return m_sigma_scale.value() * m_sigmas[row];
+  }
+
+  void
+  draw_analytic(astral::RenderEncoderBase encoder,
+                astral::RenderValue<astral::Brush> brush);
+
+  void
+  draw_effect(astral::RenderEncoderBase encoder,
+              astral::RenderValue<astral::Brush> brush,
+              enum astral::blend_mode_t blend_mode);
+
+  command_separator m_demo_options;
+  enumerated_command_line_argument_value<enum show_mode_t> m_show_mode;
+  command_line_argument_value<float> m_sigma_scale;
+  command_line_argument_value<astral::vec2> m_rect_size;
+  command_line_argument_value<UniformScaleTranslate<float>> m_initial_camera;
+
+  astral::vecN<float, number_sigmas> m_sigmas;
+  astral::vecN<float, number_corner_radii> m_corner_radii;
+
+  astral::reference_counted_ptr<astral::TextItem> m_text_item;
+
+  simple_time m_draw_timer;
+  average_timer m_frame_time_average;
+  PanZoomTrackerSDLEvent m_zoom;
+
+  unsigned int m_hud_mode;
+  std::vector<unsigned int> m_prev_stats;
+};
+
+//////////////////////////////////////////
+// BlurredRectTest methods
+BlurredRectTest::
+BlurredRectTest(void):
+  m_demo_options("Demo Options", *this),
+  m_show_mode(show_analytic_blur,
+              enumerated_string_type<enum show_mode_t>(&label, number_show_modes),
+              "show_mode",
+              "Mode specifying how to draw the blurred rounded rects",
+              *this),
+  m_sigma_scale(1.0f, "sigma_scale", "scale factor applied to the sigma of each row", *this),
+  m_rect_size(astral::vec2(200.0f, 120.0f), "rect_size", "size of each rounded rect before blurring", *this),
+  m_initial_camera(UniformScaleTranslate<float>(), "initial_camera", "initial position of camera", *this),
+  m_sigmas(2.0f, 8.0f, 20.0f),
+  m_corner_radii(0.0f, 16.0f, 50.0f),
+  m_frame_time_average(1000u),
+  m_hud_mode(basic_hud)
+{
+  std::cout << "Controls:"
+            << "\n\tm: cycle through drawing with the analytic shader, the Gaussian blur effect or their difference"
+            << "\n\tup/down: increase/decrease the sigma scale"
+            << "\n\tspace: cycle HUD"
+            << "\n\tp: print camera and options"
+            << "\n\tLeft Mouse Drag: pan"
+            << "\n\tHold Left Mouse, then drag up/down: zoom out/in"
+            << "\n";
+}
+
+void
+BlurredRectTest::
+init_gl(int, int)
+{
+  float pixel_size(32.0f);
+  astral::Font font(default_typeface(), pixel_size);
+
+  m_text_item = astral::TextItem::create(font);
+  m_prev_stats.resize(renderer().stats_labels().size(), 0);
+
+  if (m_initial_camera.set_by_command_line())
+    {
+      m_zoom.transformation(m_initial_camera.value());
+    }
+}
+
+astral::RoundedRect
+BlurredRectTest::
+rounded_rect(unsigned int col, unsigned int row) const
+{
+  /* leave room for 3 * sigma on each side of the largest sigma */
+  float pad(6.0f * m_sigmas[number_sigmas - 1u] + 20.0f);
+  astral::vec2 cell(m_rect_size.value() + astral::vec2(pad));
+  astral::RoundedRect R;
+
+  R.m_min_point = astral::vec2(col, row) * cell + astral::vec2(0.5f * pad);
+  R.m_max_point = R.m_min_point + m_rect_size.value();
+  R.corner_radii(m_corner_radii[col]);
+
+  return R;
+}
+
+void
+BlurredRectTest::
+draw_analytic(astral::RenderEncoderBase encoder,
+              astral::RenderValue<astral::Brush> brush)
+{
+  for (unsigned int row = 0; row < number_sigmas; ++row)
+    {
+      for (unsigned int col = 0; col < number_corner_radii; ++col)
+        {
+          encoder.draw_blurred_rounded_rect(rounded_rect(col, row), sigma(row), brush);
+        }
+    }
+}
+
+void
+BlurredRectTest::
+draw_effect(astral::RenderEncoderBase encoder,
+            astral::RenderValue<astral::Brush> brush,
+            enum astral::blend_mode_t blend_mode)
+{
+  const astral::Effect *blur;
+
+  blur = encoder.default_effects().m_gaussian_blur.get();
+  for (unsigned int row = 0; row < number_sigmas; ++row)
+    {
+      for (unsigned int col = 0; col < number_corner_radii; ++col)
+        {
+          astral::RoundedRect R(rounded_rect(col, row));
+          astral::GaussianBlurParameters blur_params;
+          astral::RenderEncoderLayer layer;
+          astral::Path path;
+
+          blur_params
+            .include_halo(true)
+            .sigma(sigma(row));
+
+          path.add_rounded_rect(R, astral::contour_direction_clockwise);
+          layer = encoder.begin_layer(*blur, astral::EffectParameters(blur_params.effect_parameters()),
+                                      path.bounding_box(), blend_mode);
+          layer.encoder().fill_paths(path, astral::FillParameters(), brush);
+          encoder.end_layer(layer);
+        }
+    }
+}
+
+void
+BlurredRectTest::
+draw_hud(astral::RenderEncoderSurface encoder, float frame_ms)
+{
+  static const enum astral::Renderer::renderer_stats_t vs[] =
+    {
+      astral::Renderer::number_virtual_buffer_pixels,
+      astral::Renderer::number_non_degenerate_color_virtual_buffers,
+      astral::Renderer::number_offscreen_render_targets,
+    };
+
+  astral::c_array<const enum astral::Renderer::renderer_stats_t> vs_p;
+  std::ostringstream hud_text;
+
+  hud_text << "Resolution = " << dimensions() << "\n"
+           << "Zoom = " << m_zoom.transformation().m_scale
+           << ", Translation = " << m_zoom.transformation().m_translation
+           << "\n[m] Show mode: " << label(m_show_mode.value())
+           << "\n[up/down] Sigma scale: " << m_sigma_scale.value()
+           << "\nSigmas (rows): " << m_sigmas * m_sigma_scale.value()
+           << "\nCorner radii (columns): " << m_corner_radii
+           << "\n[space] Hud Level: " << m_hud_mode << "\n"
+           << "Average over " << m_frame_time_average.interval_ms() << " ms: "
+           << m_frame_time_average.average_elapsed_ms()
+           << m_frame_time_average.parity_string() << "\n";
+
+  if (m_hud_mode >= detail_level1_hud)
+    {
+      vs_p = MAKE_C_ARRAY(vs, const astral::Renderer::renderer_stats_t);
+    }
+
+  /* draw the HUD in fixed location */
+  encoder.transformation(astral::Transformation());
+  set_and_draw_hud(encoder, frame_ms,
+                   astral::make_c_array(m_prev_stats),
+                   *m_text_item, hud_text.str(),
+                   vs_p);
+}
+
+void
+BlurredRectTest::
+draw_frame(void)
+{
+  float frame_ms;
+  astral::RenderEncoderSurface render_encoder;
+  astral::c_array<const unsigned int> stats;
+
+  m_frame_time_average.increment_counter();
+  frame_ms = update_smooth_values();
+
+  render_encoder = renderer().begin(render_target(), astral::colorspace_srgb, astral::u8vec4(0, 0, 0, 255));
+    {
+      astral::RenderValue<astral::Brush> brush;
+
+      render_encoder.transformation(m_zoom.transformation().astral_transformation());
+      brush = render_encoder.create_value(astral::Brush().base_color(astral::vec4(1.0f, 1.0f, 1.0f, 1.0f)));
+
+      switch (m_show_mode.value())
+        {
+        case show_analytic_blur:
+          draw_analytic(render_encoder, brush);
+          break;
+
+        case show_effect_blur:
+          draw_effect(render_encoder, brush, astral::blend_porter_duff_src_over);
+          break;
+
+        default:
+          draw_analytic(render_encoder, brush);
+          draw_effect(render_encoder, brush, astral::blend_mode_difference);
+        }
+
+      if (!pixel_testing())
+        {
+          draw_hud(render_encoder, frame_ms);
+        }
+    }
+  stats = renderer().end();
+
+  ASTRALassert(m_prev_stats.size() == stats.size());
+  std::copy(stats.begin(), stats.end(), m_prev_stats.begin());
+}
+
+float
+BlurredRectTest::
+update_smooth_values(void)
+{
+  const Uint8 *keyboard_state = SDL_GetKeyboardState(nullptr);
+  float return_value, delta, scale_delta;
+  bool sigma_scale_changed(false);
+
+  ASTRALassert(keyboard_state != nullptr);
+  return_value = delta = static_cast<float>(m_draw_timer.restart_us()) * 0.001f;
+
+  if (keyboard_state[SDL_SCANCODE_LSHIFT])
+    {
+      delta *= 0.1f;
+    }
+
+  if (keyboard_state[SDL_SCANCODE_RSHIFT])
+    {
+      delta *= 10.0f;
+    }
+
+  scale_delta = 0.001f * delta;
+
+  if (keyboard_state[SDL_SCANCODE_UP])
+    {
+      sigma_scale_changed = true;
+      m_sigma_scale.value() += scale_delta;
+    }
+
+  if (keyboard_state[SDL_SCANCODE_DOWN])
+    {
+      sigma_scale_changed = true;
+      m_sigma_scale.value() -= scale_delta;
+    }
+
+  if (sigma_scale_changed)
+    {
+      m_sigma_scale.value() = astral::t_max(m_sigma_scale.value(), 0.0f);
+      std::cout << "Sigma scale set to " << m_sigma_scale.value() << "\n";
+    }
+
+  return return_value;
+}
+
+void
+BlurredRectTest::
+handle_event(const SDL_Event &ev)
+{
+  m_zoom.handle_event(ev, SDL_BUTTON_LEFT);
+  if (ev.type == SDL_KEYDOWN)
+    {
+      switch(ev.key.keysym.sym)
+        {
+        case SDLK_SPACE:
+          cycle_value(m_hud_mode, false, number_hud_modes);
+          break;
+
+        case SDLK_m:
+          cycle_value(m_show_mode.value(),
+                      ev.key.keysym.mod & (KMOD_SHIFT|KMOD_CTRL|KMOD_ALT),
+                      number_show_modes);
+          std::cout << "Show mode set to " << label(m_show_mode.value()) << "\n";
+          break;
+
+        case SDLK_p:
+          {
+            const UniformScaleTranslate<float> &tr(m_zoom.transformation());
+            std::cout << "initial_camera " << tr.m_translation.x() << ":"
+                      << tr.m_translation.y() << ":" << tr.m_scale
+                      << " show_mode " << label(m_show_mode.value())
+                      << " sigma_scale " << m_sigma_scale.value()
+                      << " rect_size " << m_rect_size.value().x() << ":"
+                      << m_rect_size.value().y()
+                      << "\n";
+          }
+          break;
+        }
+    }
+  render_engine_gl3_demo::handle_event(ev);
+}
+
+int
+main(int argc, char **argv)
+{
+  BlurredRectTest M;
+  return M.main(argc, argv);
+}
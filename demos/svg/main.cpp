@@ -816,6 +816,8 @@ draw_hud(astral::RenderEncoderSurface encoder, float frame_ms)
   static const enum astral::Renderer::renderer_stats_t vs[] =
     {
       astral::Renderer::number_sparse_fill_awkward_fully_clipped_or_unclipped,
+      astral::Renderer::number_sparse_stroke_nodes_visited,
+      astral::Renderer::number_sparse_stroke_leaves_visited,
       astral::Renderer::number_sparse_fill_subrects_clipping,
       astral::Renderer::number_sparse_fill_subrect_skip_clipping,
       astral::Renderer::number_sparse_fill_contour_skip_clipping,
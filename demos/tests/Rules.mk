@@ -16,6 +16,24 @@ include $(dir)/Rules.mk
 dir := $(d)/interval_allocator
 include $(dir)/Rules.mk
 
+dir := $(d)/stroke_query
+include $(dir)/Rules.mk
+
+dir := $(d)/image_atlas
+include $(dir)/Rules.mk
+
+dir := $(d)/texel_processing
+include $(dir)/Rules.mk
+
+dir := $(d)/point_query
+include $(dir)/Rules.mk
+
+dir := $(d)/path_serialize
+include $(dir)/Rules.mk
+
+dir := $(d)/svg_path
+include $(dir)/Rules.mk
+
 # Begin standard footer
 d		:= $(dirstack_$(sp))
 sp		:= $(basename $(sp))
@@ -16,6 +16,8 @@
 #include <sstream>
 #include <fstream>
 #include <iostream>
+#include <random>
+#include <limits>
 #include <SDL.h>
 
 #include <astral/path.hpp>
@@ -23,6 +25,7 @@
 
 #include "generic_command_line.hpp"
 #include "read_path.hpp"
+#include "simple_time.hpp"
 
 class ContourTessellationTest:public command_line_register
 {
@@ -32,7 +35,23 @@ public:
     m_target_tol(1e-3, "target_tol", "Target tolerance to aim for", *this),
     m_relative_tol(true, "relative_tol",
                    "If true tolerance is relative to the bounding box of the path",
-                   *this)
+                   *this),
+    m_benchmark_contours(0, "benchmark_contours",
+                         "If non-zero, instead of printing the approximations of the path, "
+                         "generate a path with this many contours of random cubics and "
+                         "print the time to compute its fill, stroke and item path "
+                         "approximations at target_tol (which is then always absolute)",
+                         *this),
+    m_benchmark_curves(100, "benchmark_curves",
+                       "Number of cubics per contour of the benchmark path", *this),
+    m_benchmark_runs(5, "benchmark_runs",
+                     "Number of times to run each benchmark, the fastest run is reported",
+                     *this),
+    m_incremental_checks(true, "incremental_checks",
+                         "If true, after printing the approximations, check that the approximations "
+                         "of contours edited by curve_to() and set_values() are as accurate as "
+                         "those of a fresh contour; the return code is non-zero on failure",
+                         *this)
   {}
 
   int
@@ -54,17 +73,416 @@ private:
     return m_path.contour(contour).fill_approximated_geometry(tol, astral::contour_fill_approximation_allow_long_curves, actual_tol);
   }
 
+  astral::c_array<const astral::ContourCurve>
+  get_item_path_curves(unsigned int contour, float tol, float *actual_tol)
+  {
+    return m_path.contour(contour).item_path_approximated_geometry(tol, actual_tol);
+  }
+
   void
   print_approximation(const std::string &label,
                       astral::c_array<const astral::ContourCurve> (ContourTessellationTest::*function)(unsigned int, float, float*));
 
+  void
+  ready_benchmark_path(void);
+
+  void
+  run_benchmark(const std::string &label,
+                astral::c_array<const astral::ContourCurve> (ContourTessellationTest::*function)(unsigned int, float, float*));
+
   command_line_argument_value<std::string> m_path_file;
   command_line_argument_value<float> m_target_tol;
   command_line_argument_value<bool> m_relative_tol;
+  command_line_argument_value<unsigned int> m_benchmark_contours;
+  command_line_argument_value<unsigned int> m_benchmark_curves;
+  command_line_argument_value<unsigned int> m_benchmark_runs;
+  command_line_argument_value<bool> m_incremental_checks;
 
   astral::Path m_path;
 };
 
+/* Checks that the approximations of a Contour after edits that keep
+ * a prefix and suffix of its curves are as good as the approximations
+ * of a fresh Contour with the same curves.
+ */
+class IncrementalEditChecks
+{
+public:
+  /* returns the number of failures */
+  static
+  unsigned int
+  run(void)
+  {
+    IncrementalEditChecks C;
+
+    C.check_append();
+    C.check_set_values();
+    std::cout << "Incremental edit checks: " << C.m_failures << " failures\n";
+
+    return C.m_failures;
+  }
+
+private:
+  enum approximation_t
+    {
+      fill_tessellate_long_curves,
+      fill_allow_long_curves,
+      stroke_approximation,
+      item_path_approximation,
+
+      number_approximations
+    };
+
+  IncrementalEditChecks(void):
+    m_generator(2u),
+    m_failures(0u)
+  {
+    m_tolerances.push_back(1.0f);
+    m_tolerances.push_back(0.1f);
+    m_tolerances.push_back(0.01f);
+  }
+
+  void
+  check(bool v, const std::string &what)
+  {
+    if (!v)
+      {
+        std::cout << "\t" << what << ": FAIL\n";
+        ++m_failures;
+      }
+  }
+
+  static
+  const char*
+  label(enum approximation_t tp)
+  {
+    static const char *labels[number_approximations] =
+      {
+        "fill_tessellate_long_curves",
+        "fill_allow_long_curves",
+        "stroke",
+        "item_path",
+      };
+
+    return labels[tp];
+  }
+
+  static
+  astral::c_array<const astral::ContourCurve>
+  approximate(const astral::Contour &C, enum approximation_t tp, float tol, float *actual_error)
+  {
+    switch (tp)
+      {
+      case fill_tessellate_long_curves:
+        return C.fill_approximated_geometry(tol, astral::contour_fill_approximation_tessellate_long_curves, actual_error);
+      case fill_allow_long_curves:
+        return C.fill_approximated_geometry(tol, astral::contour_fill_approximation_allow_long_curves, actual_error);
+      case stroke_approximation:
+        return C.stroke_approximated_geometry(tol, actual_error);
+      default:
+        return C.item_path_approximated_geometry(tol, actual_error);
+      }
+  }
+
+  astral::vec2
+  random_point(astral::vec2 center, float radius)
+  {
+    std::uniform_real_distribution<float> dist(-radius, radius);
+    return center + astral::vec2(dist(m_generator), dist(m_generator));
+  }
+
+  /* add a random cubic, quadratic or conic to C */
+  void
+  add_random_curve(astral::ContourData &C, unsigned int i)
+  {
+    astral::vec2 p(40.0f * static_cast<float>(i + 1u), 0.0f);
+
+    switch (i % 3u)
+      {
+      case 0:
+        C.cubic_to(random_point(p, 30.0f), random_point(p, 30.0f), random_point(p, 10.0f),
+                   astral::ContourCurve::not_continuation_curve);
+        break;
+      case 1:
+        C.quadratic_to(random_point(p, 30.0f), random_point(p, 10.0f),
+                       astral::ContourCurve::not_continuation_curve);
+        break;
+      default:
+        C.conic_to(0.5f, random_point(p, 30.0f), random_point(p, 10.0f),
+                   astral::ContourCurve::not_continuation_curve);
+        break;
+      }
+  }
+
+  void
+  make_contour(astral::ContourData &C, unsigned int number_curves)
+  {
+    C.clear();
+    C.start(astral::vec2(0.0f, 0.0f));
+    for (unsigned int i = 0; i < number_curves; ++i)
+      {
+        add_random_curve(C, i);
+      }
+  }
+
+  /* fetch every approximation at every tolerance so that
+   * all the LOD chains have entries to be updated.
+   */
+  void
+  populate(const astral::Contour &C)
+  {
+    for (unsigned int tp = 0; tp < number_approximations; ++tp)
+      {
+        for (float tol : m_tolerances)
+          {
+            approximate(C, static_cast<enum approximation_t>(tp), tol, nullptr);
+          }
+      }
+  }
+
+  static
+  std::vector<astral::vec2>
+  sample_curves(astral::c_array<const astral::ContourCurve> curves, unsigned int samples_per_curve,
+                float *out_max_spacing)
+  {
+    std::vector<astral::vec2> return_value;
+    float max_spacing(0.0f);
+
+    for (const astral::ContourCurve &c : curves)
+      {
+        for (unsigned int i = 0; i <= samples_per_curve; ++i)
+          {
+            astral::vec2 p(c.eval_at(static_cast<float>(i) / static_cast<float>(samples_per_curve)));
+
+            if (i != 0u)
+              {
+                max_spacing = astral::t_max(max_spacing, (p - return_value.back()).magnitude());
+              }
+            return_value.push_back(p);
+          }
+      }
+
+    if (out_max_spacing)
+      {
+        *out_max_spacing = max_spacing;
+      }
+
+    return return_value;
+  }
+
+  /* largest distance from a point of a to the nearest point of b */
+  static
+  float
+  one_sided_distance(const std::vector<astral::vec2> &a, const std::vector<astral::vec2> &b)
+  {
+    float return_value(0.0f);
+
+    for (const astral::vec2 &p : a)
+      {
+        float d(std::numeric_limits<float>::max());
+
+        for (const astral::vec2 &q : b)
+          {
+            d = astral::t_min(d, (p - q).magnitude());
+          }
+        return_value = astral::t_max(return_value, d);
+      }
+
+    return return_value;
+  }
+
+  /* The item path approximation carries the source curve and
+   * range of each of its curves, which Contour::distance_to_contour()
+   * reports; returns the largest distance from the point of the
+   * source curve at the reported time to the query point beyond
+   * the reported distance.
+   */
+  static
+  float
+  source_inconsistency(const astral::Contour &C, float tol, const std::vector<astral::vec2> &query_pts,
+                       bool *out_bad_curve)
+  {
+    float return_value(0.0f);
+
+    *out_bad_curve = false;
+    for (const astral::vec2 &p : query_pts)
+      {
+        astral::Contour::PointQueryResult R;
+        astral::vec2 q;
+
+        R = C.distance_to_contour(tol, p);
+        if (R.m_closest_curve < 0 || R.m_closest_curve >= static_cast<int>(C.number_curves()))
+          {
+            *out_bad_curve = true;
+            continue;
+          }
+
+        q = C.curve(R.m_closest_curve).eval_at(R.m_closest_point_t);
+        return_value = astral::t_max(return_value, (q - p).magnitude() - R.m_distance);
+      }
+
+    return return_value;
+  }
+
+  /* compare the approximations of the edited contour against a
+   * fresh contour made from the same curves.
+   */
+  void
+  check_against_fresh(const astral::Contour &edited, const std::string &edit)
+  {
+    astral::reference_counted_ptr<astral::Contour> fresh;
+    std::vector<astral::vec2> source_pts, query_pts;
+    float source_spacing;
+
+    fresh = astral::Contour::create(edited);
+    source_pts = sample_curves(edited.curves(), 64u, &source_spacing);
+
+    for (unsigned int i = 0; i < 200u; ++i)
+      {
+        query_pts.push_back(random_point(edited.bounding_box().as_rect().center_point(),
+                                         0.6f * edited.bounding_box().as_rect().size().x()));
+      }
+
+    for (unsigned int t = 0; t < number_approximations; ++t)
+      {
+        enum approximation_t tp(static_cast<enum approximation_t>(t));
+
+        for (float tol : m_tolerances)
+          {
+            astral::c_array<const astral::ContourCurve> curves, fresh_curves;
+            std::vector<astral::vec2> approx_pts;
+            float error, fresh_error, approx_spacing, slack;
+            std::ostringstream str;
+
+            str << edit << ", " << label(tp) << ", tol = " << tol;
+
+            curves = approximate(edited, tp, tol, &error);
+            fresh_curves = approximate(*fresh, tp, tol, &fresh_error);
+
+            /* the entries keep their error across updates, which must
+             * meet the tolerance whenever a fresh contour does.
+             */
+            check(error <= astral::t_max(tol, fresh_error), str.str() + ": error within tolerance");
+
+            /* the curves must be a chain from the start to the end of the contour */
+            check(!curves.empty(), str.str() + ": non-empty");
+            if (curves.empty())
+              {
+                continue;
+              }
+
+            bool chained(curves.front().start_pt() == edited.start()
+                         && curves.back().end_pt() == ((edited.closed()) ? edited.start() : edited.curves().back().end_pt()));
+            for (unsigned int i = 1; i < curves.size(); ++i)
+              {
+                chained = chained && (curves[i - 1u].end_pt() == curves[i].start_pt());
+              }
+            check(chained, str.str() + ": curves are chained");
+
+            /* the approximation and contour are within the error of each other */
+            approx_pts = sample_curves(curves, 16u, &approx_spacing);
+            slack = source_spacing + approx_spacing + 1e-3f;
+            check(one_sided_distance(approx_pts, source_pts) <= error + slack, str.str() + ": approximation near contour");
+            check(one_sided_distance(source_pts, approx_pts) <= error + slack, str.str() + ": contour near approximation");
+
+            if (tp == item_path_approximation)
+              {
+                bool edited_bad, fresh_bad;
+                float edited_inconsistency, fresh_inconsistency;
+
+                edited_inconsistency = source_inconsistency(edited, tol, query_pts, &edited_bad);
+                fresh_inconsistency = source_inconsistency(*fresh, tol, query_pts, &fresh_bad);
+
+                check(!edited_bad, str.str() + ": source curves valid");
+                check(edited_inconsistency <= 2.0f * fresh_inconsistency + 2.0f * tol + 1e-3f,
+                      str.str() + ": source ranges consistent");
+              }
+          }
+      }
+  }
+
+  /* append curves to an open contour one at a time */
+  void
+  check_append(void)
+  {
+    for (unsigned int number_curves = 4; number_curves < 16u; number_curves += 3u)
+      {
+        astral::reference_counted_ptr<astral::Contour> C(astral::Contour::create());
+        std::ostringstream str;
+
+        make_contour(*C, number_curves);
+        populate(*C);
+
+        for (unsigned int k = 0; k < 3u; ++k)
+          {
+            add_random_curve(*C, number_curves + k);
+          }
+
+        str << "curve_to() on " << number_curves << " curves";
+        check_against_fresh(*C, str.str());
+      }
+  }
+
+  /* replace a curve in the middle, keeping a prefix and suffix */
+  void
+  check_set_values(void)
+  {
+    for (unsigned int number_curves = 4; number_curves < 16u; number_curves += 3u)
+      {
+        for (unsigned int closed = 0; closed < 2u; ++closed)
+          {
+            astral::reference_counted_ptr<astral::Contour> C(astral::Contour::create());
+            astral::ContourData D;
+            std::ostringstream str;
+            unsigned int changed(number_curves / 2u);
+
+            make_contour(D, number_curves);
+            if (closed)
+              {
+                D.close();
+              }
+
+            C->set_values(D);
+            populate(*C);
+
+            /* same curves except that the curve changed has a new
+             * control point and the curve after it a new end point
+             */
+            D.clear();
+            D.start(C->start());
+            for (unsigned int i = 0; i < number_curves; ++i)
+              {
+                const astral::ContourCurve &c(C->curve(i));
+
+                if (i == changed)
+                  {
+                    D.quadratic_to(random_point(c.end_pt(), 30.0f), c.end_pt(),
+                                   astral::ContourCurve::not_continuation_curve);
+                  }
+                else
+                  {
+                    D.curve_to(c);
+                  }
+              }
+
+            if (closed)
+              {
+                D.close();
+              }
+
+            C->set_values(D);
+            str << "set_values() on " << number_curves << " curves"
+                << ((closed) ? ", closed" : ", open");
+            check_against_fresh(*C, str.str());
+          }
+      }
+  }
+
+  std::mt19937 m_generator;
+  unsigned int m_failures;
+  std::vector<float> m_tolerances;
+};
+
 void
 ContourTessellationTest::
 ready_path(void)
@@ -142,6 +560,68 @@ print_approximation(const std::string &label,
     }
 }
 
+void
+ContourTessellationTest::
+ready_benchmark_path(void)
+{
+  /* always use the same seed so that runs are comparable */
+  std::mt19937 generator(1u);
+  std::uniform_real_distribution<float> center(0.0f, 1000.0f), offset(-10.0f, 10.0f);
+
+  m_path.clear();
+  for (unsigned int c = 0; c < m_benchmark_contours.value(); ++c)
+    {
+      astral::vec2 o(center(generator), center(generator));
+
+      m_path.move(o);
+      for (unsigned int i = 0; i < m_benchmark_curves.value(); ++i)
+        {
+          astral::vec2 c0, c1, p;
+
+          c0 = o + astral::vec2(offset(generator), offset(generator));
+          c1 = o + astral::vec2(offset(generator), offset(generator));
+          p = o + astral::vec2(offset(generator), offset(generator));
+          m_path.cubic_to(c0, c1, p);
+        }
+      m_path.close();
+    }
+}
+
+void
+ContourTessellationTest::
+run_benchmark(const std::string &label,
+              astral::c_array<const astral::ContourCurve> (ContourTessellationTest::*function)(unsigned int, float, float*))
+{
+  int64_t best_us(0);
+  unsigned int total_size(0u);
+
+  for (unsigned int run = 0; run < astral::t_max(1u, m_benchmark_runs.value()); ++run)
+    {
+      simple_time timer;
+      int64_t elapsed_us;
+
+      /* the approximations are cached by the contours, so
+       * a fresh path is needed for each run.
+       */
+      ready_benchmark_path();
+
+      timer.restart_us();
+      total_size = 0u;
+      for (unsigned int c = 0, numC = m_path.number_contours(); c < numC; ++c)
+        {
+          float actual_error;
+
+          total_size += (this->*function)(c, m_target_tol.value(), &actual_error).size();
+        }
+      elapsed_us = timer.elapsed_us();
+
+      best_us = (run == 0u) ? elapsed_us : astral::t_min(best_us, elapsed_us);
+    }
+
+  std::cout << label << ": total_size = " << total_size
+            << ", time = " << static_cast<float>(best_us) / 1000.0f << " ms\n";
+}
+
 int
 ContourTessellationTest::
 main(int argc, char **argv)
@@ -163,6 +643,18 @@ main(int argc, char **argv)
   parse_command_line(argc, argv);
   std::cout << "\n\n" << std::flush;
 
+  if (m_benchmark_contours.value() != 0u)
+    {
+      std::cout << "Benchmark: " << m_benchmark_contours.value() << " contours with "
+                << m_benchmark_curves.value() << " cubics each, tolerance = "
+                << m_target_tol.value() << "\n";
+
+      run_benchmark("FillTessellation", &ContourTessellationTest::get_fill_curves);
+      run_benchmark("StrokeTessellation", &ContourTessellationTest::get_stroke_curves);
+      run_benchmark("ItemPathTessellation", &ContourTessellationTest::get_item_path_curves);
+      return 0;
+    }
+
   ready_path();
 
   if (m_relative_tol.value() && !m_path.bounding_box().empty())
@@ -176,6 +668,12 @@ main(int argc, char **argv)
   print_approximation("FillTessellation", &ContourTessellationTest::get_stroke_curves);
   print_approximation("StrokeTessellation", &ContourTessellationTest::get_fill_curves);
 
+  if (m_incremental_checks.value())
+    {
+      std::cout << "\n\n";
+      return (IncrementalEditChecks::run() == 0u) ? 0 : -1;
+    }
+
   return 0;
 }
 
@@ -0,0 +1,380 @@
+/*!
+ * \file main.cpp
+ * \brief main.cpp
+ *
+ * Copyright 2020 by InvisionApp.
+ *
+ * Contact kevinrogovin@invisionapp.com
+ *
+ * This Source Code Form is subject to the
+ * terms of the Mozilla Public License, v. 2.0.
+ * If a copy of the MPL was not distributed with
+ * this file, You can obtain one at
+ * http://mozilla.org/MPL/2.0/.
+ *
+ */
+
+#include <iostream>
+#include <vector>
+#include <SDL.h>
+#include <astral/renderer/image.hpp>
+#include <astral/renderer/backend/image_backing.hpp>
+#include <astral/util/ostream_utility.hpp>
+
+#include "generic_command_line.hpp"
+
+/* Backings that do not store anything; the tests only
+ * look at what ImageAtlas allocates and releases.
+ */
+class NullColorBacking:public astral::ImageAtlasColorBacking
+{
+public:
+  NullColorBacking(unsigned int width_height, unsigned int number_layers,
+                   unsigned int max_number_layers):
+    astral::ImageAtlasColorBacking(width_height, number_layers, max_number_layers)
+  {}
+
+  virtual
+  void
+  flush(void) override
+  {}
+
+  virtual
+  void
+  upload_texels(unsigned int, astral::uvec3, astral::uvec2,
+                astral::c_array<const astral::u8vec4>) override
+  {}
+
+  virtual
+  void
+  copy_pixels(unsigned int, astral::uvec3, astral::uvec2,
+              astral::ColorBuffer&, astral::uvec2,
+              const astral::RectT<int>&,
+              enum astral::image_blit_processing_t,
+              bool) override
+  {}
+
+  virtual
+  void
+  downsample_pixels(unsigned int, astral::uvec3, astral::uvec2,
+                    astral::ColorBuffer&, astral::uvec2,
+                    enum astral::downsampling_processing_t,
+                    bool) override
+  {}
+
+  virtual
+  void
+  copy_texels(unsigned int, astral::uvec3, astral::uvec2, astral::uvec3) override
+  {}
+
+protected:
+  virtual
+  void
+  on_resize(unsigned int) override
+  {}
+};
+
+class NullIndexBacking:public astral::ImageAtlasIndexBacking
+{
+public:
+  NullIndexBacking(unsigned int width_height, unsigned int number_layers,
+                   unsigned int max_number_layers):
+    astral::ImageAtlasIndexBacking(width_height, number_layers, max_number_layers)
+  {}
+
+  virtual
+  void
+  flush(void) override
+  {}
+
+  virtual
+  void
+  upload_texels(astral::uvec3, astral::uvec2, astral::c_array<const astral::uvec3>) override
+  {}
+
+protected:
+  virtual
+  void
+  on_resize(unsigned int) override
+  {}
+};
+
+class TestOptions:public command_line_register
+{
+public:
+  TestOptions(void):
+    m_image_size(32, "image_size", "width and height of the images created by the tests", *this),
+    m_max_number_layers(16, "max_number_layers", "maximum number of layers of the color backing", *this)
+  {}
+
+  command_line_argument_value<unsigned int> m_image_size;
+  command_line_argument_value<unsigned int> m_max_number_layers;
+};
+
+class Tester
+{
+public:
+  explicit
+  Tester(const TestOptions &options):
+    m_options(options),
+    m_failures(0)
+  {
+    m_color_backing = ASTRALnew NullColorBacking(2048, 1, m_options.m_max_number_layers.value());
+    m_index_backing = ASTRALnew NullIndexBacking(2048, 1, m_options.m_max_number_layers.value());
+    m_atlas = astral::ImageAtlas::create(*m_color_backing, *m_index_backing);
+  }
+
+  int
+  run_tests(void)
+  {
+    test_budget_purges_lru();
+    test_shared_mips_not_purged();
+    test_in_use_not_purged();
+    test_deduplication();
+
+    std::cout << m_failures << " failures\n";
+    return (m_failures == 0) ? 0 : -1;
+  }
+
+private:
+  void
+  check(bool v, const char *what)
+  {
+    std::cout << "\t" << what << ": " << ((v) ? "pass" : "FAIL") << "\n";
+    if (!v)
+      {
+        ++m_failures;
+      }
+  }
+
+  /* create an image whose color tiles are all backed, the
+   * value of seed makes the content unique so that the tiles
+   * are never shared if deduplication is enabled.
+   */
+  astral::reference_counted_ptr<astral::Image>
+  create_filled_image(unsigned int seed)
+  {
+    astral::reference_counted_ptr<astral::Image> image;
+    astral::uvec2 sz(m_options.m_image_size.value());
+    std::vector<astral::u8vec4> pixels(sz.x() * sz.y());
+
+    for (unsigned int i = 0; i < pixels.size(); ++i)
+      {
+        pixels[i] = astral::u8vec4(seed & 0xFFu, (seed >> 8u) & 0xFFu, i & 0xFFu, 255u);
+      }
+
+    image = m_atlas->create_image(sz);
+    image->set_pixels(0, astral::ivec2(0, 0), astral::ivec2(sz), sz.x(), astral::make_c_array(pixels));
+
+    return image;
+  }
+
+  /* set all texels of an image to the same value */
+  void
+  fill_image(astral::Image &image, astral::u8vec4 value)
+  {
+    astral::uvec2 sz(image.size());
+    std::vector<astral::u8vec4> pixels(sz.x() * sz.y(), value);
+
+    image.set_pixels(0, astral::ivec2(0, 0), astral::ivec2(sz), sz.x(), astral::make_c_array(pixels));
+  }
+
+  /* mark the image as in use within its own lock/unlock
+   * pair so that it gets a distinct LRU position.
+   */
+  void
+  touch(astral::Image &image)
+  {
+    m_atlas->lock_resources();
+    image.mark_in_use();
+    m_atlas->unlock_resources();
+  }
+
+  void
+  test_budget_purges_lru(void)
+  {
+    astral::reference_counted_ptr<astral::Image> a, b, c, d;
+    uint64_t per_image, base;
+    unsigned int purged;
+
+    std::cout << "Budget purges least recently used first:\n";
+
+    /* the tiles the atlas keeps for itself are not counted */
+    check(m_atlas->total_color_bytes_allocated() == 0u, "empty atlas has no color bytes");
+
+    base = m_atlas->total_color_bytes_allocated();
+    a = create_filled_image(1u);
+    per_image = m_atlas->total_color_bytes_allocated() - base;
+    b = create_filled_image(2u);
+    c = create_filled_image(3u);
+
+    a->purgeable(true);
+    b->purgeable(true);
+    c->purgeable(true);
+
+    /* b is least recently used, then c, then a */
+    touch(*b);
+    touch(*c);
+    touch(*a);
+
+    /* allow room for only three images */
+    m_atlas->color_backing_byte_budget(base + 3u * per_image);
+    purged = m_atlas->total_images_purged();
+    d = create_filled_image(4u);
+
+    check(m_atlas->total_color_bytes_allocated() <= m_atlas->color_backing_byte_budget(),
+          "allocated bytes within budget");
+    check(m_atlas->total_images_purged() == purged + 1u, "exactly one image purged");
+    check(b->purged() && !c->purged() && !a->purged(), "least recently used image purged");
+    check(!b->purgeable(), "purged image no longer purgeable");
+    check(!d->purged(), "new image not purged");
+
+    m_atlas->color_backing_byte_budget(0u);
+  }
+
+  void
+  test_shared_mips_not_purged(void)
+  {
+    astral::reference_counted_ptr<astral::Image> a, shared_holder, b;
+    uint64_t per_image, base;
+    unsigned int purged;
+
+    std::cout << "Images with shared mips are not purged:\n";
+
+    base = m_atlas->total_color_bytes_allocated();
+    a = create_filled_image(10u);
+    per_image = m_atlas->total_color_bytes_allocated() - base;
+
+    /* shared_holder is not purgeable and uses the same mip
+     * elements, so purging a would release nothing.
+     */
+    shared_holder = m_atlas->create_image(a->mip_chain());
+    a->purgeable(true);
+
+    m_atlas->color_backing_byte_budget(base + per_image);
+    purged = m_atlas->total_images_purged();
+    b = create_filled_image(11u);
+
+    check(!a->purged(), "image with shared mips not purged");
+    check(m_atlas->total_images_purged() == purged, "no image purged");
+    check(!b->purged() && !b->tile_allocation_failed(), "new image allocated past the budget");
+
+    /* once the mips are no longer shared, the image can be purged */
+    shared_holder.clear();
+    purged = m_atlas->total_images_purged();
+    b = create_filled_image(12u);
+
+    check(a->purged(), "image purged once its mips are no longer shared");
+    check(m_atlas->total_images_purged() == purged + 1u, "exactly one image purged");
+
+    m_atlas->color_backing_byte_budget(0u);
+  }
+
+  void
+  test_in_use_not_purged(void)
+  {
+    astral::reference_counted_ptr<astral::Image> a, b;
+    uint64_t base, per_image;
+    unsigned int purged;
+
+    std::cout << "Images in use are not purged:\n";
+
+    base = m_atlas->total_color_bytes_allocated();
+    a = create_filled_image(20u);
+    per_image = m_atlas->total_color_bytes_allocated() - base;
+    a->purgeable(true);
+
+    m_atlas->color_backing_byte_budget(base + per_image);
+    purged = m_atlas->total_images_purged();
+
+    m_atlas->lock_resources();
+    a->mark_in_use();
+    b = create_filled_image(21u);
+    m_atlas->unlock_resources();
+
+    check(!a->purged(), "in use image not purged");
+    check(m_atlas->total_images_purged() == purged, "no image purged");
+
+    m_atlas->color_backing_byte_budget(0u);
+  }
+
+  void
+  test_deduplication(void)
+  {
+    astral::reference_counted_ptr<astral::Image> a, b, c;
+    uint64_t per_image, base, deduplicated, shared_cost;
+
+    std::cout << "Color tiles are deduplicated by content:\n";
+
+    m_atlas->deduplicate_color_tiles(true);
+
+    base = m_atlas->total_color_bytes_allocated();
+    a = create_filled_image(30u);
+    per_image = m_atlas->total_color_bytes_allocated() - base;
+
+    /* same content as a, should share the color tiles of a */
+    base = m_atlas->total_color_bytes_allocated();
+    deduplicated = m_atlas->total_color_bytes_deduplicated();
+    b = create_filled_image(30u);
+    shared_cost = m_atlas->total_color_bytes_allocated() - base;
+    check(m_atlas->total_color_bytes_deduplicated() > deduplicated, "identical content deduplicated");
+    check(shared_cost < per_image, "identical content shares color tiles");
+
+    /* different content must not share */
+    base = m_atlas->total_color_bytes_allocated();
+    deduplicated = m_atlas->total_color_bytes_deduplicated();
+    c = create_filled_image(31u);
+    check(m_atlas->total_color_bytes_deduplicated() == deduplicated, "different content not deduplicated");
+    check(m_atlas->total_color_bytes_allocated() - base == per_image, "different content allocates");
+
+    /* writing to b must copy the tiles instead of changing a */
+    base = m_atlas->total_color_bytes_allocated();
+    fill_image(*b, astral::u8vec4(1u, 2u, 3u, 4u));
+    check(m_atlas->total_color_bytes_allocated() - base == per_image - shared_cost,
+          "write to deduplicated tile copies it");
+
+    /* rewriting the same content to a tile is skipped */
+    deduplicated = m_atlas->total_color_bytes_deduplicated();
+    fill_image(*b, astral::u8vec4(1u, 2u, 3u, 4u));
+    check(m_atlas->total_color_bytes_deduplicated() > deduplicated, "rewrite of same content skipped");
+
+    /* a rewrite with different content is not skipped */
+    deduplicated = m_atlas->total_color_bytes_deduplicated();
+    fill_image(*b, astral::u8vec4(1u, 2u, 3u, 5u));
+    check(m_atlas->total_color_bytes_deduplicated() == deduplicated, "rewrite of different content uploaded");
+
+    m_atlas->deduplicate_color_tiles(false);
+  }
+
+  const TestOptions &m_options;
+  unsigned int m_failures;
+  astral::reference_counted_ptr<NullColorBacking> m_color_backing;
+  astral::reference_counted_ptr<NullIndexBacking> m_index_backing;
+  astral::reference_counted_ptr<astral::ImageAtlas> m_atlas;
+};
+
+int
+main(int argc, char **argv)
+{
+  TestOptions options;
+
+  if (argc == 2 && options.is_help_request(argv[1]))
+    {
+      std::cout << "\n\nUsage: " << argv[0];
+      options.print_help(std::cout);
+      options.print_detailed_help(std::cout);
+      return 0;
+    }
+
+  std::cout << "\n\nRunning: \"";
+  for(int i = 0; i < argc; ++i)
+    {
+      std::cout << argv[i] << " ";
+    }
+
+  options.parse_command_line(argc, argv);
+  std::cout << "\n\n" << std::flush;
+
+  Tester tester(options);
+  return tester.run_tests();
+}
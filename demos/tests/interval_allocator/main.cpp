@@ -42,7 +42,8 @@ public:
     m_layer_length(4096, "layer_length", "", *this),
     m_initial_number_layers(1, "initial_number_layers", "if negative, then only one layer that is dynamically resizeable", *this),
     m_random_seed(std::mt19937::default_seed, "random_seed", "", *this),
-    m_interval_allocator(nullptr)
+    m_interval_allocator(nullptr),
+    m_failures(0)
   {}
 
   ~Test(void)
@@ -57,7 +58,7 @@ public:
       }
   }
 
-  void
+  int
   run_tests(void);
 
 private:
@@ -70,6 +71,19 @@ private:
   void
   release_random(void);
 
+  void
+  check_value(bool v, const char *what);
+
+  /* check number_allocated(), space_allocated() and
+   * has_live_intervals() against m_allocations
+   */
+  void
+  check_stats(void);
+
+  /* remove the trailing layers that have nothing allocated */
+  void
+  shrink_layers(void);
+
   command_line_argument_value<int> m_layer_length;
   command_line_argument_value<int> m_initial_number_layers;
   command_line_argument_value<int> m_random_seed;
@@ -77,6 +91,7 @@ private:
   std::mt19937 m_generator;
   astral::IntervalAllocator *m_interval_allocator;
   std::vector<Entry*> m_allocations;
+  unsigned int m_failures;
 };
 
 void
@@ -108,12 +123,16 @@ allocate(int size)
     }
 
   ASTRALassert(p);
+  check_value(p->layer() >= 0 && static_cast<unsigned int>(p->layer()) < m_interval_allocator->number_layers(),
+              "allocated on an existing layer");
+  check_value(p->range().m_end - p->range().m_begin == size, "allocated size");
   m_interval_allocator->check(p->layer());
 
   Entry *e;
 
   e = ASTRALnew Entry(p, m_allocations.size());
   m_allocations.push_back(e);
+  check_stats();
 }
 
 void
@@ -140,6 +159,7 @@ release(unsigned int entry)
   ASTRALdelete(e);
 
   m_interval_allocator->check(layer);
+  check_stats();
 }
 
 void
@@ -155,6 +175,87 @@ release_random(void)
 
 void
 Test::
+check_value(bool v, const char *what)
+{
+  if (!v)
+    {
+      std::cout << "\t" << what << ": FAIL\n";
+      ++m_failures;
+    }
+}
+
+void
+Test::
+check_stats(void)
+{
+  unsigned int num_layers(m_interval_allocator->number_layers());
+  std::vector<unsigned int> number(num_layers, 0u), space(num_layers, 0u);
+  unsigned int total_space(0u);
+
+  for (const Entry *e : m_allocations)
+    {
+      unsigned int layer(e->m_p->layer());
+      unsigned int size(e->m_p->range().difference());
+
+      ASTRALassert(layer < num_layers);
+      ++number[layer];
+      space[layer] += size;
+      total_space += size;
+    }
+
+  for (unsigned int layer = 0; layer < num_layers; ++layer)
+    {
+      check_value(m_interval_allocator->number_allocated(layer) == number[layer], "number_allocated(layer)");
+      check_value(m_interval_allocator->space_allocated(layer) == space[layer], "space_allocated(layer)");
+    }
+  check_value(m_interval_allocator->space_allocated() == total_space, "space_allocated()");
+  check_value(m_interval_allocator->has_live_intervals() == !m_allocations.empty(), "has_live_intervals()");
+}
+
+void
+Test::
+shrink_layers(void)
+{
+  unsigned int L(1u);
+
+  for (const Entry *e : m_allocations)
+    {
+      L = astral::t_max(L, e->m_p->layer() + 1u);
+    }
+
+  std::cout << "Shrink from " << m_interval_allocator->number_layers()
+            << " to " << L << " layers\n";
+
+  if (L < m_interval_allocator->number_layers())
+    {
+      m_interval_allocator->number_layers(L);
+    }
+  check_value(m_interval_allocator->number_layers() == L, "number_layers() after shrinking");
+  check_stats();
+
+  /* the free intervals of the removed layers must not be
+   * used; allocating a full layer either fails or lands on
+   * a layer that remains.
+   */
+  const astral::IntervalAllocator::Interval *p;
+
+  p = m_interval_allocator->allocate(m_interval_allocator->layer_length());
+  if (p)
+    {
+      check_value(static_cast<unsigned int>(p->layer()) < L, "full layer allocated on a remaining layer");
+      check_value(m_interval_allocator->number_allocated(p->layer()) == 1u, "full layer allocation is alone on its layer");
+      m_interval_allocator->release(p);
+      check_stats();
+    }
+
+  for (unsigned int layer = 0; layer < L; ++layer)
+    {
+      m_interval_allocator->check(layer);
+    }
+}
+
+int
+Test::
 run_tests(void)
 {
   int num_layers;
@@ -172,8 +273,12 @@ run_tests(void)
                 << "'d': delete random amount\n"
                 << "'c': check\n"
                 << "'l': check layer\n"
+                << "'s': shrink trailing empty layers\n"
                 << "'q': quit\n" << std::flush;
-      std::cin >> choice;
+      if (!(std::cin >> choice))
+        {
+          break;
+        }
       switch (choice)
         {
         case 'a':
@@ -249,12 +354,20 @@ run_tests(void)
 
             cnt = m_interval_allocator->check();
             ASTRALassert(cnt == m_allocations.size());
+            check_stats();
             std::cout << cnt << " allocated elements total\n";
           }
           break;
+
+        case 's':
+          shrink_layers();
+          break;
         }
     }
   while (choice != 'q');
+
+  std::cout << m_failures << " failures\n";
+  return (m_failures == 0) ? 0 : -1;
 }
 
 
@@ -280,5 +393,5 @@ main(int argc, char **argv)
   test.parse_command_line(argc, argv);
   std::cout << "\n\n" << std::flush;
 
-  test.run_tests();
+  return test.run_tests();
 }
@@ -0,0 +1,411 @@
+/*!
+ * \file main.cpp
+ * \brief main.cpp
+ *
+ * Copyright 2020 by InvisionApp.
+ *
+ * Contact kevinrogovin@invisionapp.com
+ *
+ * This Source Code Form is subject to the
+ * terms of the Mozilla Public License, v. 2.0.
+ * If a copy of the MPL was not distributed with
+ * this file, You can obtain one at
+ * http://mozilla.org/MPL/2.0/.
+ *
+ */
+
+#include <iostream>
+#include <vector>
+#include <cstring>
+#include <SDL.h>
+#include <astral/path.hpp>
+#include <astral/util/ostream_utility.hpp>
+
+#include "generic_command_line.hpp"
+
+class TestOptions:public command_line_register
+{
+public:
+  TestOptions(void):
+    m_coarse_tolerance(1.0f, "coarse_tolerance", "coarsest tolerance of the serialized approximations", *this),
+    m_fine_tolerance(0.01f, "fine_tolerance", "finest tolerance of the serialized approximations", *this)
+  {}
+
+  command_line_argument_value<float> m_coarse_tolerance;
+  command_line_argument_value<float> m_fine_tolerance;
+};
+
+class Tester
+{
+public:
+  explicit
+  Tester(const TestOptions &options):
+    m_failures(0)
+  {
+    m_tolerances.push_back(options.m_coarse_tolerance.value());
+    m_tolerances.push_back(options.m_fine_tolerance.value());
+  }
+
+  int
+  run_tests(void)
+  {
+    test_round_trip();
+    test_corrupt_curves();
+    test_corrupt_source_tags();
+
+    std::cout << m_failures << " failures\n";
+    return (m_failures == 0) ? 0 : -1;
+  }
+
+private:
+  void
+  check(bool v, const char *what)
+  {
+    std::cout << "\t" << what << ": " << ((v) ? "pass" : "FAIL") << "\n";
+    if (!v)
+      {
+        ++m_failures;
+      }
+  }
+
+  /* a path with every curve type, a closed and an open contour */
+  static
+  void
+  build_path(astral::Path *path)
+  {
+    path->move(astral::vec2(0.0f, 0.0f))
+      .line_to(astral::vec2(100.0f, 0.0f))
+      .quadratic_to(astral::vec2(150.0f, 50.0f), astral::vec2(100.0f, 100.0f))
+      .cubic_to(astral::vec2(70.0f, 150.0f), astral::vec2(30.0f, 50.0f), astral::vec2(0.0f, 100.0f),
+                astral::ContourCurve::continuation_curve)
+      .close();
+
+    path->move(astral::vec2(200.0f, 0.0f))
+      .conic_to(0.5f, astral::vec2(300.0f, 0.0f), astral::vec2(300.0f, 100.0f))
+      .arc_to(ASTRAL_PI * 0.5f, astral::vec2(200.0f, 200.0f))
+      .line_to(astral::vec2(200.0f, 250.0f));
+  }
+
+  /* a path whose approximations are its own line segments so
+   * that the value of each source tag is known.
+   */
+  static
+  void
+  build_polygon(astral::Path *path)
+  {
+    path->move(astral::vec2(0.0f, 0.0f))
+      .line_to(astral::vec2(100.0f, 0.0f))
+      .line_to(astral::vec2(100.0f, 100.0f))
+      .line_to(astral::vec2(0.0f, 100.0f))
+      .close();
+  }
+
+  static
+  bool
+  curves_equal(const astral::ContourCurve &a, const astral::ContourCurve &b)
+  {
+    if (a.type() != b.type()
+        || a.continuation() != b.continuation()
+        || a.number_control_pts() != b.number_control_pts()
+        || a.start_pt() != b.start_pt()
+        || a.end_pt() != b.end_pt()
+        || (a.is_conic() && a.conic_weight() != b.conic_weight()))
+      {
+        return false;
+      }
+
+    for (unsigned int i = 0; i < a.number_control_pts(); ++i)
+      {
+        if (a.control_pt(i) != b.control_pt(i))
+          {
+            return false;
+          }
+      }
+
+    return true;
+  }
+
+  static
+  bool
+  curves_equal(astral::c_array<const astral::ContourCurve> a,
+               astral::c_array<const astral::ContourCurve> b)
+  {
+    if (a.size() != b.size())
+      {
+        return false;
+      }
+
+    for (unsigned int i = 0; i < a.size(); ++i)
+      {
+        if (!curves_equal(a[i], b[i]))
+          {
+            return false;
+          }
+      }
+
+    return true;
+  }
+
+  /* returns the offset into bytes of the bytes of v, or -1 */
+  static
+  int
+  find_bytes(const std::vector<uint8_t> &bytes, const void *v, unsigned int sz)
+  {
+    for (unsigned int i = 0; i + sz <= bytes.size(); ++i)
+      {
+        if (std::memcmp(&bytes[i], v, sz) == 0)
+          {
+            return i;
+          }
+      }
+
+    return -1;
+  }
+
+  /* returns the offset of the first byte where a and b differ */
+  static
+  unsigned int
+  first_difference(const astral::ContourCurve &a, const astral::ContourCurve &b)
+  {
+    const uint8_t *pa(reinterpret_cast<const uint8_t*>(&a));
+    const uint8_t *pb(reinterpret_cast<const uint8_t*>(&b));
+    unsigned int i;
+
+    for (i = 0; i < sizeof(astral::ContourCurve) && pa[i] == pb[i]; ++i)
+      {}
+
+    return i;
+  }
+
+  bool
+  approximations_equal(const astral::Contour &a, const astral::Contour &b)
+  {
+    for (float tol : m_tolerances)
+      {
+        float error_a, error_b;
+
+        if (!curves_equal(a.fill_approximated_geometry(tol, astral::contour_fill_approximation_tessellate_long_curves, &error_a),
+                          b.fill_approximated_geometry(tol, astral::contour_fill_approximation_tessellate_long_curves, &error_b))
+            || error_a != error_b)
+          {
+            return false;
+          }
+
+        if (!curves_equal(a.fill_approximated_geometry(tol, astral::contour_fill_approximation_allow_long_curves, &error_a),
+                          b.fill_approximated_geometry(tol, astral::contour_fill_approximation_allow_long_curves, &error_b))
+            || error_a != error_b)
+          {
+            return false;
+          }
+
+        if (!curves_equal(a.stroke_approximated_geometry(tol, &error_a),
+                          b.stroke_approximated_geometry(tol, &error_b))
+            || error_a != error_b)
+          {
+            return false;
+          }
+
+        if (!curves_equal(a.item_path_approximated_geometry(tol, &error_a),
+                          b.item_path_approximated_geometry(tol, &error_b))
+            || error_a != error_b)
+          {
+            return false;
+          }
+      }
+
+    return true;
+  }
+
+  void
+  serialize(const astral::Path &path, std::vector<uint8_t> *dst)
+  {
+    path.serialize(dst, astral::make_c_array(m_tolerances), astral::contour_prepare_all);
+  }
+
+  void
+  test_round_trip(void)
+  {
+    astral::Path path, restored;
+    std::vector<uint8_t> bytes;
+    bool geometry_equal, approx_equal;
+    enum astral::return_code R;
+
+    std::cout << "Serialize then deserialize gives the same path:\n";
+
+    build_path(&path);
+    serialize(path, &bytes);
+    R = restored.deserialize(astral::make_c_array(bytes));
+    check(R == astral::routine_success, "deserialize succeeds");
+    check(restored.number_contours() == path.number_contours(), "same number of contours");
+
+    geometry_equal = approx_equal = (restored.number_contours() == path.number_contours());
+    for (unsigned int c = 0; c < path.number_contours() && geometry_equal; ++c)
+      {
+        const astral::Contour &a(path.contour(c));
+        const astral::Contour &b(restored.contour(c));
+
+        geometry_equal = a.closed() == b.closed()
+          && curves_equal(a.curves(), b.curves());
+        approx_equal = approx_equal && approximations_equal(a, b);
+      }
+    check(geometry_equal, "same curves and closed state");
+    check(approx_equal, "same approximations and errors");
+    check(restored.bounding_box().as_rect().m_min_point == path.bounding_box().as_rect().m_min_point
+          && restored.bounding_box().as_rect().m_max_point == path.bounding_box().as_rect().m_max_point,
+          "same bounding box");
+
+    /* the data without approximations also restores the geometry */
+    path.serialize(&bytes);
+    R = restored.deserialize(astral::make_c_array(bytes));
+    check(R == astral::routine_success && restored.number_contours() == path.number_contours()
+          && curves_equal(restored.contour(1).curves(), path.contour(1).curves()),
+          "geometry only round trip");
+  }
+
+  void
+  test_corrupt_curves(void)
+  {
+    astral::Path path, restored;
+    std::vector<uint8_t> bytes, corrupt;
+    astral::ContourCurve curve, flattened, other_continuation;
+    unsigned int type_offset, continuation_offset;
+    int curve_offset;
+
+    std::cout << "Corrupt curves fail to deserialize:\n";
+
+    build_path(&path);
+    serialize(path, &bytes);
+
+    /* the curves are written in their in-memory layout; find
+     * where the quadratic curve and its type and continuation
+     * bytes are by comparing against modified copies of it.
+     */
+    curve = path.contour(0).curve(1);
+    flattened = curve;
+    flattened.flatten();
+    other_continuation = astral::ContourCurve(curve, astral::ContourCurve::continuation_curve_cusp);
+    type_offset = first_difference(curve, flattened);
+    continuation_offset = first_difference(curve, other_continuation);
+    curve_offset = find_bytes(bytes, &curve, sizeof(astral::ContourCurve));
+
+    check(curve_offset >= 0 && type_offset < sizeof(astral::ContourCurve)
+          && continuation_offset < sizeof(astral::ContourCurve),
+          "located serialized curve");
+    if (curve_offset < 0)
+      {
+        return;
+      }
+
+    corrupt = bytes;
+    corrupt[curve_offset + type_offset] = 0xEE;
+    check(restored.deserialize(astral::make_c_array(corrupt)) == astral::routine_fail
+          && restored.number_contours() == 0u,
+          "invalid curve type rejected");
+
+    /* a valid type with the wrong number of control points */
+    corrupt = bytes;
+    corrupt[curve_offset + type_offset] = astral::ContourCurve::cubic_bezier;
+    check(restored.deserialize(astral::make_c_array(corrupt)) == astral::routine_fail,
+          "curve type not matching control point count rejected");
+
+    corrupt = bytes;
+    corrupt[curve_offset + continuation_offset] = 0xEE;
+    check(restored.deserialize(astral::make_c_array(corrupt)) == astral::routine_fail,
+          "invalid continuation rejected");
+
+    corrupt = bytes;
+    corrupt.resize(bytes.size() / 2u);
+    check(restored.deserialize(astral::make_c_array(corrupt)) == astral::routine_fail,
+          "truncated data rejected");
+
+    /* the original data still reads after the failures */
+    check(restored.deserialize(astral::make_c_array(bytes)) == astral::routine_success,
+          "uncorrupted data accepted");
+  }
+
+  void
+  test_corrupt_source_tags(void)
+  {
+    astral::Path path, restored;
+    std::vector<uint8_t> bytes, corrupt;
+    int tags_offset;
+
+    /* matches the layout of ContourApproximator::SourceTag */
+    struct Tag
+    {
+      int32_t m_source_curve;
+      float m_begin, m_end;
+    };
+
+    std::cout << "Corrupt source tags fail to deserialize:\n";
+
+    build_polygon(&path);
+    serialize(path, &bytes);
+
+    /* the approximation of each line segment is itself, so
+     * the tags are {i, [0, 1]} for each curve i.
+     */
+    std::vector<Tag> tags(path.contour(0).number_curves());
+    for (unsigned int i = 0; i < tags.size(); ++i)
+      {
+        tags[i].m_source_curve = i;
+        tags[i].m_begin = 0.0f;
+        tags[i].m_end = 1.0f;
+      }
+
+    tags_offset = find_bytes(bytes, &tags[0], sizeof(Tag) * tags.size());
+    check(tags_offset >= 0, "located serialized source tags");
+    if (tags_offset < 0)
+      {
+        return;
+      }
+
+    corrupt = bytes;
+    tags[0].m_source_curve = tags.size();
+    std::memcpy(&corrupt[tags_offset], &tags[0], sizeof(Tag));
+    check(restored.deserialize(astral::make_c_array(corrupt)) == astral::routine_fail,
+          "source curve past the last curve rejected");
+
+    corrupt = bytes;
+    tags[0].m_source_curve = -1;
+    std::memcpy(&corrupt[tags_offset], &tags[0], sizeof(Tag));
+    check(restored.deserialize(astral::make_c_array(corrupt)) == astral::routine_fail,
+          "negative source curve rejected");
+
+    corrupt = bytes;
+    tags[0].m_source_curve = 0;
+    tags[0].m_end = 2.0f;
+    std::memcpy(&corrupt[tags_offset], &tags[0], sizeof(Tag));
+    check(restored.deserialize(astral::make_c_array(corrupt)) == astral::routine_fail,
+          "source range outside of [0, 1] rejected");
+  }
+
+  unsigned int m_failures;
+  std::vector<float> m_tolerances;
+};
+
+int
+main(int argc, char **argv)
+{
+  TestOptions options;
+
+  if (argc == 2 && options.is_help_request(argv[1]))
+    {
+      std::cout << "\n\nUsage: " << argv[0];
+      options.print_help(std::cout);
+      options.print_detailed_help(std::cout);
+      return 0;
+    }
+
+  std::cout << "\n\nRunning: \"";
+  for(int i = 0; i < argc; ++i)
+    {
+      std::cout << argv[i] << " ";
+    }
+
+  options.parse_command_line(argc, argv);
+  std::cout << "\n\n" << std::flush;
+
+  Tester tester(options);
+  return tester.run_tests();
+}
@@ -0,0 +1,425 @@
+/*!
+ * \file main.cpp
+ * \brief main.cpp
+ *
+ * Copyright 2020 by InvisionApp.
+ *
+ * Contact kevinrogovin@invisionapp.com
+ *
+ * This Source Code Form is subject to the
+ * terms of the Mozilla Public License, v. 2.0.
+ * If a copy of the MPL was not distributed with
+ * this file, You can obtain one at
+ * http://mozilla.org/MPL/2.0/.
+ *
+ */
+
+#include <iostream>
+#include <vector>
+#include <random>
+#include <cmath>
+#include <SDL.h>
+#include <astral/path.hpp>
+#include <astral/util/ostream_utility.hpp>
+
+#include "generic_command_line.hpp"
+
+class TestOptions:public command_line_register
+{
+public:
+  TestOptions(void):
+    m_random_seed(std::mt19937::default_seed, "random_seed", "seed for the random paths and query points", *this),
+    m_number_paths(20, "number_paths", "number of random paths to test", *this),
+    m_grid_size(24, "grid_size", "vertices are on an integer grid of this size", *this)
+  {}
+
+  command_line_argument_value<unsigned int> m_random_seed;
+  command_line_argument_value<unsigned int> m_number_paths;
+  command_line_argument_value<unsigned int> m_grid_size;
+};
+
+/* A contour given as a polyline; the reference values are
+ * computed directly against its segments.
+ */
+class ReferenceContour
+{
+public:
+  std::vector<astral::vec2> m_pts;
+  bool m_closed;
+};
+
+class Tester
+{
+public:
+  explicit
+  Tester(const TestOptions &options):
+    m_options(options),
+    m_generator(options.m_random_seed.value()),
+    m_failures(0)
+  {}
+
+  int
+  run_tests(void)
+  {
+    test_polygons();
+    test_curved_tolerances();
+
+    std::cout << m_failures << " failures\n";
+    return (m_failures == 0) ? 0 : -1;
+  }
+
+private:
+  void
+  check(bool v, const char *what)
+  {
+    std::cout << "\t" << what << ": " << ((v) ? "pass" : "FAIL") << "\n";
+    if (!v)
+      {
+        ++m_failures;
+      }
+  }
+
+  /* The distances computed by astral::Path are L1 distances; the L1
+   * distance from p to a segment is attained at an end point of the
+   * segment or where the segment crosses the vertical or horizontal
+   * line through p.
+   */
+  static
+  float
+  distance_to_segment(const astral::vec2 &p, const astral::vec2 &a, const astral::vec2 &b)
+  {
+    astral::vec2 d(b - a);
+    float return_value;
+
+    return_value = astral::t_min((p - a).L1norm(), (p - b).L1norm());
+    for (unsigned int c = 0; c < 2u; ++c)
+      {
+        if (d[c] != 0.0f)
+          {
+            float t;
+
+            t = (p[c] - a[c]) / d[c];
+            if (t >= 0.0f && t <= 1.0f)
+              {
+                return_value = astral::t_min(return_value, (p - a - t * d).L1norm());
+              }
+          }
+      }
+
+    return return_value;
+  }
+
+  /* winding number of the closed polyline around p with
+   * the half-open rule so that a ray through a vertex
+   * is counted once.
+   */
+  static
+  int
+  winding_number(const astral::vec2 &p, const std::vector<astral::vec2> &pts)
+  {
+    int w(0);
+
+    for (unsigned int i = 0; i < pts.size(); ++i)
+      {
+        const astral::vec2 &a(pts[i]), &b(pts[(i + 1u) % pts.size()]);
+        float cross;
+
+        cross = (b.x() - a.x()) * (p.y() - a.y()) - (p.x() - a.x()) * (b.y() - a.y());
+        if (a.y() <= p.y() && b.y() > p.y() && cross > 0.0f)
+          {
+            ++w;
+          }
+        else if (a.y() > p.y() && b.y() <= p.y() && cross < 0.0f)
+          {
+            --w;
+          }
+      }
+
+    return w;
+  }
+
+  /* out_distance is the distance to the path, out_boundary_distance
+   * also includes the closing edges of open contours, i.e. the
+   * distance to the boundary of the region whose winding number
+   * is out_winding.
+   */
+  static
+  void
+  reference_query(const astral::vec2 &p, const std::vector<ReferenceContour> &contours,
+                  float *out_distance, float *out_boundary_distance, int *out_winding)
+  {
+    float D(-1.0f), B(-1.0f);
+    int w(0);
+
+    for (const ReferenceContour &C : contours)
+      {
+        for (unsigned int i = 0; i < C.m_pts.size(); ++i)
+          {
+            float d;
+
+            d = distance_to_segment(p, C.m_pts[i], C.m_pts[(i + 1u) % C.m_pts.size()]);
+            B = (B < 0.0f) ? d : astral::t_min(B, d);
+            if (C.m_closed || i + 1u < C.m_pts.size())
+              {
+                D = (D < 0.0f) ? d : astral::t_min(D, d);
+              }
+          }
+
+        /* open contours are implicitly closed for the winding number */
+        w += winding_number(p, C.m_pts);
+      }
+
+    *out_distance = D;
+    *out_boundary_distance = B;
+    *out_winding = w;
+  }
+
+  astral::vec2
+  random_grid_point(void)
+  {
+    std::uniform_int_distribution<int> dist(0, m_options.m_grid_size.value());
+    return astral::vec2(dist(m_generator), dist(m_generator));
+  }
+
+  /* query points: a grid at half-integer steps, so that many of
+   * them have an x or y equal to that of a vertex, together with
+   * every vertex shifted along only one axis.
+   */
+  std::vector<astral::vec2>
+  query_points(const std::vector<ReferenceContour> &contours)
+  {
+    std::vector<astral::vec2> return_value;
+    float g(m_options.m_grid_size.value());
+
+    for (float y = -1.0f; y <= g + 1.0f; y += 0.5f)
+      {
+        for (float x = -1.0f; x <= g + 1.0f; x += 0.5f)
+          {
+            return_value.push_back(astral::vec2(x, y));
+          }
+      }
+
+    for (const ReferenceContour &C : contours)
+      {
+        for (const astral::vec2 &p : C.m_pts)
+          {
+            return_value.push_back(p + astral::vec2(0.0f, 0.25f));
+            return_value.push_back(p - astral::vec2(0.0f, 0.25f));
+            return_value.push_back(p + astral::vec2(0.25f, 0.0f));
+            return_value.push_back(p - astral::vec2(0.25f, 0.0f));
+          }
+      }
+
+    return return_value;
+  }
+
+  void
+  compare(const astral::Path &path, float tol, const std::vector<ReferenceContour> &contours,
+          float distance_slack, unsigned int *distance_mismatches,
+          unsigned int *winding_mismatches, unsigned int *inside_mismatches,
+          unsigned int *batch_mismatches)
+  {
+    std::vector<astral::vec2> pts(query_points(contours));
+    std::vector<astral::Path::PointQueryResult> batched(pts.size());
+
+    path.distance_to_path(tol, astral::make_c_array(pts), astral::make_c_array(batched));
+    for (unsigned int i = 0; i < pts.size(); ++i)
+      {
+        astral::Path::PointQueryResult R;
+        float ref_distance, ref_boundary_distance;
+        int ref_winding, w;
+
+        reference_query(pts[i], contours, &ref_distance, &ref_boundary_distance, &ref_winding);
+        R = path.distance_to_path(tol, pts[i]);
+        if (std::abs(R.m_distance - ref_distance) > distance_slack)
+          {
+            ++*distance_mismatches;
+          }
+
+        if (batched[i].m_distance != R.m_distance)
+          {
+            ++*batch_mismatches;
+          }
+
+        /* the winding number is not defined on the boundary */
+        if (ref_boundary_distance <= distance_slack)
+          {
+            continue;
+          }
+
+        w = path.winding_number(tol, pts[i]);
+        if (w != ref_winding)
+          {
+            ++*winding_mismatches;
+          }
+
+        for (unsigned int f = 0; f < astral::number_fill_rule; ++f)
+          {
+            enum astral::fill_rule_t fill_rule(static_cast<enum astral::fill_rule_t>(f));
+            if (path.inside(tol, pts[i], fill_rule) != astral::apply_fill_rule(fill_rule, ref_winding))
+              {
+                ++*inside_mismatches;
+              }
+          }
+      }
+  }
+
+  void
+  test_polygons(void)
+  {
+    unsigned int distance_mismatches(0), winding_mismatches(0);
+    unsigned int inside_mismatches(0), batch_mismatches(0);
+    std::uniform_int_distribution<int> num_contours(1, 3), num_pts(3, 9), closed(0, 3);
+
+    std::cout << "Polygons against brute force:\n";
+    for (unsigned int n = 0; n < m_options.m_number_paths.value(); ++n)
+      {
+        std::vector<ReferenceContour> contours(num_contours(m_generator));
+        astral::Path path;
+
+        for (ReferenceContour &C : contours)
+          {
+            C.m_pts.resize(num_pts(m_generator));
+            C.m_closed = (closed(m_generator) != 0);
+            for (astral::vec2 &p : C.m_pts)
+              {
+                p = random_grid_point();
+              }
+
+            /* also make vertical and horizontal edges */
+            C.m_pts[1].x() = C.m_pts[0].x();
+            C.m_pts[2].y() = C.m_pts[1].y();
+
+            path.move(C.m_pts[0]);
+            for (unsigned int i = 1; i < C.m_pts.size(); ++i)
+              {
+                path.line_to(C.m_pts[i]);
+              }
+
+            if (C.m_closed)
+              {
+                path.close();
+              }
+          }
+
+        compare(path, 1e-3f, contours, 1e-3f, &distance_mismatches,
+                &winding_mismatches, &inside_mismatches, &batch_mismatches);
+      }
+
+    check(distance_mismatches == 0u, "distance_to_path");
+    check(batch_mismatches == 0u, "batched distance_to_path");
+    check(winding_mismatches == 0u, "winding_number");
+    check(inside_mismatches == 0u, "inside");
+  }
+
+  /* For curved geometry, the L1 distance computed is that of the end
+   * points and the crossings of the axis-aligned lines through the
+   * query point, so it is compared against a linear scan over the
+   * curves of each contour; the winding number is compared against a
+   * dense polyline of the curve away from the curve.
+   */
+  void
+  test_curved_tolerances(void)
+  {
+    unsigned int distance_mismatches(0), winding_mismatches(0), inside_mismatches(0);
+    std::vector<ReferenceContour> contours(1);
+    const unsigned int num_samples(4096);
+    astral::vec2 p0(2.0f, 2.0f), c(12.0f, 30.0f), p1(22.0f, 2.0f);
+    std::vector<float> tolerances;
+    astral::Path path;
+
+    std::cout << "Curved path over many tolerances:\n";
+
+    path.move(p0).quadratic_to(c, p1).close();
+    contours[0].m_closed = true;
+    for (unsigned int i = 0; i <= num_samples; ++i)
+      {
+        float t(float(i) / float(num_samples)), s(1.0f - t);
+        contours[0].m_pts.push_back(s * s * p0 + 2.0f * s * t * c + t * t * p1);
+      }
+
+    /* request ever finer tolerances and then the coarse ones again
+     * so that the cached hierarchies are both made and reused.
+     */
+    for (float tol = 0.5f; tol > 1e-3f; tol *= 0.5f)
+      {
+        tolerances.push_back(tol);
+      }
+    tolerances.push_back(0.5f);
+    tolerances.push_back(0.1f);
+
+    for (float tol : tolerances)
+      {
+        for (const astral::vec2 &pt : query_points(contours))
+          {
+            astral::Path::PointQueryResult R, S;
+            float ref_distance, ref_boundary_distance;
+            int ref_winding;
+
+            for (unsigned int i = 0; i < path.number_contours(); ++i)
+              {
+                S.absorb(i, path.contour(i).distance_to_contour(tol, pt));
+              }
+
+            R = path.distance_to_path(tol, pt);
+            if (R.m_distance != S.m_distance || R.m_winding_impact != S.m_winding_impact)
+              {
+                ++distance_mismatches;
+              }
+
+            /* the dense polyline is within 1e-3 of the curve, the
+             * approximation used by the query within tol.
+             */
+            reference_query(pt, contours, &ref_distance, &ref_boundary_distance, &ref_winding);
+            if (ref_boundary_distance <= 2.0f * (tol + 1e-3f))
+              {
+                continue;
+              }
+
+            if (path.winding_number(tol, pt) != ref_winding)
+              {
+                ++winding_mismatches;
+              }
+
+            if (path.inside(tol, pt, astral::nonzero_fill_rule) != (ref_winding != 0))
+              {
+                ++inside_mismatches;
+              }
+          }
+      }
+
+    check(distance_mismatches == 0u, "distance_to_path matches linear scan of contours");
+    check(winding_mismatches == 0u, "winding_number away from the path");
+    check(inside_mismatches == 0u, "inside away from the path");
+  }
+
+  const TestOptions &m_options;
+  std::mt19937 m_generator;
+  unsigned int m_failures;
+};
+
+int
+main(int argc, char **argv)
+{
+  TestOptions options;
+
+  if (argc == 2 && options.is_help_request(argv[1]))
+    {
+      std::cout << "\n\nUsage: " << argv[0];
+      options.print_help(std::cout);
+      options.print_detailed_help(std::cout);
+      return 0;
+    }
+
+  std::cout << "\n\nRunning: \"";
+  for(int i = 0; i < argc; ++i)
+    {
+      std::cout << argv[i] << " ";
+    }
+
+  options.parse_command_line(argc, argv);
+  std::cout << "\n\n" << std::flush;
+
+  Tester tester(options);
+  return tester.run_tests();
+}
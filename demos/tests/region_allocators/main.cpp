@@ -16,6 +16,9 @@
 
 #include <random>
 #include <vector>
+#include <cstring>
+#include <algorithm>
+#include <iostream>
 #include <SDL.h>
 #include <astral/util/tile_allocator.hpp>
 #include <astral/util/layered_rect_atlas.hpp>
@@ -258,6 +261,227 @@ private:
   astral::uvec2 m_log2_max_tile_size;
 };
 
+/* Checks of the layer accounting, layer limit and layer
+ * shrinking of TileAllocator; these need no window and are
+ * run by passing "layer_checks" as the only argument.
+ */
+class TileAllocatorLayerChecks
+{
+public:
+  static
+  unsigned int
+  run(void)
+  {
+    TileAllocatorLayerChecks C;
+
+    C.check_accounting_and_release_all();
+    C.check_preferred_layer_limit();
+    C.check_shrink_layers();
+
+    std::cout << C.m_failures << " failures\n";
+    return C.m_failures;
+  }
+
+private:
+  enum
+    {
+      log2_tile = 6,
+      tile_space = (1u << log2_tile) * (1u << log2_tile),
+      tiles_per_layer = 4,
+    };
+
+  TileAllocatorLayerChecks(void):
+    m_failures(0u)
+  {}
+
+  void
+  check(bool v, const char *what)
+  {
+    std::cout << "\t" << what << ": " << ((v) ? "pass" : "FAIL") << "\n";
+    if (!v)
+      {
+        ++m_failures;
+      }
+  }
+
+  /* each layer holds exactly tiles_per_layer tiles of size 2^log2_tile */
+  static
+  astral::TileAllocator*
+  create_allocator(unsigned int number_layers)
+  {
+    return ASTRALnew astral::TileAllocator(log2_tile, astral::uvec2(2u, 2u), number_layers);
+  }
+
+  /* returns true if space_allocated(L) matches the sum
+   * of the sizes of the tiles of tiles on layer L for
+   * each layer L and if space_allocated() is the total
+   */
+  static
+  bool
+  accounting_matches(const astral::TileAllocator &allocator,
+                     const std::vector<const astral::TileAllocator::Tile*> &tiles)
+  {
+    std::vector<unsigned int> expected(allocator.number_layers(), 0u);
+    unsigned int total(0u);
+
+    for (const astral::TileAllocator::Tile *t : tiles)
+      {
+        unsigned int sz;
+
+        sz = (1u << t->log2_size().x()) * (1u << t->log2_size().y());
+        expected[t->location().z()] += sz;
+        total += sz;
+      }
+
+    for (unsigned int L = 0; L < expected.size(); ++L)
+      {
+        if (expected[L] != allocator.space_allocated(L))
+          {
+            return false;
+          }
+      }
+
+    return total == allocator.space_allocated();
+  }
+
+  void
+  check_accounting_and_release_all(void)
+  {
+    astral::TileAllocator *allocator(create_allocator(3u));
+    std::vector<const astral::TileAllocator::Tile*> tiles;
+    bool all_zero(true);
+
+    std::cout << "Per-layer accounting and release_all():\n";
+    for (unsigned int i = 0; i < 2u * tiles_per_layer; ++i)
+      {
+        tiles.push_back(allocator->allocate_tile(log2_tile, log2_tile));
+      }
+    for (unsigned int i = 0; i < 8u; ++i)
+      {
+        tiles.push_back(allocator->allocate_tile(log2_tile - 2, log2_tile - 1));
+      }
+    check(std::find(tiles.begin(), tiles.end(), nullptr) == tiles.end(), "all allocations succeeded");
+    check(accounting_matches(*allocator, tiles), "space_allocated(layer) matches after allocating");
+
+    allocator->release_tile(tiles[1]);
+    allocator->release_tile(tiles.back());
+    tiles.erase(tiles.begin() + 1);
+    tiles.pop_back();
+    check(accounting_matches(*allocator, tiles), "space_allocated(layer) matches after releasing");
+
+    allocator->release_all();
+    tiles.clear();
+    for (unsigned int L = 0; L < allocator->number_layers(); ++L)
+      {
+        all_zero = all_zero && allocator->space_allocated(L) == 0u;
+      }
+    check(all_zero && allocator->space_allocated() == 0u, "space_allocated(layer) is zero after release_all()");
+
+    for (unsigned int i = 0; i < 3u * tiles_per_layer; ++i)
+      {
+        tiles.push_back(allocator->allocate_tile(log2_tile, log2_tile));
+      }
+    check(std::find(tiles.begin(), tiles.end(), nullptr) == tiles.end(),
+          "every layer is usable again after release_all()");
+    check(accounting_matches(*allocator, tiles), "space_allocated(layer) matches after release_all() and reallocating");
+
+    ASTRALdelete(allocator);
+  }
+
+  void
+  check_preferred_layer_limit(void)
+  {
+    astral::TileAllocator *allocator(create_allocator(2u));
+    std::vector<const astral::TileAllocator::Tile*> tiles;
+    const astral::TileAllocator::Tile *t;
+    bool below_limit(true);
+
+    std::cout << "Preferred layer limit:\n";
+    allocator->preferred_layer_limit(1u);
+    for (unsigned int i = 0; i < tiles_per_layer; ++i)
+      {
+        tiles.push_back(allocator->allocate_tile(log2_tile, log2_tile));
+        below_limit = below_limit && tiles.back() && tiles.back()->location().z() == 0u;
+      }
+    check(below_limit, "tiles are placed below the limit while there is room");
+
+    t = allocator->allocate_tile(log2_tile, log2_tile);
+    check(t && t->location().z() == 1u, "a tile is placed at the limit once there is no room below it");
+    tiles.push_back(t);
+
+    /* free a tile below the limit, smaller tiles must now come
+     * from it rather than from the remaining room at the limit
+     */
+    allocator->release_tile(tiles[2]);
+    tiles.erase(tiles.begin() + 2);
+    below_limit = true;
+    for (unsigned int i = 0; i < 4u; ++i)
+      {
+        tiles.push_back(allocator->allocate_tile(log2_tile - 1, log2_tile - 1));
+        below_limit = below_limit && tiles.back() && tiles.back()->location().z() == 0u;
+      }
+    check(below_limit, "space freed below the limit is preferred over space at the limit");
+    check(accounting_matches(*allocator, tiles), "space_allocated(layer) matches with a limit");
+
+    allocator->preferred_layer_limit(~0u);
+    ASTRALdelete(allocator);
+  }
+
+  void
+  check_shrink_layers(void)
+  {
+    astral::TileAllocator *allocator(create_allocator(3u));
+    std::vector<const astral::TileAllocator::Tile*> tiles, kept;
+    const astral::TileAllocator::Tile *t;
+
+    std::cout << "Shrinking layers:\n";
+    for (unsigned int i = 0; i < 3u * tiles_per_layer; ++i)
+      {
+        tiles.push_back(allocator->allocate_tile(log2_tile, log2_tile));
+      }
+
+    /* release everything on the last two layers */
+    for (const astral::TileAllocator::Tile *p : tiles)
+      {
+        if (p->location().z() == 0u)
+          {
+            kept.push_back(p);
+          }
+        else
+          {
+            allocator->release_tile(p);
+          }
+      }
+    check(allocator->space_allocated(1u) == 0u && allocator->space_allocated(2u) == 0u,
+          "trailing layers are empty");
+
+    allocator->number_layers(1u);
+    check(allocator->number_layers() == 1u, "number_layers() shrinks");
+    check(accounting_matches(*allocator, kept), "space_allocated(layer) matches after shrinking");
+
+    t = allocator->allocate_tile(log2_tile, log2_tile);
+    check(t == nullptr, "no tile is allocated from a removed layer");
+
+    allocator->number_layers(2u);
+    t = allocator->allocate_tile(log2_tile, log2_tile);
+    check(t && t->location().z() == 1u, "a re-added layer is usable");
+    kept.push_back(t);
+
+    for (unsigned int i = 1; i < tiles_per_layer; ++i)
+      {
+        kept.push_back(allocator->allocate_tile(log2_tile, log2_tile));
+      }
+    check(std::find(kept.begin(), kept.end(), nullptr) == kept.end()
+          && allocator->allocate_tile(log2_tile, log2_tile) == nullptr,
+          "a re-added layer holds exactly its tiles");
+    check(accounting_matches(*allocator, kept), "space_allocated(layer) matches after growing");
+
+    ASTRALdelete(allocator);
+  }
+
+  unsigned int m_failures;
+};
+
 class RegionAllocatorTest:public render_engine_gl3_demo
 {
 public:
@@ -396,7 +620,10 @@ RegionAllocatorTest(void):
             << "\n\t\tctrl: multiply request by 100"
             << "\n\t\talt: multiply request by 1000"
             << "\n\tt: run a perf test of allocating and releasing many regions"
-            << "\n\tc: release all regions";
+            << "\n\tk: run the checks of the layer handling of TileAllocator"
+            << "\n\tc: release all regions"
+            << "\nPassing layer_checks as the only argument runs the checks of the "
+            << "layer handling of TileAllocator and exits\n";
 }
 
 RegionAllocatorTest::
@@ -902,6 +1129,10 @@ handle_event(const SDL_Event &ev)
             }
           break;
 
+        case SDLK_k:
+          TileAllocatorLayerChecks::run();
+          break;
+
         case SDLK_c:
           {
             clear();
@@ -1042,6 +1273,11 @@ draw_hud(astral::RenderEncoderSurface encoder)
 int
 main(int argc, char **argv)
 {
+  if (argc == 2 && std::strcmp(argv[1], "layer_checks") == 0)
+    {
+      return (TileAllocatorLayerChecks::run() == 0u) ? 0 : -1;
+    }
+
   RegionAllocatorTest M;
   return M.main(argc, argv);
 }
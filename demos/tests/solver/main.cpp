@@ -15,9 +15,13 @@
  */
 #include <iostream>
 #include <random>
+#include <vector>
+#include <cstring>
+#include <cmath>
 #include <algorithm>
 #include <SDL.h>
 #include <astral/util/polynomial.hpp>
+#include <astral/util/polynomial_batch.hpp>
 #include <astral/util/ostream_utility.hpp>
 
 #include "generic_command_line.hpp"
@@ -126,6 +130,11 @@ public:
     m_num_test4_two_double_roots(10, "num_test4_two_double_roots",
                                  "Number of tests to run on quartic solver where there two double roots",
                                  *this),
+    m_num_batch_tests(1000, "num_batch_tests",
+                      "Number of polynomials on which to check that the batched solvers "
+                      "solve_quadratic_batch() and solve_cubic_batch() give exactly the "
+                      "same roots as solve_quadratic() and solve_cubic()",
+                      *this),
     m_dist_min(-10.0f, "dist_min", "Minimum randome value to feed to solvers", *this),
     m_dist_max(10.0f, "dist_max", "Maximum randome value to feed to solvers", *this),
     m_accuracy(float_accuracy,
@@ -146,6 +155,7 @@ public:
   command_line_argument_value<int> m_num_test4_no_roots;
   command_line_argument_value<int> m_num_test4_two_roots;
   command_line_argument_value<int> m_num_test4_two_double_roots;
+  command_line_argument_value<int> m_num_batch_tests;
   command_line_argument_value<float> m_dist_min;
   command_line_argument_value<float> m_dist_max;
   enumerated_command_line_argument_value<enum accuracy_t> m_accuracy;
@@ -512,6 +522,142 @@ private:
   }
 };
 
+/* Checks that the batched solvers give exactly the same results
+ * as the scalar solvers; the random coefficients are often snapped
+ * to small integers or zero so that the degenerate cases (zero
+ * leading coefficients, multiple roots, exactly zero discriminant)
+ * are exercised.
+ */
+class BatchTester
+{
+public:
+  template<typename Distribution, typename Engine>
+  static
+  void
+  run_tests(unsigned int num, Distribution &dist, Engine &e)
+  {
+    if (num == 0)
+      {
+        return;
+      }
+
+    std::vector<astral::vecN<float, 3>> Q(num);
+    std::vector<astral::vecN<float, 4>> P(num);
+    std::vector<float> values(num);
+    std::vector<astral::vecN<float, 2>> quad_roots(num);
+    std::vector<astral::vecN<float, 3>> cubic_roots(num);
+    std::vector<unsigned int> counts(num);
+    unsigned int quad_fails(0), cubic_fails(0);
+    float v;
+
+    for (unsigned int i = 0; i < num; ++i)
+      {
+        for (unsigned int k = 0; k < 3; ++k)
+          {
+            Q[i][k] = BatchTester::coefficient(dist, e);
+          }
+        for (unsigned int k = 0; k < 4; ++k)
+          {
+            P[i][k] = BatchTester::coefficient(dist, e);
+          }
+        values[i] = BatchTester::coefficient(dist, e);
+      }
+    v = values[0];
+
+    std::cout << "Test batched solvers (" << astral::detail::polynomial_batch_instruction_set() << "):\n";
+
+    astral::detail::solve_quadratic_batch(astral::make_c_array(Q), v,
+                                          astral::make_c_array(quad_roots),
+                                          astral::make_c_array(counts));
+    for (unsigned int i = 0; i < num; ++i)
+      {
+        quad_fails += !BatchTester::check_quadratic(Q[i], v, quad_roots[i], counts[i]);
+      }
+
+    astral::detail::solve_quadratic_batch(Q[0], astral::make_c_array(values),
+                                          astral::make_c_array(quad_roots),
+                                          astral::make_c_array(counts));
+    for (unsigned int i = 0; i < num; ++i)
+      {
+        quad_fails += !BatchTester::check_quadratic(Q[0], values[i], quad_roots[i], counts[i]);
+      }
+
+    astral::detail::solve_cubic_batch(astral::make_c_array(P), v,
+                                      astral::make_c_array(cubic_roots),
+                                      astral::make_c_array(counts));
+    for (unsigned int i = 0; i < num; ++i)
+      {
+        cubic_fails += !BatchTester::check_cubic(P[i], v, cubic_roots[i], counts[i]);
+      }
+
+    astral::detail::solve_cubic_batch(P[0], astral::make_c_array(values),
+                                      astral::make_c_array(cubic_roots),
+                                      astral::make_c_array(counts));
+    for (unsigned int i = 0; i < num; ++i)
+      {
+        cubic_fails += !BatchTester::check_cubic(P[0], values[i], cubic_roots[i], counts[i]);
+      }
+
+    std::cout << "\tquadratic mismatches: " << quad_fails << " of " << 2u * num << "\n"
+              << "\tcubic mismatches: " << cubic_fails << " of " << 2u * num << "\n\n";
+  }
+
+private:
+  template<typename Distribution, typename Engine>
+  static
+  float
+  coefficient(Distribution &dist, Engine &e)
+  {
+    float r(dist(e));
+
+    switch (e() % 4u)
+      {
+      case 0:
+        return 0.0f;
+      case 1:
+        return std::floor(r);
+      default:
+        return r;
+      }
+  }
+
+  template<size_t N>
+  static
+  bool
+  same_roots(unsigned int expected_count, const astral::vecN<float, N> &expected,
+             unsigned int count, const astral::vecN<float, N> &roots)
+  {
+    return expected_count == count
+      && 0 == std::memcmp(expected.c_ptr(), roots.c_ptr(), count * sizeof(float));
+  }
+
+  static
+  bool
+  check_quadratic(astral::vecN<float, 3> Q, float v,
+                  const astral::vecN<float, 2> &roots, unsigned int count)
+  {
+    astral::vecN<float, 2> expected;
+    unsigned int expected_count;
+
+    Q[0] -= v;
+    expected_count = astral::solve_quadratic<float>(Q, expected);
+    return same_roots(expected_count, expected, count, roots);
+  }
+
+  static
+  bool
+  check_cubic(astral::vecN<float, 4> P, float v,
+              const astral::vecN<float, 3> &roots, unsigned int count)
+  {
+    astral::vecN<float, 3> expected;
+    unsigned int expected_count;
+
+    P[0] -= v;
+    expected_count = astral::solve_cubic<float>(P, expected);
+    return same_roots(expected_count, expected, count, roots);
+  }
+};
+
 int
 main(int argc, char **argv)
 {
@@ -561,5 +707,7 @@ main(int argc, char **argv)
       break;
     }
 
+  BatchTester::run_tests(options.m_num_batch_tests.value(), dist, rd);
+
   return 0;
 }
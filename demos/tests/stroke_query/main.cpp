@@ -0,0 +1,467 @@
+/*!
+ * \file main.cpp
+ * \brief main.cpp
+ *
+ * Copyright 2020 by InvisionApp.
+ *
+ * Contact kevinrogovin@invisionapp.com
+ *
+ * This Source Code Form is subject to the
+ * terms of the Mozilla Public License, v. 2.0.
+ * If a copy of the MPL was not distributed with
+ * this file, You can obtain one at
+ * http://mozilla.org/MPL/2.0/.
+ *
+ */
+#include <string>
+#include <sstream>
+#include <fstream>
+#include <iostream>
+#include <vector>
+#include <algorithm>
+
+#include <astral/path.hpp>
+#include <astral/renderer/shader/stroke_shader.hpp>
+#include <astral/renderer/shader/stroke_query.hpp>
+#include <astral/util/thread_pool.hpp>
+
+#include "command_line_list.hpp"
+#include "render_engine_gl3_demo.hpp"
+#include "read_path.hpp"
+#include "simple_time.hpp"
+
+typedef astral::detail::StrokeQueryCullingTest CullingTest;
+
+/* Benchmark of astral::StrokeQuery: for each path, the path
+ * is queried at several zoom levels over a grid of offsets
+ * and the time per query is printed along with how many
+ * nodes and leaves of the hierarchy were visited. This is
+ * done for each StrokeShader::hierarchy_builder_t so that
+ * the builders can be compared, along with the time it
+ * took to build each hierarchy. Unless disabled, each
+ * query is also checked to give the same
+ * child boxes and results with SIMD culling as without;
+ * the test exits with a non-zero value on a mismatch.
+ */
+class StrokeQueryTest:public render_engine_gl3_demo
+{
+public:
+  StrokeQueryTest(void);
+
+protected:
+  virtual
+  void
+  draw_frame(void) override;
+
+private:
+  class PathFileList:public command_line_list_loader<std::string>
+  {
+  public:
+    PathFileList(const std::string &nm,
+                 const std::string &desc,
+                 command_line_register &p):
+      command_line_list_loader<std::string>(nm, desc, p)
+    {}
+
+  private:
+    virtual
+    enum astral::return_code
+    load_element(const std::string &filename, std::string *out_value) override
+    {
+      std::ifstream file(filename.c_str());
+      std::ostringstream str;
+
+      if (!file)
+        {
+          return astral::routine_fail;
+        }
+
+      str << file.rdbuf();
+      *out_value = str.str();
+
+      return astral::routine_success;
+    }
+  };
+
+  class Stats
+  {
+  public:
+    Stats(void):
+      m_build_us(0),
+      m_queries(0u),
+      m_time_us(0),
+      m_nodes_visited(0u),
+      m_leaves_visited(0u),
+      m_rects(0u)
+    {}
+
+    void
+    add(const Stats &obj)
+    {
+      m_build_us += obj.m_build_us;
+      m_queries += obj.m_queries;
+      m_time_us += obj.m_time_us;
+      m_nodes_visited += obj.m_nodes_visited;
+      m_leaves_visited += obj.m_leaves_visited;
+      m_rects += obj.m_rects;
+    }
+
+    void
+    print(std::ostream &str) const
+    {
+      str << "build = " << static_cast<float>(m_build_us) / 1000.0f << " ms, "
+          << m_queries << " queries in "
+          << static_cast<float>(m_time_us) / 1000.0f << " ms ("
+          << static_cast<float>(m_time_us) / static_cast<float>(astral::t_max(1u, m_queries))
+          << " us/query), nodes visited = " << m_nodes_visited
+          << ", leaves visited = " << m_leaves_visited
+          << ", rects = " << m_rects;
+    }
+
+    int64_t m_build_us;
+    unsigned int m_queries;
+    int64_t m_time_us;
+    unsigned int m_nodes_visited, m_leaves_visited, m_rects;
+  };
+
+  /* Calls f(translate, scale) for each of the query views of a path */
+  template<typename F>
+  void
+  for_each_view(const astral::BoundingBox<float> &path_bb, const F &f);
+
+  void
+  run_query(const astral::StrokeShader::CookedData &cooked,
+            const astral::vec2 &translate, float scale);
+
+  Stats
+  run_queries(const astral::StrokeShader::CookedData &cooked,
+              const astral::BoundingBox<float> &path_bb);
+
+  /* Returns the number of queries where the SIMD culling gave
+   * different child boxes or results than scalar culling.
+   */
+  unsigned int
+  check_queries(const astral::StrokeShader::CookedData &cooked,
+                const astral::BoundingBox<float> &path_bb);
+
+  PathFileList m_paths;
+  command_line_argument_value<float> m_tol;
+  command_line_argument_value<float> m_stroke_width;
+  command_line_argument_value<float> m_miter_limit;
+  command_line_argument_value<unsigned int> m_query_size;
+  command_line_argument_value<unsigned int> m_number_zoom_levels;
+  command_line_argument_value<float> m_zoom_factor;
+  command_line_argument_value<unsigned int> m_grid_size;
+  command_line_argument_value<unsigned int> m_benchmark_runs;
+  command_line_argument_value<bool> m_check_culling;
+  command_line_argument_value<unsigned int> m_builder_threads;
+
+  astral::reference_counted_ptr<astral::StrokeQuery> m_query;
+  astral::StrokeQuery::ActivePrimitives m_active_primitives;
+  astral::StrokeQuery::StrokeRadii m_radii;
+};
+
+StrokeQueryTest::
+StrokeQueryTest(void):
+  m_paths("path", "File or directory of files from which to read paths, "
+          "for example demo_data/paths", *this),
+  m_tol(1e-3, "tol", "Tolerance, relative to the bounding box of each path, "
+        "at which to approximate the path for stroking", *this),
+  m_stroke_width(4.0f, "stroke_width", "Stroking width in pixels at zoom level 0", *this),
+  m_miter_limit(5.0f, "miter_limit", "Miter limit, determines the radius about joins", *this),
+  m_query_size(2048u, "query_size", "Width and height in pixels of each query", *this),
+  m_number_zoom_levels(4u, "number_zoom_levels",
+                       "Number of zoom levels at which to query each path; zoom level 0 "
+                       "fits the path to the query", *this),
+  m_zoom_factor(4.0f, "zoom_factor", "Zoom factor between successive zoom levels", *this),
+  m_grid_size(4u, "grid_size",
+              "At each zoom level, the path is queried at a grid_size x grid_size "
+              "grid of offsets that covers the zoomed path", *this),
+  m_benchmark_runs(5u, "benchmark_runs",
+                   "Number of times to run the queries of each path, the fastest "
+                   "run is reported", *this),
+  m_check_culling(true, "check_culling",
+                  "If true, check that each query gives the same child boxes "
+                  "and results with SIMD culling as with scalar culling", *this),
+  m_builder_threads(astral::ThreadPool::default_number_threads(), "builder_threads",
+                    "Number of threads used to build the hierarchy with the SAH builder, "
+                    "0 means to build it on the calling thread", *this)
+{}
+
+template<typename F>
+void
+StrokeQueryTest::
+for_each_view(const astral::BoundingBox<float> &path_bb, const F &f)
+{
+  float query_size(m_query_size.value());
+  float base_scale, zoom(1.0f);
+  astral::vec2 path_size(path_bb.size());
+
+  base_scale = query_size / astral::t_max(path_size.x(), path_size.y());
+  for (unsigned int level = 0; level < m_number_zoom_levels.value(); ++level, zoom *= m_zoom_factor.value())
+    {
+      float scale(base_scale * zoom);
+      float step(0.0f);
+
+      if (m_grid_size.value() > 1u)
+        {
+          step = query_size * (zoom - 1.0f) / static_cast<float>(m_grid_size.value() - 1u);
+        }
+
+      for (unsigned int x = 0; x < m_grid_size.value(); ++x)
+        {
+          for (unsigned int y = 0; y < m_grid_size.value(); ++y)
+            {
+              f(-scale * path_bb.min_point() - step * astral::vec2(x, y), scale);
+            }
+        }
+    }
+}
+
+void
+StrokeQueryTest::
+run_query(const astral::StrokeShader::CookedData &cooked,
+          const astral::vec2 &translate, float scale)
+{
+  m_query->begin_query(astral::ScaleTranslate(translate, astral::vec2(scale)),
+                       astral::ivec2(m_query_size.value()), true);
+  m_query->add_element(0, astral::Transformation(), astral::Transformation(),
+                       cooked, 0.0f, m_active_primitives, m_radii);
+  m_query->end_query(m_query_size.value());
+}
+
+StrokeQueryTest::Stats
+StrokeQueryTest::
+run_queries(const astral::StrokeShader::CookedData &cooked,
+            const astral::BoundingBox<float> &path_bb)
+{
+  Stats return_value;
+
+  for (unsigned int run = 0; run < astral::t_max(1u, m_benchmark_runs.value()); ++run)
+    {
+      simple_time timer;
+      Stats S;
+
+      timer.restart_us();
+      for_each_view(path_bb, [&](const astral::vec2 &translate, float scale)
+                    {
+                      run_query(cooked, translate, scale);
+
+                      ++S.m_queries;
+                      S.m_nodes_visited += m_query->number_nodes_visited();
+                      S.m_leaves_visited += m_query->number_leaves_visited();
+                      S.m_rects += m_query->elements().size();
+                    });
+      S.m_time_us = timer.elapsed_us();
+
+      if (run == 0u || S.m_time_us < return_value.m_time_us)
+        {
+          return_value = S;
+        }
+    }
+
+  return return_value;
+}
+
+unsigned int
+StrokeQueryTest::
+check_queries(const astral::StrokeShader::CookedData &cooked,
+              const astral::BoundingBox<float> &path_bb)
+{
+  unsigned int return_value(0u);
+
+  for_each_view(path_bb, [&](const astral::vec2 &translate, float scale)
+                {
+                  std::vector<astral::vecN<astral::range_type<int>, 2>> tiles;
+                  std::vector<unsigned int> ids;
+                  std::vector<astral::range_type<int>> ranges;
+                  std::vector<astral::uvec2> empty_tiles;
+                  unsigned int nodes, leaves, idx(0u), range_idx(0u);
+                  bool matches;
+
+                  /* record the results of the scalar culling */
+                  CullingTest::child_culling(*m_query, CullingTest::child_culling_scalar);
+                  run_query(cooked, translate, scale);
+                  nodes = m_query->number_nodes_visited();
+                  leaves = m_query->number_leaves_visited();
+                  empty_tiles.assign(m_query->empty_tiles().begin(), m_query->empty_tiles().end());
+                  for (const auto &E : m_query->elements())
+                    {
+                      tiles.push_back(E.tile_range());
+                      for (const auto &src : E.sources())
+                        {
+                          ids.push_back(src.ID());
+                          for (unsigned int P = 0; P < astral::StrokeShader::number_primitive_types; ++P)
+                            {
+                              auto R(src.vertex_ranges(static_cast<enum astral::StrokeShader::primitive_type_t>(P)));
+
+                              ids.push_back(R.size());
+                              ranges.insert(ranges.end(), R.begin(), R.end());
+                            }
+                        }
+                    }
+
+                  /* the SIMD culling with the child boxes checked against scalar */
+                  CullingTest::child_culling(*m_query, CullingTest::child_culling_checked);
+                  run_query(cooked, translate, scale);
+                  matches = (CullingTest::number_child_culling_mismatches(*m_query) == 0u)
+                    && nodes == m_query->number_nodes_visited()
+                    && leaves == m_query->number_leaves_visited()
+                    && tiles.size() == m_query->elements().size()
+                    && empty_tiles.size() == m_query->empty_tiles().size()
+                    && std::equal(empty_tiles.begin(), empty_tiles.end(), m_query->empty_tiles().begin());
+
+                  for (unsigned int e = 0; matches && e < tiles.size(); ++e)
+                    {
+                      const astral::StrokeQuery::ResultRect &E(m_query->elements()[e]);
+
+                      matches = (E.tile_range() == tiles[e]);
+                      for (const auto &src : E.sources())
+                        {
+                          matches = matches && idx < ids.size() && ids[idx++] == src.ID();
+                          for (unsigned int P = 0; matches && P < astral::StrokeShader::number_primitive_types; ++P)
+                            {
+                              auto R(src.vertex_ranges(static_cast<enum astral::StrokeShader::primitive_type_t>(P)));
+
+                              matches = idx < ids.size() && ids[idx++] == R.size();
+                              for (const auto &r : R)
+                                {
+                                  matches = matches && range_idx < ranges.size() && ranges[range_idx++] == r;
+                                }
+                            }
+                        }
+                    }
+                  matches = matches && idx == ids.size() && range_idx == ranges.size();
+
+                  if (!matches)
+                    {
+                      std::cout << "\tMismatch between SIMD and scalar culling at translate = "
+                                << translate << ", scale = " << scale << ", child box mismatches = "
+                                << CullingTest::number_child_culling_mismatches(*m_query) << "\n";
+                      ++return_value;
+                    }
+                });
+
+  CullingTest::child_culling(*m_query, CullingTest::child_culling_simd);
+  return return_value;
+}
+
+void
+StrokeQueryTest::
+draw_frame(void)
+{
+  static const enum astral::StrokeShader::hierarchy_builder_t builders[] =
+    {
+      astral::StrokeShader::midpoint_hierarchy_builder,
+      astral::StrokeShader::sah_hierarchy_builder,
+    };
+  static const char *builder_labels[] =
+    {
+      "midpoint",
+      "sah",
+    };
+  static const unsigned int number_builders = sizeof(builders) / sizeof(builders[0]);
+
+  astral::vecN<Stats, number_builders> total;
+  astral::StrokeParameters stroke_params;
+  astral::reference_counted_ptr<astral::ThreadPool> thread_pool;
+  unsigned int mismatches(0u);
+
+  if (m_builder_threads.value() > 0u)
+    {
+      thread_pool = astral::ThreadPool::create(m_builder_threads.value());
+    }
+
+  m_query = astral::StrokeQuery::create();
+  stroke_params
+    .width(m_stroke_width.value())
+    .join(astral::join_miter)
+    .cap(astral::cap_square);
+  stroke_params.m_miter_limit = m_miter_limit.value();
+  m_active_primitives = astral::StrokeQuery::ActivePrimitives(false, stroke_params, false);
+
+  if (m_paths.elements().empty())
+    {
+      std::cout << "No paths given, use for example: path demo_data/paths\n";
+    }
+
+  for (const auto &E : m_paths.elements())
+    {
+      astral::Path path;
+      astral::StrokeShader::RawData raw;
+      astral::vec2 path_size;
+      float tol, base_scale, radius;
+
+      read_path(&path, E.m_loaded_value);
+      if (path.bounding_box().empty())
+        {
+          continue;
+        }
+
+      path_size = path.bounding_box().size();
+      tol = m_tol.value() * astral::t_max(path_size.x(), path_size.y());
+      for (unsigned int c = 0, endc = path.number_contours(); c < endc; ++c)
+        {
+          float actual_tol;
+
+          raw.add_contour(path.contour(c).closed(),
+                          path.contour(c).stroke_approximated_geometry(tol, &actual_tol));
+        }
+
+      base_scale = static_cast<float>(m_query_size.value()) / astral::t_max(path_size.x(), path_size.y());
+      radius = 0.5f * m_stroke_width.value() / base_scale;
+      m_radii = astral::StrokeQuery::StrokeRadii(radius, radius * m_miter_limit.value(),
+                                                 radius * ASTRAL_SQRT2);
+
+      std::cout << E.m_filename << ": line_segments = " << raw.line_segments().size()
+                << ", biarc_curves = " << raw.biarc_curves().size() << "\n";
+
+      for (unsigned int b = 0; b < number_builders; ++b)
+        {
+          astral::StrokeShader::CookedData cooked;
+          simple_time timer;
+          int64_t build_us;
+          Stats S;
+
+          timer.restart_us();
+          astral::StrokeShader::create_render_data(engine(), raw, &cooked,
+                                                   builders[b], thread_pool.get());
+          build_us = timer.elapsed_us();
+
+          if (m_check_culling.value())
+            {
+              mismatches += check_queries(cooked, path.bounding_box());
+            }
+
+          S = run_queries(cooked, path.bounding_box());
+          S.m_build_us = build_us;
+          std::cout << "\t" << builder_labels[b] << ": ";
+          S.print(std::cout);
+          std::cout << "\n";
+
+          total[b].add(S);
+        }
+    }
+
+  for (unsigned int b = 0; b < number_builders; ++b)
+    {
+      std::cout << "Total " << builder_labels[b] << ": ";
+      total[b].print(std::cout);
+      std::cout << "\n";
+    }
+
+  if (m_check_culling.value())
+    {
+      std::cout << mismatches << " queries where SIMD and scalar culling differ\n";
+    }
+
+  m_query = nullptr;
+  end_demo((mismatches == 0u) ? 0 : -1);
+}
+
+int
+main(int argc, char **argv)
+{
+  StrokeQueryTest M;
+  return M.main(argc, argv);
+}
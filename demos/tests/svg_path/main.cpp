@@ -0,0 +1,471 @@
+/*!
+ * \file main.cpp
+ * \brief main.cpp
+ *
+ * Copyright 2020 by InvisionApp.
+ *
+ * Contact kevinrogovin@invisionapp.com
+ *
+ * This Source Code Form is subject to the
+ * terms of the Mozilla Public License, v. 2.0.
+ * If a copy of the MPL was not distributed with
+ * this file, You can obtain one at
+ * http://mozilla.org/MPL/2.0/.
+ *
+ */
+
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include <SDL.h>
+#include <astral/svg_path.hpp>
+#include <astral/util/ostream_utility.hpp>
+
+#include "generic_command_line.hpp"
+
+class TestOptions:public command_line_register
+{
+public:
+  TestOptions(void):
+    m_tolerance(1e-5f, "tolerance", "tolerance when comparing coordinates", *this)
+  {}
+
+  command_line_argument_value<float> m_tolerance;
+};
+
+/* The expected curves of a contour */
+class ExpectedContour
+{
+public:
+  explicit
+  ExpectedContour(astral::vec2 start, bool closed = false):
+    m_start(start),
+    m_closed(closed)
+  {}
+
+  ExpectedContour&
+  line_to(astral::vec2 p)
+  {
+    m_curves.push_back(Curve(astral::ContourCurve::line_segment, p));
+    return *this;
+  }
+
+  ExpectedContour&
+  quadratic_to(astral::vec2 c, astral::vec2 p)
+  {
+    m_curves.push_back(Curve(astral::ContourCurve::quadratic_bezier, p));
+    m_curves.back().m_control_pts.push_back(c);
+    return *this;
+  }
+
+  ExpectedContour&
+  cubic_to(astral::vec2 c0, astral::vec2 c1, astral::vec2 p)
+  {
+    m_curves.push_back(Curve(astral::ContourCurve::cubic_bezier, p));
+    m_curves.back().m_control_pts.push_back(c0);
+    m_curves.back().m_control_pts.push_back(c1);
+    return *this;
+  }
+
+  class Curve
+  {
+  public:
+    Curve(enum astral::ContourCurve::type_t tp, astral::vec2 end_pt):
+      m_type(tp),
+      m_end_pt(end_pt)
+    {}
+
+    enum astral::ContourCurve::type_t m_type;
+    astral::vec2 m_end_pt;
+    std::vector<astral::vec2> m_control_pts;
+  };
+
+  astral::vec2 m_start;
+  bool m_closed;
+  std::vector<Curve> m_curves;
+};
+
+class Tester
+{
+public:
+  explicit
+  Tester(const TestOptions &options):
+    m_tolerance(options.m_tolerance.value()),
+    m_failures(0)
+  {}
+
+  int
+  run_tests(void)
+  {
+    test_numbers();
+    test_arc_flags();
+    test_moveto();
+    test_commands();
+    test_error_recovery();
+
+    std::cout << m_failures << " failures\n";
+    return (m_failures == 0) ? 0 : -1;
+  }
+
+private:
+  void
+  check(bool v, const char *what)
+  {
+    std::cout << "\t" << what << ": " << ((v) ? "pass" : "FAIL") << "\n";
+    if (!v)
+      {
+        ++m_failures;
+      }
+  }
+
+  bool
+  same_point(astral::vec2 a, astral::vec2 b) const
+  {
+    return std::abs(a.x() - b.x()) <= m_tolerance
+      && std::abs(a.y() - b.y()) <= m_tolerance;
+  }
+
+  bool
+  matches(const astral::Path &path, const std::vector<ExpectedContour> &expected) const
+  {
+    if (path.number_contours() != expected.size())
+      {
+        return false;
+      }
+
+    for (unsigned int c = 0; c < expected.size(); ++c)
+      {
+        const astral::Contour &contour(path.contour(c));
+        const ExpectedContour &E(expected[c]);
+        astral::vec2 start(E.m_start);
+
+        if (contour.closed() != E.m_closed
+            || contour.number_curves() != E.m_curves.size()
+            || !same_point(contour.start(), E.m_start))
+          {
+            return false;
+          }
+
+        for (unsigned int i = 0; i < E.m_curves.size(); ++i)
+          {
+            const astral::ContourCurve &curve(contour.curve(i));
+            const ExpectedContour::Curve &e(E.m_curves[i]);
+
+            if (curve.type() != e.m_type
+                || curve.number_control_pts() != e.m_control_pts.size()
+                || !same_point(curve.start_pt(), start)
+                || !same_point(curve.end_pt(), e.m_end_pt))
+              {
+                return false;
+              }
+
+            for (unsigned int k = 0; k < e.m_control_pts.size(); ++k)
+              {
+                if (!same_point(curve.control_pt(k), e.m_control_pts[k]))
+                  {
+                    return false;
+                  }
+              }
+            start = e.m_end_pt;
+          }
+      }
+
+    return true;
+  }
+
+  /* parse d and check the return code and the curves */
+  void
+  check_parse(const char *d, enum astral::return_code expected_code,
+              const std::vector<ExpectedContour> &expected)
+  {
+    astral::Path path;
+    enum astral::return_code R;
+    std::string what;
+
+    R = astral::add_svg_path_data(d, &path);
+    what = std::string("\"") + d + "\"";
+    check(R == expected_code && matches(path, expected), what.c_str());
+  }
+
+  /* returns true if the paths have the same curves */
+  bool
+  same_curves(const astral::Path &a, const astral::Path &b) const
+  {
+    if (a.number_contours() != b.number_contours())
+      {
+        return false;
+      }
+
+    for (unsigned int c = 0; c < a.number_contours(); ++c)
+      {
+        const astral::Contour &ca(a.contour(c));
+        const astral::Contour &cb(b.contour(c));
+
+        if (ca.closed() != cb.closed() || ca.number_curves() != cb.number_curves())
+          {
+            return false;
+          }
+
+        for (unsigned int i = 0; i < ca.number_curves(); ++i)
+          {
+            const astral::ContourCurve &A(ca.curve(i));
+            const astral::ContourCurve &B(cb.curve(i));
+
+            if (A.type() != B.type()
+                || !same_point(A.start_pt(), B.start_pt())
+                || !same_point(A.end_pt(), B.end_pt())
+                || A.number_control_pts() != B.number_control_pts()
+                || (A.is_conic() && std::abs(A.conic_weight() - B.conic_weight()) > m_tolerance))
+              {
+                return false;
+              }
+
+            for (unsigned int k = 0; k < A.number_control_pts(); ++k)
+              {
+                if (!same_point(A.control_pt(k), B.control_pt(k)))
+                  {
+                    return false;
+                  }
+              }
+          }
+      }
+
+    return true;
+  }
+
+  void
+  test_numbers(void)
+  {
+    std::cout << "Numbers:\n";
+
+    /* a second decimal point starts a new number */
+    check_parse("M1.5.5L2,3", astral::routine_success,
+                {
+                  ExpectedContour(astral::vec2(1.5f, 0.5f))
+                    .line_to(astral::vec2(2.0f, 3.0f))
+                });
+
+    check_parse("M0 0L1.5.5.25.75", astral::routine_success,
+                {
+                  ExpectedContour(astral::vec2(0.0f, 0.0f))
+                    .line_to(astral::vec2(1.5f, 0.5f))
+                    .line_to(astral::vec2(0.25f, 0.75f))
+                });
+
+    /* a sign starts a new number, a leading . and exponents */
+    check_parse("M-.5e1-.5e1l-.5e1.5e1", astral::routine_success,
+                {
+                  ExpectedContour(astral::vec2(-5.0f, -5.0f))
+                    .line_to(astral::vec2(-10.0f, 0.0f))
+                });
+
+    check_parse("M1e-1+2E+1L-1.25E2 .0", astral::routine_success,
+                {
+                  ExpectedContour(astral::vec2(0.1f, 20.0f))
+                    .line_to(astral::vec2(-125.0f, 0.0f))
+                });
+
+    /* an e without digits is not an exponent */
+    check_parse("M1 2e", astral::routine_fail,
+                {
+                  ExpectedContour(astral::vec2(1.0f, 2.0f))
+                });
+  }
+
+  void
+  test_arc_flags(void)
+  {
+    astral::Path separated, unseparated, commas;
+    enum astral::return_code R0, R1, R2;
+    bool all_arcs(true);
+
+    std::cout << "Arc flags:\n";
+
+    /* the flags are single characters that need not be
+     * separated from each other or from the end point
+     */
+    R0 = astral::add_svg_path_data("M0 0a5 5 0 1 1 10 0a5 5 0 0 0 10 0", &separated);
+    R1 = astral::add_svg_path_data("M0 0a5 5 0 1110 0a5 5 0 0010 0", &unseparated);
+    R2 = astral::add_svg_path_data("M0,0a5,5,0,1,1,10,0,5,5,0,0,0,10,0", &commas);
+
+    check(R0 == astral::routine_success && R1 == astral::routine_success && R2 == astral::routine_success,
+          "arcs parsed");
+    check(same_curves(separated, unseparated), "unseparated flags same as separated");
+    check(same_curves(separated, commas), "repeated arc same as separated");
+
+    /* circular arcs are added as arcs ending at the end points */
+    check(unseparated.number_contours() == 1u
+          && unseparated.contour(0).number_curves() > 0u
+          && same_point(unseparated.contour(0).curves().back().end_pt(), astral::vec2(20.0f, 0.0f)),
+          "arcs end at the end point");
+    for (unsigned int c = 0; c < unseparated.number_contours(); ++c)
+      {
+        for (const astral::ContourCurve &curve : unseparated.contour(c).curves())
+          {
+            all_arcs = all_arcs && curve.type() == astral::ContourCurve::conic_arc_curve;
+          }
+      }
+    check(all_arcs, "circular arcs added as arcs");
+
+    /* a flag must be 0 or 1 */
+    check_parse("M0 0L1 1a5 5 0 2 1 10 0", astral::routine_fail,
+                {
+                  ExpectedContour(astral::vec2(0.0f, 0.0f))
+                    .line_to(astral::vec2(1.0f, 1.0f))
+                });
+  }
+
+  void
+  test_moveto(void)
+  {
+    std::cout << "Moveto:\n";
+
+    /* each moveto starts a contour, even if nothing is drawn */
+    check_parse("M0 0M10 10L20 20", astral::routine_success,
+                {
+                  ExpectedContour(astral::vec2(0.0f, 0.0f)),
+                  ExpectedContour(astral::vec2(10.0f, 10.0f))
+                    .line_to(astral::vec2(20.0f, 20.0f))
+                });
+
+    /* the pairs after the first of a moveto are linetos */
+    check_parse("M10 10 20 20 30 10", astral::routine_success,
+                {
+                  ExpectedContour(astral::vec2(10.0f, 10.0f))
+                    .line_to(astral::vec2(20.0f, 20.0f))
+                    .line_to(astral::vec2(30.0f, 10.0f))
+                });
+
+    check_parse("m10 10 5 5m1 1 1-1", astral::routine_success,
+                {
+                  ExpectedContour(astral::vec2(10.0f, 10.0f))
+                    .line_to(astral::vec2(15.0f, 15.0f)),
+                  ExpectedContour(astral::vec2(16.0f, 16.0f))
+                    .line_to(astral::vec2(17.0f, 15.0f))
+                });
+
+    /* after a closepath, drawing starts at the start of the closed contour */
+    check_parse("M0 0L10 0L10 10zL20 20", astral::routine_success,
+                {
+                  ExpectedContour(astral::vec2(0.0f, 0.0f), true)
+                    .line_to(astral::vec2(10.0f, 0.0f))
+                    .line_to(astral::vec2(10.0f, 10.0f))
+                    .line_to(astral::vec2(0.0f, 0.0f)),
+                  ExpectedContour(astral::vec2(0.0f, 0.0f))
+                    .line_to(astral::vec2(20.0f, 20.0f))
+                });
+
+    /* a relative moveto after a closepath is relative to the start */
+    check_parse("m5 5l10 0l0 10zm1 1l1 0", astral::routine_success,
+                {
+                  ExpectedContour(astral::vec2(5.0f, 5.0f), true)
+                    .line_to(astral::vec2(15.0f, 5.0f))
+                    .line_to(astral::vec2(15.0f, 15.0f))
+                    .line_to(astral::vec2(5.0f, 5.0f)),
+                  ExpectedContour(astral::vec2(6.0f, 6.0f))
+                    .line_to(astral::vec2(7.0f, 6.0f))
+                });
+  }
+
+  void
+  test_commands(void)
+  {
+    std::cout << "Commands:\n";
+
+    check_parse("M0 0H10V10h-5v-5", astral::routine_success,
+                {
+                  ExpectedContour(astral::vec2(0.0f, 0.0f))
+                    .line_to(astral::vec2(10.0f, 0.0f))
+                    .line_to(astral::vec2(10.0f, 10.0f))
+                    .line_to(astral::vec2(5.0f, 10.0f))
+                    .line_to(astral::vec2(5.0f, 5.0f))
+                });
+
+    /* smooth curves reflect the previous control point */
+    check_parse("M0 0Q5 5 10 0T20 0", astral::routine_success,
+                {
+                  ExpectedContour(astral::vec2(0.0f, 0.0f))
+                    .quadratic_to(astral::vec2(5.0f, 5.0f), astral::vec2(10.0f, 0.0f))
+                    .quadratic_to(astral::vec2(15.0f, -5.0f), astral::vec2(20.0f, 0.0f))
+                });
+
+    check_parse("M0 0c1 2 3 4 5 0s5-4 5 0", astral::routine_success,
+                {
+                  ExpectedContour(astral::vec2(0.0f, 0.0f))
+                    .cubic_to(astral::vec2(1.0f, 2.0f), astral::vec2(3.0f, 4.0f), astral::vec2(5.0f, 0.0f))
+                    .cubic_to(astral::vec2(7.0f, -4.0f), astral::vec2(10.0f, -4.0f), astral::vec2(10.0f, 0.0f))
+                });
+  }
+
+  void
+  test_error_recovery(void)
+  {
+    std::cout << "Error recovery:\n";
+
+    /* the data must start with a moveto */
+    check_parse("L10 10", astral::routine_fail, {});
+
+    /* the contours up to the error are kept */
+    check_parse("M0 0L10 0L10 10zM20 20L30 30L", astral::routine_fail,
+                {
+                  ExpectedContour(astral::vec2(0.0f, 0.0f), true)
+                    .line_to(astral::vec2(10.0f, 0.0f))
+                    .line_to(astral::vec2(10.0f, 10.0f))
+                    .line_to(astral::vec2(0.0f, 0.0f)),
+                  ExpectedContour(astral::vec2(20.0f, 20.0f))
+                    .line_to(astral::vec2(30.0f, 30.0f))
+                });
+
+    /* an incomplete coordinate pair is not added */
+    check_parse("M0 0L10 0 20", astral::routine_fail,
+                {
+                  ExpectedContour(astral::vec2(0.0f, 0.0f))
+                    .line_to(astral::vec2(10.0f, 0.0f))
+                });
+
+    /* an unknown command */
+    check_parse("M0 0L10 0X5 5", astral::routine_fail,
+                {
+                  ExpectedContour(astral::vec2(0.0f, 0.0f))
+                    .line_to(astral::vec2(10.0f, 0.0f))
+                });
+
+    /* two commas between numbers */
+    check_parse("M0 0L10,,0", astral::routine_fail,
+                {
+                  ExpectedContour(astral::vec2(0.0f, 0.0f))
+                });
+
+    /* white space only is empty path data */
+    check_parse("  ", astral::routine_success, {});
+  }
+
+  float m_tolerance;
+  unsigned int m_failures;
+};
+
+int
+main(int argc, char **argv)
+{
+  TestOptions options;
+
+  if (argc == 2 && options.is_help_request(argv[1]))
+    {
+      std::cout << "\n\nUsage: " << argv[0];
+      options.print_help(std::cout);
+      options.print_detailed_help(std::cout);
+      return 0;
+    }
+
+  std::cout << "\n\nRunning: \"";
+  for(int i = 0; i < argc; ++i)
+    {
+      std::cout << argv[i] << " ";
+    }
+
+  options.parse_command_line(argc, argv);
+  std::cout << "\n\n" << std::flush;
+
+  Tester tester(options);
+  return tester.run_tests();
+}
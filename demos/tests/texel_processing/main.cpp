@@ -0,0 +1,322 @@
+/*!
+ * \file main.cpp
+ * \brief main.cpp
+ *
+ * Copyright 2021 by InvisionApp.
+ *
+ * Contact kevinrogovin@invisionapp.com
+ *
+ * This Source Code Form is subject to the
+ * terms of the Mozilla Public License, v. 2.0.
+ * If a copy of the MPL was not distributed with
+ * this file, You can obtain one at
+ * http://mozilla.org/MPL/2.0/.
+ *
+ */
+
+#include <iostream>
+#include <vector>
+#include <random>
+#include <cstdlib>
+#include <SDL.h>
+#include <astral/util/texel_processing.hpp>
+#include <astral/util/ostream_utility.hpp>
+
+#include "generic_command_line.hpp"
+
+class TestOptions:public command_line_register
+{
+public:
+  TestOptions(void):
+    m_random_seed(std::mt19937::default_seed, "random_seed", "seed for the random texel values", *this),
+    m_max_size(67, "max_size", "texel counts and widths tested are from 0 to max_size", *this)
+  {}
+
+  command_line_argument_value<unsigned int> m_random_seed;
+  command_line_argument_value<unsigned int> m_max_size;
+};
+
+/* The texel processing functions use SSE2, AVX2 or NEON when
+ * available; the functions here are the scalar definitions of
+ * the same computations that the vectorized paths must match
+ * bit-for-bit.
+ */
+class Tester
+{
+public:
+  explicit
+  Tester(const TestOptions &options):
+    m_options(options),
+    m_generator(options.m_random_seed.value()),
+    m_failures(0)
+  {}
+
+  int
+  run_tests(void)
+  {
+    std::cout << "Instruction set: " << astral::texel_processing_instruction_set() << "\n";
+
+    test_premultiply();
+    test_downsample();
+    test_downsample_gamma_correct();
+
+    std::cout << m_failures << " failures\n";
+    return (m_failures == 0) ? 0 : -1;
+  }
+
+private:
+  void
+  check(bool v, const char *what)
+  {
+    std::cout << "\t" << what << ": " << ((v) ? "pass" : "FAIL") << "\n";
+    if (!v)
+      {
+        ++m_failures;
+      }
+  }
+
+  static
+  uint8_t
+  reference_premultiply(unsigned int c, unsigned int a)
+  {
+    /* rounded value of (c * a) / 255 */
+    return (2u * c * a + 255u) / 510u;
+  }
+
+  static
+  uint8_t
+  reference_average(unsigned int a, unsigned int b, unsigned int c, unsigned int d)
+  {
+    return (a + b + c + d + 2u) / 4u;
+  }
+
+  std::vector<astral::u8vec4>
+  random_texels(unsigned int count)
+  {
+    std::uniform_int_distribution<unsigned int> dist(0u, 255u);
+    std::vector<astral::u8vec4> return_value(count);
+
+    for (astral::u8vec4 &t : return_value)
+      {
+        t = astral::u8vec4(dist(m_generator), dist(m_generator), dist(m_generator), dist(m_generator));
+      }
+
+    return return_value;
+  }
+
+  void
+  test_premultiply(void)
+  {
+    bool exhaustive_match(true), random_match(true);
+    std::vector<astral::u8vec4> texels;
+
+    std::cout << "premultiply_alpha_texels():\n";
+
+    /* every (channel, alpha) pair, laid out so that every
+     * vector width sees values in every lane
+     */
+    for (unsigned int a = 0; a < 256u; ++a)
+      {
+        for (unsigned int c = 0; c < 256u; ++c)
+          {
+            texels.push_back(astral::u8vec4(c, 255u - c, (c * 7u) & 0xFFu, a));
+          }
+      }
+
+    std::vector<astral::u8vec4> expected(texels);
+    for (astral::u8vec4 &t : expected)
+      {
+        t.x() = reference_premultiply(t.x(), t.w());
+        t.y() = reference_premultiply(t.y(), t.w());
+        t.z() = reference_premultiply(t.z(), t.w());
+      }
+
+    astral::premultiply_alpha_texels(astral::make_c_array(texels));
+    exhaustive_match = (texels == expected);
+    check(exhaustive_match, "all channel and alpha values");
+
+    /* every count with an unaligned start so that the
+     * vector loops and the scalar tail are both taken
+     */
+    for (unsigned int count = 0; count <= m_options.m_max_size.value(); ++count)
+      {
+        std::vector<astral::u8vec4> src(random_texels(count + 1u)), ref;
+
+        ref = src;
+        for (unsigned int i = 1; i < ref.size(); ++i)
+          {
+            ref[i].x() = reference_premultiply(ref[i].x(), ref[i].w());
+            ref[i].y() = reference_premultiply(ref[i].y(), ref[i].w());
+            ref[i].z() = reference_premultiply(ref[i].z(), ref[i].w());
+          }
+
+        astral::premultiply_alpha_texels(astral::make_c_array(src).sub_array(1u));
+        random_match = random_match && (src == ref);
+      }
+    check(random_match, "every count at an unaligned start");
+  }
+
+  void
+  test_downsample(void)
+  {
+    bool match(true), size_match(true);
+
+    std::cout << "downsample_texels():\n";
+    for (unsigned int w = 0; w <= m_options.m_max_size.value(); ++w)
+      {
+        for (unsigned int h = 0; h < 6u; ++h)
+          {
+            /* a row width larger than the width checks the row stride */
+            unsigned int row_width(w + (w & 3u));
+            astral::uvec2 src_size(w, h), dst_size;
+            std::vector<astral::u8vec4> src, dst, ref;
+
+            src = random_texels(row_width * h + 1u);
+            dst.resize((w / 2u) * (h / 2u) + 1u, astral::u8vec4(0xAAu));
+            ref = dst;
+
+            for (unsigned int y = 0; y < h / 2u; ++y)
+              {
+                for (unsigned int x = 0; x < w / 2u; ++x)
+                  {
+                    const astral::u8vec4 *r0(&src[2u * y * row_width + 2u * x]);
+                    const astral::u8vec4 *r1(r0 + row_width);
+
+                    for (unsigned int c = 0; c < 4u; ++c)
+                      {
+                        ref[y * (w / 2u) + x][c] = reference_average(r0[0][c], r0[1][c], r1[0][c], r1[1][c]);
+                      }
+                  }
+              }
+
+            dst_size = astral::downsample_texels(src_size, row_width, astral::make_c_array(src),
+                                                 astral::make_c_array(dst), false);
+
+            size_match = size_match && (dst_size == astral::uvec2(w / 2u, h / 2u));
+
+            /* the compare includes the texel past the end, it must be untouched */
+            match = match && (dst == ref);
+          }
+      }
+    check(size_match, "size of the output");
+    check(match, "every width and odd and even heights");
+  }
+
+  void
+  test_downsample_gamma_correct(void)
+  {
+    bool opaque_match(true), transparent_ignored(true), uniform_preserved(true);
+
+    std::cout << "downsample_texels() with gamma correction:\n";
+
+    /* for opaque texels, the weighting by alpha must reduce
+     * to averaging the linear values directly.
+     */
+    {
+      const unsigned int linear_max(4095u);
+      std::vector<astral::u8vec4> src(random_texels(2u * 128u)), dst(64u);
+      std::vector<unsigned int> linear_from_srgb(256u);
+      std::vector<unsigned int> srgb_from_linear(linear_max + 1u);
+
+      for (unsigned int i = 0; i < 256u; ++i)
+        {
+          float f(astral::linear_from_srgb(static_cast<float>(i) / 255.0f));
+          linear_from_srgb[i] = static_cast<unsigned int>(astral::t_max(0.0f, astral::t_min(1.0f, f)) * linear_max + 0.5f);
+        }
+
+      for (unsigned int i = 0; i <= linear_max; ++i)
+        {
+          float f(astral::srgb_from_linear(static_cast<float>(i) / static_cast<float>(linear_max)));
+          srgb_from_linear[i] = static_cast<unsigned int>(astral::t_max(0.0f, astral::t_min(1.0f, f)) * 255.0f + 0.5f);
+        }
+
+      for (astral::u8vec4 &t : src)
+        {
+          t.w() = 255u;
+        }
+
+      astral::downsample_texels(astral::uvec2(128u, 2u), 128u, astral::make_c_array(src),
+                                astral::make_c_array(dst), true);
+      for (unsigned int x = 0; x < 64u; ++x)
+        {
+          const astral::u8vec4 *r0(&src[2u * x]), *r1(r0 + 128u);
+
+          for (unsigned int c = 0; c < 3u; ++c)
+            {
+              unsigned int sum;
+
+              sum = linear_from_srgb[r0[0][c]] + linear_from_srgb[r0[1][c]]
+                + linear_from_srgb[r1[0][c]] + linear_from_srgb[r1[1][c]];
+              opaque_match = opaque_match && (dst[x][c] == srgb_from_linear[(sum + 2u) / 4u]);
+            }
+          opaque_match = opaque_match && (dst[x].w() == 255u);
+        }
+    }
+    check(opaque_match, "opaque texels average the linear values");
+
+    /* a fully transparent texel must not change the color of
+     * the result, only its alpha; and a 2x2 block of the same
+     * pre-multiplied texel must give back that texel up to rounding.
+     */
+    for (unsigned int v = 0; v < 256u; v += 5u)
+      {
+        for (unsigned int a = 1; a < 256u; a += 6u)
+          {
+            astral::u8vec4 t(reference_premultiply(v, a), reference_premultiply(255u - v, a), 0u, a);
+            astral::u8vec4 clear(0u, 0u, 0u, 0u);
+            std::vector<astral::u8vec4> src, dst(1u);
+
+            src = { t, clear, clear, t };
+            astral::downsample_texels(astral::uvec2(2u, 2u), 2u, astral::make_c_array(src),
+                                      astral::make_c_array(dst), true);
+
+            for (unsigned int c = 0; c < 3u; ++c)
+              {
+                int expected(reference_premultiply(t[c] == 0u ? 0u : astral::t_min(255u, (t[c] * 255u + a / 2u) / a),
+                                                   dst[0].w()));
+                transparent_ignored = transparent_ignored && std::abs(int(dst[0][c]) - expected) <= 1;
+              }
+
+            src = { t, t, t, t };
+            astral::downsample_texels(astral::uvec2(2u, 2u), 2u, astral::make_c_array(src),
+                                      astral::make_c_array(dst), true);
+            for (unsigned int c = 0; c < 4u; ++c)
+              {
+                uniform_preserved = uniform_preserved && std::abs(int(dst[0][c]) - int(t[c])) <= 1;
+              }
+          }
+      }
+    check(transparent_ignored, "transparent texels do not affect color");
+    check(uniform_preserved, "uniform blocks are preserved");
+  }
+
+  const TestOptions &m_options;
+  std::mt19937 m_generator;
+  unsigned int m_failures;
+};
+
+int
+main(int argc, char **argv)
+{
+  TestOptions options;
+
+  if (argc == 2 && options.is_help_request(argv[1]))
+    {
+      std::cout << "\n\nUsage: " << argv[0];
+      options.print_help(std::cout);
+      options.print_detailed_help(std::cout);
+      return 0;
+    }
+
+  std::cout << "\n\nRunning: \"";
+  for(int i = 0; i < argc; ++i)
+    {
+      std::cout << argv[i] << " ";
+    }
+
+  options.parse_command_line(argc, argv);
+  std::cout << "\n\n" << std::flush;
+
+  Tester tester(options);
+  return tester.run_tests();
+}
@@ -21,6 +21,14 @@
 
 namespace astral
 {
+  class AnimatedPath;
+
+  namespace detail
+  {
+    ///@cond
+    class SerializedAnimatedContour;
+    ///@endcond
+  }
 
 /*!\addtogroup Paths
  * @{
@@ -374,10 +382,21 @@ namespace astral
                               float *actual_error = nullptr) const;
 
   private:
+    friend class AnimatedPath;
+
     class DataGenerator;
 
     AnimatedContour(void);
 
+    /* Write the start and end contours to dst */
+    void
+    serialize(detail::SerializedWriter &dst, detail::SerializedAnimatedContour *out_record) const;
+
+    /* Returns nullptr if the record is not valid */
+    static
+    reference_counted_ptr<AnimatedContour>
+    deserialize(const detail::SerializedReader &src, const detail::SerializedAnimatedContour &record);
+
     DataGenerator&
     data_generator(void) const;
 
@@ -191,6 +191,24 @@ namespace astral
 
     ~AnimatedPath();
 
+    /*!
+     * Write the geometry of this astral::AnimatedPath to a
+     * buffer in the same format as Path::serialize(); the
+     * approximations of the contours are not written.
+     * \param dst location to which to write the data, the
+     *            contents are replaced
+     */
+    void
+    serialize(std::vector<uint8_t> *dst) const;
+
+    /*!
+     * Set this astral::AnimatedPath from data written by
+     * serialize(); on failure the path is cleared.
+     * \param src the data, must be aligned to 8 bytes
+     */
+    enum return_code
+    deserialize(c_array<const uint8_t> src);
+
     /*!
      * Clear the contents of the \ref AnimatedPath
      */
@@ -0,0 +1,161 @@
+/*!
+ * \file compact_contour_curves.hpp
+ * \brief file compact_contour_curves.hpp
+ *
+ * Copyright 2019 by InvisionApp.
+ *
+ * Contact: kevinrogovin@invisionapp.com
+ *
+ * This Source Code Form is subject to the
+ * terms of the Mozilla Public License, v. 2.0.
+ * If a copy of the MPL was not distributed with
+ * this file, You can obtain one at
+ * http://mozilla.org/MPL/2.0/.
+ *
+ */
+
+#ifndef ASTRAL_COMPACT_CONTOUR_CURVES_HPP
+#define ASTRAL_COMPACT_CONTOUR_CURVES_HPP
+
+#include <vector>
+#include <astral/util/c_array.hpp>
+#include <astral/util/vecN.hpp>
+#include <astral/util/bounding_box.hpp>
+#include <astral/util/reference_counted.hpp>
+#include <astral/contour_curve.hpp>
+
+namespace astral
+{
+
+/*!\addtogroup Paths
+ * @{
+ */
+
+  /*!
+   * \brief
+   * An astral::CompactContourCurves stores a sequence of
+   * \ref ContourCurve values of a single contour in a lossy,
+   * compact form: the points are stored as 16-bit fixed point
+   * values relative to a bounding box, the type, continuation
+   * and generation of each curve are packed into 16-bits and
+   * the start point of a curve is only stored when it is not
+   * the end point of the previous curve. A line segment takes
+   * 6 bytes and a cubic bezier curve 14 bytes against the 36
+   * bytes of a \ref ContourCurve.
+   *
+   * The curves are encoded in chunks of \ref chunk_size curves
+   * so that a range of curves can be decoded without decoding
+   * all of the curves before it.
+   */
+  class CompactContourCurves:
+    public reference_counted<CompactContourCurves>::concurrent
+  {
+  public:
+    enum
+      {
+        /*!
+         * Number of curves in each chunk
+         */
+        chunk_size = 64u
+      };
+
+    /*!
+     * Create an astral::CompactContourCurves encoding
+     * a sequence of curves.
+     * \param curves the curves to encode
+     * \param bb box relative to which points are encoded, must
+     *           contain the start, end and control points of
+     *           all of the curves
+     */
+    static
+    reference_counted_ptr<CompactContourCurves>
+    create(c_array<const ContourCurve> curves, const BoundingBox<float> &bb)
+    {
+      return ASTRALnew CompactContourCurves(curves, bb);
+    }
+
+    /*!
+     * Returns the number of curves
+     */
+    unsigned int
+    size(void) const
+    {
+      return m_headers.size();
+    }
+
+    /*!
+     * Returns true if there are no curves
+     */
+    bool
+    empty(void) const
+    {
+      return m_headers.empty();
+    }
+
+    /*!
+     * Decode a range of the curves.
+     * \param begin index of the first curve to decode
+     * \param dst location to which to write the curves, the
+     *            curves decoded are [begin, begin + dst.size())
+     */
+    void
+    decode(unsigned int begin, c_array<ContourCurve> dst) const;
+
+    /*!
+     * Decode all of the curves
+     * \param dst location to which to write the curves, the
+     *            contents are replaced
+     */
+    void
+    decode(std::vector<ContourCurve> *dst) const;
+
+    /*!
+     * Returns the largest distance in each coordinate between
+     * a point passed to create() and the decoded point.
+     */
+    vec2
+    quantization_error(void) const
+    {
+      return 0.5f * m_step;
+    }
+
+    /*!
+     * Returns the number of bytes used to store the curves.
+     */
+    unsigned int
+    memory_size(void) const;
+
+  private:
+    CompactContourCurves(c_array<const ContourCurve> curves, const BoundingBox<float> &bb);
+
+    void
+    encode_point(const vec2 &p);
+
+    vec2
+    decode_point(const uint16_t *p) const
+    {
+      return m_min + m_step * vec2(p[0], p[1]);
+    }
+
+    /* origin and size of a quantization step */
+    vec2 m_min, m_step;
+
+    /* header of each curve, see the .cpp for the bits */
+    std::vector<uint16_t> m_headers;
+
+    /* (x, y) pairs of the points */
+    std::vector<uint16_t> m_points;
+
+    /* conic weights and arc angles */
+    std::vector<float> m_scalars;
+
+    /* for each chunk, the offsets into m_points and m_scalars
+     * of the data of the first curve of the chunk
+     */
+    std::vector<uvec2> m_chunks;
+  };
+
+/*! @} */
+}
+
+#endif
@@ -24,6 +24,7 @@
 #include <astral/util/bounding_box.hpp>
 #include <astral/util/reference_counted.hpp>
 #include <astral/contour_curve.hpp>
+#include <astral/compact_contour_curves.hpp>
 #include <astral/renderer/vertex_data.hpp>
 #include <astral/renderer/shader/fill_stc_shader.hpp>
 #include <astral/renderer/shader/stroke_shader.hpp>
@@ -31,6 +32,17 @@
 namespace astral
 {
   class RenderEngine;
+  class AnimatedContour;
+
+  namespace detail
+  {
+    ///@cond
+    class SerializedWriter;
+    class SerializedReader;
+    class SerializedContourData;
+    class SerializedContour;
+    ///@endcond
+  }
 
 /*!\addtogroup Paths
  * @{
@@ -79,6 +91,47 @@ namespace astral
       number_contour_fill_approximation
     };
 
+  /*!
+   * Enumeration of bit masks to specify what data Path::prepare()
+   * is to generate ahead of time.
+   */
+  enum contour_prepare_bits:uint32_t
+    {
+      /*!
+       * Generate the fill approximations and fill render
+       * data for \ref contour_fill_approximation_tessellate_long_curves
+       */
+      contour_prepare_fill_tessellate_long_curves = 1u << contour_fill_approximation_tessellate_long_curves,
+
+      /*!
+       * Generate the fill approximations and fill render
+       * data for \ref contour_fill_approximation_allow_long_curves
+       */
+      contour_prepare_fill_allow_long_curves = 1u << contour_fill_approximation_allow_long_curves,
+
+      /*!
+       * Generate the fill approximations and fill render
+       * data for all values of \ref contour_fill_approximation_t
+       */
+      contour_prepare_fill = contour_prepare_fill_tessellate_long_curves | contour_prepare_fill_allow_long_curves,
+
+      /*!
+       * Generate the stroke approximations and stroke render data
+       */
+      contour_prepare_stroke = 1u << number_contour_fill_approximation,
+
+      /*!
+       * Generate the approximations used by astral::ItemPath
+       * and, for Path::prepare(), the astral::ItemPath as well
+       */
+      contour_prepare_item_path = contour_prepare_stroke << 1u,
+
+      /*!
+       * Generate all of the above
+       */
+      contour_prepare_all = contour_prepare_fill | contour_prepare_stroke | contour_prepare_item_path
+    };
+
   /*!
    * \brief
    * A \ref ContourData represents the geometry of a single contour of a Path.
@@ -143,6 +196,7 @@ namespace astral
       m_start_pt(obj.m_start_pt),
       m_last_end_pt(obj.m_last_end_pt),
       m_curves(std::move(obj.m_curves)),
+      m_compact(std::move(obj.m_compact)),
       m_santize_curves_on_adding(obj.m_santize_curves_on_adding),
       m_sanitized(obj.m_sanitized),
       m_closed(obj.m_closed),
@@ -177,6 +231,7 @@ namespace astral
       m_closed = false;
       m_sanitized = true;
       m_curves.clear();
+      m_compact = nullptr;
       m_bb.clear();
       m_join_bb.clear();
       m_control_point_bb.clear();
@@ -221,7 +276,7 @@ namespace astral
     bool
     empty(void) const
     {
-      return m_curves.empty();
+      return number_curves() == 0u;
     }
 
     /*!
@@ -581,7 +636,7 @@ namespace astral
     unsigned int
     number_curves(void) const
     {
-      return m_curves.size();
+      return m_compact ? m_compact->size() : m_curves.size();
     }
 
     /*!
@@ -591,6 +646,7 @@ namespace astral
     const ContourCurve&
     curve(unsigned int N) const
     {
+      ready_curves();
       ASTRALassert(N < m_curves.size());
       return m_curves[N];
     }
@@ -609,14 +665,51 @@ namespace astral
      * Returns all the curves of the contour. NOTE: the
      * backing of the returned c_array is only guarnateed
      * to be valid until the geometry of the contour
-     * is changed.
+     * is changed. If is_compact() returns true, the curves
+     * are decoded by the first call and kept until the
+     * contour is changed.
      */
     c_array<const ContourCurve>
     curves(void) const
     {
+      ready_curves();
       return make_c_array(m_curves);
     }
 
+    /*!
+     * Store the curves of this astral::ContourData in the
+     * compact form of astral::CompactContourCurves relative
+     * to control_point_bounding_box(). Compacting is lossy:
+     * the curves are replaced by the curves as decoded from
+     * the compact form and the bounding boxes are recomputed,
+     * see CompactContourCurves::quantization_error(). Methods
+     * that change the curves decode them and leave the compact
+     * form. Does nothing if there are no curves or if the
+     * contour is already compact.
+     */
+    void
+    compact(void);
+
+    /*!
+     * Returns true if the curves are stored in the compact
+     * form, see compact().
+     */
+    bool
+    is_compact(void) const
+    {
+      return m_compact;
+    }
+
+    /*!
+     * If is_compact() returns true, returns the compact form
+     * of the curves, otherwise returns nullptr.
+     */
+    const CompactContourCurves*
+    compact_curves(void) const
+    {
+      return m_compact.get();
+    }
+
     /*!
      * Returns true if the contour is closed.
      */
@@ -712,11 +805,71 @@ namespace astral
     make_curve_first(unsigned int I);
 
   private:
+    friend class Contour;
+    friend class AnimatedContour;
+
+    /* Write the curves to dst and fill the fields of out_record */
+    void
+    serialize_data(detail::SerializedWriter &dst, detail::SerializedContourData *out_record) const;
+
+    /* Set the values of this ContourData from serialized data
+     * directly, i.e. without sanitizing or recomputing anything.
+     */
+    enum return_code
+    deserialize_data(const detail::SerializedReader &src, const detail::SerializedContourData &record);
+
     virtual
     void
     mark_dirty(void)
     {}
 
+    /* decode the curves if they are compact and not yet decoded */
+    void
+    ready_curves(void) const
+    {
+      if (m_compact && m_curves.size() != m_compact->size())
+        {
+          m_compact->decode(&m_curves);
+        }
+    }
+
+    /* if the curves are compact, free the decoded curves */
+    void
+    release_decoded_curves(void) const
+    {
+      if (m_compact)
+        {
+          std::vector<ContourCurve>().swap(m_curves);
+        }
+    }
+
+    /* decode the curves and leave the compact form, called
+     * by those methods that change the curves
+     */
+    void
+    uncompact(void)
+    {
+      if (m_compact)
+        {
+          ready_curves();
+          m_compact = nullptr;
+        }
+    }
+
+    /* Called when the curves [begin, old_end) were replaced by
+     * the curves [begin, new_end) and the curves after them are
+     * unchanged; a range with begin == old_end == new_end
+     * indicates that only closed() may have changed.
+     */
+    virtual
+    void
+    mark_curves_dirty(unsigned int begin, unsigned int old_end, unsigned int new_end)
+    {
+      ASTRALunused(begin);
+      ASTRALunused(old_end);
+      ASTRALunused(new_end);
+    }
+
     void
     update_bbs(void)
     {
@@ -729,7 +882,12 @@ namespace astral
     }
 
     vec2 m_start_pt, m_last_end_pt;
-    std::vector<ContourCurve> m_curves;
+
+    /* if m_compact is non-null, m_curves is either empty or
+     * holds the curves decoded from m_compact
+     */
+    mutable std::vector<ContourCurve> m_curves;
+    reference_counted_ptr<const CompactContourCurves> m_compact;
     bool m_santize_curves_on_adding, m_sanitized, m_closed;
     BoundingBox<float> m_bb, m_join_bb, m_control_point_bb;
   };
@@ -931,17 +1089,59 @@ namespace astral
     }
 
   private:
+    friend class Path;
     class DataGenerator;
+    class ScopedDecode;
 
     explicit
     Contour(const ContourData &obj);
 
+    /* Returns the same value as item_path_approximated_geometry()
+     * and for each curve of it, writes the index into curves()
+     * of the curve it approximates and the range of that curve.
+     */
+    c_array<const ContourCurve>
+    item_path_approximated_geometry(float error_tol, float *actual_error,
+                                    std::vector<int> *out_source_curves,
+                                    std::vector<range_type<float>> *out_source_ranges) const;
+
     Contour(void);
 
+    /* Generates the approximations, and if render_input is true
+     * the part of the render data that does not need a RenderEngine,
+     * for each tolerance and each use named by the bit mask uses of
+     * contour_prepare_bits; Path::prepare() calls this from worker
+     * threads, one thread per contour.
+     */
+    void
+    prepare_data(c_array<const float> tolerances, uint32_t uses, bool render_input) const;
+
+    /* Generates the render data for each tolerance and each use
+     * named by the bit mask uses of contour_prepare_bits, must be
+     * called from the thread that renders.
+     */
+    void
+    prepare_render_data(c_array<const float> tolerances, uint32_t uses, RenderEngine &engine) const;
+
+    /* Write the contour to dst, together with the LOD chains of the
+     * approximations named by uses after generating the approximations
+     * for each of the tolerances; returns the offset of the record.
+     */
+    uint64_t
+    serialize(detail::SerializedWriter &dst, c_array<const float> tolerances, uint32_t uses) const;
+
+    /* Set this Contour from a record written by serialize() */
+    enum return_code
+    deserialize(const detail::SerializedReader &src, const detail::SerializedContour &record);
+
     virtual
     void
     mark_dirty(void) override final;
 
+    virtual
+    void
+    mark_curves_dirty(unsigned int begin, unsigned int old_end, unsigned int new_end) override final;
+
     DataGenerator&
     data_generator(void) const;
 
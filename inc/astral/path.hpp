@@ -20,6 +20,7 @@
 #include <vector>
 #include <astral/contour.hpp>
 #include <astral/util/bounding_box.hpp>
+#include <astral/renderer/render_enums.hpp>
 #include <astral/renderer/vertex_data.hpp>
 #include <astral/renderer/shader/fill_stc_shader.hpp>
 #include <astral/renderer/shader/stroke_shader.hpp>
@@ -28,6 +29,7 @@ namespace astral
 {
   class RenderEngine;
   class ItemPath;
+  class ThreadPool;
 
 /*!\addtogroup Paths
  * @{
@@ -687,6 +689,78 @@ namespace astral
     const ItemPath&
     item_path(float tol, float *actual_error = nullptr) const;
 
+    /*!
+     * Generate ahead of time the data that astral::Renderer
+     * would otherwise generate for each contour on demand
+     * when the path is drawn. The approximations, and the
+     * parts of the render data that do not need a \ref
+     * RenderEngine, are generated for all contours in parallel
+     * by the threads of a \ref ThreadPool; the render data and
+     * the astral::ItemPath are then generated on the calling
+     * thread. Returns after all of the data is generated. No
+     * other thread may access this astral::Path, or any copy
+     * of it, during the call.
+     * \param tolerances the tolerances, as passed to the methods
+     *                   of \ref Contour or to item_path(), for
+     *                   which to generate the data
+     * \param uses bit mask of \ref contour_prepare_bits naming
+     *             what data to generate
+     * \param thread_pool the \ref ThreadPool to run the work;
+     *                    the calling thread helps with the work
+     *                    and waits on all jobs of the pool
+     * \param engine if non-null, the render data is generated as
+     *               well; if null, only the parts not needing a \ref
+     *               RenderEngine are, and are kept until the render
+     *               data is requested. The passed value must be the
+     *               same as the one later used for rendering.
+     */
+    void
+    prepare(c_array<const float> tolerances, uint32_t uses,
+            ThreadPool &thread_pool, RenderEngine *engine = nullptr) const;
+
+    /*!
+     * Write this astral::Path to a buffer so that it can be
+     * stored and later restored with deserialize() without
+     * recomputing the approximations of its contours. The arrays
+     * of curves are written in their in-memory layout so that
+     * reading is a matter of bounds checking and copying. The
+     * format is native endian and is only to be read by the same
+     * version of Astral on the same platform. Render data, i.e.
+     * data in GPU memory, is never written.
+     * \param dst location to which to write the data, the contents
+     *            are replaced
+     * \param tolerances the tolerances for which to generate and
+     *                   then write the approximations; if empty,
+     *                   only the geometry of the path is written
+     * \param uses bit mask of \ref contour_prepare_bits naming which
+     *             approximations to write; if the bit \ref
+     *             contour_prepare_item_path is up, the astral::ItemPath
+     *             realizations of the path are also written
+     */
+    void
+    serialize(std::vector<uint8_t> *dst,
+              c_array<const float> tolerances = c_array<const float>(),
+              uint32_t uses = 0u) const;
+
+    /*!
+     * Set this astral::Path from data written by serialize(). The
+     * data is checked to be from a compatible writer and that it
+     * is within the bounds of src; on failure the path is cleared.
+     * \param src the data, must be aligned to 8 bytes
+     */
+    enum return_code
+    deserialize(c_array<const uint8_t> src);
+
+    /*!
+     * Store the curves of each contour in a compact form,
+     * see ContourData::compact(). The curves are decoded
+     * only when they are needed to generate the approximations
+     * and render data of a contour; the approximations and
+     * render data are not compact.
+     */
+    void
+    compact(void);
+
     /*!
      * Clear the path.
      */
@@ -705,13 +779,16 @@ namespace astral
     }
 
     /*!
-     * Computes the L1-distance to the path.
+     * Computes the L1-distance to the path. The query is accelerated
+     * by a bounding volume hierarchy over the curves of the path
+     * that is built on first use for each tolerance. The winding
+     * impact of the returned value is the winding number of the
+     * path at pt.
      * \param tol tolerance of query
      * \param pt the query point
-     * \param distance_cull if non-negative will cull from the query any
-     *                      contours for which pt is outside of their tight
-     *                      bounding box and this distance from the box
-     *                      boundary
+     * \param distance_cull if non-negative, curves whose distance from
+     *                      pt is atleast this value are culled from the
+     *                      query for the closest point
      */
     PointQueryResult
     distance_to_path(float tol, const vec2 &pt, float distance_cull) const;
@@ -727,6 +804,58 @@ namespace astral
       return distance_to_path(tol, pt, -1.0f);
     }
 
+    /*!
+     * Batched version of distance_to_path(float, const vec2&, float) const;
+     * the acceleration structure is fetched once for all of the query points.
+     * \param tol tolerance of query
+     * \param pts the query points
+     * \param out_results location to which to write the results, the
+     *                    size must be the same as pts
+     * \param distance_cull if non-negative, curves whose distance from
+     *                      a query point is atleast this value are
+     *                      culled from the query for the closest point
+     */
+    void
+    distance_to_path(float tol, c_array<const vec2> pts,
+                     c_array<PointQueryResult> out_results,
+                     float distance_cull = -1.0f) const;
+
+    /*!
+     * Returns the winding number of the path at a point. This is
+     * faster than distance_to_path() because only those curves that
+     * can affect the winding number are visited.
+     * \param tol tolerance of query
+     * \param pt the query point
+     */
+    int
+    winding_number(float tol, const vec2 &pt) const;
+
+    /*!
+     * Returns true if a point is inside of the path for a fill rule.
+     * \param tol tolerance of query
+     * \param pt the query point
+     * \param fill_rule fill rule to apply to the winding number at pt
+     */
+    bool
+    inside(float tol, const vec2 &pt, enum fill_rule_t fill_rule) const
+    {
+      return apply_fill_rule(fill_rule, winding_number(tol, pt));
+    }
+
+    /*!
+     * Equivalent to
+     * \code
+     * inside(-1.0f, pt, fill_rule);
+     * \endcode
+     * \param pt the query point
+     * \param fill_rule fill rule to apply to the winding number at pt
+     */
+    bool
+    inside(const vec2 &pt, enum fill_rule_t fill_rule) const
+    {
+      return inside(-1.0f, pt, fill_rule);
+    }
+
   private:
     class DataGenerator;
 
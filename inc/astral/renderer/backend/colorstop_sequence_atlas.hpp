@@ -19,6 +19,7 @@
 
 #include <vector>
 #include <map>
+#include <unordered_map>
 #include <algorithm>
 
 #include <astral/util/reference_counted.hpp>
@@ -126,7 +127,12 @@ namespace astral
   /*!
    * \brief
    * An astral::ColorStopSequenceAtlas represents the object that provides the backing
-   * store for pixels of \ref astral::ColorStopSequence objects.
+   * store for pixels of \ref astral::ColorStopSequence objects. The create() methods
+   * hash-cons their results: if a live \ref astral::ColorStopSequence already has the
+   * same texels, colorspace and opacity as the one requested, that object is returned
+   * instead of allocating a new region and uploading the texels again. Sequences
+   * with at most ColorStopSequence::max_analytic_colorstops color stops are
+   * analytic and do not occupy any region of the atlas.
    */
   class ColorStopSequenceAtlas:public reference_counted<ColorStopSequenceAtlas>::non_concurrent
   {
@@ -230,10 +236,43 @@ namespace astral
       return *m_backing;
     }
 
+    /*!
+     * Returns the number of times a create() method returned an
+     * existing \ref ColorStopSequence over the lifetime of this
+     * astral::ColorStopSequenceAtlas.
+     */
+    uint64_t
+    total_sequences_deduplicated(void) const
+    {
+      return m_total_sequences_deduplicated;
+    }
+
+    /*!
+     * Returns the number of bytes of texels whose upload and storage
+     * was avoided by returning an existing \ref ColorStopSequence over
+     * the lifetime of this astral::ColorStopSequenceAtlas.
+     */
+    uint64_t
+    total_bytes_deduplicated(void) const
+    {
+      return m_total_bytes_deduplicated;
+    }
+
   private:
     friend class ColorStopSequence;
     class MemoryPool;
 
+    /* an element of m_hash_table; m_texels holds a copy of the
+     * texels of a sequence that is not analytic so that a hash
+     * match can be checked against the texels
+     */
+    class HashEntry
+    {
+    public:
+      ColorStopSequence *m_sequence;
+      std::vector<u8vec4> m_texels;
+    };
+
     explicit
     ColorStopSequenceAtlas(const reference_counted_ptr<ColorStopSequenceAtlasBacking> &backing);
 
@@ -243,11 +282,31 @@ namespace astral
     const IntervalAllocator::Interval*
     allocate_region(c_array<const u8vec4> colors);
 
+    static
+    uint64_t
+    compute_key(c_array<const u8vec4> colors, enum colorspace_t colorspace, bool opaque);
+
+    static
+    uint64_t
+    compute_key(c_array<const ColorStop<vec4>> colorstops, enum colorspace_t colorspace, bool opaque);
+
+    /* returns true if the sequence was added */
+    bool
+    add_to_hash_table(uint64_t key, ColorStopSequence *sequence, c_array<const u8vec4> texels);
+
     reference_counted_ptr<ColorStopSequenceAtlasBacking> m_backing;
     IntervalAllocator m_interval_allocator;
     std::vector<const IntervalAllocator::Interval*> m_delayed_frees;
     int m_lock_resources;
     MemoryPool *m_pool;
+
+    /* maps the key computed by compute_key() to the
+     * live ColorStopSequence with those texels
+     */
+    std::unordered_map<uint64_t, HashEntry> m_hash_table;
+
+    uint64_t m_total_sequences_deduplicated;
+    uint64_t m_total_bytes_deduplicated;
   };
 
 /*! @} */
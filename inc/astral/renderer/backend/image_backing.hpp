@@ -29,6 +29,7 @@
 #include <astral/renderer/image_sampler_bits.hpp>
 #include <astral/renderer/image_id.hpp>
 #include <astral/util/tile_allocator.hpp>
+#include <astral/util/thread_pool.hpp>
 
 namespace astral
 {
@@ -232,6 +233,196 @@ namespace astral
       uvec2 m_tile;
     };
 
+    /*!
+     * \brief
+     * An astral::ImageAtlas::PurgeCallback is used by an astral::ImageAtlas
+     * to inform the caller that an astral::Image has been purged, see
+     * Image::purgeable(bool).
+     */
+    class PurgeCallback:public reference_counted<PurgeCallback>::non_concurrent
+    {
+    public:
+      virtual
+      ~PurgeCallback()
+      {}
+
+      /*!
+       * To be implemented by a derived class to react to an
+       * astral::Image getting purged. It is illegal to create,
+       * modify or release astral::Image objects from this
+       * callback.
+       * \param image the astral::Image that was purged
+       */
+      virtual
+      void
+      on_purge(Image &image) = 0;
+    };
+
+    /*!
+     * \brief
+     * Class to specify how the texels passed to
+     * ImageAtlas::upload_image_async() are processed
+     * and what astral::Image is made from them.
+     */
+    class AsyncImageParams
+    {
+    public:
+      AsyncImageParams(void):
+        m_number_mip_levels(1u),
+        m_colorspace(colorspace_srgb),
+        m_pixel_colorspace(colorspace_srgb),
+        m_premultiply_alpha(false),
+        m_gamma_correct_mipmaps(false)
+      {}
+
+      /*!
+       * Set \ref m_number_mip_levels
+       */
+      AsyncImageParams&
+      number_mip_levels(unsigned int v)
+      {
+        m_number_mip_levels = v;
+        return *this;
+      }
+
+      /*!
+       * Set \ref m_colorspace
+       */
+      AsyncImageParams&
+      colorspace(enum colorspace_t v)
+      {
+        m_colorspace = v;
+        return *this;
+      }
+
+      /*!
+       * Set \ref m_pixel_colorspace
+       */
+      AsyncImageParams&
+      pixel_colorspace(enum colorspace_t v)
+      {
+        m_pixel_colorspace = v;
+        return *this;
+      }
+
+      /*!
+       * Set \ref m_premultiply_alpha
+       */
+      AsyncImageParams&
+      premultiply_alpha(bool v)
+      {
+        m_premultiply_alpha = v;
+        return *this;
+      }
+
+      /*!
+       * Set \ref m_gamma_correct_mipmaps
+       */
+      AsyncImageParams&
+      gamma_correct_mipmaps(bool v)
+      {
+        m_gamma_correct_mipmaps = v;
+        return *this;
+      }
+
+      /*!
+       * The number of mipmap levels the image will have; the
+       * levels after the first are generated from the texels
+       * by a 2x2 box filter, see astral::downsample_texels().
+       * Default value is 1.
+       */
+      unsigned int m_number_mip_levels;
+
+      /*!
+       * The colorspace of the created astral::Image. Default
+       * value is \ref colorspace_srgb.
+       */
+      enum colorspace_t m_colorspace;
+
+      /*!
+       * The colorspace of the texels passed; if different than
+       * \ref m_colorspace, the texels are converted. Default
+       * value is \ref colorspace_srgb.
+       */
+      enum colorspace_t m_pixel_colorspace;
+
+      /*!
+       * If true, the texels passed do not have alpha
+       * pre-multiplied and are pre-multiplied after
+       * the colorspace conversion. If false, the texels
+       * are pre-multiplied and if a colorspace conversion
+       * is needed, they are un-premultiplied for the
+       * conversion. Default value is false.
+       */
+      bool m_premultiply_alpha;
+
+      /*!
+       * If true and \ref m_colorspace is \ref colorspace_srgb,
+       * the mipmap levels are generated by averaging the linear
+       * values of the texels. Default value is false.
+       */
+      bool m_gamma_correct_mipmaps;
+    };
+
+    /*!
+     * \brief
+     * An astral::ImageAtlas::AsyncUpload is a handle to the upload
+     * of an image made with ImageAtlas::upload_image_async(). The
+     * texels are processed by the worker threads of the
+     * astral::ThreadPool of the astral::ImageAtlas and the
+     * astral::Image is created and its tiles uploaded at the first
+     * ImageAtlas::flush() after the processing is done.
+     *
+     * The methods processed(), ready() and wait() may be called
+     * from any thread. Since astral::Image is not thread safe,
+     * image() must only be called from the thread that uses the
+     * astral::ImageAtlas and if the handle becomes ready, its last
+     * reference must be released from that thread as well.
+     */
+    class AsyncUpload:public reference_counted<AsyncUpload>::concurrent
+    {
+    public:
+      virtual
+      ~AsyncUpload()
+      {}
+
+      /*!
+       * Returns true if the worker threads have finished
+       * processing the texels, i.e. the image will be
+       * made at the next ImageAtlas::flush().
+       */
+      bool
+      processed(void) const;
+
+      /*!
+       * Returns true if the astral::Image has been
+       * created and its texels uploaded, i.e. image()
+       * returns a non-null value.
+       */
+      bool
+      ready(void) const;
+
+      /*!
+       * Blocks until processed() returns true.
+       */
+      void
+      wait(void) const;
+
+      /*!
+       * Returns the astral::Image once ready() is true;
+       * before then returns nullptr.
+       */
+      const reference_counted_ptr<Image>&
+      image(void) const;
+
+    private:
+      friend class ImageAtlas;
+      class Implement;
+
+      AsyncUpload(void)
+      {}
+    };
+
     /*!
      * Ctor.
      * \param color_backing backing for the color tiles
@@ -270,6 +461,40 @@ namespace astral
     create_image(unsigned int num_mip_levels, uvec2 sz,
                  enum colorspace_t colorspace = colorspace_srgb);
 
+    /*!
+     * Upload an image asynchronously. The texels are copied and
+     * then the colorspace conversion, pre-multiplication of alpha,
+     * mipmap generation and splitting into padded tiles are done
+     * on the worker threads of async_upload_thread_pool(). The
+     * astral::Image is created and its tiles are uploaded at the
+     * first flush() after that processing completes, see
+     * astral::ImageAtlas::AsyncUpload. In contrast to the other
+     * methods of astral::ImageAtlas, this method may be called
+     * from any thread.
+     * \param sz the dimensions of the image
+     * \param row_width number of texels between successive rows of pixels
+     * \param pixels texels of the image with texel (x, y) at
+     *               pixels[x + y * row_width]
+     * \param params specifies how to process the texels
+     */
+    reference_counted_ptr<AsyncUpload>
+    upload_image_async(uvec2 sz, unsigned int row_width, c_array<const u8vec4> pixels,
+                       const AsyncImageParams &params = AsyncImageParams());
+
+    /*!
+     * Set the astral::ThreadPool used by upload_image_async().
+     * If never set, a pool with ThreadPool::default_number_threads()
+     * threads is created on the first call to upload_image_async().
+     */
+    void
+    async_upload_thread_pool(const reference_counted_ptr<ThreadPool> &pool);
+
+    /*!
+     * Returns the astral::ThreadPool used by upload_image_async().
+     */
+    reference_counted_ptr<ThreadPool>
+    async_upload_thread_pool(void);
+
     /*!
      * Create a astral::Image by explicitely providing its
      * mipmap chain. Note that if multiple astral::Image
@@ -450,6 +675,140 @@ namespace astral
     void
     extra_color_backing_texels(unsigned int);
 
+    /*!
+     * Set the maximum number of bytes that the color tiles
+     * of images may occupy in the color backing; a value of
+     * zero indicates that there is no budget. Only LOD = 0 of
+     * a tile, padding included, is counted, the texels of
+     * the other LOD's are not; the few tiles the atlas keeps
+     * for itself (the shared empty, white and failed tiles)
+     * are not counted either. When allocating
+     * a color tile would exceed the budget, astral::Image
+     * objects marked as purgeable are purged, least recently
+     * used first, until the allocation fits within the budget
+     * or there are no more images to purge. Images are also
+     * purged when allocating a color tile fails because the
+     * color backing is at its maximum size. Default value is
+     * zero.
+     */
+    void
+    color_backing_byte_budget(uint64_t bytes);
+
+    /*!
+     * Returns the value set by color_backing_byte_budget(uint64_t).
+     */
+    uint64_t
+    color_backing_byte_budget(void) const;
+
+    /*!
+     * Set the astral::ImageAtlas::PurgeCallback to inform
+     * when an astral::Image is purged.
+     */
+    void
+    purge_callback(const reference_counted_ptr<PurgeCallback> &v);
+
+    /*!
+     * Returns the number of bytes that the LOD = 0 texels of
+     * the live color tiles of images consume, counted as
+     * described in color_backing_byte_budget(uint64_t), i.e.
+     * the value compared against color_backing_byte_budget().
+     */
+    uint64_t
+    total_color_bytes_allocated(void) const;
+
+    /*!
+     * Returns the number of astral::Image objects that have
+     * been purged over the lifetime of this astral::ImageAtlas.
+     */
+    unsigned int
+    total_images_purged(void) const;
+
+    /*!
+     * Perform an incremental compaction step of the color backing:
+     * color tiles on the last layer of the color backing are moved
+     * to free space on the layers below it via
+     * ImageAtlasColorBacking::copy_texels() and the index texels
+     * that refer to them are rewritten. Once the last layers have
+     * no color tiles, the color backing is shrunk. The step does
+     * nothing if the content of the last layer cannot fit in the
+     * layers below it. Calling compact() between lock_resources()
+     * and unlock_resources() does nothing. Like flush(), it should
+     * only be called when the 3D API state can be modified.
+     * The scan for tiles to move resumes where the previous call
+     * stopped and examining a tile is charged against max_texels
+     * as well, so the cost of a call is bounded by max_texels and
+     * not by the number of live images; the last tile started
+     * may take a call slightly over budget.
+     * \param max_texels maximum number of texels of color tiles to move
+     * \returns the number of texels moved
+     */
+    unsigned int
+    compact(unsigned int max_texels);
+
+    /*!
+     * Set the number of texels that compact() is allowed to move each
+     * time resources are locked from an unlocked state, i.e. at the
+     * start of each frame of Renderer. A value of zero disables the
+     * per-frame compaction. Default value is zero.
+     */
+    void
+    compaction_texels_per_frame(unsigned int v);
+
+    /*!
+     * Returns the value set by compaction_texels_per_frame(unsigned int).
+     */
+    unsigned int
+    compaction_texels_per_frame(void) const;
+
+    /*!
+     * Returns the number of texels of color tiles that compact()
+     * has moved over the lifetime of this astral::ImageAtlas.
+     */
+    uint64_t
+    total_color_texels_compacted(void) const;
+
+    /*!
+     * Returns the number of layers of the color backing that
+     * compact() has removed over the lifetime of this
+     * astral::ImageAtlas.
+     */
+    unsigned int
+    total_color_layers_reclaimed(void) const;
+
+    /*!
+     * Set if color tiles are deduplicated by content. When enabled,
+     * the first time the texels of a color tile are set via
+     * ImageMipElement::set_pixels() (or Image::set_pixels()) with
+     * the write covering the entire tile, a 128-bit key of the
+     * texels is computed. If a live color tile of the same size has
+     * the same key, the image uses that color tile instead and the
+     * upload is skipped. Only the key is kept for each tile; no CPU
+     * copy of the texels is made.
+     *
+     * A deduplicated color tile is copied when any of the images
+     * sharing it writes to it again, i.e. writes to a deduplicated
+     * color tile are copy-on-write. Tiles shared explicitly via
+     * ImageAtlas::create_mip_element() with shared tiles are not
+     * deduplicated; writes to them continue to be seen by all
+     * sharers. Default value is false.
+     */
+    void
+    deduplicate_color_tiles(bool v);
+
+    /*!
+     * Returns the value set by deduplicate_color_tiles(bool).
+     */
+    bool
+    deduplicate_color_tiles(void) const;
+
+    /*!
+     * Returns the number of bytes of color tile texels whose
+     * upload and storage was avoided by deduplicate_color_tiles()
+     * over the lifetime of this astral::ImageAtlas.
+     */
+    uint64_t
+    total_color_bytes_deduplicated(void) const;
+
     /*!
      * Returns the location in color_backing() where
      * the (shared) empty tile is located. This value
@@ -616,12 +975,14 @@ namespace astral
     {}
 
     /*!
-     * Resize the atlas
+     * Resize the atlas. The atlas can only be shrunk by
+     * astral::ImageAtlas when it has already moved all
+     * content off of the layers that are removed.
      */
     void
     number_layers(unsigned int L)
     {
-      ASTRALassert(L >= m_number_layers);
+      ASTRALassert(L <= m_max_number_layers);
       on_resize(L);
       m_number_layers = L;
     }
@@ -658,7 +1019,10 @@ namespace astral
     /*!
      * To be implemented by a derived class to resize the atlas.
      * The value of number_layers() is the value -before- the
-     * resize is to occur.
+     * resize is to occur. If new_number_layers is less than
+     * number_layers(), the content of the layers that remain
+     * must be preserved and the content of the removed layers
+     * is discarded.
      */
     virtual
     void
@@ -774,6 +1138,26 @@ namespace astral
                       ColorBuffer &src, uvec2 src_location,
                       enum downsampling_processing_t downsamping_processing,
                       bool permute_src_x_y_coordinates) = 0;
+
+    /*!
+     * To be implemented by a derived class to copy texels from
+     * one region of the color backing to another region of the
+     * color backing; this is used by astral::ImageAtlas to move
+     * color tiles when compacting, see ImageAtlas::compact(), and
+     * to copy a deduplicated color tile when it is written to, see
+     * ImageAtlas::deduplicate_color_tiles(). The source and
+     * destination regions never overlap but may be on the same
+     * layer. The copy must observe all of the uploads and copies
+     * issued before it, i.e. it acts as if flush() was issued
+     * before the copy.
+     * \param lod mipmap level
+     * \param location location within in atlas to which to copy
+     * \param size size of rect to copy
+     * \param src_location location within the atlas from which to copy
+     */
+    virtual
+    void
+    copy_texels(unsigned int lod, uvec3 location, uvec2 size, uvec3 src_location) = 0;
   };
 
   /*!
@@ -41,30 +41,65 @@ namespace astral
    * not HAVE a ctor. To create an astral::ColorStopSequence,
    * use one of the astral::ColorStopSequenceAtlas::create()
    * methods from the class astral::ColorStopSequenceAtlas.
+   *
+   * A sequence made from at most \ref max_analytic_colorstops
+   * color stops is analytic: it does not occupy any texels of the
+   * \ref ColorStopSequenceAtlas, instead its color stops are
+   * given by analytic_colorstops() and a backend is to pack them
+   * directly into the data of a \ref Gradient.
    */
   class ColorStopSequence:public reference_counted<ColorStopSequence>::non_concurrent_custom_delete
   {
   public:
+    enum
+      {
+        /*!
+         * The maximum number of color stops a sequence
+         * can have and be analytic.
+         */
+        max_analytic_colorstops = 3
+      };
+
     ~ColorStopSequence();
 
     /*!
      * Return where in the backing \ref ColorStopSequenceAtlas the
-     * color data of this \ref ColorStopSequence is located.
+     * color data of this \ref ColorStopSequence is located. If
+     * the sequence is analytic, returns an empty range.
      */
     range_type<int>
     location(void) const
     {
-      return m_interval->range();
+      return (m_interval) ?
+        m_interval->range() :
+        range_type<int>(0, 0);
     }
 
     /*!
      * Return what layer in the backing \ref ColorStopSequenceAtlas
-     * the color data of this \ref ColorStopSequence is located.
+     * the color data of this \ref ColorStopSequence is located. If
+     * the sequence is analytic, returns 0.
      */
     int
     layer(void) const
     {
-      return m_interval->layer();
+      return (m_interval) ?
+        m_interval->layer() :
+        0;
+    }
+
+    /*!
+     * If the sequence is analytic, returns its color stops
+     * sorted by \ref ColorStop::m_t with each \ref ColorStop::m_t
+     * clamped to [0, 1]; the array has between 1 and
+     * \ref max_analytic_colorstops elements. If the sequence
+     * is backed by texels in the \ref ColorStopSequenceAtlas,
+     * returns an empty array.
+     */
+    c_array<const ColorStop<vec4>>
+    analytic_colorstops(void) const
+    {
+      return c_array<const ColorStop<vec4>>(m_analytic_colorstops).sub_array(0, m_number_analytic_colorstops);
     }
 
     /*!
@@ -100,9 +135,18 @@ namespace astral
     {}
 
     reference_counted_ptr<ColorStopSequenceAtlas> m_atlas;
+    /* null if the sequence is analytic */
     const IntervalAllocator::Interval *m_interval;
     enum colorspace_t m_colorspace;
     bool m_opaque;
+
+    /* only the first m_number_analytic_colorstops are used */
+    vecN<ColorStop<vec4>, max_analytic_colorstops> m_analytic_colorstops;
+    unsigned int m_number_analytic_colorstops;
+
+    /* key into ColorStopSequenceAtlas::m_hash_table */
+    uint64_t m_key;
+    bool m_in_hash_table;
   };
 
 /*! @} */
@@ -569,6 +569,22 @@ namespace astral
     set_pixels(int lod, ivec2 location, ivec2 size, unsigned int row_width,
                c_array<const u8vec4> pixels);
 
+    /*!
+     * Set the pixels of LOD 0 of the entire image and set the pixels
+     * of every other LOD from them by successive 2x2 downsampling,
+     * see astral::downsample_texels(). Same restrictions as set_pixels().
+     * \param row_width the number of texels between the start
+     *                  of successive rows in the paramater
+     *                  texels;
+     * \param pixels pixel values of LOD 0 with alpha pre-multiplied,
+     *               its size must be atleast row_width * size().y()
+     * \param gamma_correct if true and colorspace() is \ref colorspace_srgb,
+     *                      the downsampling averages the linear values.
+     */
+    void
+    set_pixels_and_mipmaps(unsigned int row_width, c_array<const u8vec4> pixels,
+                           bool gamma_correct = false);
+
     /*!
      * Copy pixels from a single astral::ColorBuffer to the color backing.
      * The pixels taken from astral::ColorBuffer taken are those when
@@ -724,6 +740,44 @@ namespace astral
     bool
     tile_allocation_failed(void) const;
 
+    /*!
+     * Returns true if this astral::Image may be purged by its
+     * astral::ImageAtlas, see purgeable(bool). Default value
+     * is false.
+     */
+    bool
+    purgeable(void) const;
+
+    /*!
+     * Mark this astral::Image as purgeable. A purgeable image
+     * is one whose content can be regenerated by the caller and
+     * thus the astral::ImageAtlas may reclaim its color tiles
+     * when allocating color tiles would exceed the budget set by
+     * ImageAtlas::color_backing_byte_budget() or when allocating
+     * would fail outright. Purgeable images are purged least
+     * recently used first, where the recency is given by the last
+     * lock_resources()/unlock_resources() pair within which
+     * mark_in_use() was called on the image. An image that is
+     * in_use() or that is rendered to by astral::Renderer is
+     * never purged. Neither is an image that shares any of its
+     * astral::ImageMipElement objects with another holder since
+     * purging it would not release any texels.
+     */
+    void
+    purgeable(bool v);
+
+    /*!
+     * Returns true if the astral::ImageAtlas has purged this
+     * astral::Image, see purgeable(bool). A purged image keeps
+     * its size, ID and number of mipmap levels, but all of its
+     * tiles are empty tiles, i.e. all texels are (0, 0, 0, 0).
+     * The contents can not be restored; a caller should create
+     * a new astral::Image and upload its pixels again. A purged
+     * image is no longer purgeable.
+     */
+    bool
+    purged(void) const;
+
     /*!
      * Given an astral::MipmapLevel, return index into mip_chain()
      * to use to access the astral::ImageMipElement that holds the
@@ -33,6 +33,14 @@ namespace astral
   class ContourCurve;
   class Path;
   class CombinedPath;
+  class Typeface;
+
+  namespace detail
+  {
+    class SerializedWriter;
+    class SerializedReader;
+    class SerializedItemPath;
+  }
   ///@endcond
 
 /*!\addtogroup Renderer
@@ -460,12 +468,29 @@ namespace astral
     }
 
   private:
+    friend class Path;
+    friend class Typeface;
+
     class BandRegion;
     class BandedCurve;
     class Band;
 
     ItemPath(const Geometry &geometry, GenerationParams params);
 
+    ItemPath(void)
+    {}
+
+    /* Returns false if the data is no longer held on the CPU
+     * because it was uploaded to the GPU.
+     */
+    bool
+    serialize(detail::SerializedWriter &dst, detail::SerializedItemPath *out_record) const;
+
+    /* Returns nullptr if the record is not valid */
+    static
+    reference_counted_ptr<ItemPath>
+    deserialize(const detail::SerializedReader &src, const detail::SerializedItemPath &record);
+
     /* Upload to the GPU is delayed until the first
      * time it is needed
      */
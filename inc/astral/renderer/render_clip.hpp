@@ -18,6 +18,7 @@
 #define ASTRAL_RENDER_CLIP_HPP
 
 #include <astral/util/reference_counted.hpp>
+#include <astral/util/transformation.hpp>
 #include <astral/renderer/render_enums.hpp>
 #include <astral/renderer/mask_details.hpp>
 #include <astral/renderer/shader/item_path_shader.hpp>
@@ -37,7 +38,13 @@ namespace astral
    * An astral::RenderClipElement embodies a region in space
    * to which to clip against. This object is re-usable across
    * frames subject to that it is used by the same astral::Renderer
-   * object.
+   * object. The region is in the pixel coordinates of the encoder
+   * that made it, so a caller that keeps a RenderClipElement across
+   * frames must only use it again while the source paths and the
+   * transformation from logical to pixel coordinates are unchanged,
+   * see astral::RetainedRenderClip. Using it again skips generating
+   * the mask and, for those made by a RenderClipCombineResult, the
+   * combine passes as well.
    */
   class RenderClipElement:public reference_counted<RenderClipElement>::non_concurrent_custom_delete
   {
@@ -316,6 +323,103 @@ namespace astral
     RenderClipCombineResult(void)
     {}
   };
+
+  /*!
+   * \brief
+   * An astral::RetainedRenderClip holds an astral::RenderClipElement
+   * and an astral::RenderClipCombineResult across frames together
+   * with what they were made from: the transformation from logical
+   * to pixel coordinates of the encoder that made them and a key
+   * chosen by the caller that the caller changes whenever the source
+   * paths of the clip change. The contract is explicit: Astral does
+   * not track if paths change, the caller does by changing the key.
+   * A typical use is
+   * \code
+   * if (!retained.matches(encoder.transformation(), path_version))
+   *   {
+   *     retained.set(encoder.transformation(), path_version,
+   *                  clip_element, encoder.combine_clipping(*clip_element, path, params));
+   *   }
+   * encoder.begin_clip_node_pixel(blend_mode, flags, *retained.clip_combine_result(),
+   *                               clip_in_bbox, clip_out_bbox);
+   * \endcode
+   */
+  class RetainedRenderClip
+  {
+  public:
+    RetainedRenderClip(void):
+      m_key(0u)
+    {}
+
+    /*!
+     * Returns true if this astral::RetainedRenderClip holds
+     * a value made with the given transformation and key.
+     * \param tr transformation from logical to pixel coordinates
+     *           of the encoder about to use the clip
+     * \param key key of the source paths of the clip
+     */
+    bool
+    matches(const Transformation &tr, uint64_t key) const
+    {
+      return (m_clip_element || m_clip_combine_result)
+        && key == m_key
+        && tr.m_matrix == m_transformation.m_matrix
+        && tr.m_translate == m_transformation.m_translate;
+    }
+
+    /*!
+     * Set the values held.
+     * \param tr transformation from logical to pixel coordinates
+     *           of the encoder that made the values
+     * \param key key of the source paths of the clip
+     * \param clip_element astral::RenderClipElement to hold, may be null
+     * \param clip_combine_result astral::RenderClipCombineResult to hold, may be null
+     */
+    void
+    set(const Transformation &tr, uint64_t key,
+        const reference_counted_ptr<const RenderClipElement> &clip_element,
+        const reference_counted_ptr<const RenderClipCombineResult> &clip_combine_result = nullptr)
+    {
+      m_transformation = tr;
+      m_key = key;
+      m_clip_element = clip_element;
+      m_clip_combine_result = clip_combine_result;
+    }
+
+    /*!
+     * Release the values held.
+     */
+    void
+    clear(void)
+    {
+      m_clip_element = nullptr;
+      m_clip_combine_result = nullptr;
+    }
+
+    /*!
+     * Returns the astral::RenderClipElement passed to set().
+     */
+    const reference_counted_ptr<const RenderClipElement>&
+    clip_element(void) const
+    {
+      return m_clip_element;
+    }
+
+    /*!
+     * Returns the astral::RenderClipCombineResult passed to set().
+     */
+    const reference_counted_ptr<const RenderClipCombineResult>&
+    clip_combine_result(void) const
+    {
+      return m_clip_combine_result;
+    }
+
+  private:
+    Transformation m_transformation;
+    uint64_t m_key;
+    reference_counted_ptr<const RenderClipElement> m_clip_element;
+    reference_counted_ptr<const RenderClipCombineResult> m_clip_combine_result;
+  };
 /*! @} */
 }
 
@@ -318,6 +318,18 @@ namespace astral
          */
         number_sparse_fill_awkward_fully_clipped_or_unclipped,
 
+        /*!
+         * The number of nodes of the hierarchies of stroked
+         * paths visited on CPU for sparse stroking
+         */
+        number_sparse_stroke_nodes_visited,
+
+        /*!
+         * The number of leaves of the hierarchies of stroked
+         * paths visited on CPU for sparse stroking
+         */
+        number_sparse_stroke_leaves_visited,
+
         number_renderer_stats
       };
 
@@ -2220,6 +2232,23 @@ namespace astral
       draw_rect(rect, true, material, blend_mode);
     }
 
+    /*!
+     * Draw an astral::RoundedRect blurred by a Gaussian blur, for
+     * example a box shadow, with ShaderSet::m_blurred_rounded_rect_shader.
+     * The blur is computed analytically by the shader; there is no
+     * offscreen rendering. The color of the blurred rect comes from
+     * the material.
+     * \param rect rounded rect to blur
+     * \param sigma standard deviation of the Gaussian blur in logical
+     *              coordinates
+     * \param material the material and mask to apply to the draw
+     * \param blend_mode blend mode to apply to the draw
+     */
+    void
+    draw_blurred_rounded_rect(const RoundedRect &rect, float sigma,
+                              const ItemMaterial &material = ItemMaterial(),
+                              enum blend_mode_t blend_mode = blend_porter_duff_src_over) const;
+
     /*!
      * Draw the region of a mask with a material.
      * \param mask the mask to apply to the draw
@@ -3509,6 +3538,34 @@ namespace astral
     RenderEncoderShadowMap
     encoder_shadow_map_relative(int dimensions, vec2 light_p) const;
 
+    /*!
+     * Begin an offscreen render that regenerates the content of
+     * an existing astral::ShadowMap, i.e. for when the occluders
+     * of a shadow map retained from a previous frame changed. The
+     * render reuses the allocation of the shadow map in the atlas
+     * along with its dimensions and light position and
+     * RenderEncoderShadowMap::finish() returns the same object.
+     * If the shadow map cannot be rendered to because it is already
+     * used by a draw or rendered to within the current begin()/end()
+     * pair, then a new astral::ShadowMap of the same dimensions and
+     * light position is rendered to instead. Returned encoder inherits
+     * the rendering accuracy and the value of use_sub_ubers() of this
+     * encoder.
+     * \param shadow_map astral::ShadowMap whose content to regenerate
+     */
+    RenderEncoderShadowMap
+    encoder_shadow_map(const reference_counted_ptr<ShadowMap> &shadow_map) const;
+
+    /*!
+     * Equivalent to encoder_shadow_map(const reference_counted_ptr<ShadowMap>&)
+     * except that the returned encoder's logical coordinates are the same as
+     * the current logical coordinates, i.e. the shadow map regenerated is one
+     * created by encoder_shadow_map_relative().
+     * \param shadow_map astral::ShadowMap whose content to regenerate
+     */
+    RenderEncoderShadowMap
+    encoder_shadow_map_relative(const reference_counted_ptr<ShadowMap> &shadow_map) const;
+
     /*!
      * Create an astral::RenderEncoderStrokeMask used to generate a mask
      * from stroking paths. The returned object inherits the current value
@@ -0,0 +1,212 @@
+/*!
+ * \file blurred_rounded_rect_shader.hpp
+ * \brief file blurred_rounded_rect_shader.hpp
+ *
+ * Copyright 2020 by InvisionApp.
+ *
+ * Contact: kevinrogovin@invisionapp.com
+ *
+ * This Source Code Form is subject to the
+ * terms of the Mozilla Public License, v. 2.0.
+ * If a copy of the MPL was not distributed with
+ * this file, You can obtain one at
+ * http://mozilla.org/MPL/2.0/.
+ *
+ */
+
+#ifndef ASTRAL_BLURRED_ROUNDED_RECT_SHADER_HPP
+#define ASTRAL_BLURRED_ROUNDED_RECT_SHADER_HPP
+
+#include <astral/util/rect.hpp>
+#include <astral/util/rounded_rect.hpp>
+#include <astral/renderer/shader/item_shader.hpp>
+#include <astral/renderer/shader/item_data.hpp>
+
+namespace astral
+{
+  /*!
+   * \brief
+   * An astral::BlurredRoundedRectShader is for drawing an
+   * astral::RoundedRect blurred by a Gaussian blur, i.e. a
+   * box shadow, without rendering the rounded rect offscreen
+   * and blurring it. The shader computes the blur in closed
+   * form from the error function along x and integrates the
+   * result along y in a few pieces each weighted exactly by
+   * the Gaussian; the value is exact for rects with no
+   * rounding and the only approximation is in the corners.
+   * The shader emits vec4(1.0, 1.0, 1.0, 1.0) as the color
+   * value and the blurred rounded rect as the coverage, so the
+   * color of the shadow comes from the material of the draw.
+   *
+   * The packing of vertices is as follows:
+   *  - Vertex::m_data[0].f --> x-relative position, value is 0 or 1
+   *  - Vertex::m_data[1].f --> y-relative position, value is 0 or 1
+   *  .
+   * i.e. the same attribute data as astral::DynamicRectShader
+   *
+   * The ItemData is packed as:
+   *  - [0].x().f --> min-x corner of the area drawn
+   *  - [0].y().f --> min-y corner of the area drawn
+   *  - [0].z().f --> max-x corner of the area drawn
+   *  - [0].w().f --> max-y corner of the area drawn
+   *  - [1].x().f --> min-x corner of the rounded rect
+   *  - [1].y().f --> min-y corner of the rounded rect
+   *  - [1].z().f --> max-x corner of the rounded rect
+   *  - [1].w().f --> max-y corner of the rounded rect
+   *  - [2].xy().f --> RoundedRect::m_corner_radii[RoundedRect::minx_miny_corner]
+   *  - [2].zw().f --> RoundedRect::m_corner_radii[RoundedRect::maxx_miny_corner]
+   *  - [3].xy().f --> RoundedRect::m_corner_radii[RoundedRect::minx_maxy_corner]
+   *  - [3].zw().f --> RoundedRect::m_corner_radii[RoundedRect::maxx_maxy_corner]
+   *  - [4].x().f --> standard deviation of the Gaussian blur
+   *  - [4].yzw  --> free
+   */
+  class BlurredRoundedRectShader
+  {
+  public:
+    /*!
+     * \brief
+     * Enumeration describing how item data is packed for
+     * an astral::BlurredRoundedRectShader
+     */
+    enum item_data_packing:uint32_t
+      {
+        /*!
+         * Offset at which to pack the area drawn
+         */
+        coordinate_offset = 0,
+
+        /*!
+         * Offset at which to pack the rect of the rounded rect
+         */
+        rect_offset,
+
+        /*!
+         * Offset at which to pack the radii of the min-y corners
+         */
+        miny_radii_offset,
+
+        /*!
+         * Offset at which to pack the radii of the max-y corners
+         */
+        maxy_radii_offset,
+
+        /*!
+         * Offset at which to pack the standard deviation
+         */
+        sigma_offset,
+
+        /*!
+         * Number of item datas consumed.
+         */
+        item_data_size
+      };
+
+    /*!
+     * Empty ctor, leaving the object wihout a shader
+     */
+    BlurredRoundedRectShader(void)
+    {}
+
+    /*!
+     * Ctor giving it a shader.
+     * \param sh shader of the created object
+     */
+    BlurredRoundedRectShader(const reference_counted_ptr<const ColorItemShader> &sh):
+      m_shader(sh)
+    {}
+
+    /*!
+     * Ctor giving it a shader.
+     * \param sh shader of the created object
+     */
+    BlurredRoundedRectShader(const ColorItemShader *sh):
+      m_shader(sh)
+    {}
+
+    /*!
+     * Cast operator
+     */
+    operator const reference_counted_ptr<const ColorItemShader>&() const { return m_shader; }
+
+    /*!
+     * Cast operator
+     */
+    operator reference_counted_ptr<const ColorItemShader>&() { return m_shader; }
+
+    /*!
+     * overload operator*
+     */
+    const ColorItemShader& operator*(void) const { return *m_shader; }
+
+    /*!
+     * overload operator->
+     */
+    const ColorItemShader* operator->(void) const { ASTRALassert(m_shader); return m_shader.get(); }
+
+    /*!
+     * Return the pointer to the underlying shader
+     */
+    const ColorItemShader* get(void) const { return m_shader.get(); }
+
+    /*!
+     * Pack item data that the \ref ColorItemShader of a \ref
+     * BlurredRoundedRectShader accepts and return the area
+     * drawn, i.e. the rect to pass to the draw. The area drawn
+     * is the rounded rect enlarged by three times sigma on each
+     * side; beyond it the blurred rounded rect is less than
+     * 1/500.
+     * \param rect rounded rect to blur; the rect is
+     *             sanitized with RoundedRect::sanitize_simple()
+     * \param sigma standard deviation of the Gaussian blur
+     * \param dst location to which to write the item data
+     */
+    static
+    Rect
+    pack_item_data(RoundedRect rect, float sigma, c_array<gvec4> dst)
+    {
+      Rect draw_rect;
+      float pad;
+
+      ASTRALassert(dst.size() == item_data_size);
+
+      rect.sanitize_simple();
+      sigma = t_max(sigma, 0.0f);
+      pad = 3.0f * sigma;
+
+      draw_rect = rect;
+      draw_rect.outset(pad, pad);
+
+      dst[coordinate_offset].x().f = draw_rect.m_min_point.x();
+      dst[coordinate_offset].y().f = draw_rect.m_min_point.y();
+      dst[coordinate_offset].z().f = draw_rect.m_max_point.x();
+      dst[coordinate_offset].w().f = draw_rect.m_max_point.y();
+
+      dst[rect_offset].x().f = rect.m_min_point.x();
+      dst[rect_offset].y().f = rect.m_min_point.y();
+      dst[rect_offset].z().f = rect.m_max_point.x();
+      dst[rect_offset].w().f = rect.m_max_point.y();
+
+      dst[miny_radii_offset].x().f = rect.m_corner_radii[RoundedRect::minx_miny_corner].x();
+      dst[miny_radii_offset].y().f = rect.m_corner_radii[RoundedRect::minx_miny_corner].y();
+      dst[miny_radii_offset].z().f = rect.m_corner_radii[RoundedRect::maxx_miny_corner].x();
+      dst[miny_radii_offset].w().f = rect.m_corner_radii[RoundedRect::maxx_miny_corner].y();
+
+      dst[maxy_radii_offset].x().f = rect.m_corner_radii[RoundedRect::minx_maxy_corner].x();
+      dst[maxy_radii_offset].y().f = rect.m_corner_radii[RoundedRect::minx_maxy_corner].y();
+      dst[maxy_radii_offset].z().f = rect.m_corner_radii[RoundedRect::maxx_maxy_corner].x();
+      dst[maxy_radii_offset].w().f = rect.m_corner_radii[RoundedRect::maxx_maxy_corner].y();
+
+      dst[sigma_offset].x().f = sigma;
+      dst[sigma_offset].y().f = 0.0f;
+      dst[sigma_offset].z().f = 0.0f;
+      dst[sigma_offset].w().f = 0.0f;
+
+      return draw_rect;
+    }
+
+  private:
+    reference_counted_ptr<const ColorItemShader> m_shader;
+  };
+}
+
+#endif
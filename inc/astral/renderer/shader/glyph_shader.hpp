@@ -47,8 +47,9 @@ namespace astral
    *  - [0].y().f --> y-pen position of glyph
    *  - [0].z().f --> width of glyph
    *  - [0].w().f --> height of glyph
-   *  - [1].x().u --> astral::StaticData::location() of Glyph::render_data()
-   *                  or Glyph::image_render_data()
+   *  - [1].x().u --> astral::StaticData::location() of Glyph::render_data(),
+   *                  Glyph::distance_field_render_data() or
+   *                  Glyph::image_render_data()
    *  - [2].y.u() --> flags, see GlyphShader::flags_t
    *  - [2].zw   --> free
    */
@@ -64,6 +65,17 @@ namespace astral
          * If bit is up, then glyph is a colored glyph
          */
         is_colored_glyph = 1u,
+
+        /*!
+         * If bit is up, then the static data of the glyph is
+         * from Glyph::distance_field_render_data() instead of
+         * Glyph::render_data() and the glyph is drawn by sampling
+         * its distance field instead of evaluating its curves.
+         * Such glyphs observe SyntheticData::m_thicken only up
+         * to half a texel of the coarsest mipmap level of the
+         * distance field.
+         */
+        is_distance_field_glyph = 2u,
       };
 
     /*!
@@ -92,7 +104,8 @@ namespace astral
        * \param out_pen_position location to which to write the position
        *                         of the pen of the idx'th element.
        * \param out_shared_data_location value of astral::StaticData::location()
-       *                                 of Glyph::image_render_data() or
+       *                                 of Glyph::image_render_data(),
+       *                                 Glyph::distance_field_render_data() or
        *                                 Glyph::render_data()
        * \returns returns the flags of the glyph enumerated by \ref flags_t
        */
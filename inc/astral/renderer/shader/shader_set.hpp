@@ -22,6 +22,7 @@
 #include <astral/renderer/shader/fill_stc_shader.hpp>
 #include <astral/renderer/shader/blit_mask_tile_shader.hpp>
 #include <astral/renderer/shader/dynamic_rect_shader.hpp>
+#include <astral/renderer/shader/blurred_rounded_rect_shader.hpp>
 #include <astral/renderer/shader/stroke_shader.hpp>
 #include <astral/renderer/shader/item_path_shader.hpp>
 #include <astral/renderer/shader/glyph_shader.hpp>
@@ -84,6 +85,13 @@ namespace astral
      */
     MaskedRectShader m_masked_rect_shader;
 
+    /*!
+     * A shader to draw a Gaussian blurred astral::RoundedRect
+     * computed analytically. Shader emits vec4(1.0, 1.0, 1.0, 1.0)
+     * as color value and the blurred rounded rect as coverage.
+     */
+    BlurredRoundedRectShader m_blurred_rounded_rect_shader;
+
     /*!
      * Shader used to perform tile-by-tile drawing to combine
      * a pre-exising mask M with the generation of a new mask
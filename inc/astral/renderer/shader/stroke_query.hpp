@@ -22,6 +22,13 @@
 
 namespace astral
 {
+///@cond
+  namespace detail
+  {
+    class StrokeQueryCullingTest;
+  }
+///@endcond
+
   /*!
    * \brief
    * An astral::StrokeQuery is to query what pixel-rects to render
@@ -351,6 +358,22 @@ namespace astral
     ivec2
     number_elementary_rects(void) const;
 
+    /*!
+     * Returns the number of nodes of the hierarchies of the
+     * elements added to the current or last query whose
+     * bounding box was tested by the query.
+     */
+    unsigned int
+    number_nodes_visited(void) const;
+
+    /*!
+     * Returns the number of leaves of the hierarchies of the
+     * elements added to the current or last query whose
+     * bounding box was tested by the query.
+     */
+    unsigned int
+    number_leaves_visited(void) const;
+
     /*!
      * Clear the query to empty.
      */
@@ -358,6 +381,8 @@ namespace astral
     clear(void);
     
   private:
+    friend class detail::StrokeQueryCullingTest;
+
     StrokeQuery(void)
     {}
 
@@ -367,6 +392,57 @@ namespace astral
     const Implement&
     implement(void) const;
   };
+
+///@cond
+  namespace detail
+  {
+    /* Test-only hook to choose how a StrokeQuery computes and
+     * culls the bounding boxes of the children of a node of the
+     * hierarchy of a stroke; a StrokeQuery always uses SIMD
+     * culling unless told otherwise through this class. The
+     * results of a query are the same for each value.
+     */
+    class StrokeQueryCullingTest
+    {
+    public:
+      enum child_culling_t:uint32_t
+        {
+          /* compute the boxes one at a time and compute the
+           * range of tiles of each box, including those that
+           * miss the query
+           */
+          child_culling_scalar,
+
+          /* compute the boxes and reject those that miss the
+           * query four at a time with SIMD instructions; this
+           * is the default
+           */
+          child_culling_simd,
+
+          /* as child_culling_simd, but also compute the boxes
+           * as child_culling_scalar does and count the boxes
+           * that differ in number_child_culling_mismatches()
+           */
+          child_culling_checked,
+        };
+
+      /* set how query computes and culls child boxes */
+      static
+      void
+      child_culling(StrokeQuery &query, enum child_culling_t v);
+
+      /* if the child culling of query is child_culling_checked,
+       * returns the number of boxes of the current or last query
+       * whose value or whose being culled differed between the
+       * SIMD and scalar computations; if there are no bugs, this
+       * is zero
+       */
+      static
+      unsigned int
+      number_child_culling_mismatches(const StrokeQuery &query);
+    };
+  }
+///@endcond
 }
 
 #endif
@@ -33,6 +33,7 @@
 namespace astral
 {
   class StrokeQuery;
+  class ThreadPool;
 
   /*!
    * \brief
@@ -103,6 +104,32 @@ namespace astral
         path_shader_count,
       };
 
+    /*!
+     * \brief
+     * Enumeration to specify how the hierarchy of a
+     * StrokeShader::CookedData used by astral::StrokeQuery
+     * to cull a static path is built
+     */
+    enum hierarchy_builder_t:uint32_t
+      {
+        /*!
+         * Recursively halve the bounding box along the axis
+         * that has fewer elements straddling the halves.
+         * Fast to build, this is the default.
+         */
+        midpoint_hierarchy_builder = 0,
+
+        /*!
+         * Recursively split the elements at the binned split
+         * that minimizes the surface area heuristic. Slower to
+         * build than \ref midpoint_hierarchy_builder, but
+         * queries on huge paths visit fewer leaves; large
+         * sub-trees can be built by the threads of an
+         * astral::ThreadPool.
+         */
+        sah_hierarchy_builder,
+      };
+
     /*!
      * \brief
      * enumeration to describe the capper shaders
@@ -1501,10 +1528,19 @@ namespace astral
      * \param engine the astral::RenderEngine used
      * \param input specifies the path geometry
      * \param output provides the data to feed the renderer
+     * \param builder specifies how to build the hierarchy used
+     *                by astral::StrokeQuery
+     * \param thread_pool if non-null and builder is \ref
+     *                    sah_hierarchy_builder, large sub-trees of
+     *                    the hierarchy are built by the threads of
+     *                    thread_pool; the function returns only
+     *                    once they are all built
      */
     static
     void
-    create_render_data(RenderEngine &engine, const RawData &input, CookedData *output);
+    create_render_data(RenderEngine &engine, const RawData &input, CookedData *output,
+                       enum hierarchy_builder_t builder = midpoint_hierarchy_builder,
+                       ThreadPool *thread_pool = nullptr);
 
     /*!
      * Fill in the fields of a StrokeShader::CookedData for the
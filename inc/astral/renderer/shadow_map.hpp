@@ -94,12 +94,15 @@ namespace astral
     /*!
      * Resize the atlas to be atleast the
      * specified size. Returns the actual
-     * height after the resize.
+     * height after the resize. The atlas
+     * can only be shrunk by astral::ShadowMapAtlas
+     * when there are no shadow maps on the rows
+     * that are removed.
      */
     unsigned int
     height(unsigned int L)
     {
-      ASTRALassert(L >= height());
+      ASTRALassert((L & 3u) == 0u);
       m_height = on_resize(L);
       return m_height;
     }
@@ -160,7 +163,10 @@ namespace astral
      * To be implemented by a derived class to resize the atlas.
      * The value of height() is the value -before- the
      * resize is to occur. To return the actual height after
-     * teh resize. The return value must be even.
+     * teh resize. The return value must be even. If new_height
+     * is less than height(), the content of the rows that
+     * remain must be preserved and the content of the removed
+     * rows is discarded.
      */
     virtual
     unsigned int
@@ -268,6 +274,94 @@ namespace astral
     ShadowMap*
     fetch_shadow_map(ShadowMapID ID);
 
+    /*!
+     * Set the number of consecutive frames, i.e. outer-most
+     * unlock_resources() calls, that the rows at the end of
+     * the backing must have no shadow maps on them before
+     * the backing is shrunk to remove them. The backing is
+     * never shrunk below the height it had when this
+     * astral::ShadowMapAtlas was created. A value of zero
+     * disables shrinking. Default value is zero.
+     */
+    void
+    shrink_after_idle_frames(unsigned int v)
+    {
+      m_shrink_after_idle_frames = v;
+    }
+
+    /*!
+     * Returns the value set by shrink_after_idle_frames(unsigned int).
+     */
+    unsigned int
+    shrink_after_idle_frames(void) const
+    {
+      return m_shrink_after_idle_frames;
+    }
+
+    /*!
+     * Returns the number of astral::ShadowMap objects alive.
+     */
+    unsigned int
+    number_shadow_maps(void) const;
+
+    /*!
+     * Returns the number of texels of the backing used by
+     * the astral::ShadowMap objects alive, i.e. the sum of
+     * 4 * ShadowMap::dimensions().
+     */
+    unsigned int
+    texels_used(void) const
+    {
+      return 4u * m_dimensions_used;
+    }
+
+    /*!
+     * Returns the number of texels of the backing allocated,
+     * this is at least texels_used() because the size of each
+     * astral::ShadowMap is rounded up to its size class and
+     * because the region of a released astral::ShadowMap is
+     * only reclaimed at unlock_resources().
+     */
+    unsigned int
+    texels_allocated(void) const
+    {
+      return 4u * m_interval_allocator.space_allocated();
+    }
+
+    /*!
+     * Returns the number of texels of the backing, i.e.
+     * ShadowMapAtlasBacking::width() * ShadowMapAtlasBacking::height().
+     */
+    unsigned int
+    texels_total(void) const
+    {
+      return m_backing->width() * m_backing->height();
+    }
+
+    /*!
+     * Returns the number of rows of the backing that
+     * have been removed by shrinking over the lifetime
+     * of this astral::ShadowMapAtlas.
+     */
+    unsigned int
+    total_rows_reclaimed(void) const
+    {
+      return m_total_rows_reclaimed;
+    }
+
+    /*!
+     * Returns the size class of an astral::ShadowMap, i.e.
+     * the length of the region of the backing allocated for
+     * a shadow map with the given dimensions. Size classes
+     * are powers of two so that the region released by one
+     * shadow map can be reused exactly by another shadow map
+     * of the same size class, which keeps the free space from
+     * fragmenting as lights of different sizes come and go.
+     * \param D dimensions of the astral::ShadowMap
+     */
+    unsigned int
+    size_class(unsigned int D) const;
+
   private:
     friend class ShadowMap;
     class MemoryPool;
@@ -278,6 +372,9 @@ namespace astral
     const IntervalAllocator::Interval*
     allocate_interval(unsigned int sz);
 
+    void
+    shrink_if_idle(void);
+
     void
     release(const IntervalAllocator::Interval*);
 
@@ -322,6 +419,25 @@ namespace astral
 
     /* pool to allocate ShadowMap objects */
     MemoryPool *m_pool;
+
+    /* height of the backing at creation, shrinking
+     * never goes below this value
+     */
+    unsigned int m_initial_height;
+
+    /* see shrink_after_idle_frames() */
+    unsigned int m_shrink_after_idle_frames;
+
+    /* number of consecutive frames that rows at the
+     * end of the backing have had no shadow maps
+     */
+    unsigned int m_idle_frames;
+
+    /* sum of ShadowMap::dimensions() over alive ShadowMap */
+    unsigned int m_dimensions_used;
+
+    /* see total_rows_reclaimed() */
+    unsigned int m_total_rows_reclaimed;
   };
 
   /*!
@@ -387,6 +503,20 @@ namespace astral
    * occluded = (depth < p_depth);
    *
    * \endcode
+   *
+   * The content of an astral::ShadowMap remains in the atlas for
+   * as long as a reference to it is held, across any number of
+   * Renderer::begin()/Renderer::end() pairs. When the light and
+   * the occluders of a shadow map do not change from one frame
+   * to the next, the caller should keep the astral::ShadowMap
+   * returned by RenderEncoderShadowMap::finish() and use it again
+   * in later frames; such a shadow map has no offscreen render,
+   * i.e. drawing with it adds no work to the shadow map passes
+   * of Renderer::end(). When the occluders do change, the content
+   * can be regenerated in place, i.e. without a new allocation in
+   * the atlas, with RenderEncoderBase::encoder_shadow_map(const reference_counted_ptr<ShadowMap>&).
+   * Astral never tracks if the occluders of a shadow map changed;
+   * a retained shadow map is re-rendered only when the caller asks.
    */
   class ShadowMap:public reference_counted<ShadowMap>::non_concurrent_custom_delete
   {
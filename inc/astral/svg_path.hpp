@@ -0,0 +1,117 @@
+/*!
+ * \file svg_path.hpp
+ * \brief file svg_path.hpp
+ *
+ * Copyright 2019 by InvisionApp.
+ *
+ * Contact: kevinrogovin@invisionapp.com
+ *
+ * This Source Code Form is subject to the
+ * terms of the Mozilla Public License, v. 2.0.
+ * If a copy of the MPL was not distributed with
+ * this file, You can obtain one at
+ * http://mozilla.org/MPL/2.0/.
+ *
+ */
+
+#ifndef ASTRAL_SVG_PATH_HPP
+#define ASTRAL_SVG_PATH_HPP
+
+#include <astral/util/util.hpp>
+#include <astral/util/vecN.hpp>
+#include <astral/util/rect.hpp>
+#include <astral/path.hpp>
+
+namespace astral
+{
+
+/*!\addtogroup Paths
+ * @{
+ */
+
+  /*!
+   * Parse SVG path data, i.e. the value of the "d" attribute of
+   * an SVG path element, and add the contours it describes to an
+   * astral::Path. The data is parsed in a single pass and each
+   * command is added to the astral::Path as it is read with no
+   * intermediate storage: lines, quadratic and cubic bezier curves
+   * are added as they are, circular arcs are added with
+   * Path::arc_to() and elliptic arcs are added as conics, i.e. no
+   * curve is promoted to a cubic bezier curve.
+   *
+   * As the SVG specification requires, if an error is encountered
+   * the contours described by the data up to the error are added.
+   * \param begin pointer to the first character of the path data
+   * \param end pointer to one past the last character of the path data
+   * \param dst astral::Path to which to add the contours
+   * \returns routine_success if all of the path data was parsed
+   *          and routine_fail if an error was encountered
+   */
+  enum return_code
+  add_svg_path_data(const char *begin, const char *end, Path *dst);
+
+  /*!
+   * Overload of add_svg_path_data() for a nul-terminated string.
+   */
+  enum return_code
+  add_svg_path_data(c_string d, Path *dst);
+
+  /*!
+   * Parse the value of the "points" attribute of an SVG polyline
+   * or polygon element and add it as a contour to an astral::Path.
+   * If the list has an odd number of coordinates, the last one is
+   * dropped and routine_fail is returned.
+   * \param begin pointer to the first character of the points list
+   * \param end pointer to one past the last character of the points list
+   * \param closed if true, the contour is closed as for a polygon,
+   *               otherwise it is left open as for a polyline
+   * \param dst astral::Path to which to add the contour
+   */
+  enum return_code
+  add_svg_points(const char *begin, const char *end, bool closed, Path *dst);
+
+  /*!
+   * Overload of add_svg_points() for a nul-terminated string.
+   */
+  enum return_code
+  add_svg_points(c_string points, bool closed, Path *dst);
+
+  /*!
+   * Add the contour of an SVG rect element to an astral::Path.
+   * The radii are resolved as in the SVG specification: a negative
+   * radius is "auto" and takes the value of the other radius and
+   * the radii are clamped to half of the width and height of the
+   * rect. The corners are added with Path::arc_to() if they are
+   * circular and as conics otherwise.
+   * \param rect the rect, i.e. the x, y, width and height attributes
+   * \param radii the rx and ry attributes
+   * \param dst astral::Path to which to add the contour
+   */
+  void
+  add_svg_rect(const Rect &rect, vec2 radii, Path *dst);
+
+  /*!
+   * Add the contour of an SVG ellipse element to an astral::Path;
+   * an SVG circle element is an ellipse with equal radii. The
+   * contour is added with Path::arc_to() if the radii are equal
+   * and as conics otherwise.
+   * \param center the cx and cy attributes
+   * \param radii the rx and ry attributes
+   * \param dst astral::Path to which to add the contour
+   */
+  void
+  add_svg_ellipse(vec2 center, vec2 radii, Path *dst);
+
+  /*!
+   * Add the contour of an SVG line element to an astral::Path.
+   * \param p0 the x1 and y1 attributes
+   * \param p1 the x2 and y2 attributes
+   * \param dst astral::Path to which to add the contour
+   */
+  void
+  add_svg_line(vec2 p0, vec2 p1, Path *dst);
+
+/*! @} */
+}
+
+#endif
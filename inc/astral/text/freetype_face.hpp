@@ -94,6 +94,20 @@ namespace astral
       create_glyph_generator(unsigned int number_threads,
                              reference_counted_ptr<FreetypeLib> lib) const;
 
+      /*!
+       * Returns a string that identifies the font data and the
+       * face index, used as the value of GlyphGenerator::cache_key()
+       * of the generators made by create_glyph_generator(). The
+       * default implementation returns an empty string, i.e. the
+       * glyphs are not cached.
+       */
+      virtual
+      std::string
+      cache_key(void) const
+      {
+        return std::string();
+      }
+
     protected:
       /*!
        * To be implemented by a derived class to create a
@@ -129,6 +143,15 @@ namespace astral
       ~GeneratorFile()
       {}
 
+      /*!
+       * Returns a string made from the path, the size and the
+       * modification time of the file and the face index; the
+       * contents of the file are not read.
+       */
+      virtual
+      std::string
+      cache_key(void) const override;
+
     protected:
       virtual
       FT_Face
@@ -184,6 +207,15 @@ namespace astral
       ~GeneratorMemory()
       {}
 
+      /*!
+       * Returns a string made from a hash and the size of the
+       * font data and the face index; the hash is computed on
+       * the first call and stored.
+       */
+      virtual
+      std::string
+      cache_key(void) const override;
+
     protected:
       virtual
       FT_Face
@@ -197,6 +229,8 @@ namespace astral
 
       reference_counted_ptr<const DataBufferBase> m_buffer;
       int m_face_index;
+      mutable std::once_flag m_cache_key_once;
+      mutable std::string m_cache_key;
     };
 
     /*!
@@ -217,6 +251,15 @@ namespace astral
       ~GeneratorResource()
       {}
 
+      /*!
+       * Returns a string made from a hash and the size of the
+       * font data and the face index; the hash is computed on
+       * the first call and stored.
+       */
+      virtual
+      std::string
+      cache_key(void) const override;
+
     protected:
       virtual
       FT_Face
@@ -225,6 +268,8 @@ namespace astral
     private:
       c_array<const uint8_t> m_buffer;
       int m_face_index;
+      mutable std::once_flag m_cache_key_once;
+      mutable std::string m_cache_key;
     };
 
     /*!
@@ -48,6 +48,36 @@ namespace astral
   class Glyph
   {
   public:
+    /*!
+     * Enumeration giving the parameters of the distance
+     * field images of scalable glyphs, see
+     * distance_field_render_data().
+     */
+    enum distance_field_properties_t:uint32_t
+      {
+        /*!
+         * The pixel size, i.e. the number of texels per EM,
+         * of the base level of the distance field image
+         * of a glyph.
+         */
+        distance_field_pixel_size = 64u,
+
+        /*!
+         * The number of texels of the base level of the
+         * distance field image on each side of the glyph.
+         */
+        distance_field_padding = 2u,
+
+        /*!
+         * The number of mipmap levels of the distance field
+         * image of a glyph; the dimensions of the base level
+         * are a multiple of 2^(distance_field_number_mipmap_levels - 1)
+         * so that each mipmap level is exactly half the size
+         * of the level before it.
+         */
+        distance_field_number_mipmap_levels = 4u,
+      };
+
     /*!
      * Default ctor initializes the glyph as invalid.
      */
@@ -220,6 +250,28 @@ namespace astral
     image_render_data(RenderEngine &engine, unsigned int strike_index,
                       reference_counted_ptr<const Image> *out_image = nullptr) const;
 
+    /*!
+     * Returns the astral::StaticData holding an astral::ImageSampler,
+     * as packed by RenderEngine::pack_image_sampler_as_static_data(),
+     * of a distance field image of the glyph. The distance field is
+     * computed on the CPU from path() the first time it is requested
+     * at a resolution of \ref distance_field_pixel_size with
+     * \ref distance_field_number_mipmap_levels mipmap levels, each
+     * level computed from the path at its own resolution. The image
+     * is \ref distance_field_padding texels of the base level larger
+     * on each side than the glyph; shaders using the image should map
+     * [0, 1]x[0, 1] to [P, W - P]x[P, H - P] where P is the padding and
+     * (W, H) is astral::Image::size(). The distance field values are
+     * in units of texels of the mipmap level sampled. If the glyph is
+     * not scalable or is colored, returns nullptr.
+     * \param engine astral::RenderEngine to use to realize the data
+     * \param out_image if non-null, location to which to write
+     *                  a reference to the image
+     */
+    reference_counted_ptr<const StaticData>
+    distance_field_render_data(RenderEngine &engine,
+                               reference_counted_ptr<const Image> *out_image = nullptr) const;
+
   private:
     friend class Typeface;
     class Private;
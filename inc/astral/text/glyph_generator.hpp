@@ -17,6 +17,7 @@
 #ifndef ASTRAL_GLYPH_GENERATOR_HPP
 #define ASTRAL_GLYPH_GENERATOR_HPP
 
+#include <string>
 #include <astral/util/c_array.hpp>
 #include <astral/util/vecN.hpp>
 #include <astral/util/reference_counted.hpp>
@@ -174,6 +175,24 @@ namespace astral
                      ivec2 *out_image_size,
                      std::vector<FixedPointColor_sRGB> *out_pixels) const = 0;
 
+    /*!
+     * Returns a string that identifies the glyph data produced
+     * by this astral::GlyphGenerator, i.e. two generators that
+     * return the same non-empty string produce the same glyphs.
+     * The string is used to key the on-disk glyph cache of an
+     * astral::Typeface, see Typeface::glyph_cache_directory(),
+     * and thus is to only have characters that are valid in a
+     * filename. The default implementation returns an empty
+     * string which indicates that the glyphs are not to be
+     * cached.
+     */
+    virtual
+    std::string
+    cache_key(void) const
+    {
+      return std::string();
+    }
+
     /*!
      * Returns (and creates on demand) a astral::GlyphGenerator
      * consisting of a single tofu-glyph.
@@ -65,6 +65,59 @@ namespace astral
         use_nearest_strike,
       };
 
+    /*!
+     * Enumeration to decide how glyphs that come from
+     * scalable typefaces are rendered.
+     */
+    enum scalable_glyph_handling_t
+      {
+        /*!
+         * Always render the glyphs from the data of
+         * Glyph::render_data(), i.e. by evaluating the
+         * curves of the glyph per pixel.
+         */
+        use_item_path_glyphs,
+
+        /*!
+         * When the glyphs appear at a pixel size no more
+         * than twice Glyph::distance_field_pixel_size,
+         * render those glyphs whose curves are expensive
+         * to evaluate per pixel from the data of
+         * Glyph::distance_field_render_data() instead;
+         * the choice is made per glyph from the average
+         * number of curves per pixel of the glyph as given
+         * by ItemPath::Properties::m_average_render_cost.
+         * Colored glyphs are always rendered from
+         * Glyph::render_data().
+         */
+        use_distance_field_glyphs_when_cheaper,
+      };
+
+    /*!
+     * Enumeration to decide how add_glyph() and add_glyphs()
+     * handle glyphs whose data has not yet been generated by
+     * the astral::Typeface, see Typeface::glyph_ready().
+     */
+    enum pending_glyph_handling_t
+      {
+        /*!
+         * Generate the glyph data, or wait for it to be
+         * generated, when the glyph is added. The glyph
+         * is always drawn.
+         */
+        wait_for_glyphs,
+
+        /*!
+         * Request with Typeface::prefetch_glyphs() that the
+         * glyph data be generated and do not wait for it.
+         * Until update_pending_glyphs() finds the glyph ready,
+         * the glyph is a pending glyph that is not drawn; a
+         * caller can use pending_glyph() to draw placeholders
+         * for the pending glyphs.
+         */
+        skip_pending_glyphs,
+      };
+
     /*!
      * Ctor.
      * \param font what astral::Font to use
@@ -112,6 +165,75 @@ namespace astral
     void
     clear(const Font &font);
 
+    /*!
+     * Set how glyphs that are not yet ready are handled
+     * by add_glyph() and add_glyphs(); the default value
+     * is \ref wait_for_glyphs.
+     */
+    void
+    pending_glyph_handling(enum pending_glyph_handling_t v)
+    {
+      m_pending_glyph_handling = v;
+    }
+
+    /*!
+     * Returns how glyphs that are not yet ready are
+     * handled by add_glyph() and add_glyphs().
+     */
+    enum pending_glyph_handling_t
+    pending_glyph_handling(void) const
+    {
+      return m_pending_glyph_handling;
+    }
+
+    /*!
+     * Set how glyphs of a scalable typeface are rendered;
+     * the default value is \ref use_item_path_glyphs. Has
+     * no effect if the typeface of font() is not scalable.
+     */
+    void
+    scalable_glyph_handling(enum scalable_glyph_handling_t v);
+
+    /*!
+     * Returns how glyphs of a scalable typeface are rendered.
+     */
+    enum scalable_glyph_handling_t
+    scalable_glyph_handling(void) const
+    {
+      return m_scalable_glyph_handling;
+    }
+
+    /*!
+     * Add the pending glyphs that have become ready to this
+     * astral::TextItem; the pending glyphs that are added
+     * are appended in the order they were added with
+     * add_glyph() or add_glyphs(). If pending_glyph_handling()
+     * is \ref wait_for_glyphs, all pending glyphs are added,
+     * waiting for them as necessary. Returns the number of
+     * glyphs still pending.
+     */
+    unsigned int
+    update_pending_glyphs(void);
+
+    /*!
+     * Returns the number of glyphs added that are pending,
+     * i.e. not drawn because they were not ready when added
+     * and have not yet been added by update_pending_glyphs().
+     */
+    unsigned int
+    number_pending_glyphs(void) const;
+
+    /*!
+     * Get the named pending glyph.
+     * \param idx index of the pending glyph with 0 <= idx < number_pending_glyphs()
+     * \param out_glyph_index if non-null, location to which to write the glyph index
+     * \param out_position if non-null, location to which to write the pen position
+     * \param out_palette if non-null, location to which to write palette
+     */
+    void
+    pending_glyph(unsigned int idx, GlyphIndex *out_glyph_index,
+                  vec2 *out_position, GlyphPaletteID *out_palette = nullptr) const;
+
     /*!
      * Add a single glyph.
      * \param glyph_index astral::GlyphIndex that picks the glyph
@@ -161,7 +283,11 @@ namespace astral
      * Create on demand the rendering data to render the text item
      * \param zoom_factor zooming factor applied to the drawing of the text
      *                    item. This value is used to select what strike from
-     *                    a non-scalable typeface to use.
+     *                    a non-scalable typeface to use and, if
+     *                    scalable_glyph_handling() is \ref
+     *                    use_distance_field_glyphs_when_cheaper, if
+     *                    glyphs of a scalable typeface may be drawn
+     *                    from their distance fields.
      * \param engine astral::RenderEngine from which to allocate vertices and indices
      * \param out_strike_index if non-null returns the strike used for non-scalable
      *                         glyphs. For scalable glyphs, will write the value -1.
@@ -229,6 +355,7 @@ namespace astral
 
   private:
     class PerGlyph;
+    class PendingGlyph;
     class GlyphElements;
     class ScalableGlyphElements;
     class ImageGlyphElements;
@@ -247,10 +374,14 @@ namespace astral
     vecN<std::vector<const Path*>, number_fill_rule> m_combined_path_backings;
     vecN<std::vector<vec2>, number_fill_rule> m_combined_path_translate_backings;
     std::vector<unsigned int> m_color_glyphs;
+    std::vector<PendingGlyph> m_pending_glyphs;
+    enum pending_glyph_handling_t m_pending_glyph_handling;
+    enum scalable_glyph_handling_t m_scalable_glyph_handling;
 
     /* Scalable typefaces have only one element in this
-     * array where as non-scaleable typefaces have one
-     * element per strike.
+     * array, or two elements if distance field glyphs
+     * are used, where as non-scaleable typefaces have
+     * one element per strike.
      */
     mutable std::vector<PerRenderSize> m_per_render_size;
   };
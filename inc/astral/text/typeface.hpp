@@ -21,6 +21,7 @@
 #include <astral/util/c_array.hpp>
 #include <astral/util/vecN.hpp>
 #include <astral/util/reference_counted.hpp>
+#include <astral/util/thread_pool.hpp>
 #include <astral/text/glyph.hpp>
 #include <astral/text/glyph_generator.hpp>
 #include <astral/text/typeface_metrics.hpp>
@@ -144,15 +145,71 @@ namespace astral
      * Fetch a sequence of astral::Glyph values using
      * multiple threads. The use case is to spread the
      * CPU load of generating the glyph data across
-     * many threads. This function can be called mutiple
+     * many threads. The glyphs are generated by the
+     * threads of glyph_thread_pool() together with the
+     * calling thread. This function can be called mutiple
      * times simutansously from -DIFFERENT- astral::Typeface
      * objects.
+     * \param number_threads maximum number of threads, including
+     *                       the calling thread, to use; the value
+     *                       is clamped to GlyphGenerator::number_threads()
+     *                       of the generator of the astral::Typeface
+     * \param glyph_indices which glyphs to fetch
+     * \param out_glyphs location to which to write the glyphs
      */
     void
     fetch_glyphs_parallel(unsigned int number_threads,
                           c_array<const GlyphIndex> glyph_indices,
                           c_array<Glyph> out_glyphs);
 
+    /*!
+     * Request that the named glyphs be generated by the threads
+     * of glyph_thread_pool(). This function returns immediately;
+     * use glyph_ready() to query if a glyph has been generated.
+     * Calling fetch_glyph() on a glyph that is not yet ready
+     * blocks until the glyph is generated; if the generation of
+     * the glyph has not yet started, the calling thread generates
+     * the glyph itself.
+     * \param glyph_indices which glyphs to generate
+     */
+    void
+    prefetch_glyphs(c_array<const GlyphIndex> glyph_indices);
+
+    /*!
+     * Returns true if the named glyph has been generated,
+     * i.e. if fetch_glyph() will return without generating
+     * or waiting for the glyph data.
+     */
+    bool
+    glyph_ready(GlyphIndex glyph_code) const;
+
+    /*!
+     * Returns the number of glyphs requested by prefetch_glyphs()
+     * or fetch_glyphs_parallel() that are not yet ready.
+     */
+    unsigned int
+    number_glyphs_pending(void) const;
+
+    /*!
+     * Set the astral::ThreadPool used by all astral::Typeface
+     * objects to generate glyphs for prefetch_glyphs() and
+     * fetch_glyphs_parallel(). An astral::Typeface uses the
+     * value at its first call to one of those methods. If never
+     * set, a pool with ThreadPool::default_number_threads()
+     * threads is created when first needed.
+     */
+    static
+    void
+    glyph_thread_pool(const reference_counted_ptr<ThreadPool> &pool);
+
+    /*!
+     * Returns the astral::ThreadPool used to generate glyphs
+     * for prefetch_glyphs() and fetch_glyphs_parallel().
+     */
+    static
+    reference_counted_ptr<ThreadPool>
+    glyph_thread_pool(void);
+
     /*!
      * Specifies how scalable glyphs are realized as
      * astral::ItemPath values.
@@ -177,6 +234,141 @@ namespace astral
     void
     default_item_path_params(const ItemPath::GenerationParams&);
 
+    /*!
+     * Set the directory of the on-disk glyph cache used by the
+     * scalable astral::Typeface objects created afterwards whose
+     * GlyphGenerator::cache_key() is not empty. An astral::Typeface
+     * uses one file of the directory keyed by the cache key and by
+     * item_path_params(). The file holds, for each non-colored glyph
+     * generated by a previous process, the astral::Path, metrics and
+     * astral::ItemPath data of the glyph. The file is memory mapped
+     * when the astral::Typeface is created and a glyph is read from
+     * it, instead of being generated, when the glyph is first fetched.
+     * The glyphs generated that are not in the file are added to it
+     * by save_glyph_cache(), which the dtor of astral::Typeface also
+     * calls; see save_glyph_cache() on the disk I/O this adds to
+     * releasing a Typeface. The directory must already exist. An
+     * empty string, the default value, disables the cache.
+     */
+    static
+    void
+    glyph_cache_directory(c_string dir);
+
+    /*!
+     * Returns the value set by glyph_cache_directory(c_string).
+     */
+    static
+    c_string
+    glyph_cache_directory(void);
+
+    /*!
+     * Write the on-disk glyph cache file of this astral::Typeface
+     * if glyphs not in the file were generated since the file was
+     * last read or written. The file is written to a temporary file
+     * that then replaces the cache file so that a reader never sees
+     * a partially written file. Returns routine_fail if this
+     * astral::Typeface does not use a glyph cache or if writing the
+     * file failed.
+     *
+     * The dtor of astral::Typeface calls this as well, so releasing
+     * the last reference to a Typeface that has unsaved glyphs
+     * blocks the releasing thread on writing the file. To keep that
+     * disk I/O off a given thread, e.g. the rendering thread, call
+     * save_glyph_cache() at a point of the application's choosing
+     * before the last reference is dropped; unless more glyphs are
+     * generated afterwards, the dtor then has nothing to write.
+     */
+    enum return_code
+    save_glyph_cache(void);
+
+    /*!
+     * \brief
+     * Statistics on the memory used by the realized glyphs
+     * of an astral::Typeface, see glyph_memory_stats().
+     */
+    class GlyphMemoryStats
+    {
+    public:
+      GlyphMemoryStats(void):
+        m_resident_bytes(0u),
+        m_resident_glyphs(0u),
+        m_number_evictions(0u),
+        m_number_regenerations(0u)
+      {}
+
+      /*!
+       * Estimate of the number of bytes used by the realized
+       * glyphs: the curves of the astral::Path values, the data
+       * of the astral::ItemPath values, the astral::StaticData
+       * of the glyphs and the images of the strikes.
+       */
+      uint64_t m_resident_bytes;
+
+      /*!
+       * Number of glyphs whose data is counted in
+       * \ref m_resident_bytes.
+       */
+      unsigned int m_resident_glyphs;
+
+      /*!
+       * Number of times the data of a glyph was released
+       * to keep \ref m_resident_bytes within the budget
+       * set by glyph_memory_budget(uint64_t).
+       */
+      unsigned int m_number_evictions;
+
+      /*!
+       * Number of times a glyph whose data was released
+       * was generated again.
+       */
+      unsigned int m_number_regenerations;
+    };
+
+    /*!
+     * Set the budget, in bytes, of the memory used by the realized
+     * glyphs of this astral::Typeface as estimated by
+     * GlyphMemoryStats::m_resident_bytes. When the budget is
+     * exceeded, the data of the least recently used glyphs for
+     * which no astral::Glyph handle is alive is released; such
+     * a glyph is generated again when it is next fetched. Glyphs
+     * realized by prefetch_glyphs() or read from the on-disk glyph
+     * cache are counted, and may be released, from the next call
+     * to fetch_glyph(), prefetch_glyphs(), glyph_memory_stats() or
+     * glyph_memory_budget(uint64_t) after they are realized, even
+     * if they are not fetched. A value of 0 means no budget.
+     */
+    void
+    glyph_memory_budget(uint64_t bytes);
+
+    /*!
+     * Returns the value set by glyph_memory_budget(uint64_t).
+     */
+    uint64_t
+    glyph_memory_budget(void) const;
+
+    /*!
+     * Returns statistics on the memory used by the
+     * realized glyphs of this astral::Typeface.
+     */
+    GlyphMemoryStats
+    glyph_memory_stats(void) const;
+
+    /*!
+     * The value for glyph_memory_budget() of the
+     * astral::Typeface objects created afterwards;
+     * initial value is 0, i.e. no budget.
+     */
+    static
+    uint64_t
+    default_glyph_memory_budget(void);
+
+    /*!
+     * Set the value returned by default_glyph_memory_budget(void)
+     */
+    static
+    void
+    default_glyph_memory_budget(uint64_t bytes);
+
   private:
     class Implement;
     friend class Glyph;
@@ -84,7 +84,11 @@ namespace astral
     release(const Interval*);
 
     /*!
-     * Increase the number of layers
+     * Resize the number of layers. The number of layers
+     * can only be decreased if there are no intervals
+     * allocated on the layers that are removed, i.e.
+     * number_allocated(unsigned int) const is zero for
+     * each layer I with L <= I < number_layers().
      */
     void
     number_layers(unsigned int L);
@@ -132,6 +136,33 @@ namespace astral
       return m_number_allocated != 0u;
     }
 
+    /*!
+     * Returns the number of intervals returned by allocate()
+     * on the named layer that have not been passed to release().
+     * \param layer which layer with layer < number_layers()
+     */
+    unsigned int
+    number_allocated(unsigned int layer) const;
+
+    /*!
+     * Returns the sum of the sizes of the intervals returned
+     * by allocate() that have not been passed to release().
+     */
+    unsigned int
+    space_allocated(void) const
+    {
+      return m_space_allocated;
+    }
+
+    /*!
+     * Returns the sum of the sizes of the intervals returned
+     * by allocate() on the named layer that have not been
+     * passed to release().
+     * \param layer which layer with layer < number_layers()
+     */
+    unsigned int
+    space_allocated(unsigned int layer) const;
+
     /*!
      * Just for debugging; prints to std::cout all intervals
      * (free and allocated) of a layer and returns the number
@@ -163,6 +194,9 @@ namespace astral
     /* number of intervals allocated */
     int m_number_allocated;
 
+    /* sum of the sizes of the intervals allocated */
+    unsigned int m_space_allocated;
+
     /* for each "layer", we have a linked list of Interval values,
      * where an Interval can be allocated or free. When an Interval
      * is allocated or freed it affects the linked list. On allocation
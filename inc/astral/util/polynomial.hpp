@@ -717,8 +717,13 @@ namespace astral
   }
 
   /*!
-   * Solve a cubic equation; multi-roots are counted and listed in their multiplicity
-   * \param P the coefficients of the polynomial to solve for
+   * Solve the cubic equation t^3 - 3pt + 2q = 0 and add an offset
+   * to each of the solutions; solve_cubic() reduces the cubic
+   * x^3 + bx^2 + cx + d = 0 to this form with x = t - b / 3.
+   * Multi-roots are counted and listed in their multiplicity.
+   * \param p the value p of the cubic
+   * \param q the value q of the cubic
+   * \param offset value to add to each solution
    * \param solutions the array in which to place the found solutions
    * \param complex_solutions if non-empty, the array in which to place
    *                          the complex solutions
@@ -726,30 +731,15 @@ namespace astral
    */
   template<typename T>
   unsigned int
-  solve_cubic(c_array<const T> P, c_array<T> solutions,
-              c_array<std::complex<T>> complex_solutions = c_array<std::complex<T>>())
+  solve_depressed_cubic(T p, T q, T offset, c_array<T> solutions,
+                        c_array<std::complex<T>> complex_solutions = c_array<std::complex<T>>())
   {
-    ASTRALassert(P.size() == 4);
     ASTRALassert(solutions.size() >= 3);
     ASTRALassert(complex_solutions.empty() || complex_solutions.size() >= 2);
 
-    if (P[3] == T(0))
-      {
-        return solve_quadratic(P.sub_array(0, 3), solutions, complex_solutions);
-      }
-
-    T inverse_a = T(1) / P[3];
-    T b = P[2] * inverse_a;
-    T c = P[1] * inverse_a;
-    T d = P[0] * inverse_a;
-
-    T b3 = b * b * b;
-    T q = (T(2) * b3 - T(9) * b * c + T(27) * d) / T(54);
-    T p = (b * b - T(3) * c) / T(9);
     T q2 = q * q;
     T p3 = p * p * p;
     T D = q2 - p3;
-    T offset = -b / T(3);
 
     if (D >= T(0))
       {
@@ -855,6 +845,41 @@ namespace astral
       }
   }
 
+  /*!
+   * Solve a cubic equation; multi-roots are counted and listed in their multiplicity
+   * \param P the coefficients of the polynomial to solve for
+   * \param solutions the array in which to place the found solutions
+   * \param complex_solutions if non-empty, the array in which to place
+   *                          the complex solutions
+   * \returns the number of real solutions
+   */
+  template<typename T>
+  unsigned int
+  solve_cubic(c_array<const T> P, c_array<T> solutions,
+              c_array<std::complex<T>> complex_solutions = c_array<std::complex<T>>())
+  {
+    ASTRALassert(P.size() == 4);
+    ASTRALassert(solutions.size() >= 3);
+    ASTRALassert(complex_solutions.empty() || complex_solutions.size() >= 2);
+
+    if (P[3] == T(0))
+      {
+        return solve_quadratic(P.sub_array(0, 3), solutions, complex_solutions);
+      }
+
+    T inverse_a = T(1) / P[3];
+    T b = P[2] * inverse_a;
+    T c = P[1] * inverse_a;
+    T d = P[0] * inverse_a;
+
+    T b3 = b * b * b;
+    T q = (T(2) * b3 - T(9) * b * c + T(27) * d) / T(54);
+    T p = (b * b - T(3) * c) / T(9);
+    T offset = -b / T(3);
+
+    return solve_depressed_cubic(p, q, offset, solutions, complex_solutions);
+  }
+
   /*!
    * Let r = sqrt(a * a - b), computes in a numerically
    * more stable way the values r1 = a + r and r2 = a - r
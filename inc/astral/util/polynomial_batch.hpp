@@ -0,0 +1,122 @@
+/*!
+ * \file polynomial_batch.hpp
+ * \brief file polynomial_batch.hpp
+ *
+ * Copyright 2020 by InvisionApp.
+ *
+ * Contact: kevinrogovin@invisionapp.com
+ *
+ * This Source Code Form is subject to the
+ * terms of the Mozilla Public License, v. 2.0.
+ * If a copy of the MPL was not distributed with
+ * this file, You can obtain one at
+ * http://mozilla.org/MPL/2.0/.
+ *
+ */
+
+#ifndef ASTRAL_POLYNOMIAL_BATCH_HPP
+#define ASTRAL_POLYNOMIAL_BATCH_HPP
+
+#include <astral/util/util.hpp>
+#include <astral/util/vecN.hpp>
+#include <astral/util/c_array.hpp>
+
+namespace astral
+{
+///@cond
+  /* The batched solvers are not part of the public interface;
+   * the sparse fill clipping solves its own rational form with
+   * the same SIMD wrappers. They are declared here so that the
+   * solver test can check them against solve_quadratic<float>()
+   * and solve_cubic<float>().
+   */
+  namespace detail
+  {
+    /*
+     * Returns the instruction set used by the batched solvers
+     * solve_quadratic_batch() and solve_cubic_batch(), one of
+     * "SSE2", "NEON" or "scalar".
+     */
+    c_string
+    polynomial_batch_instruction_set(void);
+
+    /*
+     * For each i, solve the quadratic equation Q[i](t) = v where
+     * Q[i][k] is the coefficient of t^k. Typically Q[i] is one
+     * coordinate of a curve and v gives an axis aligned line. The
+     * equations are solved 4 at a time with SIMD instructions and
+     * the results are exactly the same as solve_quadratic<float>()
+     * called on the polynomial Q[i] - v.
+     * \param Q the coefficients of the polynomials
+     * \param v the value to which to solve
+     * \param out_solutions location to which to write the real
+     *                      solutions, size must be the same as Q
+     * \param out_number_solutions location to which to write the
+     *                             number of real solutions, size
+     *                             must be the same as Q
+     */
+    void
+    solve_quadratic_batch(c_array<const vecN<float, 3>> Q, float v,
+                          c_array<vecN<float, 2>> out_solutions,
+                          c_array<unsigned int> out_number_solutions);
+
+    /*
+     * For each i, solve the quadratic equation Q(t) = v[i] where
+     * Q[k] is the coefficient of t^k. Typically Q is one coordinate
+     * of a curve and the v[i] give a set of axis aligned lines, for
+     * example the boundaries of tiles. The results are exactly the
+     * same as solve_quadratic<float>() called on the polynomial
+     * Q - v[i].
+     * \param Q the coefficients of the polynomial
+     * \param v the values to which to solve
+     * \param out_solutions location to which to write the real
+     *                      solutions, size must be the same as v
+     * \param out_number_solutions location to which to write the
+     *                             number of real solutions, size
+     *                             must be the same as v
+     */
+    void
+    solve_quadratic_batch(const vecN<float, 3> &Q, c_array<const float> v,
+                          c_array<vecN<float, 2>> out_solutions,
+                          c_array<unsigned int> out_number_solutions);
+
+    /*
+     * For each i, solve the cubic equation P[i](t) = v where P[i][k]
+     * is the coefficient of t^k. The reduction of each cubic to the
+     * form t^3 - 3pt + 2q = 0 is done 4 at a time with SIMD instructions
+     * and the results are exactly the same as solve_cubic<float>()
+     * called on the polynomial P[i] - v.
+     * \param P the coefficients of the polynomials
+     * \param v the value to which to solve
+     * \param out_solutions location to which to write the real
+     *                      solutions, size must be the same as P
+     * \param out_number_solutions location to which to write the
+     *                             number of real solutions, size
+     *                             must be the same as P
+     */
+    void
+    solve_cubic_batch(c_array<const vecN<float, 4>> P, float v,
+                      c_array<vecN<float, 3>> out_solutions,
+                      c_array<unsigned int> out_number_solutions);
+
+    /*
+     * For each i, solve the cubic equation P(t) = v[i] where P[k] is
+     * the coefficient of t^k. The results are exactly the same as
+     * solve_cubic<float>() called on the polynomial P - v[i].
+     * \param P the coefficients of the polynomial
+     * \param v the values to which to solve
+     * \param out_solutions location to which to write the real
+     *                      solutions, size must be the same as v
+     * \param out_number_solutions location to which to write the
+     *                             number of real solutions, size
+     *                             must be the same as v
+     */
+    void
+    solve_cubic_batch(const vecN<float, 4> &P, c_array<const float> v,
+                      c_array<vecN<float, 3>> out_solutions,
+                      c_array<unsigned int> out_number_solutions);
+  }
+///@endcond
+}
+
+#endif
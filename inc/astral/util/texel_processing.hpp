@@ -0,0 +1,91 @@
+/*!
+ * \file texel_processing.hpp
+ * \brief file texel_processing.hpp
+ *
+ * Copyright 2021 by InvisionApp.
+ *
+ * Contact: kevinrogovin@invisionapp.com
+ *
+ * This Source Code Form is subject to the
+ * terms of the Mozilla Public License, v. 2.0.
+ * If a copy of the MPL was not distributed with
+ * this file, You can obtain one at
+ * http://mozilla.org/MPL/2.0/.
+ *
+ */
+
+#ifndef ASTRAL_TEXEL_PROCESSING_HPP
+#define ASTRAL_TEXEL_PROCESSING_HPP
+
+#include <astral/util/vecN.hpp>
+#include <astral/util/c_array.hpp>
+#include <astral/util/color.hpp>
+
+namespace astral
+{
+/*!\addtogroup Utility
+ * @{
+ */
+
+  /*!
+   * Returns the name of the instruction set used by the texel
+   * processing functions, i.e. one of "AVX2", "SSE2", "NEON"
+   * or "scalar". The choice is made at compile time; all
+   * instruction sets produce bit-identical results.
+   */
+  c_string
+  texel_processing_instruction_set(void);
+
+  /*!
+   * Pre-multiply the rgb channels of each texel by its alpha
+   * channel, in place. The result for each channel is the
+   * rounded value of (c * a) / 255.
+   * \param texels texels to pre-multiply
+   */
+  void
+  premultiply_alpha_texels(c_array<u8vec4> texels);
+
+  /*!
+   * Convert the rgb channels of each texel from one colorspace to
+   * another, in place; the alpha channel is left unchanged. The
+   * conversion is performed on the channel values as is, i.e. if
+   * the texels are pre-multiplied, the conversion is applied to the
+   * pre-multiplied values. Each output is the rounded value of the
+   * conversion of astral::linear_from_srgb(float) or astral::srgb_from_linear(float).
+   * \param dst colorspace to which to convert
+   * \param src colorspace of the texels
+   * \param texels texels to convert
+   */
+  void
+  convert_colorspace_texels(enum colorspace_t dst, enum colorspace_t src,
+                            c_array<u8vec4> texels);
+
+  /*!
+   * Downsample texels by a 2x2 box filter, i.e. each texel of the
+   * output is the rounded average of a 2x2 block of the input.
+   * \param src_size size of the source texels; the destination size
+   *                 is src_size / 2 (rounded down) with the last row
+   *                 and column of the source ignored if odd
+   * \param src_row_width number of texels between the start of
+   *                      successive rows of src
+   * \param src source texels
+   * \param dst location to which to write the downsampled texels,
+   *            tightly packed, i.e. the row width is src_size.x() / 2
+   * \param gamma_correct if true, the texels are pre-multiplied by
+   *                      alpha with the rgb channels sRGB encoded;
+   *                      the rgb channels are un-premultiplied and
+   *                      linearized, averaged weighted by alpha and
+   *                      then re-encoded and pre-multiplied by the
+   *                      averaged alpha. The alpha channel is always
+   *                      averaged directly.
+   * \returns the size of the downsampled texels
+   */
+  uvec2
+  downsample_texels(uvec2 src_size, unsigned int src_row_width,
+                    c_array<const u8vec4> src, c_array<u8vec4> dst,
+                    bool gamma_correct = false);
+
+/*! @} */
+}
+
+#endif
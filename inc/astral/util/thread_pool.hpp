@@ -0,0 +1,176 @@
+/*!
+ * \file thread_pool.hpp
+ * \brief file thread_pool.hpp
+ *
+ * Copyright 2020 by InvisionApp.
+ *
+ * Contact: kevinrogovin@invisionapp.com
+ *
+ * This Source Code Form is subject to the
+ * terms of the Mozilla Public License, v. 2.0.
+ * If a copy of the MPL was not distributed with
+ * this file, You can obtain one at
+ * http://mozilla.org/MPL/2.0/.
+ *
+ */
+
+#ifndef ASTRAL_THREAD_POOL_HPP
+#define ASTRAL_THREAD_POOL_HPP
+
+#include <astral/util/reference_counted.hpp>
+
+namespace astral
+{
+/*!\addtogroup Utility
+ * @{
+ */
+
+  /*!
+   * \brief
+   * An astral::ThreadPool is a set of persistent worker threads
+   * that execute astral::ThreadPool::Job objects in the order
+   * they were added. The methods of an astral::ThreadPool may
+   * be called from any thread.
+   */
+  class ThreadPool:public reference_counted<ThreadPool>::concurrent
+  {
+  public:
+    /*!
+     * \brief
+     * An astral::ThreadPool::Job represents a unit of work
+     * to be executed by an astral::ThreadPool.
+     */
+    class Job:public reference_counted<Job>::concurrent
+    {
+    public:
+      virtual
+      ~Job()
+      {}
+
+      /*!
+       * To be implemented by a derived class to perform
+       * the work of the job. It is called exactly once
+       * from one of the threads of the astral::ThreadPool
+       * or from a thread calling ThreadPool::wait_all() or
+       * ThreadPool::wait().
+       */
+      virtual
+      void
+      execute(void) = 0;
+    };
+
+    /*!
+     * \brief
+     * An astral::ThreadPool::Batch tracks the jobs added with
+     * ThreadPool::add_job(const reference_counted_ptr<Job>&, Batch&)
+     * so that a caller can wait for just those jobs with
+     * ThreadPool::wait() instead of every job of the pool. A
+     * Batch is typically a local variable; it must be used with
+     * only one astral::ThreadPool and all of its jobs must have
+     * finished (i.e. ThreadPool::wait() called) before it is
+     * destroyed.
+     */
+    class Batch:astral::noncopyable
+    {
+    public:
+      Batch(void):
+        m_number_pending(0u)
+      {}
+
+      ~Batch()
+      {
+        ASTRALassert(m_number_pending == 0u);
+      }
+
+    private:
+      friend class ThreadPool;
+
+      /* number of jobs of the batch that have not finished,
+       * protected by the mutex of the ThreadPool
+       */
+      unsigned int m_number_pending;
+    };
+
+    /*!
+     * Create an astral::ThreadPool.
+     * \param number_threads number of worker threads; if zero,
+     *                       jobs are executed by add_job() directly
+     *                       on the calling thread.
+     */
+    static
+    reference_counted_ptr<ThreadPool>
+    create(unsigned int number_threads = default_number_threads());
+
+    /*!
+     * Dtor. Waits for all jobs added to finish before
+     * stopping the worker threads.
+     */
+    virtual
+    ~ThreadPool()
+    {}
+
+    /*!
+     * Returns the number of worker threads.
+     */
+    unsigned int
+    number_threads(void) const;
+
+    /*!
+     * Add a job to be executed by the worker threads.
+     */
+    void
+    add_job(const reference_counted_ptr<Job> &job);
+
+    /*!
+     * Add a job to be executed by the worker threads as
+     * part of a batch.
+     * \param job job to execute
+     * \param batch batch to which the job is added
+     */
+    void
+    add_job(const reference_counted_ptr<Job> &job, Batch &batch);
+
+    /*!
+     * Returns the number of jobs added that have not yet
+     * finished executing.
+     */
+    unsigned int
+    number_jobs_pending(void) const;
+
+    /*!
+     * Blocks until all jobs added have finished executing; the
+     * calling thread also executes jobs that have not yet been
+     * started by the worker threads.
+     */
+    void
+    wait_all(void);
+
+    /*!
+     * Blocks until all jobs of a batch have finished executing;
+     * the calling thread also executes the jobs of the batch
+     * that have not yet been started by the worker threads.
+     * Jobs that are not part of the batch are not waited on.
+     * \param batch batch of jobs to wait on
+     */
+    void
+    wait(Batch &batch);
+
+    /*!
+     * Returns the number of hardware threads minus one
+     * (for the calling thread), clamped to [1, 8].
+     */
+    static
+    unsigned int
+    default_number_threads(void);
+
+  private:
+    class Implement;
+
+    ThreadPool(void)
+    {}
+  };
+
+/*! @} */
+}
+
+#endif
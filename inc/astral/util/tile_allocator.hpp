@@ -192,14 +192,42 @@ namespace astral
                 unsigned int number_layers);
 
     /*!
-     * Resize the number of layers of the TileAllocator;
-     * resize can only increase the number of layers.
-     * \param new_value new value of number of layers with
-     *                  new_value >= number_layers(void) const
+     * Resize the number of layers of the TileAllocator. The
+     * number of layers can only be decreased if there are no
+     * tiles allocated on the layers that are removed, i.e.
+     * space_allocated(unsigned int) const is zero for each
+     * layer L with new_value <= L < number_layers().
+     * \param new_value new value of number of layers
      */
     void
     number_layers(unsigned int new_value);
 
+    /*!
+     * Set the layer limit for allocation. When the limit is
+     * less than number_layers(), allocate_tile() and allocate_region()
+     * will prefer to return tiles whose layer is strictly less than
+     * the limit and only return a tile on a layer at or above the
+     * limit if no such tile is available. This is used to evacuate
+     * the last layers of a TileAllocator so that it can be shrunk.
+     * Note that while the limit is active, allocation is no longer
+     * essentially O(1) since the free lists need to be walked.
+     * Default value is ~0u, i.e. no limit.
+     */
+    void
+    preferred_layer_limit(unsigned int v)
+    {
+      m_preferred_layer_limit = v;
+    }
+
+    /*!
+     * Returns the value set by preferred_layer_limit(unsigned int).
+     */
+    unsigned int
+    preferred_layer_limit(void) const
+    {
+      return m_preferred_layer_limit;
+    }
+
     /*!
      * Returns the log2 of the tile size.
      */
@@ -269,6 +297,18 @@ namespace astral
       return m_space_allocated;
     }
 
+    /*!
+     * Returns the space of the tiles that have been allocated
+     * and not released on the named layer.
+     * \param layer which layer with layer < number_layers()
+     */
+    unsigned int
+    space_allocated(unsigned int layer) const
+    {
+      ASTRALassert(layer < m_space_allocated_per_layer.size());
+      return m_space_allocated_per_layer[layer];
+    }
+
   private:
     class TileImplement;
     class RegionImplement;
@@ -292,6 +332,9 @@ namespace astral
     TileImplement*
     create_base_tile(void);
 
+    TileImplement*
+    allocate_tile_below_limit(c_array<const uvec2> szs);
+
     TileImplement*
     split_tile(TileImplement *tile, unsigned int log2_width, unsigned int log2_height);
 
@@ -332,6 +375,9 @@ namespace astral
     /* number of layers */
     unsigned int m_number_layers;
 
+    /* see preferred_layer_limit() */
+    unsigned int m_preferred_layer_limit;
+
     /* counter from where to allocate next root tile,
      * incremented when a root tile is requested and
      * m_free_root_tile is empty
@@ -341,6 +387,9 @@ namespace astral
     /* pool to allocate tiles */
     MemoryPool *m_pool;
     unsigned int m_num_tiles_allocated, m_space_allocated;
+
+    /* space allocated on each layer, size is m_number_layers */
+    std::vector<unsigned int> m_space_allocated_per_layer;
   };
 /*! @} */
 }
@@ -523,6 +523,51 @@ namespace astral
     *v1 = v >> 16u;
   }
 
+  /*!
+   * \brief
+   * Computes a 64-bit hash of a sequence of uint32_t values.
+   *
+   * The hash is FNV-1a over 32-bit words with an extra xor-shift
+   * so that the high bits of a word also affect the low bits of
+   * the hash. Different values can have the same hash, so a user
+   * that finds an object by its hash must still compare the
+   * object before using it.
+   */
+  class Hash64
+  {
+  public:
+    Hash64(void):
+      m_value(14695981039346656037u)
+    {}
+
+    /*!
+     * Add a value to the hash.
+     * \param v value to add
+     */
+    Hash64&
+    mix(uint32_t v)
+    {
+      const uint64_t prime(1099511628211u);
+
+      m_value ^= v;
+      m_value *= prime;
+      m_value ^= (m_value >> 29u);
+      return *this;
+    }
+
+    /*!
+     * Returns the hash of the values added by mix().
+     */
+    uint64_t
+    value(void) const
+    {
+      return m_value;
+    }
+
+  private:
+    uint64_t m_value;
+  };
+
   /*!
    * \brief
    * A class reprenting the STL range
@@ -15,9 +15,21 @@ include $(dir)/Rules.mk
 
 ASTRAL_SOURCES += $(call filelist, animated_path.cpp path.cpp \
 	contour.cpp contour_approximator.cpp contour_curve.cpp \
+	cubic_bezier_batch.cpp compact_contour_curves.cpp \
+	svg_path.cpp \
+	point_query_hierarchy.cpp \
 	contour_curve_util.cpp animated_contour_util.cpp \
 	animated_contour.cpp)
 
+# CubicBezierBatch must give the same values as split_cubic() and
+# compute_quadratic_appoximation(); keep the compiler from fusing
+# multiplies and adds into FMA in one of them but not the other.
+ASTRAL_EXACT_FP_OBJS := $(foreach cfg,debug release, \
+	$(BUILD)/$(cfg)/$(d)/cubic_bezier_batch.cpp.o \
+	$(BUILD)/$(cfg)/$(d)/contour_curve_util.cpp.o)
+$(ASTRAL_EXACT_FP_OBJS): BUILD_COMPILE_DEBUG_FLAGS += -ffp-contract=off
+$(ASTRAL_EXACT_FP_OBJS): BUILD_COMPILE_RELEASE_FLAGS += -ffp-contract=off
+
 # Begin standard footer
 d		:= $(dirstack_$(sp))
 sp		:= $(basename $(sp))
@@ -19,6 +19,7 @@
 #include "animated_contour_util.hpp"
 #include "contour_approximator.hpp"
 #include "generic_lod.hpp"
+#include "serialized_data.hpp"
 
 namespace
 {
@@ -727,6 +728,32 @@ create_raw(vec2 st_contour, vec2 ed_contour)
   return return_value;
 }
 
+void
+astral::AnimatedContour::
+serialize(detail::SerializedWriter &dst, detail::SerializedAnimatedContour *out_record) const
+{
+  m_start.serialize_data(dst, &out_record->m_start);
+  m_end.serialize_data(dst, &out_record->m_end);
+}
+
+astral::reference_counted_ptr<astral::AnimatedContour>
+astral::AnimatedContour::
+deserialize(const detail::SerializedReader &src, const detail::SerializedAnimatedContour &record)
+{
+  reference_counted_ptr<AnimatedContour> return_value;
+
+  return_value = ASTRALnew AnimatedContour();
+  if (routine_fail == return_value->m_start.deserialize_data(src, record.m_start)
+      || routine_fail == return_value->m_end.deserialize_data(src, record.m_end)
+      || return_value->m_start.curves().size() != return_value->m_end.curves().size()
+      || return_value->m_start.closed() != return_value->m_end.closed())
+    {
+      return nullptr;
+    }
+
+  return return_value;
+}
+
 astral::AnimatedContour::DataGenerator&
 astral::AnimatedContour::
 data_generator(void) const
@@ -25,6 +25,7 @@
 #include "contour_approximator.hpp"
 #include "animated_contour_util.hpp"
 #include "generic_lod.hpp"
+#include "serialized_data.hpp"
 
 namespace
 {
@@ -385,6 +386,78 @@ add_animated_contour(reference_counted_ptr<AnimatedContour> contour)
   return *this;
 }
 
+void
+astral::AnimatedPath::
+serialize(std::vector<uint8_t> *dst) const
+{
+  detail::SerializedWriter writer(dst);
+  detail::SerializedHeader header;
+  uint64_t header_offset, contours_offset;
+
+  std::memset(&header, 0, sizeof(header));
+  header.m_magic = detail::serialized_animated_path_magic;
+  header.m_version = detail::serialized_version;
+  header.m_byte_order = detail::serialized_byte_order;
+  header.m_curve_size = sizeof(ContourCurve);
+
+  header_offset = writer.allocate<detail::SerializedHeader>();
+  contours_offset = writer.allocate<detail::SerializedAnimatedContour>(m_path.size());
+  for (unsigned int i = 0; i < m_path.size(); ++i)
+    {
+      detail::SerializedAnimatedContour R;
+
+      m_path[i]->serialize(writer, &R);
+      writer.write(contours_offset, i, R);
+    }
+  header.m_contours = contours_offset;
+  header.m_number_contours = m_path.size();
+
+  header.m_size = writer.size();
+  writer.write(header_offset, header);
+}
+
+enum astral::return_code
+astral::AnimatedPath::
+deserialize(c_array<const uint8_t> src)
+{
+  detail::SerializedHeader header;
+  AnimatedPath tmp;
+
+  *this = AnimatedPath();
+  if (!detail::SerializedReader(src).read(0u, &header)
+      || header.m_magic != detail::serialized_animated_path_magic
+      || header.m_version != detail::serialized_version
+      || header.m_byte_order != detail::serialized_byte_order
+      || header.m_curve_size != sizeof(ContourCurve)
+      || header.m_size > src.size())
+    {
+      return routine_fail;
+    }
+
+  detail::SerializedReader reader(src.sub_array(0, header.m_size));
+
+  for (unsigned int i = 0; i < header.m_number_contours; ++i)
+    {
+      detail::SerializedAnimatedContour record;
+      reference_counted_ptr<AnimatedContour> C;
+
+      if (!reader.read(header.m_contours, i, &record))
+        {
+          return routine_fail;
+        }
+
+      C = AnimatedContour::deserialize(reader, record);
+      if (!C)
+        {
+          return routine_fail;
+        }
+      tmp.add_animated_contour(C);
+    }
+
+  *this = tmp;
+  return routine_success;
+}
+
 astral::AnimatedPath&
 astral::AnimatedPath::
 clear(void)
@@ -0,0 +1,249 @@
+/*!
+ * \file compact_contour_curves.cpp
+ * \brief file compact_contour_curves.cpp
+ *
+ * Copyright 2019 by InvisionApp.
+ *
+ * Contact: kevinrogovin@invisionapp.com
+ *
+ * This Source Code Form is subject to the
+ * terms of the Mozilla Public License, v. 2.0.
+ * If a copy of the MPL was not distributed with
+ * this file, You can obtain one at
+ * http://mozilla.org/MPL/2.0/.
+ *
+ */
+
+#include <cmath>
+#include <astral/compact_contour_curves.hpp>
+
+/* The header of a curve is packed as:
+ *  - bits [0, 3) : ContourCurve::type()
+ *  - bits [3, 5) : ContourCurve::continuation()
+ *  - bit 5       : set if the start point is stored
+ *  - bits [8, 16): ContourCurve::generation()
+ *
+ * The points of a curve are stored in the order: start point
+ * (if stored), then the control points and then the end point.
+ * A conic stores its weight and an arc stores its angle in
+ * m_scalars; the control point of an arc is not stored since it
+ * is computed from the end points and angle.
+ */
+namespace
+{
+  enum
+    {
+      type_bit0 = 0u,
+      type_num_bits = 3u,
+      continuation_bit0 = type_bit0 + type_num_bits,
+      continuation_num_bits = 2u,
+      start_pt_stored_bit = continuation_bit0 + continuation_num_bits,
+      generation_bit0 = 8u,
+      generation_num_bits = 8u,
+
+      max_fixed_point_value = 0xFFFF,
+    };
+
+  unsigned int
+  number_stored_control_pts(enum astral::ContourCurve::type_t tp)
+  {
+    switch (tp)
+      {
+      case astral::ContourCurve::quadratic_bezier:
+      case astral::ContourCurve::conic_curve:
+        return 1u;
+
+      case astral::ContourCurve::cubic_bezier:
+        return 2u;
+
+      default:
+        return 0u;
+      }
+  }
+
+  bool
+  has_scalar(enum astral::ContourCurve::type_t tp)
+  {
+    return tp == astral::ContourCurve::conic_curve
+      || tp == astral::ContourCurve::conic_arc_curve;
+  }
+}
+
+astral::CompactContourCurves::
+CompactContourCurves(c_array<const ContourCurve> curves, const BoundingBox<float> &bb):
+  m_min(0.0f, 0.0f),
+  m_step(0.0f, 0.0f)
+{
+  if (!bb.empty())
+    {
+      m_min = bb.min_point();
+      m_step = bb.size() / static_cast<float>(max_fixed_point_value);
+    }
+
+  m_headers.reserve(curves.size());
+  m_points.reserve(4u * curves.size());
+  m_chunks.reserve((curves.size() + chunk_size - 1u) / chunk_size);
+
+  for (unsigned int i = 0; i < curves.size(); ++i)
+    {
+      const ContourCurve &C(curves[i]);
+      enum ContourCurve::type_t tp(C.type());
+      uint32_t header;
+      bool store_start_pt;
+
+      if (i % chunk_size == 0u)
+        {
+          m_chunks.push_back(uvec2(m_points.size(), m_scalars.size()));
+        }
+
+      /* the first curve of a chunk always stores the start
+       * point so that chunks can be decoded independently
+       */
+      store_start_pt = (i % chunk_size == 0u || C.start_pt() != curves[i - 1u].end_pt());
+
+      header = pack_bits(type_bit0, type_num_bits, tp)
+        | pack_bits(continuation_bit0, continuation_num_bits, C.continuation())
+        | pack_bits(generation_bit0, generation_num_bits, t_min(C.generation(), 255u));
+
+      if (store_start_pt)
+        {
+          header |= (1u << start_pt_stored_bit);
+          encode_point(C.start_pt());
+        }
+
+      for (unsigned int c = 0, endc = number_stored_control_pts(tp); c < endc; ++c)
+        {
+          encode_point(C.control_pt(c));
+        }
+      encode_point(C.end_pt());
+
+      if (tp == ContourCurve::conic_curve)
+        {
+          m_scalars.push_back(C.conic_weight());
+        }
+      else if (tp == ContourCurve::conic_arc_curve)
+        {
+          m_scalars.push_back(C.arc_angle());
+        }
+
+      m_headers.push_back(header);
+    }
+}
+
+void
+astral::CompactContourCurves::
+encode_point(const vec2 &p)
+{
+  for (unsigned int c = 0; c < 2; ++c)
+    {
+      float v;
+
+      v = (m_step[c] > 0.0f) ? (p[c] - m_min[c]) / m_step[c] : 0.0f;
+      v = t_max(0.0f, t_min(static_cast<float>(max_fixed_point_value), std::round(v)));
+      m_points.push_back(static_cast<uint16_t>(v));
+    }
+}
+
+void
+astral::CompactContourCurves::
+decode(unsigned int begin, c_array<ContourCurve> dst) const
+{
+  unsigned int chunk, point_offset, scalar_offset;
+  vec2 prev_end_pt(0.0f, 0.0f);
+
+  ASTRALassert(begin + dst.size() <= m_headers.size());
+  if (dst.empty())
+    {
+      return;
+    }
+
+  chunk = begin / chunk_size;
+  point_offset = m_chunks[chunk].x();
+  scalar_offset = m_chunks[chunk].y();
+
+  for (unsigned int i = chunk * chunk_size, endi = begin + dst.size(); i < endi; ++i)
+    {
+      uint32_t header(m_headers[i]);
+      enum ContourCurve::type_t tp;
+      enum ContourCurve::continuation_t ct;
+      vecN<vec2, 2> ctl;
+      vec2 start_pt, end_pt;
+      unsigned int num_ctl;
+      float scalar(1.0f);
+
+      tp = static_cast<enum ContourCurve::type_t>(unpack_bits(type_bit0, type_num_bits, header));
+      ct = static_cast<enum ContourCurve::continuation_t>(unpack_bits(continuation_bit0, continuation_num_bits, header));
+      num_ctl = number_stored_control_pts(tp);
+
+      if (header & (1u << start_pt_stored_bit))
+        {
+          start_pt = decode_point(&m_points[point_offset]);
+          point_offset += 2u;
+        }
+      else
+        {
+          ASTRALassert(i % chunk_size != 0u);
+          start_pt = prev_end_pt;
+        }
+
+      for (unsigned int c = 0; c < num_ctl; ++c, point_offset += 2u)
+        {
+          ctl[c] = decode_point(&m_points[point_offset]);
+        }
+      end_pt = decode_point(&m_points[point_offset]);
+      point_offset += 2u;
+
+      if (has_scalar(tp))
+        {
+          scalar = m_scalars[scalar_offset++];
+        }
+
+      prev_end_pt = end_pt;
+      if (i < begin)
+        {
+          continue;
+        }
+
+      ContourCurve &C(dst[i - begin]);
+      switch (tp)
+        {
+        case ContourCurve::line_segment:
+          C = ContourCurve(start_pt, end_pt, ct);
+          break;
+
+        case ContourCurve::quadratic_bezier:
+          C = ContourCurve(start_pt, ctl[0], end_pt, ct);
+          break;
+
+        case ContourCurve::cubic_bezier:
+          C = ContourCurve(start_pt, ctl[0], ctl[1], end_pt, ct);
+          break;
+
+        case ContourCurve::conic_curve:
+          C = ContourCurve(start_pt, scalar, ctl[0], end_pt, ct);
+          break;
+
+        case ContourCurve::conic_arc_curve:
+          C = ContourCurve(start_pt, scalar, end_pt, ct);
+          break;
+        }
+      C.generation(unpack_bits(generation_bit0, generation_num_bits, header));
+    }
+}
+
+void
+astral::CompactContourCurves::
+decode(std::vector<ContourCurve> *dst) const
+{
+  dst->resize(m_headers.size());
+  decode(0, make_c_array(*dst));
+}
+
+unsigned int
+astral::CompactContourCurves::
+memory_size(void) const
+{
+  return sizeof(uint16_t) * (m_headers.size() + m_points.size())
+    + sizeof(float) * m_scalars.size()
+    + sizeof(uvec2) * m_chunks.size();
+}
@@ -15,14 +15,97 @@
  */
 
 #include <tuple>
+#include <type_traits>
+#include <algorithm>
 #include <ostream>
+#include <cstring>
 #include <astral/contour.hpp>
 
 #include "contour_approximator.hpp"
 #include "generic_lod.hpp"
+#include "serialized_data.hpp"
 
 namespace
 {
+  /* Returns true if a ContourCurve read from serialized data
+   * has values for its type and continuation that are enums
+   * of ContourCurve and the number of control points of its
+   * type; the data may come from a corrupt or hostile file.
+   */
+  bool
+  serialized_curve_valid(const astral::ContourCurve &c)
+  {
+    unsigned int expected_control_pts;
+
+    switch (c.type())
+      {
+      case astral::ContourCurve::line_segment:
+        expected_control_pts = 0u;
+        break;
+
+      case astral::ContourCurve::cubic_bezier:
+        expected_control_pts = 2u;
+        break;
+
+      case astral::ContourCurve::quadratic_bezier:
+      case astral::ContourCurve::conic_curve:
+      case astral::ContourCurve::conic_arc_curve:
+        expected_control_pts = 1u;
+        break;
+
+      default:
+        return false;
+      }
+
+    switch (c.continuation())
+      {
+      case astral::ContourCurve::not_continuation_curve:
+      case astral::ContourCurve::continuation_curve:
+      case astral::ContourCurve::continuation_curve_cusp:
+        break;
+
+      default:
+        return false;
+      }
+
+    return c.number_control_pts() == expected_control_pts;
+  }
+
+  bool
+  serialized_curves_valid(astral::c_array<const astral::ContourCurve> curves)
+  {
+    for (const astral::ContourCurve &c : curves)
+      {
+        if (!serialized_curve_valid(c))
+          {
+            return false;
+          }
+      }
+
+    return true;
+  }
+
+  /* Returns true if each source tag read from serialized data
+   * refers to a curve of a contour with number_curves curves
+   * and to a range within [0, 1].
+   */
+  bool
+  serialized_tags_valid(astral::c_array<const astral::detail::ContourApproximator::SourceTag> tags,
+                        unsigned int number_curves)
+  {
+    for (const astral::detail::ContourApproximator::SourceTag &tag : tags)
+      {
+        if (tag.m_source_curve < 0
+            || static_cast<unsigned int>(tag.m_source_curve) >= number_curves
+            || !(tag.m_source_range.m_begin >= 0.0f && tag.m_source_range.m_end <= 1.0f))
+          {
+            return false;
+          }
+      }
+
+    return true;
+  }
+
   class SantizedCurve
   {
   public:
@@ -465,70 +548,277 @@ public:
       }
   }
 
+  /* Generate the approximations named by uses, and if render_input
+   * is true, the input to the render data of those approximations.
+   */
+  void
+  prepare_data(const ContourData *C, float tol, uint32_t uses, bool render_input)
+  {
+    for (unsigned int i = 0; i < number_contour_fill_approximation; ++i)
+      {
+        if (uses & (1u << i))
+          {
+            const auto &e(m_fill[i].fetch(tol, m_fill_mode[i], C));
+            if (render_input)
+              {
+                e.prepare_render_input(*C);
+              }
+          }
+      }
+
+    if (uses & contour_prepare_stroke)
+      {
+        const auto &e(m_stroke.fetch(tol, m_stroke_mode, C));
+        if (render_input)
+          {
+            e.prepare_render_input(*C);
+          }
+      }
+
+    if (uses & contour_prepare_item_path)
+      {
+        m_item_path.fetch(tol, m_item_path_mode, C);
+      }
+  }
+
+  void
+  prepare_render_data(const ContourData *C, float tol, uint32_t uses, RenderEngine &engine)
+  {
+    for (unsigned int i = 0; i < number_contour_fill_approximation; ++i)
+      {
+        if (uses & (1u << i))
+          {
+            fill_render_data(C, tol, engine, static_cast<enum contour_fill_approximation_t>(i), nullptr);
+          }
+      }
+
+    if (uses & contour_prepare_stroke)
+      {
+        stroke_render_data(C, tol, engine, nullptr);
+      }
+  }
+
+  /* Write the LOD chains named by uses */
+  void
+  serialize(detail::SerializedWriter &dst, uint32_t uses, detail::SerializedContour *out_record)
+  {
+    for (unsigned int i = 0; i < number_contour_fill_approximation; ++i)
+      {
+        serialize_lod(dst, uses, i, m_fill[i], out_record);
+      }
+    serialize_lod(dst, uses, detail::serialized_stroke_lod, m_stroke, out_record);
+    serialize_lod(dst, uses, detail::serialized_item_path_lod, m_item_path, out_record);
+  }
+
+  enum return_code
+  deserialize(const detail::SerializedReader &src, const detail::SerializedContour &record)
+  {
+    for (unsigned int i = 0; i < number_contour_fill_approximation; ++i)
+      {
+        if (routine_fail == deserialize_lod(src, record, i, &m_fill[i]))
+          {
+            return routine_fail;
+          }
+      }
+
+    if (routine_fail == deserialize_lod(src, record, detail::serialized_stroke_lod, &m_stroke)
+        || routine_fail == deserialize_lod(src, record, detail::serialized_item_path_lod, &m_item_path))
+      {
+        return routine_fail;
+      }
+
+    return routine_success;
+  }
+
+  /* Update the approximations after the curves [begin, old_end)
+   * of C were replaced by the curves [begin, new_end). Returns
+   * false if the approximations could not be updated in place and
+   * the DataGenerator must be discarded.
+   */
+  bool
+  update_curves(const ContourData *C, unsigned int begin,
+                unsigned int old_end, unsigned int new_end)
+  {
+    unsigned int old_size, new_size;
+
+    new_size = C->curves().size();
+    old_size = new_size + old_end - new_end;
+
+    /* stroking splits single curve contours and the first and last
+     * curves of a contour are post-processed together, so for small
+     * contours and edits that touch most of the contour, recomputing
+     * on demand is simpler and not more expensive.
+     */
+    if (old_size < min_curves_for_update
+        || new_size < min_curves_for_update
+        || 2u * (new_end - begin) > new_size
+        || 2u * (old_end - begin) > old_size)
+      {
+        return false;
+      }
+
+    for (unsigned int i = 0; i < number_contour_fill_approximation; ++i)
+      {
+        if (!FillEntry::update_curves(m_fill[i].mutable_elements(), m_fill_mode[i],
+                                      C, begin, old_end, new_end))
+          {
+            return false;
+          }
+      }
+
+    return StrokeEntry::update_curves(m_stroke.mutable_elements(), m_stroke_mode,
+                                      C, begin, old_end, new_end)
+      && ItemPathEntry::update_curves(m_item_path.mutable_elements(), m_item_path_mode,
+                                      C, begin, old_end, new_end);
+  }
+
 private:
+  enum
+    {
+      min_curves_for_update = 4
+    };
+
   class EmptyRenderDataElement
   {};
 
+  template<typename T>
+  static
+  void
+  serialize_lod(detail::SerializedWriter &dst, uint32_t uses, unsigned int lod,
+                detail::GenericLOD<T> &chain, detail::SerializedContour *out_record)
+  {
+    c_array<const T> entries;
+
+    if (!(uses & (1u << lod)))
+      {
+        return;
+      }
+
+    entries = chain.all_elements();
+    out_record->m_number_lods[lod] = entries.size();
+    out_record->m_lods[lod] = dst.allocate<detail::SerializedLOD>(entries.size());
+    for (unsigned int i = 0; i < entries.size(); ++i)
+      {
+        detail::SerializedLOD R;
+
+        ASTRALassert(entries[i].value().size() == entries[i].src_tags().size());
+        R.m_number_curves = entries[i].value().size();
+        R.m_error = entries[i].error();
+        R.m_curves = dst.write_array(entries[i].value());
+        R.m_tags = dst.write_array(entries[i].src_tags());
+        dst.write(out_record->m_lods[lod], i, R);
+      }
+  }
+
+  template<typename T>
+  static
+  enum return_code
+  deserialize_lod(const detail::SerializedReader &src, const detail::SerializedContour &record,
+                  unsigned int lod, detail::GenericLOD<T> *out_chain)
+  {
+    std::vector<T> entries;
+    unsigned int number_entries(record.m_number_lods[lod]);
+
+    entries.reserve(number_entries);
+    for (unsigned int i = 0; i < number_entries; ++i)
+      {
+        detail::SerializedLOD R;
+        c_array<const ContourCurve> curves;
+        c_array<const detail::ContourApproximator::SourceTag> tags;
+
+        if (!src.read(record.m_lods[lod], i, &R)
+            || !src.read_array(R.m_curves, R.m_number_curves, &curves)
+            || !src.read_array(R.m_tags, R.m_number_curves, &tags)
+            || !serialized_curves_valid(curves)
+            || !serialized_tags_valid(tags, record.m_data.m_number_curves)
+            || (i != 0u && !(R.m_error < entries.back().error())))
+          {
+            return routine_fail;
+          }
+
+        /* only the last element of a chain can be refined */
+        entries.push_back(T(R.m_error, curves, tags, i + 1u == number_entries));
+      }
+
+    if (!entries.empty())
+      {
+        out_chain->load(entries);
+      }
+
+    return routine_success;
+  }
+
   typedef std::tuple<FillSTCShader::CookedData> FillRenderData;
   typedef std::tuple<StrokeShader::CookedData, StrokeShader::SimpleCookedData> StrokeRenderData;
   typedef std::tuple<EmptyRenderDataElement> EmptyRenderData;
 
+  /* The generation of render data is in two steps: the first step
+   * creates the input to the shader's render data creation and does
+   * not use a RenderEngine, so it can be done on any thread; the
+   * second step creates the render data from that input.
+   */
   static
   void
-  generate_render_data(c_array<const ContourCurve> input,
-                       const ContourData &raw_contour,
-                       RenderEngine &engine, FillSTCShader::CookedData *output)
+  generate_render_input(c_array<const ContourCurve> input,
+                        const ContourData &raw_contour,
+                        FillSTCShader::Data *output)
   {
-    FillSTCShader::Data geometry;
-
     ASTRALunused(raw_contour);
-    geometry.add_contour(input);
-    *output = FillSTCShader::create_cooked_data(engine, geometry);
+    output->add_contour(input);
   }
 
   static
   void
-  generate_render_data(c_array<const ContourCurve> input,
-                       const ContourData &raw_contour,
-                       RenderEngine &engine, StrokeShader::CookedData *output)
+  generate_render_input(c_array<const ContourCurve> input,
+                        const ContourData &raw_contour,
+                        StrokeShader::RawData *output)
   {
-    StrokeShader::RawData builder;
-
     if (input.empty())
       {
-        builder.add_point_cap(raw_contour.start());
+        output->add_point_cap(raw_contour.start());
       }
     else
       {
-        builder.add_contour(raw_contour.closed(), input);
+        output->add_contour(raw_contour.closed(), input);
       }
+  }
+
+  static
+  void
+  generate_render_input(c_array<const ContourCurve>,
+                        const ContourData&,
+                        EmptyRenderDataElement*)
+  {
+  }
+
+  static
+  void
+  generate_render_data(const FillSTCShader::Data &geometry,
+                       RenderEngine &engine, FillSTCShader::CookedData *output)
+  {
+    *output = FillSTCShader::create_cooked_data(engine, geometry);
+  }
+
+  static
+  void
+  generate_render_data(const StrokeShader::RawData &builder,
+                       RenderEngine &engine, StrokeShader::CookedData *output)
+  {
     StrokeShader::create_render_data(engine, builder, output);
   }
 
   static
   void
-  generate_render_data(c_array<const ContourCurve> input,
-                       const ContourData &raw_contour,
+  generate_render_data(const StrokeShader::RawData &builder,
                        RenderEngine &engine, StrokeShader::SimpleCookedData *output)
   {
-    StrokeShader::RawData builder;
-
-    if (input.empty())
-      {
-        builder.add_point_cap(raw_contour.start());
-      }
-    else
-      {
-        builder.add_contour(raw_contour.closed(), input);
-      }
     StrokeShader::create_render_data(engine, builder, output);
   }
 
   static
   void
-  generate_render_data(c_array<const ContourCurve>,
-                       const ContourData&,
-                       RenderEngine&, EmptyRenderData*)
+  generate_render_data(const EmptyRenderDataElement&,
+                       RenderEngine&, EmptyRenderDataElement*)
   {
   }
 
@@ -538,11 +828,12 @@ private:
    *                                           curve, then that curve is split
    *                                           into two. This is needed for stroking
    * \param T the object type to return in render_data()
+   * \param InputType the type from which the elements of T are generated
    */
   template<enum detail::ContourApproximator::mode_t mode,
            bool split_singleton_contours,
            enum detail::ContourApproximator::split_cubics_at_cusp_mode_t split_cubic_cusps_mode,
-           typename T>
+           typename T, typename InputType>
   class Entry
   {
   public:
@@ -553,6 +844,8 @@ private:
      */
     explicit
     Entry(enum detail::ContourApproximator::max_size_mode_t sz_mode, const ContourData *C):
+      m_refine_from_source(false),
+      m_render_input_ready(false),
       m_render_data_ready(false)
     {
       m_approximation = ASTRALnew detail::ContourApproximator(C, &m_quadratic_data_backing, mode,
@@ -562,6 +855,25 @@ private:
       m_error = m_approximation->error();
     }
 
+    /*!
+     * Ctor from serialized data.
+     * \param error error of the approximation
+     * \param curves the approximation
+     * \param tags the source tag of each curve of the approximation
+     * \param refinable if true, create_refinement() may be called
+     *                  on the created Entry
+     */
+    Entry(float error, c_array<const ContourCurve> curves,
+          c_array<const detail::ContourApproximator::SourceTag> tags,
+          bool refinable):
+      m_error(error),
+      m_quadratic_data_backing(curves.begin(), curves.end()),
+      m_src_tags(tags.begin(), tags.end()),
+      m_refine_from_source(refinable),
+      m_render_input_ready(false),
+      m_render_data_ready(false)
+    {}
+
     c_array<const ContourCurve>
     value(void) const
     {
@@ -584,18 +896,102 @@ private:
     error(void) const { return m_error; }
 
     Entry
-    create_refinement(enum detail::ContourApproximator::max_size_mode_t, const ContourData*)
+    create_refinement(enum detail::ContourApproximator::max_size_mode_t sz_mode, const ContourData *C)
     {
-      Entry return_value(*m_approximation, make_c_array(m_src_tags));
+      if (!m_approximation)
+        {
+          /* the entry was deserialized and does not have the state
+           * from which to refine, so approximate C from the start
+           * until the error is less than the error of this entry.
+           */
+          Entry return_value(sz_mode, C);
+
+          ASTRALassert(m_refine_from_source);
+          for (unsigned int i = 0; i < max_update_refinements && return_value.error() >= m_error; ++i)
+            {
+              return_value = Entry(*return_value.m_approximation);
+            }
+          finalize();
+          return return_value;
+        }
+
+      Entry return_value(*m_approximation);
       finalize();
       return return_value;
     }
 
+    /* Update the entries of a chain after the curves [begin, old_end)
+     * of the source contour were replaced by the curves [begin, new_end)
+     * of C. The re-approximation of the changed curves is refined until
+     * its error is no more than the error of each entry and then spliced
+     * into the entry, so the errors of the entries are unchanged. Returns
+     * false if the entries could not be updated, in which case the
+     * entries are in an undefined state and must be discarded.
+     */
+    static
+    bool
+    update_curves(c_array<Entry> entries,
+                  enum detail::ContourApproximator::max_size_mode_t sz_mode,
+                  const ContourData *C, unsigned int begin,
+                  unsigned int old_end, unsigned int new_end)
+    {
+      c_array<const ContourCurve> curves(C->curves());
+      reference_counted_ptr<const detail::ContourApproximator> A;
+      detail::ContourApproximator::ApproximatedContour quads;
+      std::vector<detail::ContourApproximator::SourceTag> tags;
+      unsigned int src_begin, context_end, iterations(0u);
+
+      if (begin == old_end && begin == new_end)
+        {
+          for (const Entry &e : entries)
+            {
+              e.release_render_input();
+              e.reset_all_render_data();
+            }
+          return true;
+        }
+
+      /* the approximation of a curve depends on the continuation
+       * type of the curve after it, so the curve before begin must
+       * be re-approximated as well. The curve after the replaced
+       * curves is included so that the last replaced curve sees its
+       * continuation; its approximation is unchanged and is not
+       * spliced.
+       */
+      src_begin = (begin > 0u) ? begin - 1u : 0u;
+      context_end = t_min(new_end + 1u, static_cast<unsigned int>(curves.size()));
+
+      A = ASTRALnew detail::ContourApproximator(curves.sub_array(src_begin, context_end - src_begin),
+                                                &quads, mode, sz_mode, false,
+                                                split_cubic_cusps_mode, &tags);
+      for (Entry &e : entries)
+        {
+          while (A->error() > e.error())
+            {
+              if (++iterations > max_update_refinements)
+                {
+                  return false;
+                }
+              A = A->create_refinement(&quads, &tags);
+            }
+          e.splice(src_begin, old_end, new_end, make_c_array(quads), make_c_array(tags), *A);
+        }
+
+      return true;
+    }
+
     void
-    finalize(void) { m_approximation = nullptr; }
+    finalize(void)
+    {
+      m_approximation = nullptr;
+      m_refine_from_source = false;
+    }
 
     bool
-    finalized(void) const { return m_approximation.get() == nullptr; }
+    finalized(void) const
+    {
+      return m_approximation.get() == nullptr && !m_refine_from_source;
+    }
 
     template<unsigned int N>
     const typename std::tuple_element<N, T>::type&
@@ -604,11 +1000,42 @@ private:
       if (!m_render_data_ready[N])
         {
           m_render_data_ready[N] = true;
-          generate_render_data(value(), raw_contour, engine, &std::get<N>(m_render_data));
+          prepare_render_input(raw_contour);
+          generate_render_data(m_render_input, engine, &std::get<N>(m_render_data));
+
+          /* the input is only kept between prepare_render_input()
+           * and the creation of the render data
+           */
+          release_render_input();
         }
       return std::get<N>(m_render_data);
     }
 
+    /* Generate the input from which render_data() creates the
+     * render data; this does not use a RenderEngine and thus may
+     * be called from any thread as long as only one thread at a
+     * time accesses the Entry.
+     */
+    void
+    prepare_render_input(const ContourData &raw_contour) const
+    {
+      if (!m_render_input_ready)
+        {
+          m_render_input_ready = true;
+          generate_render_input(value(), raw_contour, &m_render_input);
+        }
+    }
+
+    void
+    release_render_input(void) const
+    {
+      if (m_render_input_ready)
+        {
+          m_render_input_ready = false;
+          m_render_input = InputType();
+        }
+    }
+
     template<unsigned int N>
     bool
     render_data_ready(void) const
@@ -628,18 +1055,144 @@ private:
     }
 
   private:
+    enum
+      {
+        /* number of refinements of the re-approximation of the
+         * changed curves update_curves() will perform before
+         * giving up.
+         */
+        max_update_refinements = 24
+      };
+
     explicit
-    Entry(const detail::ContourApproximator &A, c_array<const detail::ContourApproximator::SourceTag> A_tags):
+    Entry(const detail::ContourApproximator &A):
+      m_refine_from_source(false),
+      m_render_input_ready(false),
       m_render_data_ready(false)
     {
-      m_approximation = A.create_refinement(A_tags, &m_quadratic_data_backing, &m_src_tags);
+      m_approximation = A.create_refinement(&m_quadratic_data_backing, &m_src_tags);
       m_error = m_approximation->error();
     }
 
+    /* Replace in curves and tags the curves whose source is in
+     * [src_begin, old_end) by those curves of sub whose source
+     * (offset by src_begin) is in [src_begin, new_end) and shift
+     * the sources of the curves after them.
+     */
+    static
+    void
+    splice_curves(unsigned int src_begin, unsigned int old_end, unsigned int new_end,
+                  c_array<const ContourCurve> sub,
+                  c_array<const detail::ContourApproximator::SourceTag> sub_tags,
+                  std::vector<ContourCurve> *curves,
+                  std::vector<detail::ContourApproximator::SourceTag> *tags)
+    {
+      typedef detail::ContourApproximator::SourceTag SourceTag;
+
+      std::vector<ContourCurve> out_curves;
+      std::vector<SourceTag> out_tags;
+      std::vector<SourceTag>::const_iterator b, e;
+      int delta(static_cast<int>(new_end) - static_cast<int>(old_end));
+      unsigned int qb, qe;
+      auto cmp = [](const SourceTag &tag, int v) { return tag.m_source_curve < v; };
+
+      ASTRALassert(sub.size() == sub_tags.size());
+      ASTRALassert(curves->size() == tags->size());
+
+      /* the tags are sorted by the source curve */
+      b = std::lower_bound(tags->cbegin(), tags->cend(), static_cast<int>(src_begin), cmp);
+      e = std::lower_bound(b, tags->cend(), static_cast<int>(old_end), cmp);
+      qb = b - tags->cbegin();
+      qe = e - tags->cbegin();
+
+      out_curves.reserve(qb + sub.size() + curves->size() - qe);
+      out_tags.reserve(out_curves.capacity());
+
+      out_curves.insert(out_curves.end(), curves->begin(), curves->begin() + qb);
+      out_tags.insert(out_tags.end(), tags->begin(), tags->begin() + qb);
+      for (unsigned int i = 0; i < sub.size() && sub_tags[i].m_source_curve + static_cast<int>(src_begin) < static_cast<int>(new_end); ++i)
+        {
+          SourceTag tag(sub_tags[i]);
+
+          tag.m_source_curve += static_cast<int>(src_begin);
+          out_curves.push_back(sub[i]);
+          out_tags.push_back(tag);
+        }
+
+      for (unsigned int i = qe, endi = curves->size(); i < endi; ++i)
+        {
+          SourceTag tag((*tags)[i]);
+
+          tag.m_source_curve += delta;
+          out_curves.push_back((*curves)[i]);
+          out_tags.push_back(tag);
+        }
+
+      curves->swap(out_curves);
+      tags->swap(out_tags);
+    }
+
+    void
+    splice(unsigned int src_begin, unsigned int old_end, unsigned int new_end,
+           c_array<const ContourCurve> sub,
+           c_array<const detail::ContourApproximator::SourceTag> sub_tags,
+           const detail::ContourApproximator &sub_approximation)
+    {
+      splice_curves(src_begin, old_end, new_end, sub, sub_tags,
+                    &m_quadratic_data_backing, &m_src_tags);
+
+      /* if this entry is the last of its chain, the state from
+       * which to create the next refinement must be updated too
+       */
+      if (m_approximation)
+        {
+          std::vector<ContourCurve> tess;
+          std::vector<detail::ContourApproximator::SourceTag> tess_tags;
+          c_array<const ContourCurve> src_tess(m_approximation->tessellation(0));
+          c_array<const detail::ContourApproximator::SourceTag> src_tess_tags(m_approximation->tessellation_tags());
+
+          tess.assign(src_tess.begin(), src_tess.end());
+          tess_tags.assign(src_tess_tags.begin(), src_tess_tags.end());
+          splice_curves(src_begin, old_end, new_end,
+                        sub_approximation.tessellation(0),
+                        sub_approximation.tessellation_tags(),
+                        &tess, &tess_tags);
+
+          m_approximation = ASTRALnew detail::ContourApproximator(make_c_array(tess), make_c_array(tess_tags),
+                                                                  m_error, mode, m_approximation->sz_mode(),
+                                                                  split_singleton_contours);
+        }
+
+      release_render_input();
+      reset_all_render_data();
+    }
+
+    template<unsigned int N = 0>
+    typename std::enable_if<N < std::tuple_size<T>::value>::type
+    reset_all_render_data(void) const
+    {
+      reset_render_data<N>();
+      reset_all_render_data<N + 1>();
+    }
+
+    template<unsigned int N = 0>
+    typename std::enable_if<N == std::tuple_size<T>::value>::type
+    reset_all_render_data(void) const
+    {}
+
     float m_error;
     detail::ContourApproximator::ApproximatedContour m_quadratic_data_backing;
     std::vector<detail::ContourApproximator::SourceTag> m_src_tags;
     reference_counted_ptr<const detail::ContourApproximator> m_approximation;
+
+    /* true if the entry was deserialized and is the last of its
+     * chain, in which case create_refinement() recomputes from
+     * the source contour
+     */
+    bool m_refine_from_source;
+
+    mutable InputType m_render_input;
+    mutable bool m_render_input_ready;
     mutable T m_render_data;
     mutable vecN<bool, std::tuple_size<T>::value> m_render_data_ready;
   };
@@ -648,9 +1201,12 @@ private:
    *       comes from the implementation of the shaders in the GL3 backend.
    */
   typedef detail::ContourApproximator CA;
-  typedef Entry<CA::approximate_to_quadratic, false, CA::dont_split_cubics_at_cusps, FillRenderData> FillEntry;
-  typedef Entry<CA::approximate_to_quadratic_error_to_biarc, true, CA::split_cubics_at_cusps, StrokeRenderData> StrokeEntry;
-  typedef Entry<CA::approximate_to_conic_or_quadratic, false, CA::dont_split_cubics_at_cusps, EmptyRenderData> ItemPathEntry;
+  typedef Entry<CA::approximate_to_quadratic, false, CA::dont_split_cubics_at_cusps,
+                FillRenderData, FillSTCShader::Data> FillEntry;
+  typedef Entry<CA::approximate_to_quadratic_error_to_biarc, true, CA::split_cubics_at_cusps,
+                StrokeRenderData, StrokeShader::RawData> StrokeEntry;
+  typedef Entry<CA::approximate_to_conic_or_quadratic, false, CA::dont_split_cubics_at_cusps,
+                EmptyRenderData, EmptyRenderDataElement> ItemPathEntry;
 
   enum CA::max_size_mode_t m_stroke_mode, m_item_path_mode;
   vecN<enum CA::max_size_mode_t, number_contour_fill_approximation> m_fill_mode;
@@ -677,6 +1233,7 @@ operator=(ContourData &&obj) noexcept
       m_bb = obj.m_bb;
       m_control_point_bb = obj.m_control_point_bb;
       m_curves = std::move(obj.m_curves);
+      m_compact = std::move(obj.m_compact);
     }
 
   return *this;
@@ -687,6 +1244,7 @@ astral::ContourData::
 close(bool force_add)
 {
   ASTRALassert(!m_closed);
+  uncompact();
   if (!m_curves.empty() && (force_add || m_curves.front().start_pt() != m_curves.back().end_pt()))
     {
       line_to(m_curves.front().start_pt(), ContourCurve::not_continuation_curve);
@@ -699,7 +1257,9 @@ astral::ContourData::
 reverse(void) const
 {
   ContourData R;
-  unsigned int N(m_curves.size());
+  unsigned int N(number_curves());
+
+  ready_curves();
 
   R.m_closed = m_closed;
   R.m_santize_curves_on_adding = m_santize_curves_on_adding;
@@ -730,10 +1290,69 @@ reverse(void) const
   return R;
 }
 
+void
+astral::ContourData::
+serialize_data(detail::SerializedWriter &dst, detail::SerializedContourData *out_record) const
+{
+  c_array<const ContourCurve> curves(this->curves());
+
+  out_record->m_curves = dst.write_array(curves);
+  out_record->m_number_curves = curves.size();
+  out_record->m_flags = 0u;
+  if (m_closed)
+    {
+      out_record->m_flags |= detail::SerializedContourData::closed_flag;
+    }
+  if (m_sanitized)
+    {
+      out_record->m_flags |= detail::SerializedContourData::sanitized_flag;
+    }
+  if (m_santize_curves_on_adding)
+    {
+      out_record->m_flags |= detail::SerializedContourData::santize_curves_on_adding_flag;
+    }
+
+  out_record->m_start_pt[0] = m_start_pt.x();
+  out_record->m_start_pt[1] = m_start_pt.y();
+  out_record->m_last_end_pt[0] = m_last_end_pt.x();
+  out_record->m_last_end_pt[1] = m_last_end_pt.y();
+  out_record->m_bb.set(m_bb);
+  out_record->m_join_bb.set(m_join_bb);
+  out_record->m_control_point_bb.set(m_control_point_bb);
+}
+
+enum astral::return_code
+astral::ContourData::
+deserialize_data(const detail::SerializedReader &src, const detail::SerializedContourData &record)
+{
+  c_array<const ContourCurve> curves;
+
+  if (!src.read_array(record.m_curves, record.m_number_curves, &curves)
+      || !serialized_curves_valid(curves))
+    {
+      return routine_fail;
+    }
+
+  m_compact = nullptr;
+  m_curves.assign(curves.begin(), curves.end());
+  m_closed = (record.m_flags & detail::SerializedContourData::closed_flag) != 0u;
+  m_sanitized = (record.m_flags & detail::SerializedContourData::sanitized_flag) != 0u;
+  m_santize_curves_on_adding = (record.m_flags & detail::SerializedContourData::santize_curves_on_adding_flag) != 0u;
+  m_start_pt = vec2(record.m_start_pt[0], record.m_start_pt[1]);
+  m_last_end_pt = vec2(record.m_last_end_pt[0], record.m_last_end_pt[1]);
+  m_bb = record.m_bb.get();
+  m_join_bb = record.m_join_bb.get();
+  m_control_point_bb = record.m_control_point_bb.get();
+  mark_dirty();
+
+  return routine_success;
+}
+
 void
 astral::ContourData::
 inplace_reverse(void)
 {
+  uncompact();
   std::swap(m_start_pt, m_last_end_pt);
   if (m_curves.empty())
     {
@@ -757,6 +1376,7 @@ void
 astral::ContourData::
 make_curve_first(unsigned int S)
 {
+  uncompact();
   ASTRALassert(S < m_curves.size());
   ASTRALassert(m_closed);
 
@@ -1111,18 +1731,77 @@ make_as_oval(const Rect &rect, enum contour_direction_t d,
     }
 }
 
+static
+bool
+curves_identical(const astral::ContourCurve &a, const astral::ContourCurve &b)
+{
+  if (a.type() != b.type()
+      || a.continuation() != b.continuation()
+      || a.generation() != b.generation()
+      || a.start_pt() != b.start_pt()
+      || a.end_pt() != b.end_pt())
+    {
+      return false;
+    }
+
+  for (unsigned int i = 0, endi = a.number_control_pts(); i < endi; ++i)
+    {
+      if (a.control_pt(i) != b.control_pt(i))
+        {
+          return false;
+        }
+    }
+
+  /* a conic stores its weight (and an arc its angle)
+   * after its control point
+   */
+  return !a.is_conic()
+    || (a.conic_weight() == b.conic_weight()
+        && (a.type() != astral::ContourCurve::conic_arc_curve || a.arc_angle() == b.arc_angle()));
+}
+
 void
 astral::ContourData::
 set_values(const ContourData &obj)
 {
+  unsigned int old_size(number_curves()), new_size(obj.number_curves());
+  unsigned int prefix(0u), suffix(0u), common(t_min(old_size, new_size));
+  bool closed_changed(m_closed != obj.m_closed);
+
+  if (this == &obj)
+    {
+      return;
+    }
+
+  ready_curves();
+  obj.ready_curves();
+
+  /* find the range of curves that changed so that the
+   * derived class can update instead of recompute
+   */
+  while (prefix < common && curves_identical(m_curves[prefix], obj.m_curves[prefix]))
+    {
+      ++prefix;
+    }
+
+  while (suffix < common - prefix
+         && curves_identical(m_curves[old_size - 1u - suffix], obj.m_curves[new_size - 1u - suffix]))
+    {
+      ++suffix;
+    }
+
   *this = obj;
-  mark_dirty();
+  if (prefix != old_size || prefix != new_size || closed_changed)
+    {
+      mark_curves_dirty(prefix, old_size - suffix, new_size - suffix);
+    }
 }
 
 void
 astral::ContourData::
 curve_to(const ContourCurve &curve)
 {
+  uncompact();
   if (m_curves.empty())
     {
       m_start_pt = m_last_end_pt = curve.start_pt();
@@ -1145,7 +1824,9 @@ curve_to(const ContourCurve &curve)
       if (!curves.empty())
         {
           update_bbs();
-          mark_dirty();
+          mark_curves_dirty(m_curves.size() - curves.size(),
+                            m_curves.size() - curves.size(),
+                            m_curves.size());
         }
     }
   else
@@ -1153,7 +1834,7 @@ curve_to(const ContourCurve &curve)
       m_sanitized = false;
       m_curves.push_back(curve);
       update_bbs();
-      mark_dirty();
+      mark_curves_dirty(m_curves.size() - 1u, m_curves.size() - 1u, m_curves.size());
     }
 
   m_last_end_pt = curve.end_pt();
@@ -1171,6 +1852,7 @@ sanitize(void)
   bool curves_modified(false);
   std::vector<ContourCurve> tmp;
 
+  uncompact();
   for (const ContourCurve &curve : m_curves)
     {
       SantizedCurve s;
@@ -1207,6 +1889,51 @@ sanitize(void)
   return curves_modified;
 }
 
+void
+astral::ContourData::
+compact(void)
+{
+  reference_counted_ptr<CompactContourCurves> compact_curves;
+  std::vector<ContourCurve> quantized;
+
+  if (m_compact || m_curves.empty())
+    {
+      return;
+    }
+
+  compact_curves = CompactContourCurves::create(make_c_array(m_curves), m_control_point_bb);
+  compact_curves->decode(&quantized);
+
+  /* the quantization moves the points, so the boxes are
+   * recomputed and a curve may have become degenerate
+   */
+  m_bb.clear();
+  m_join_bb.clear();
+  m_control_point_bb.clear();
+  for (const ContourCurve &curve : quantized)
+    {
+      m_bb.union_box(curve.tight_bounding_box());
+      m_control_point_bb.union_box(curve.control_point_bounding_box());
+      if (curve.continuation() == ContourCurve::not_continuation_curve)
+        {
+          m_join_bb.union_point(curve.start_pt());
+        }
+
+      if (m_sanitized)
+        {
+          SantizedCurve s;
+
+          m_sanitized = !sanitize_curve(curve, &s);
+        }
+    }
+
+  m_start_pt = quantized.front().start_pt();
+  m_last_end_pt = quantized.back().end_pt();
+  m_compact = compact_curves;
+  std::vector<ContourCurve>().swap(m_curves);
+  mark_dirty();
+}
+
 namespace std
 {
   ostream&
@@ -1261,6 +1988,34 @@ namespace std
 
 } //namespace std
 
+/* A ScopedDecode frees, on leaving its scope, the curves
+ * of a compact Contour that were decoded during its scope;
+ * the curves are then only decoded while generating the
+ * approximations, which are kept, instead of for the
+ * lifetime of the Contour.
+ */
+class astral::Contour::ScopedDecode:astral::noncopyable
+{
+public:
+  explicit
+  ScopedDecode(const Contour &contour):
+    m_contour(contour),
+    m_release(contour.m_curves.size() != contour.number_curves())
+  {}
+
+  ~ScopedDecode()
+  {
+    if (m_release)
+      {
+        m_contour.release_decoded_curves();
+      }
+  }
+
+private:
+  const Contour &m_contour;
+  bool m_release;
+};
+
 ///////////////////////////////////
 // astral::Contour methods
 astral::Contour::
@@ -1284,6 +2039,16 @@ mark_dirty(void)
   m_data_generator = nullptr;
 }
 
+void
+astral::Contour::
+mark_curves_dirty(unsigned int begin, unsigned int old_end, unsigned int new_end)
+{
+  if (m_data_generator && !m_data_generator->update_curves(this, begin, old_end, new_end))
+    {
+      m_data_generator = nullptr;
+    }
+}
+
 astral::Contour::DataGenerator&
 astral::Contour::
 data_generator(void) const
@@ -1300,13 +2065,42 @@ astral::c_array<const astral::ContourCurve>
 astral::Contour::
 item_path_approximated_geometry(float tol, float *out_tol) const
 {
+  ScopedDecode decode(*this);
+
   return data_generator().item_path_approximated_geometry(this, tol, out_tol);
 }
 
+astral::c_array<const astral::ContourCurve>
+astral::Contour::
+item_path_approximated_geometry(float tol, float *out_tol,
+                                std::vector<int> *out_source_curves,
+                                std::vector<range_type<float>> *out_source_ranges) const
+{
+  ScopedDecode decode(*this);
+
+  c_array<const ContourCurve> curves;
+  c_array<const detail::ContourApproximator::SourceTag> tags;
+
+  curves = data_generator().item_path_approximated_geometry(this, tol, out_tol, &tags);
+  ASTRALassert(tags.size() == curves.size());
+
+  out_source_curves->resize(tags.size());
+  out_source_ranges->resize(tags.size());
+  for (unsigned int i = 0; i < tags.size(); ++i)
+    {
+      (*out_source_curves)[i] = tags[i].m_source_curve;
+      (*out_source_ranges)[i] = tags[i].m_source_range;
+    }
+
+  return curves;
+}
+
 astral::c_array<const astral::ContourCurve>
 astral::Contour::
 fill_approximated_geometry(float tol, enum contour_fill_approximation_t ct, float *out_tol) const
 {
+  ScopedDecode decode(*this);
+
   return data_generator().fill_approximated_geometry(this, tol, ct, out_tol);
 }
 
@@ -1315,6 +2109,8 @@ astral::Contour::
 fill_render_data(float tol, RenderEngine &engine,
                  enum contour_fill_approximation_t ct, float *out_tol) const
 {
+  ScopedDecode decode(*this);
+
   return data_generator().fill_render_data(this, tol, engine, ct, out_tol);
 }
 
@@ -1322,6 +2118,8 @@ astral::c_array<const astral::ContourCurve>
 astral::Contour::
 stroke_approximated_geometry(float tol, float *out_tol) const
 {
+  ScopedDecode decode(*this);
+
   return data_generator().stroke_approximated_geometry(this, tol, out_tol);
 }
 
@@ -1329,6 +2127,8 @@ const astral::StrokeShader::CookedData&
 astral::Contour::
 stroke_render_data(float tol, RenderEngine &engine, float *out_tol) const
 {
+  ScopedDecode decode(*this);
+
   return data_generator().stroke_render_data(this, tol, engine, out_tol);
 }
 
@@ -1336,9 +2136,71 @@ const astral::StrokeShader::SimpleCookedData&
 astral::Contour::
 simple_stroke_render_data(float tol, RenderEngine &engine, float *out_tol) const
 {
+  ScopedDecode decode(*this);
+
   return data_generator().simple_stroke_render_data(this, tol, engine, out_tol);
 }
 
+uint64_t
+astral::Contour::
+serialize(detail::SerializedWriter &dst, c_array<const float> tolerances, uint32_t uses) const
+{
+  detail::SerializedContour R;
+  uint64_t return_value;
+  ScopedDecode decode(*this);
+
+  return_value = dst.allocate<detail::SerializedContour>();
+  std::memset(&R, 0, sizeof(R));
+  serialize_data(dst, &R.m_data);
+
+  /* only the LOD chains that were asked for are serialized */
+  uses &= contour_prepare_all;
+  if (uses != 0u && !tolerances.empty())
+    {
+      prepare_data(tolerances, uses, false);
+      data_generator().serialize(dst, uses, &R);
+    }
+
+  dst.write(return_value, R);
+  return return_value;
+}
+
+enum astral::return_code
+astral::Contour::
+deserialize(const detail::SerializedReader &src, const detail::SerializedContour &record)
+{
+  if (routine_fail == deserialize_data(src, record.m_data))
+    {
+      return routine_fail;
+    }
+
+  return data_generator().deserialize(src, record);
+}
+
+void
+astral::Contour::
+prepare_data(c_array<const float> tolerances, uint32_t uses, bool render_input) const
+{
+  ScopedDecode decode(*this);
+
+  for (float tol : tolerances)
+    {
+      data_generator().prepare_data(this, tol, uses, render_input);
+    }
+}
+
+void
+astral::Contour::
+prepare_render_data(c_array<const float> tolerances, uint32_t uses, RenderEngine &engine) const
+{
+  ScopedDecode decode(*this);
+
+  for (float tol : tolerances)
+    {
+      data_generator().prepare_render_data(this, tol, uses, engine);
+    }
+}
+
 astral::Contour::PointQueryResult
 astral::Contour::
 distance_to_contour(float tol, const vec2 &pt, float distance_cull) const
@@ -1346,6 +2208,7 @@ distance_to_contour(float tol, const vec2 &pt, float distance_cull) const
   c_array<const ContourCurve> curves;
   c_array<const detail::ContourApproximator::SourceTag> tags;
   PointQueryResult w;
+  ScopedDecode decode(*this);
 
   /* if the point is outside of bb and its distance is greater
    * than max_value with max_value >= 0.0, then early out
@@ -17,6 +17,7 @@
 #include <astral/util/ostream_utility.hpp>
 #include <astral/util/polynomial.hpp>
 #include "contour_approximator.hpp"
+#include "cubic_bezier_batch.hpp"
 
 static
 void
@@ -162,23 +163,48 @@ add_cubic(bool approximate_as_line_segment,
       float error;
 
       error = compute_quadratic_appoximation(C, &Q);
-      quadratic_contour->push_back(ContourCurve(Q[0], Q[1], Q[2], C.continuation()));
-      tessed_contour->push_back(C);
+      add_cubic_approximated(quadratic_contour, tessed_contour, C, Q, error);
+    }
+}
 
-      if (m_mode == approximate_to_quadratic_error_to_biarc)
-        {
-          error += compute_biarc_error_rel_length<double>(Q);
-        }
+void
+astral::detail::ContourApproximator::
+add_cubic_approximated(ApproximatedContour *quadratic_contour,
+                       TessedContour *tessed_contour,
+                       const ContourCurve &C,
+                       const QuadraticBezierCurve &Q, float error)
+{
+  ASTRALassert(C.type() == ContourCurve::cubic_bezier);
 
-      m_error = t_max(m_error, error);
-      if (size_of_curve_contributes_to_error(m_sz_mode)
-          && C.generation() < generation_ignore_size)
-        {
-          m_error = t_max(m_error, compute_error_from_size(Q));
-        }
+  quadratic_contour->push_back(ContourCurve(Q[0], Q[1], Q[2], C.continuation()));
+  tessed_contour->push_back(C);
+
+  if (m_mode == approximate_to_quadratic_error_to_biarc)
+    {
+      error += compute_biarc_error_rel_length<double>(Q);
+    }
+
+  m_error = t_max(m_error, error);
+  if (size_of_curve_contributes_to_error(m_sz_mode)
+      && C.generation() < generation_ignore_size)
+    {
+      m_error = t_max(m_error, compute_error_from_size(Q));
     }
 }
 
+void
+astral::detail::ContourApproximator::
+add_approximated(ApproximatedContour *quadratic_contour,
+                 TessedContour *tessed_contour,
+                 const ContourCurve &C,
+                 const ContourCurve &approximation,
+                 float error)
+{
+  quadratic_contour->push_back(approximation);
+  tessed_contour->push_back(C);
+  m_error = t_max(m_error, error);
+}
+
 void
 astral::detail::ContourApproximator::
 add_quadratic(ApproximatedContour *quadratic_contour,
@@ -279,10 +305,20 @@ add_line(ApproximatedContour *quadratic_contour,
 
 astral::reference_counted_ptr<const astral::detail::ContourApproximator>
 astral::detail::ContourApproximator::
-create_refinement_implement(c_array<const SourceTag> tags,
-                            c_array<ApproximatedContour> dst_geometry,
+create_refinement_implement(c_array<ApproximatedContour> dst_geometry,
                             std::vector<SourceTag> *dst_tags) const
 {
+  c_array<const SourceTag> tags;
+
+  /* the tags of the curves of m_tessed_contours are needed to
+   * generate the tags of the refinement
+   */
+  ASTRALassert(!dst_tags || m_tessed_tags.size() == m_tessed_contours.front().size());
+  if (dst_tags)
+    {
+      tags = make_c_array(m_tessed_tags);
+    }
+
   return ASTRALnew ContourApproximator(make_c_array(m_tessed_contours),
                                        m_error * 0.5f, dst_geometry, m_mode,
                                        m_sz_mode, m_split_singleton_contours,
@@ -305,7 +341,8 @@ compute_error_from_size(const QuadraticBezierCurve &p)
 
 void
 astral::detail::ContourApproximator::
-post_process_approximation(c_array<ApproximatedContour> contours)
+post_process_approximation(c_array<ApproximatedContour> contours,
+                           std::vector<SourceTag> *tags)
 {
   if (contours.empty() || contours[0].empty())
     {
@@ -347,11 +384,20 @@ post_process_approximation(c_array<ApproximatedContour> contours)
   std::vector<ApproximatedContour> out_contours(contours.size());
   std::vector<vec2> start_pts(contours.size()), end_pts(contours.size());
   std::vector<bool> can_remove_curve(contours[0].size(), true);
+  std::vector<SourceTag> out_tags;
+
+  if (tags)
+    {
+      out_tags.reserve(tags->size());
+    }
+
+  ASTRALassert(!tags || tags->size() == contours[0].size());
 
   for (unsigned int contour = 0, end_contour = contours.size(); contour < end_contour; ++contour)
     {
       start_pts[contour] = contours[contour].front().start_pt();
       end_pts[contour] = contours[contour].back().end_pt();
+      out_contours[contour].reserve(contours[contour].size());
 
       /* We cannot remove a curve if either of its start or end would be merged
        * with a bevel glue join. If we remove such a curve, then there is a risk
@@ -391,8 +437,16 @@ post_process_approximation(c_array<ApproximatedContour> contours)
       if (num_degenerate == contours.size() && can_remove_curve[curve])
         {
           /* all curves are degenerate, or close to degenerate. */
+          continue;
         }
-      else if (num_flat == contours.size())
+
+      /* the curve is kept, so is its tag */
+      if (tags)
+        {
+          out_tags.push_back((*tags)[curve]);
+        }
+
+      if (num_flat == contours.size())
         {
           /* replace all conic curves present with a line segment */
           for (unsigned int contour = 0, end_contour = contours.size(); contour < end_contour; ++contour)
@@ -466,6 +520,27 @@ post_process_approximation(c_array<ApproximatedContour> contours)
       /* swap out_contours[] with contours[] to "write" the data */
       contours[contour].swap(out_contours[contour]);
     }
+
+  if (tags)
+    {
+      tags->swap(out_tags);
+    }
+}
+
+astral::detail::ContourApproximator::
+ContourApproximator(c_array<const ContourCurve> tessellation,
+                    c_array<const SourceTag> tessellation_tags,
+                    float error, enum mode_t pmode, enum max_size_mode_t psz_mode,
+                    bool split_singleton_contours):
+  m_mode(pmode),
+  m_sz_mode(psz_mode),
+  m_split_singleton_contours(split_singleton_contours),
+  m_error(error),
+  m_tessed_contours(1),
+  m_tessed_tags(tessellation_tags.begin(), tessellation_tags.end())
+{
+  ASTRALassert(tessellation_tags.empty() || tessellation_tags.size() == tessellation.size());
+  m_tessed_contours[0].assign(tessellation.begin(), tessellation.end());
 }
 
 astral::detail::ContourApproximator::
@@ -584,9 +659,35 @@ ContourApproximator(const CurveFetcherBase &in_Cs, float target_tol,
 
   const CurveFetcherBase &Cs(*pCs);
   unsigned int number_curves(Cs.get_curves(0).size());
+  unsigned int number_contours(Cs.number_contours());
+  std::vector<c_array<const ContourCurve>> curves(number_contours);
 
-  m_tessed_contours.resize(Cs.number_contours());
-  for (unsigned int i = 0; i < Cs.number_contours(); ++i)
+  for (unsigned int contour = 0; contour < number_contours; ++contour)
+    {
+      curves[contour] = Cs.get_curves(contour);
+      ASTRALassert(curves[contour].size() == number_curves);
+    }
+
+  /* The curves are processed in two passes. The first pass computes
+   * the approximation and its error of each curve to decide which
+   * curves are split. The second pass adds the curves that are not
+   * split using the values of the first pass and adds the halves of
+   * those curves that are split. In each pass, the cubics are first
+   * gathered into a CubicBezierBatch so that the cubic to quadratic
+   * approximation and splitting are performed on several curves at
+   * once. Cubics are gathered and consumed in the same order, curve
+   * by curve and within a curve, contour by contour.
+   */
+  std::vector<QuadraticBezierCurve> approx_quads(number_contours * number_curves);
+  std::vector<float> approx_errors(number_contours * number_curves, 0.0f);
+  std::vector<bool> should_split(number_curves, false), has_quadratic(number_curves, false);
+  std::vector<QuadraticBezierCurve> batch_quads, before_quads, after_quads;
+  std::vector<float> batch_errors, before_errors, after_errors;
+  CubicBezierBatch batch, split_batch, before_batch, after_batch;
+  unsigned int batch_idx, number_split(0u);
+
+  m_tessed_contours.resize(number_contours);
+  for (unsigned int i = 0; i < number_contours; ++i)
     {
       quads[i].clear();
     }
@@ -597,27 +698,38 @@ ContourApproximator(const CurveFetcherBase &in_Cs, float target_tol,
       dst_tags->clear();
     }
 
+  batch.reserve(number_curves * number_contours);
+  split_batch.reserve(number_curves * number_contours);
   for (unsigned int curve = 0; curve < number_curves; ++curve)
     {
-      bool should_split, has_quadratic;
+      for (unsigned int contour = 0; contour < number_contours; ++contour)
+        {
+          const ContourCurve &p(curves[contour][curve]);
+
+          if (p.type() == ContourCurve::cubic_bezier && !curve_has_glue_cusp(curves[contour], curve))
+            {
+              batch.add(p);
+            }
+        }
+    }
+  batch.compute_quadratic_approximations(&batch_quads, &batch_errors);
 
-      should_split = false;
-      has_quadratic = false;
-      for (unsigned int contour = 0; contour < Cs.number_contours(); ++contour)
+  batch_idx = 0u;
+  for (unsigned int curve = 0; curve < number_curves; ++curve)
+    {
+      for (unsigned int contour = 0; contour < number_contours; ++contour)
         {
-          const ContourCurve &p(Cs.get_curves(contour)[curve]);
+          const ContourCurve &p(curves[contour][curve]);
           QuadraticBezierCurve Q;
           float error(0.0f);
           bool curve_touches_glue_cusp;
 
-          ASTRALassert(Cs.get_curves(contour).size() == number_curves);
-
           /* if the curve's continuation type or the continuation
            * type of the next curve is continuation_curve_cusp,
            * then the cubic must be approximated by line segments
            * only.
            */
-          curve_touches_glue_cusp = Cs.curve_has_glue_cusp(contour, curve);
+          curve_touches_glue_cusp = curve_has_glue_cusp(curves[contour], curve);
           switch (p.type())
             {
             case ContourCurve::cubic_bezier:
@@ -633,8 +745,10 @@ ContourApproximator(const CurveFetcherBase &in_Cs, float target_tol,
                   }
                 else
                   {
-                    error = compute_quadratic_appoximation(p, &Q);
-                    has_quadratic = true;
+                    Q = batch_quads[batch_idx];
+                    error = batch_errors[batch_idx];
+                    ++batch_idx;
+                    has_quadratic[curve] = true;
                   }
               }
               break;
@@ -649,12 +763,12 @@ ContourApproximator(const CurveFetcherBase &in_Cs, float target_tol,
                 {
                   Q = QuadraticBezierCurve(p.start_pt(), p.control_pt(0), p.end_pt());
                 }
-              has_quadratic = true;
+              has_quadratic[curve] = true;
               break;
 
             case ContourCurve::quadratic_bezier:
               Q = QuadraticBezierCurve(p.start_pt(), p.control_pt(0), p.end_pt());
-              has_quadratic = true;
+              has_quadratic[curve] = true;
               break;
 
             case ContourCurve::line_segment:
@@ -665,29 +779,73 @@ ContourApproximator(const CurveFetcherBase &in_Cs, float target_tol,
               break;
             }
 
-          if (m_mode == approximate_to_quadratic_error_to_biarc
-              && p.type() != ContourCurve::line_segment)
-            {
-              error += compute_biarc_error_rel_length<double>(Q);
-            }
-
-          if (p.generation() < generation_ignore_size)
+          /* a cubic that touches a glue cusp is approximated by a line
+           * segment, so there is no quadratic curve Q for it and its
+           * error was computed above.
+           */
+          if (p.type() != ContourCurve::cubic_bezier || !curve_touches_glue_cusp)
             {
-              if (size_of_lines_contributes_to_error(m_sz_mode) && p.type() == ContourCurve::line_segment)
+              if (m_mode == approximate_to_quadratic_error_to_biarc
+                  && p.type() != ContourCurve::line_segment)
                 {
-                  vec2 d(p.start_pt() - p.end_pt());
-                  error = t_max(error, compute_error_from_size(d.magnitude()));
+                  error += compute_biarc_error_rel_length<double>(Q);
                 }
-              else if (size_of_curve_contributes_to_error(m_sz_mode) && p.type() != ContourCurve::line_segment)
+
+              if (p.generation() < generation_ignore_size)
                 {
-                  error = t_max(error, compute_error_from_size(Q));
+                  if (size_of_lines_contributes_to_error(m_sz_mode) && p.type() == ContourCurve::line_segment)
+                    {
+                      vec2 d(p.start_pt() - p.end_pt());
+                      error = t_max(error, compute_error_from_size(d.magnitude()));
+                    }
+                  else if (size_of_curve_contributes_to_error(m_sz_mode) && p.type() != ContourCurve::line_segment)
+                    {
+                      error = t_max(error, compute_error_from_size(Q));
+                    }
                 }
             }
 
-          should_split = should_split || (error > target_tol && target_tol > 0.0f)
+          /* the error computed is exactly what add_cubic(), add_quadratic(),
+           * add_conic() and add_line() would compute for the curve, so
+           * the second pass can use these values if the curve is not split.
+           */
+          approx_quads[contour * number_curves + curve] = Q;
+          approx_errors[contour * number_curves + curve] = error;
+
+          should_split[curve] = should_split[curve] || (error > target_tol && target_tol > 0.0f)
             || (number_curves == 1 && m_split_singleton_contours);
         }
+      if (should_split[curve])
+        {
+          ++number_split;
+          for (unsigned int contour = 0; contour < number_contours; ++contour)
+            {
+              if (curves[contour][curve].type() == ContourCurve::cubic_bezier)
+                {
+                  split_batch.add(curves[contour][curve]);
+                }
+            }
+        }
+    }
+
+  split_batch.split(&before_batch, &after_batch);
+  before_batch.compute_quadratic_approximations(&before_quads, &before_errors);
+  after_batch.compute_quadratic_approximations(&after_quads, &after_errors);
+
+  for (unsigned int i = 0; i < number_contours; ++i)
+    {
+      quads[i].reserve(number_curves + number_split);
+      m_tessed_contours[i].reserve(number_curves + number_split);
+    }
 
+  if (dst_tags)
+    {
+      dst_tags->reserve(number_curves + number_split);
+    }
+
+  batch_idx = 0u;
+  for (unsigned int curve = 0; curve < number_curves; ++curve)
+    {
       if (dst_tags)
         {
           SourceTag src_tag;
@@ -702,7 +860,7 @@ ContourApproximator(const CurveFetcherBase &in_Cs, float target_tol,
               src_tag = tags[curve];
             }
 
-          if (should_split)
+          if (should_split[curve])
             {
               SourceTag a, b;
 
@@ -719,31 +877,33 @@ ContourApproximator(const CurveFetcherBase &in_Cs, float target_tol,
             }
         }
 
-      for (unsigned int contour = 0; contour < Cs.number_contours(); ++contour)
+      for (unsigned int contour = 0; contour < number_contours; ++contour)
         {
-          const ContourCurve &p(Cs.get_curves(contour)[curve]);
+          const ContourCurve &p(curves[contour][curve]);
+          const QuadraticBezierCurve &Q(approx_quads[contour * number_curves + curve]);
+          float error(approx_errors[contour * number_curves + curve]);
           bool curve_touches_glue_cusp;
 
-          curve_touches_glue_cusp = Cs.curve_has_glue_cusp(contour, curve);
+          curve_touches_glue_cusp = curve_has_glue_cusp(curves[contour], curve);
 
           switch (p.type())
             {
             case ContourCurve::line_segment:
-              if (should_split)
+              if (should_split[curve])
                 {
                   ContourCurveSplit split(true, p);
 
-                  add_line(&quads[contour], &m_tessed_contours[contour], has_quadratic, split.before_t());
-                  add_line(&quads[contour], &m_tessed_contours[contour], has_quadratic, split.after_t());
+                  add_line(&quads[contour], &m_tessed_contours[contour], has_quadratic[curve], split.before_t());
+                  add_line(&quads[contour], &m_tessed_contours[contour], has_quadratic[curve], split.after_t());
                 }
               else
                 {
-                  add_line(&quads[contour], &m_tessed_contours[contour], has_quadratic, p);
+                  add_line(&quads[contour], &m_tessed_contours[contour], has_quadratic[curve], p);
                 }
               break;
 
             case ContourCurve::quadratic_bezier:
-              if (should_split)
+              if (should_split[curve])
                 {
                   ContourCurveSplit split(true, p);
 
@@ -752,36 +912,71 @@ ContourApproximator(const CurveFetcherBase &in_Cs, float target_tol,
                 }
               else
                 {
-                  add_quadratic(&quads[contour], &m_tessed_contours[contour], p);
+                  add_approximated(&quads[contour], &m_tessed_contours[contour], p,
+                                   ContourCurve(Q[0], Q[1], Q[2], p.continuation()),
+                                   error);
                 }
               break;
 
             case ContourCurve::conic_arc_curve:
             case ContourCurve::conic_curve:
-              if (should_split)
+              if (should_split[curve])
                 {
                   ContourCurveSplit split(true, p);
 
                   add_conic(&quads[contour], &m_tessed_contours[contour], split.before_t());
                   add_conic(&quads[contour], &m_tessed_contours[contour], split.after_t());
                 }
+              else if (m_mode == approximate_to_conic_or_quadratic)
+                {
+                  add_approximated(&quads[contour], &m_tessed_contours[contour], p, p, error);
+                }
               else
                 {
-                  add_conic(&quads[contour], &m_tessed_contours[contour], p);
+                  add_approximated(&quads[contour], &m_tessed_contours[contour], p,
+                                   ContourCurve(Q[0], Q[1], Q[2], p.continuation()),
+                                   error);
                 }
               break;
 
             case ContourCurve::cubic_bezier:
-              if (should_split)
+              if (should_split[curve])
                 {
-                  ContourCurveSplit split(true, p);
+                  /* same as ContourCurveSplit(true, p) */
+                  ContourCurve before_t(before_batch.curve(batch_idx), p.continuation());
+                  ContourCurve after_t(after_batch.curve(batch_idx), ContourCurve::continuation_curve);
+
+                  before_t.generation(p.generation() + 1u);
+                  after_t.generation(p.generation() + 1u);
+                  if (curve_touches_glue_cusp)
+                    {
+                      add_cubic(true, &quads[contour], &m_tessed_contours[contour], has_quadratic[curve], before_t);
+                      add_cubic(true, &quads[contour], &m_tessed_contours[contour], has_quadratic[curve], after_t);
+                    }
+                  else
+                    {
+                      add_cubic_approximated(&quads[contour], &m_tessed_contours[contour], before_t,
+                                             before_quads[batch_idx], before_errors[batch_idx]);
+                      add_cubic_approximated(&quads[contour], &m_tessed_contours[contour], after_t,
+                                             after_quads[batch_idx], after_errors[batch_idx]);
+                    }
+                  ++batch_idx;
+                }
+              else if (curve_touches_glue_cusp)
+                {
+                  vec2 ctl(0.5f * (p.start_pt() + p.end_pt()));
 
-                  add_cubic(curve_touches_glue_cusp, &quads[contour], &m_tessed_contours[contour], has_quadratic, split.before_t());
-                  add_cubic(curve_touches_glue_cusp, &quads[contour], &m_tessed_contours[contour], has_quadratic, split.after_t());
+                  add_approximated(&quads[contour], &m_tessed_contours[contour], p,
+                                   (has_quadratic[curve]) ?
+                                   ContourCurve(p.start_pt(), ctl, p.end_pt(), p.continuation()) :
+                                   ContourCurve(p.start_pt(), p.end_pt(), p.continuation()),
+                                   error);
                 }
               else
                 {
-                  add_cubic(curve_touches_glue_cusp, &quads[contour], &m_tessed_contours[contour], has_quadratic, p);
+                  add_approximated(&quads[contour], &m_tessed_contours[contour], p,
+                                   ContourCurve(Q[0], Q[1], Q[2], p.continuation()),
+                                   error);
                 }
               break;
 
@@ -790,5 +985,10 @@ ContourApproximator(const CurveFetcherBase &in_Cs, float target_tol,
             }
         }
     }
-  post_process_approximation(quads);
+  if (dst_tags)
+    {
+      /* the tags before post-processing are the tags of m_tessed_contours */
+      m_tessed_tags = *dst_tags;
+    }
+  post_process_approximation(quads, dst_tags);
 }
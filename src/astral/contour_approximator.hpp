@@ -219,12 +219,30 @@ namespace astral
                             split_cubic_cusps_mode, dst_tags)
       {}
 
+      /*!
+       * Ctor to create a ContourApproximator for a single contour
+       * directly from the state of a previous approximation, i.e.
+       * the values returned by tessellation() and tessellation_tags()
+       * of a ContourApproximator, possibly modified. The purpose is
+       * to be able to resume refinement after replacing the
+       * tessellation of some of the curves.
+       * \param tessellation tessellation of the source contour
+       * \param tessellation_tags tag for each curve of tessellation
+       * \param error error of the approximation
+       * \param mode mode_t of the approximation
+       * \param sz_mode max_size_mode_t of the approximation
+       * \param split_singleton_contours split_singleton_contours of the approximation
+       */
+      ContourApproximator(c_array<const ContourCurve> tessellation,
+                          c_array<const SourceTag> tessellation_tags,
+                          float error, enum mode_t mode, enum max_size_mode_t sz_mode,
+                          bool split_singleton_contours);
+
       /*!
        * Refine the approximation by creating and returning a
        * new ContourApproximator object that allows those cubics
        * that were split in this to be split again in the returned
        * object AND the target tolerance is set to half of error().
-       * \param tags for each curve, the tag of its source
        * \param dst_geometry the tessellation of Cs[I] will be written
        *                     to dst_geometry[I], the size of dst_geometry
        *                     must be the same as the size of Cs; in adddition,
@@ -233,14 +251,15 @@ namespace astral
        *                     will have the same number of curves and the
        *                     degree of the I'th curve for all approximations
        *                     is the same.
-       * \param dst_tags location to which to write the tagging information
+       * \param dst_tags location to which to write the tagging information;
+       *                 this ContourApproximator must have been created
+       *                 with tagging as well
        */
       reference_counted_ptr<const ContourApproximator>
-      create_refinement(c_array<const SourceTag> tags,
-                        c_array<ApproximatedContour> dst_geometry,
+      create_refinement(c_array<ApproximatedContour> dst_geometry,
                         std::vector<SourceTag> *dst_tags) const
       {
-        return create_refinement_implement(tags, dst_geometry, dst_tags);
+        return create_refinement_implement(dst_geometry, dst_tags);
       }
 
       /*!
@@ -249,18 +268,17 @@ namespace astral
       reference_counted_ptr<const ContourApproximator>
       create_refinement(c_array<ApproximatedContour> dst_geometry) const
       {
-        return create_refinement_implement(c_array<const SourceTag>(), dst_geometry, nullptr);
+        return create_refinement_implement(dst_geometry, nullptr);
       }
 
       /*!
        * Overload to reduce typing
        */
       reference_counted_ptr<const ContourApproximator>
-      create_refinement(c_array<const SourceTag> tags,
-                        ApproximatedContour *dst_geometry,
+      create_refinement(ApproximatedContour *dst_geometry,
                         std::vector<SourceTag> *dst_tags) const
       {
-        return create_refinement(tags, c_array<ApproximatedContour>(dst_geometry, 1), dst_tags);
+        return create_refinement(c_array<ApproximatedContour>(dst_geometry, 1), dst_tags);
       }
 
       /*!
@@ -272,6 +290,27 @@ namespace astral
         return create_refinement(c_array<ApproximatedContour>(dst_geometry, 1));
       }
 
+      /*!
+       * Returns the tessellation of the named source contour
+       * from which the approximation was made, refinement
+       * resumes from this tessellation.
+       */
+      c_array<const ContourCurve>
+      tessellation(unsigned int contour) const
+      {
+        return make_c_array(m_tessed_contours[contour]);
+      }
+
+      /*!
+       * Returns the tags of the curves of tessellation(); this
+       * array is empty if tagging was not requested.
+       */
+      c_array<const SourceTag>
+      tessellation_tags(void) const
+      {
+        return make_c_array(m_tessed_tags);
+      }
+
       /*!
        * Return the error between the source contour and the
        * approximation by quadratic curves.
@@ -315,6 +354,23 @@ namespace astral
 
       typedef std::vector<ContourCurve> TessedContour;
 
+      static
+      bool
+      curve_has_glue_cusp(c_array<const ContourCurve> curves, unsigned int curve)
+      {
+        if (curves[curve].continuation() == ContourCurve::continuation_curve_cusp)
+          {
+            return true;
+          }
+
+        if (curve + 1 < curves.size() && curves[curve + 1].continuation() == ContourCurve::continuation_curve_cusp)
+          {
+            return true;
+          }
+
+        return false;
+      }
+
       class CurveFetcherBase
       {
       public:
@@ -342,19 +398,7 @@ namespace astral
         bool
         curve_has_glue_cusp(unsigned int contour, unsigned int curve) const
         {
-          c_array<const ContourCurve> curves(get_curves(contour));
-
-          if (curves[curve].continuation() == ContourCurve::continuation_curve_cusp)
-            {
-              return true;
-            }
-
-          if (curve + 1 < curves.size() && curves[curve + 1].continuation() == ContourCurve::continuation_curve_cusp)
-            {
-              return true;
-            }
-
-          return false;
+          return ContourApproximator::curve_has_glue_cusp(get_curves(contour), curve);
         }
 
       private:
@@ -431,8 +475,7 @@ namespace astral
                           std::vector<SourceTag> *dst_tags);
 
       reference_counted_ptr<const ContourApproximator>
-      create_refinement_implement(c_array<const SourceTag> tags,
-                                  c_array<ApproximatedContour> dst_geometry,
+      create_refinement_implement(c_array<ApproximatedContour> dst_geometry,
                                   std::vector<SourceTag> *dst_tags) const;
 
       void
@@ -442,6 +485,25 @@ namespace astral
                 bool has_quadratic,
                 const ContourCurve &C);
 
+      /* add a cubic whose approximation by a quadratic
+       * curve and the error of it are already computed
+       */
+      void
+      add_cubic_approximated(ApproximatedContour *quadratic_contour,
+                             TessedContour *contour_tessed,
+                             const ContourCurve &C,
+                             const QuadraticBezierCurve &Q, float error);
+
+      /* add a curve whose approximation and the total
+       * error of it are already computed
+       */
+      void
+      add_approximated(ApproximatedContour *quadratic_contour,
+                       TessedContour *contour_tessed,
+                       const ContourCurve &C,
+                       const ContourCurve &approximation,
+                       float error);
+
       void
       add_quadratic(ApproximatedContour *quadratic_contour,
                     TessedContour *contour_tessed,
@@ -486,7 +548,8 @@ namespace astral
 
       static
       void
-      post_process_approximation(c_array<ApproximatedContour> contours);
+      post_process_approximation(c_array<ApproximatedContour> contours,
+                                 std::vector<SourceTag> *tags);
 
       enum mode_t m_mode;
       enum max_size_mode_t m_sz_mode;
@@ -498,6 +561,11 @@ namespace astral
        * restarting it.
        */
       std::vector<TessedContour> m_tessed_contours;
+
+      /* if tagging was requested, the tags of the curves of
+       * each element of m_tessed_contours
+       */
+      std::vector<SourceTag> m_tessed_tags;
     };
 
   } // of namespace detail
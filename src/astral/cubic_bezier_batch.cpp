@@ -0,0 +1,439 @@
+/*!
+ * \file cubic_bezier_batch.cpp
+ * \brief file cubic_bezier_batch.cpp
+ *
+ * Copyright 2019 by InvisionApp.
+ *
+ * Contact: kevinrogovin@invisionapp.com
+ *
+ * This Source Code Form is subject to the
+ * terms of the Mozilla Public License, v. 2.0.
+ * If a copy of the MPL was not distributed with
+ * this file, You can obtain one at
+ * http://mozilla.org/MPL/2.0/.
+ *
+ */
+
+#include <cmath>
+#include "cubic_bezier_batch.hpp"
+#include "util/simd.hpp"
+
+/* The AVX kernels are compiled with the avx target attribute
+ * and only run if the CPU reports AVX at run time, so the
+ * library itself does not need to be built with -mavx.
+ */
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+  #include <immintrin.h>
+  #define ASTRAL_CUBIC_BATCH_AVX
+  #define ASTRAL_CUBIC_BATCH_AVX_TARGET __attribute__((target("avx")))
+#endif
+
+namespace
+{
+  /* sqrt(3) / 36, see compute_quadratic_appoximation() */
+  const float sqrt3_div_36(0.04811252243f);
+
+  /* The vectorized and scalar routines below must perform the
+   * same operations in the same order as split_cubic() and
+   * compute_quadratic_appoximation() so that the results do
+   * not depend on the instruction set. Both this file and
+   * contour_curve_util.cpp are built with -ffp-contract=off
+   * (see Rules.mk) so that the compiler does not fuse a multiply
+   * and an add into an FMA in one of them but not the other.
+   */
+
+#if !defined(ASTRAL_SIMD_SCALAR)
+  using namespace astral::detail::simd;
+#endif
+
+#if defined(ASTRAL_CUBIC_BATCH_AVX)
+  bool
+  avx_supported(void)
+  {
+    static const bool R(__builtin_cpu_supports("avx"));
+    return R;
+  }
+#endif
+
+  inline
+  void
+  quadratic_approximation_scalar(const float *x[4], const float *y[4],
+                                 float *ctl_x, float *ctl_y, float *error,
+                                 unsigned int begin, unsigned int end)
+  {
+    for (unsigned int i = begin; i < end; ++i)
+      {
+        float ax, ay, bx, by, dx, dy;
+
+        ax = 3.0f * x[1][i] - x[0][i];
+        ay = 3.0f * y[1][i] - y[0][i];
+        bx = 3.0f * x[2][i] - x[3][i];
+        by = 3.0f * y[2][i] - y[3][i];
+        dx = ax - bx;
+        dy = ay - by;
+
+        ctl_x[i] = 0.25f * (ax + bx);
+        ctl_y[i] = 0.25f * (ay + by);
+        error[i] = sqrt3_div_36 * std::sqrt(dx * dx + dy * dy);
+      }
+  }
+
+  inline
+  void
+  split_scalar(const float *p[4], float *before[4], float *after[4],
+               unsigned int begin, unsigned int end)
+  {
+    for (unsigned int i = begin; i < end; ++i)
+      {
+        float p0(p[0][i]), p1(p[1][i]), p2(p[2][i]), p3(p[3][i]);
+        float p01, p23, pA, pB, pC;
+
+        p01 = (p0 + p1) * 0.5f;
+        p23 = (p2 + p3) * 0.5f;
+        pA = (p0 + 2.0f * p1 + p2) * 0.25f;
+        pB = (p1 + 2.0f * p2 + p3) * 0.25f;
+        pC = (p0 + 3.0f * p1 + 3.0f * p2 + p3) * 0.125f;
+
+        before[0][i] = p0;
+        before[1][i] = p01;
+        before[2][i] = pA;
+        before[3][i] = pC;
+
+        after[0][i] = pC;
+        after[1][i] = pB;
+        after[2][i] = p23;
+        after[3][i] = p3;
+      }
+  }
+
+#if defined(ASTRAL_CUBIC_BATCH_AVX)
+  /* 8-wide versions of quadratic_approximation_simd() and
+   * split_simd(); they are written directly with the AVX
+   * intrinsics because the wrappers of simd.hpp are compiled
+   * for the baseline instruction set and cannot be inlined
+   * into a function with a different target.
+   */
+  ASTRAL_CUBIC_BATCH_AVX_TARGET
+  unsigned int
+  quadratic_approximation_avx(const float *x[4], const float *y[4],
+                              float *ctl_x, float *ctl_y, float *error,
+                              unsigned int count)
+  {
+    const __m256 three(_mm256_set1_ps(3.0f));
+    const __m256 quarter(_mm256_set1_ps(0.25f));
+    const __m256 err_scale(_mm256_set1_ps(sqrt3_div_36));
+    unsigned int i, end;
+
+    end = count - count % 8u;
+    for (i = 0; i < end; i += 8u)
+      {
+        __m256 ax, ay, bx, by, dx, dy;
+
+        ax = _mm256_sub_ps(_mm256_mul_ps(three, _mm256_loadu_ps(x[1] + i)), _mm256_loadu_ps(x[0] + i));
+        ay = _mm256_sub_ps(_mm256_mul_ps(three, _mm256_loadu_ps(y[1] + i)), _mm256_loadu_ps(y[0] + i));
+        bx = _mm256_sub_ps(_mm256_mul_ps(three, _mm256_loadu_ps(x[2] + i)), _mm256_loadu_ps(x[3] + i));
+        by = _mm256_sub_ps(_mm256_mul_ps(three, _mm256_loadu_ps(y[2] + i)), _mm256_loadu_ps(y[3] + i));
+        dx = _mm256_sub_ps(ax, bx);
+        dy = _mm256_sub_ps(ay, by);
+
+        _mm256_storeu_ps(ctl_x + i, _mm256_mul_ps(quarter, _mm256_add_ps(ax, bx)));
+        _mm256_storeu_ps(ctl_y + i, _mm256_mul_ps(quarter, _mm256_add_ps(ay, by)));
+        _mm256_storeu_ps(error + i, _mm256_mul_ps(err_scale,
+                                                  _mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx),
+                                                                               _mm256_mul_ps(dy, dy)))));
+      }
+
+    return end;
+  }
+
+  ASTRAL_CUBIC_BATCH_AVX_TARGET
+  unsigned int
+  split_avx(const float *p[4], float *before[4], float *after[4], unsigned int count)
+  {
+    const __m256 half(_mm256_set1_ps(0.5f));
+    const __m256 quarter(_mm256_set1_ps(0.25f));
+    const __m256 eighth(_mm256_set1_ps(0.125f));
+    const __m256 two(_mm256_set1_ps(2.0f));
+    const __m256 three(_mm256_set1_ps(3.0f));
+    unsigned int i, end;
+
+    end = count - count % 8u;
+    for (i = 0; i < end; i += 8u)
+      {
+        __m256 p0, p1, p2, p3, p01, p23, pA, pB, pC;
+
+        p0 = _mm256_loadu_ps(p[0] + i);
+        p1 = _mm256_loadu_ps(p[1] + i);
+        p2 = _mm256_loadu_ps(p[2] + i);
+        p3 = _mm256_loadu_ps(p[3] + i);
+
+        p01 = _mm256_mul_ps(_mm256_add_ps(p0, p1), half);
+        p23 = _mm256_mul_ps(_mm256_add_ps(p2, p3), half);
+        pA = _mm256_mul_ps(_mm256_add_ps(_mm256_add_ps(p0, _mm256_mul_ps(two, p1)), p2), quarter);
+        pB = _mm256_mul_ps(_mm256_add_ps(_mm256_add_ps(p1, _mm256_mul_ps(two, p2)), p3), quarter);
+        pC = _mm256_mul_ps(_mm256_add_ps(_mm256_add_ps(_mm256_add_ps(p0, _mm256_mul_ps(three, p1)),
+                                                       _mm256_mul_ps(three, p2)), p3), eighth);
+
+        _mm256_storeu_ps(before[0] + i, p0);
+        _mm256_storeu_ps(before[1] + i, p01);
+        _mm256_storeu_ps(before[2] + i, pA);
+        _mm256_storeu_ps(before[3] + i, pC);
+
+        _mm256_storeu_ps(after[0] + i, pC);
+        _mm256_storeu_ps(after[1] + i, pB);
+        _mm256_storeu_ps(after[2] + i, p23);
+        _mm256_storeu_ps(after[3] + i, p3);
+      }
+
+    return end;
+  }
+#endif
+
+  /* returns the number of curves processed, the AVX kernel
+   * is used first when available and the 4-wide kernel then
+   * picks up from where it stopped
+   */
+  unsigned int
+  quadratic_approximation_simd(const float *x[4], const float *y[4],
+                               float *ctl_x, float *ctl_y, float *error,
+                               unsigned int count)
+  {
+    unsigned int i(0u);
+
+    #if defined(ASTRAL_CUBIC_BATCH_AVX)
+      {
+        if (avx_supported())
+          {
+            i = quadratic_approximation_avx(x, y, ctl_x, ctl_y, error, count);
+          }
+      }
+    #endif
+
+    #if !defined(ASTRAL_SIMD_SCALAR)
+      {
+        const simd_float three(simd_splat(3.0f));
+        const simd_float quarter(simd_splat(0.25f));
+        const simd_float err_scale(simd_splat(sqrt3_div_36));
+
+        for (; i + simd_width <= count; i += simd_width)
+          {
+            simd_float ax, ay, bx, by, dx, dy;
+
+            ax = simd_sub(simd_mul(three, simd_load(x[1] + i)), simd_load(x[0] + i));
+            ay = simd_sub(simd_mul(three, simd_load(y[1] + i)), simd_load(y[0] + i));
+            bx = simd_sub(simd_mul(three, simd_load(x[2] + i)), simd_load(x[3] + i));
+            by = simd_sub(simd_mul(three, simd_load(y[2] + i)), simd_load(y[3] + i));
+            dx = simd_sub(ax, bx);
+            dy = simd_sub(ay, by);
+
+            simd_store(ctl_x + i, simd_mul(quarter, simd_add(ax, bx)));
+            simd_store(ctl_y + i, simd_mul(quarter, simd_add(ay, by)));
+            simd_store(error + i, simd_mul(err_scale, simd_sqrt(simd_add(simd_mul(dx, dx), simd_mul(dy, dy)))));
+          }
+      }
+    #endif
+
+    ASTRALunused(x);
+    ASTRALunused(y);
+    ASTRALunused(ctl_x);
+    ASTRALunused(ctl_y);
+    ASTRALunused(error);
+    ASTRALunused(count);
+    return i;
+  }
+
+  /* returns the number of curves processed */
+  unsigned int
+  split_simd(const float *p[4], float *before[4], float *after[4], unsigned int count)
+  {
+    unsigned int i(0u);
+
+    #if defined(ASTRAL_CUBIC_BATCH_AVX)
+      {
+        if (avx_supported())
+          {
+            i = split_avx(p, before, after, count);
+          }
+      }
+    #endif
+
+    #if !defined(ASTRAL_SIMD_SCALAR)
+      {
+        const simd_float half(simd_splat(0.5f));
+        const simd_float quarter(simd_splat(0.25f));
+        const simd_float eighth(simd_splat(0.125f));
+        const simd_float two(simd_splat(2.0f));
+        const simd_float three(simd_splat(3.0f));
+
+        for (; i + simd_width <= count; i += simd_width)
+          {
+            simd_float p0, p1, p2, p3, p01, p23, pA, pB, pC;
+
+            p0 = simd_load(p[0] + i);
+            p1 = simd_load(p[1] + i);
+            p2 = simd_load(p[2] + i);
+            p3 = simd_load(p[3] + i);
+
+            p01 = simd_mul(simd_add(p0, p1), half);
+            p23 = simd_mul(simd_add(p2, p3), half);
+            pA = simd_mul(simd_add(simd_add(p0, simd_mul(two, p1)), p2), quarter);
+            pB = simd_mul(simd_add(simd_add(p1, simd_mul(two, p2)), p3), quarter);
+            pC = simd_mul(simd_add(simd_add(simd_add(p0, simd_mul(three, p1)), simd_mul(three, p2)), p3), eighth);
+
+            simd_store(before[0] + i, p0);
+            simd_store(before[1] + i, p01);
+            simd_store(before[2] + i, pA);
+            simd_store(before[3] + i, pC);
+
+            simd_store(after[0] + i, pC);
+            simd_store(after[1] + i, pB);
+            simd_store(after[2] + i, p23);
+            simd_store(after[3] + i, p3);
+          }
+      }
+    #endif
+
+    ASTRALunused(p);
+    ASTRALunused(before);
+    ASTRALunused(after);
+    ASTRALunused(count);
+    return i;
+  }
+}
+
+astral::c_string
+astral::detail::CubicBezierBatch::
+instruction_set(void)
+{
+#if defined(ASTRAL_CUBIC_BATCH_AVX)
+  if (avx_supported())
+    {
+      return "AVX";
+    }
+#endif
+
+#if defined(ASTRAL_SIMD_SSE2)
+  return "SSE2";
+#elif defined(ASTRAL_SIMD_NEON)
+  return "NEON";
+#else
+  return "scalar";
+#endif
+}
+
+void
+astral::detail::CubicBezierBatch::
+clear(void)
+{
+  resize(0u);
+}
+
+void
+astral::detail::CubicBezierBatch::
+reserve(unsigned int sz)
+{
+  for (unsigned int k = 0; k < 4; ++k)
+    {
+      m_x[k].reserve(sz);
+      m_y[k].reserve(sz);
+    }
+}
+
+void
+astral::detail::CubicBezierBatch::
+resize(unsigned int sz)
+{
+  for (unsigned int k = 0; k < 4; ++k)
+    {
+      m_x[k].resize(sz);
+      m_y[k].resize(sz);
+    }
+  m_size = sz;
+}
+
+void
+astral::detail::CubicBezierBatch::
+add(const ContourCurve &C)
+{
+  ASTRALassert(C.type() == ContourCurve::cubic_bezier);
+
+  vecN<vec2, 4> p(C.start_pt(), C.control_pt(0), C.control_pt(1), C.end_pt());
+  for (unsigned int k = 0; k < 4; ++k)
+    {
+      m_x[k].push_back(p[k].x());
+      m_y[k].push_back(p[k].y());
+    }
+  ++m_size;
+}
+
+void
+astral::detail::CubicBezierBatch::
+compute_quadratic_approximations(std::vector<QuadraticBezierCurve> *out_quads,
+                                 std::vector<float> *out_errors) const
+{
+  const float *x[4], *y[4];
+  std::vector<float> ctl_x(m_size), ctl_y(m_size);
+  unsigned int simd_end;
+
+  out_quads->resize(m_size);
+  out_errors->resize(m_size);
+  if (m_size == 0u)
+    {
+      return;
+    }
+
+  for (unsigned int k = 0; k < 4; ++k)
+    {
+      x[k] = m_x[k].data();
+      y[k] = m_y[k].data();
+    }
+
+  simd_end = quadratic_approximation_simd(x, y, ctl_x.data(), ctl_y.data(), out_errors->data(), m_size);
+  quadratic_approximation_scalar(x, y, ctl_x.data(), ctl_y.data(), out_errors->data(), simd_end, m_size);
+
+  for (unsigned int i = 0; i < m_size; ++i)
+    {
+      QuadraticBezierCurve &Q((*out_quads)[i]);
+
+      Q[0] = vec2(m_x[0][i], m_y[0][i]);
+      Q[1] = vec2(ctl_x[i], ctl_y[i]);
+      Q[2] = vec2(m_x[3][i], m_y[3][i]);
+    }
+}
+
+void
+astral::detail::CubicBezierBatch::
+split(CubicBezierBatch *out_before, CubicBezierBatch *out_after) const
+{
+  ASTRALassert(out_before != this && out_after != this);
+
+  out_before->resize(m_size);
+  out_after->resize(m_size);
+  if (m_size == 0u)
+    {
+      return;
+    }
+
+  /* x and y coordinates are processed in the same way,
+   * so just run the kernels once for each.
+   */
+  for (unsigned int coord = 0; coord < 2; ++coord)
+    {
+      const vecN<std::vector<float>, 4> &src((coord == 0) ? m_x : m_y);
+      vecN<std::vector<float>, 4> &before((coord == 0) ? out_before->m_x : out_before->m_y);
+      vecN<std::vector<float>, 4> &after((coord == 0) ? out_after->m_x : out_after->m_y);
+      const float *p[4];
+      float *b[4], *a[4];
+      unsigned int simd_end;
+
+      for (unsigned int k = 0; k < 4; ++k)
+        {
+          p[k] = src[k].data();
+          b[k] = before[k].data();
+          a[k] = after[k].data();
+        }
+
+      simd_end = split_simd(p, b, a, m_size);
+      split_scalar(p, b, a, simd_end, m_size);
+    }
+}
@@ -0,0 +1,136 @@
+/*!
+ * \file cubic_bezier_batch.hpp
+ * \brief file cubic_bezier_batch.hpp
+ *
+ * Copyright 2019 by InvisionApp.
+ *
+ * Contact: kevinrogovin@invisionapp.com
+ *
+ * This Source Code Form is subject to the
+ * terms of the Mozilla Public License, v. 2.0.
+ * If a copy of the MPL was not distributed with
+ * this file, You can obtain one at
+ * http://mozilla.org/MPL/2.0/.
+ *
+ */
+
+#ifndef ASTRAL_CUBIC_BEZIER_BATCH_HPP
+#define ASTRAL_CUBIC_BEZIER_BATCH_HPP
+
+#include <vector>
+#include <astral/util/vecN.hpp>
+#include <astral/util/c_array.hpp>
+#include <astral/util/util.hpp>
+#include <astral/contour_curve.hpp>
+#include "contour_curve_util.hpp"
+
+namespace astral
+{
+  namespace detail
+  {
+    /*!
+     * A CubicBezierBatch holds a set of cubic bezier curves
+     * as a structure of arrays so that the operations on them
+     * that ContourApproximator performs on every cubic can be
+     * done on 4 (SSE2, NEON) or 8 (AVX) curves at a time;
+     * AVX is chosen at run time on x86 CPUs that support it.
+     * The results are the same as those of split_cubic() and
+     * compute_quadratic_appoximation() for each curve because
+     * the vectorized paths perform the same floating point
+     * operations in the same order and the files involved are
+     * built with -ffp-contract=off, so that no path has its
+     * multiplies and adds fused into FMA instructions.
+     */
+    class CubicBezierBatch
+    {
+    public:
+      CubicBezierBatch(void):
+        m_size(0u)
+      {}
+
+      /*!
+       * Returns the instruction set used by the vectorized
+       * routines on this CPU, one of "AVX", "SSE2", "NEON"
+       * or "scalar".
+       */
+      static
+      c_string
+      instruction_set(void);
+
+      /*!
+       * Clear the batch
+       */
+      void
+      clear(void);
+
+      /*!
+       * Reserve space for the named number of curves
+       */
+      void
+      reserve(unsigned int sz);
+
+      /*!
+       * Add a curve to the batch.
+       * \param C curve to add, must be a cubic bezier curve
+       */
+      void
+      add(const ContourCurve &C);
+
+      /*!
+       * Returns the number of curves in the batch
+       */
+      unsigned int
+      size(void) const
+      {
+        return m_size;
+      }
+
+      /*!
+       * Returns the named curve of the batch
+       */
+      CubicBezierCurve
+      curve(unsigned int i) const
+      {
+        ASTRALassert(i < m_size);
+        return CubicBezierCurve(vec2(m_x[0][i], m_y[0][i]),
+                                vec2(m_x[1][i], m_y[1][i]),
+                                vec2(m_x[2][i], m_y[2][i]),
+                                vec2(m_x[3][i], m_y[3][i]));
+      }
+
+      /*!
+       * For each curve, compute the same values as
+       * compute_quadratic_appoximation().
+       * \param out_quads location to which to write the quadratic
+       *                  approximation of each curve
+       * \param out_errors location to which to write the error
+       *                   of each approximation
+       */
+      void
+      compute_quadratic_approximations(std::vector<QuadraticBezierCurve> *out_quads,
+                                       std::vector<float> *out_errors) const;
+
+      /*!
+       * For each curve, compute the same values as split_cubic().
+       * \param out_before location to which to write the curves
+       *                   before t = 0.5, the contents are replaced
+       * \param out_after location to which to write the curves
+       *                  after t = 0.5, the contents are replaced
+       */
+      void
+      split(CubicBezierBatch *out_before, CubicBezierBatch *out_after) const;
+
+    private:
+      void
+      resize(unsigned int sz);
+
+      /* m_x[k][i] and m_y[k][i] are the coordinates of
+       * the k'th point of the i'th curve
+       */
+      vecN<std::vector<float>, 4> m_x, m_y;
+      unsigned int m_size;
+    };
+  }
+}
+
+#endif
@@ -153,6 +153,32 @@ namespace astral
         return make_c_array(m_entries);
       }
 
+      /*!
+       * Set the elements of an empty chain, for example from
+       * serialized data; the errors of the elements must be
+       * decreasing. The contents of entries are swapped in.
+       */
+      void
+      load(std::vector<T> &entries)
+      {
+        ASTRALassert(m_entries.empty());
+        ASTRALassert(!entries.empty());
+
+        m_entries.swap(entries);
+        m_max_size = m_max_ratio * m_entries.front().size();
+      }
+
+      /*!
+       * Returns the elements for modifying in place; the
+       * caller must keep the errors of the elements
+       * decreasing.
+       */
+      c_array<T>
+      mutable_elements(void)
+      {
+        return make_c_array(m_entries);
+      }
+
     private:
       static
       bool
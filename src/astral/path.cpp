@@ -14,15 +14,20 @@
  *
  */
 
+#include <atomic>
+#include <cstring>
 #include <astral/path.hpp>
 #include <astral/renderer/combined_path.hpp>
 #include <astral/renderer/render_data.hpp>
 #include <astral/renderer/render_engine.hpp>
 #include <astral/renderer/item_path.hpp>
 #include <astral/util/ostream_utility.hpp>
+#include <astral/util/thread_pool.hpp>
 
 #include "contour_approximator.hpp"
 #include "generic_lod.hpp"
+#include "point_query_hierarchy.hpp"
+#include "serialized_data.hpp"
 
 class astral::Path::DataGenerator:public reference_counted<DataGenerator>::non_concurrent
 {
@@ -42,6 +47,21 @@ public:
     return e.data();
   }
 
+  const detail::PointQueryHierarchy&
+  fetch_point_query_hierarchy(float tol, const Path &path);
+
+  /* Write the ItemPath values of the LOD chain after making
+   * sure that it holds the ItemPath for each tolerance.
+   */
+  void
+  serialize_item_paths(detail::SerializedWriter &dst, c_array<const float> tolerances,
+                       const Path &path, detail::SerializedHeader *header);
+
+  enum return_code
+  deserialize_item_paths(const detail::SerializedReader &src, const detail::SerializedHeader &header);
+
+  class PrepareJob;
+
 private:
   class ItemPathEntry
   {
@@ -64,6 +84,11 @@ private:
       ItemPathEntry(-1.0f, path)
     {}
 
+    ItemPathEntry(const reference_counted_ptr<ItemPath> &item_path, bool finalized):
+      m_finalized(finalized),
+      m_data(item_path)
+    {}
+
     bool
     finalized(void) const { return m_finalized; }
 
@@ -102,8 +127,202 @@ private:
   };
 
   detail::GenericLOD<ItemPathEntry> m_item_path_entries;
+
+  /* maximum number of elements of m_point_query_hierarchies */
+  static const unsigned int max_number_point_query_hierarchies = 4u;
+
+  /* sorted in order of decreasing error() */
+  std::vector<reference_counted_ptr<const detail::PointQueryHierarchy>> m_point_query_hierarchies;
+};
+
+/* A PrepareJob repeatedly takes the next contour not yet
+ * taken by any PrepareJob and generates its data; the
+ * counter of the contours taken is shared by the jobs.
+ */
+class astral::Path::DataGenerator::PrepareJob:public astral::ThreadPool::Job
+{
+public:
+  PrepareJob(const std::vector<const astral::Contour*> &contours,
+             std::atomic<unsigned int> &next_contour,
+             astral::c_array<const float> tolerances,
+             uint32_t uses, bool render_input):
+    m_contours(contours),
+    m_next_contour(next_contour),
+    m_tolerances(tolerances),
+    m_uses(uses),
+    m_render_input(render_input)
+  {}
+
+  virtual
+  void
+  execute(void) override
+  {
+    for (unsigned int c = m_next_contour++; c < m_contours.size(); c = m_next_contour++)
+      {
+        m_contours[c]->prepare_data(m_tolerances, m_uses, m_render_input);
+      }
+  }
+
+private:
+  const std::vector<const astral::Contour*> &m_contours;
+  std::atomic<unsigned int> &m_next_contour;
+  astral::c_array<const float> m_tolerances;
+  uint32_t m_uses;
+  bool m_render_input;
 };
 
+////////////////////////////////////////
+// astral::Path::DataGenerator methods
+void
+astral::Path::DataGenerator::
+serialize_item_paths(detail::SerializedWriter &dst, c_array<const float> tolerances,
+                     const Path &path, detail::SerializedHeader *header)
+{
+  c_array<const ItemPathEntry> entries;
+  std::vector<detail::SerializedItemPath> records;
+
+  for (float tol : tolerances)
+    {
+      m_item_path_entries.fetch(tol, path);
+    }
+
+  /* The entire chain is written, it is already sorted by
+   * decreasing error which is the order that it is read.
+   */
+  entries = m_item_path_entries.all_elements();
+  records.resize(entries.size());
+  for (unsigned int i = 0; i < entries.size(); ++i)
+    {
+      if (!entries[i].data().serialize(dst, &records[i]))
+        {
+          reference_counted_ptr<ItemPath> p;
+
+          /* the ItemPath was uploaded to the GPU which released
+           * its CPU-side data; make it again, which gives the same
+           * data because the contours return the same approximation
+           * for a tolerance of the error of the approximation.
+           */
+          p = ItemPath::create(ItemPath::Geometry().add(path, entries[i].error()),
+                               entries[i].data().m_params);
+          p->serialize(dst, &records[i]);
+        }
+    }
+
+  header->m_item_paths = dst.write_array(make_c_array(records));
+  header->m_number_item_paths = records.size();
+}
+
+enum astral::return_code
+astral::Path::DataGenerator::
+deserialize_item_paths(const detail::SerializedReader &src, const detail::SerializedHeader &header)
+{
+  std::vector<ItemPathEntry> entries;
+
+  if (header.m_number_item_paths == 0u)
+    {
+      return routine_success;
+    }
+
+  entries.reserve(header.m_number_item_paths);
+  for (unsigned int i = 0; i < header.m_number_item_paths; ++i)
+    {
+      detail::SerializedItemPath record;
+      reference_counted_ptr<ItemPath> p;
+      bool is_last;
+
+      if (!src.read(header.m_item_paths, i, &record))
+        {
+          return routine_fail;
+        }
+
+      p = ItemPath::deserialize(src, record);
+      if (!p || (!entries.empty() && p->properties().m_error >= entries.back().error()))
+        {
+          return routine_fail;
+        }
+
+      /* only the last entry can be refined further */
+      is_last = (i + 1u == header.m_number_item_paths);
+      entries.push_back(ItemPathEntry(p, !is_last));
+    }
+
+  m_item_path_entries.load(entries);
+  return routine_success;
+}
+
+const astral::detail::PointQueryHierarchy&
+astral::Path::DataGenerator::
+fetch_point_query_hierarchy(float tol, const Path &path)
+{
+  /* Reuse the coarsest hierarchy that is accurate enough,
+   * or the hierarchy made for exactly tol; the latter is
+   * to handle when the approximations cannot reach tol.
+   */
+  for (const auto &h : m_point_query_hierarchies)
+    {
+      if (h->tolerance() == tol || (tol > 0.0f && h->error() <= tol))
+        {
+          return *h;
+        }
+    }
+
+  std::vector<detail::PointQueryHierarchy::Element> elements;
+  std::vector<range_type<float>> source_ranges;
+  std::vector<int> source_curves;
+  reference_counted_ptr<const detail::PointQueryHierarchy> h;
+  float error(0.0f);
+
+  for (unsigned int c = 0, endc = path.number_contours(); c < endc; ++c)
+    {
+      const Contour &contour(path.contour(c));
+      c_array<const ContourCurve> curves;
+      float contour_error;
+
+      curves = contour.item_path_approximated_geometry(tol, &contour_error, &source_curves, &source_ranges);
+      if (curves.empty())
+        {
+          continue;
+        }
+
+      error = t_max(error, contour_error);
+      for (unsigned int i = 0; i < curves.size(); ++i)
+        {
+          elements.push_back(detail::PointQueryHierarchy::Element(c, curves[i], source_curves[i], source_ranges[i]));
+        }
+
+      if (!contour.closed())
+        {
+          elements.push_back(detail::PointQueryHierarchy::Element(c, curves.back().end_pt(), curves.front().start_pt()));
+        }
+    }
+
+  h = ASTRALnew detail::PointQueryHierarchy(tol, error, elements);
+
+  auto iter = std::lower_bound(m_point_query_hierarchies.begin(), m_point_query_hierarchies.end(), h,
+                               [](const reference_counted_ptr<const detail::PointQueryHierarchy> &lhs,
+                                  const reference_counted_ptr<const detail::PointQueryHierarchy> &rhs)
+                               {
+                                 return lhs->error() > rhs->error();
+                               });
+  m_point_query_hierarchies.insert(iter, h);
+
+  /* Each finer tolerance requested makes a new hierarchy; cap their
+   * number by dropping the coarsest ones since a request for a coarser
+   * tolerance is served by any finer hierarchy.
+   */
+  while (m_point_query_hierarchies.size() > max_number_point_query_hierarchies)
+    {
+      iter = m_point_query_hierarchies.begin();
+      if (*iter == h)
+        {
+          ++iter;
+        }
+      m_point_query_hierarchies.erase(iter);
+    }
+
+  return *h;
+}
+
 ///////////////////////////////////////
 // astral::Path methods
 astral::Path::
@@ -293,15 +512,19 @@ ready_bb(void) const
       m_control_point_bb.clear();
       for (const auto &c : m_contours)
         {
-          if (!c->curves().empty())
+          /* use start() and current_pt() instead of the first
+           * and last curve so that compact contours are not
+           * decoded
+           */
+          if (!c->empty())
             {
               m_bb.union_box(c->bounding_box());
               m_join_bb.union_box(c->join_bounding_box());
               m_control_point_bb.union_box(c->control_point_bounding_box());
               if (!c->closed())
                 {
-                  m_cap_bb.union_point(c->curves().front().start_pt());
-                  m_cap_bb.union_point(c->curves().back().end_pt());
+                  m_cap_bb.union_point(c->start());
+                  m_cap_bb.union_point(c->current_pt());
                 }
             }
           else
@@ -345,6 +568,17 @@ join_bounding_box(void) const
   return m_join_bb;
 }
 
+void
+astral::Path::
+compact(void)
+{
+  mark_dirty();
+  for (const reference_counted_ptr<Contour> &C : m_contours)
+    {
+      C->compact();
+    }
+}
+
 void
 astral::Path::
 clear(void)
@@ -357,6 +591,92 @@ clear(void)
   m_data_generator = nullptr;
 }
 
+void
+astral::Path::
+serialize(std::vector<uint8_t> *dst, c_array<const float> tolerances, uint32_t uses) const
+{
+  detail::SerializedWriter writer(dst);
+  detail::SerializedHeader header;
+  uint64_t header_offset, contours_offset;
+
+  std::memset(&header, 0, sizeof(header));
+  header.m_magic = detail::serialized_path_magic;
+  header.m_version = detail::serialized_version;
+  header.m_byte_order = detail::serialized_byte_order;
+  header.m_curve_size = sizeof(ContourCurve);
+  header.m_flags = m_santize_curves_on_adding ? 1u : 0u;
+
+  header_offset = writer.allocate<detail::SerializedHeader>();
+  contours_offset = writer.allocate<uint64_t>(m_contours.size());
+  for (unsigned int i = 0; i < m_contours.size(); ++i)
+    {
+      writer.write(contours_offset, i, m_contours[i]->serialize(writer, tolerances, uses));
+    }
+  header.m_contours = contours_offset;
+  header.m_number_contours = m_contours.size();
+
+  if ((uses & contour_prepare_item_path) && !tolerances.empty())
+    {
+      data_generator().serialize_item_paths(writer, tolerances, *this, &header);
+    }
+
+  header.m_size = writer.size();
+  writer.write(header_offset, header);
+}
+
+enum astral::return_code
+astral::Path::
+deserialize(c_array<const uint8_t> src)
+{
+  detail::SerializedHeader header;
+  std::vector<reference_counted_ptr<Contour>> contours;
+
+  clear();
+
+  if (!detail::SerializedReader(src).read(0u, &header)
+      || header.m_magic != detail::serialized_path_magic
+      || header.m_version != detail::serialized_version
+      || header.m_byte_order != detail::serialized_byte_order
+      || header.m_curve_size != sizeof(ContourCurve)
+      || header.m_size > src.size())
+    {
+      return routine_fail;
+    }
+
+  detail::SerializedReader reader(src.sub_array(0, header.m_size));
+
+  contours.reserve(header.m_number_contours);
+  for (unsigned int i = 0; i < header.m_number_contours; ++i)
+    {
+      uint64_t offset;
+      detail::SerializedContour record;
+
+      if (!reader.read(header.m_contours, i, &offset)
+          || !reader.read(offset, &record))
+        {
+          return routine_fail;
+        }
+
+      contours.push_back(Contour::create());
+      if (routine_fail == contours.back()->deserialize(reader, record))
+        {
+          return routine_fail;
+        }
+    }
+
+  m_contours.swap(contours);
+  m_santize_curves_on_adding = (header.m_flags & 1u) != 0u;
+  m_bb_ready = false;
+
+  if (routine_fail == data_generator().deserialize_item_paths(reader, header))
+    {
+      clear();
+      return routine_fail;
+    }
+
+  return routine_success;
+}
+
 astral::Path::DataGenerator&
 astral::Path::
 data_generator(void) const
@@ -375,6 +695,64 @@ item_path(float tol, float *actual_error) const
   return data_generator().fetch_item_path(tol, *this, actual_error);
 }
 
+void
+astral::Path::
+prepare(c_array<const float> tolerances, uint32_t uses,
+        ThreadPool &thread_pool, RenderEngine *engine) const
+{
+  std::vector<const Contour*> contours;
+  std::atomic<unsigned int> next_contour(0u);
+  ThreadPool::Batch batch;
+  unsigned int number_jobs;
+
+  if (m_contours.empty() || tolerances.empty())
+    {
+      return;
+    }
+
+  /* Contour::prepare_data() is called by only one thread for a
+   * given contour and it only modifies data of that contour.
+   */
+  contours.reserve(m_contours.size());
+  for (const reference_counted_ptr<Contour> &C : m_contours)
+    {
+      contours.push_back(C.get());
+    }
+
+  /* one job per thread, the calling thread executes one of
+   * them in wait() if it is not yet started. The jobs reference
+   * the locals of this function, so wait on just these jobs;
+   * the pool may be shared with other work.
+   */
+  number_jobs = t_min(thread_pool.number_threads() + 1u, static_cast<unsigned int>(contours.size()));
+  for (unsigned int i = 0; i < number_jobs; ++i)
+    {
+      thread_pool.add_job(ASTRALnew DataGenerator::PrepareJob(contours, next_contour, tolerances,
+                                                              uses, engine != nullptr),
+                           batch);
+    }
+  thread_pool.wait(batch);
+
+  /* publish: creating render data needs the RenderEngine and
+   * the ItemPath uses the data of all contours.
+   */
+  if (engine)
+    {
+      for (const Contour *C : contours)
+        {
+          C->prepare_render_data(tolerances, uses, *engine);
+        }
+    }
+
+  if (uses & contour_prepare_item_path)
+    {
+      for (float tol : tolerances)
+        {
+          item_path(tol);
+        }
+    }
+}
+
 astral::Path::PointQueryResult
 astral::Path::
 distance_to_path(float tol, const vec2 &pt, float distance_cull) const
@@ -402,18 +780,39 @@ distance_to_path(float tol, const vec2 &pt, float distance_cull) const
         }
     }
 
-  for (unsigned int i = 0, endi = m_contours.size(); i < endi; ++i)
+  return data_generator().fetch_point_query_hierarchy(tol, *this).query(pt, distance_cull);
+}
+
+void
+astral::Path::
+distance_to_path(float tol, c_array<const vec2> pts,
+                 c_array<PointQueryResult> out_results,
+                 float distance_cull) const
+{
+  ASTRALassert(pts.size() == out_results.size());
+  if (m_contours.empty())
     {
-      w.absorb(i, m_contours[i]->distance_to_contour(tol, pt, distance_cull));
-      if (w.m_closest_contour > 0)
-        {
-          distance_cull = (distance_cull < 0.0f) ?
-            w.m_distance :
-            t_min(distance_cull, w.m_distance);
-        }
+      std::fill(out_results.begin(), out_results.end(), PointQueryResult());
+      return;
+    }
+
+  const detail::PointQueryHierarchy &h(data_generator().fetch_point_query_hierarchy(tol, *this));
+  for (unsigned int i = 0; i < pts.size(); ++i)
+    {
+      out_results[i] = h.query(pts[i], distance_cull);
+    }
+}
+
+int
+astral::Path::
+winding_number(float tol, const vec2 &pt) const
+{
+  if (m_contours.empty() || !bounding_box().contains(pt))
+    {
+      return 0;
     }
 
-  return w;
+  return data_generator().fetch_point_query_hierarchy(tol, *this).winding_number(pt);
 }
 
 bool
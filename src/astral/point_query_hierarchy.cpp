@@ -0,0 +1,250 @@
+/*!
+ * \file point_query_hierarchy.cpp
+ * \brief file point_query_hierarchy.cpp
+ *
+ * Copyright 2019 by InvisionApp.
+ *
+ * Contact: kevinrogovin@invisionapp.com
+ *
+ * This Source Code Form is subject to the
+ * terms of the Mozilla Public License, v. 2.0.
+ * If a copy of the MPL was not distributed with
+ * this file, You can obtain one at
+ * http://mozilla.org/MPL/2.0/.
+ *
+ */
+
+#include <algorithm>
+#include <limits>
+#include "point_query_hierarchy.hpp"
+#include "contour_curve_util.hpp"
+
+//////////////////////////////////////////////////
+// astral::detail::PointQueryHierarchy::Element methods
+astral::detail::PointQueryHierarchy::Element::
+Element(int contour, const ContourCurve &curve,
+        int source_curve, range_type<float> source_range):
+  m_curve(curve),
+  m_bb(curve.control_point_bounding_box()),
+  m_contour(contour),
+  m_source_curve(source_curve),
+  m_source_range(source_range)
+{
+  ASTRALassert(curve.type() != ContourCurve::cubic_bezier);
+  ASTRALassert(source_curve >= 0);
+}
+
+astral::detail::PointQueryHierarchy::Element::
+Element(int contour, const vec2 &start, const vec2 &end):
+  /* the continuation type does not matter for the computation,
+   * but the ctor needs a continuation type value.
+   */
+  m_curve(start, end, ContourCurve::not_continuation_curve),
+  m_contour(contour),
+  m_source_curve(-1),
+  m_source_range(0.0f, 1.0f)
+{
+  m_bb.union_point(start);
+  m_bb.union_point(end);
+}
+
+//////////////////////////////////////////////////
+// astral::detail::PointQueryHierarchy methods
+astral::detail::PointQueryHierarchy::
+PointQueryHierarchy(float tol, float error, std::vector<Element> &elements):
+  m_tolerance(tol),
+  m_error(error)
+{
+  m_elements.swap(elements);
+  if (!m_elements.empty())
+    {
+      /* a binary tree with leaves of atleast half of
+       * max_elements_per_leaf has fewer than this many
+       * nodes
+       */
+      m_nodes.reserve(4u * m_elements.size() / max_elements_per_leaf + 1u);
+      m_nodes.push_back(Node());
+      build(0u, 0u, m_elements.size());
+    }
+}
+
+void
+astral::detail::PointQueryHierarchy::
+build(unsigned int node, unsigned int begin, unsigned int end)
+{
+  BoundingBox<float> bb, center_bb;
+
+  ASTRALassert(begin < end);
+  for (unsigned int i = begin; i < end; ++i)
+    {
+      const BoundingBox<float> &e(m_elements[i].m_bb);
+
+      bb.union_box(e);
+      center_bb.union_point(0.5f * (e.min_point() + e.max_point()));
+    }
+
+  m_nodes[node].m_bb = bb;
+  m_nodes[node].m_elements = range_type<unsigned int>(begin, end);
+  m_nodes[node].m_children = 0u;
+
+  if (end - begin <= max_elements_per_leaf)
+    {
+      return;
+    }
+
+  /* split at the median of the centers along the
+   * axis where the centers are most spread out
+   */
+  unsigned int mid, children, coordinate;
+  vec2 sz(center_bb.size());
+
+  coordinate = (sz.x() >= sz.y()) ? 0u : 1u;
+  mid = begin + (end - begin) / 2u;
+  std::nth_element(m_elements.begin() + begin,
+                   m_elements.begin() + mid,
+                   m_elements.begin() + end,
+                   [coordinate](const Element &lhs, const Element &rhs)
+                   {
+                     return lhs.m_bb.min_point()[coordinate] + lhs.m_bb.max_point()[coordinate]
+                       < rhs.m_bb.min_point()[coordinate] + rhs.m_bb.max_point()[coordinate];
+                   });
+
+  children = m_nodes.size();
+  m_nodes[node].m_children = children;
+  m_nodes.push_back(Node());
+  m_nodes.push_back(Node());
+
+  build(children, begin, mid);
+  build(children + 1u, mid, end);
+}
+
+astral::Path::PointQueryResult
+astral::detail::PointQueryHierarchy::
+query(const vec2 &pt, float distance_cull) const
+{
+  Path::PointQueryResult R;
+  vecN<unsigned int, max_depth> stack;
+  unsigned int stack_size(0u);
+  float best;
+
+  if (m_nodes.empty())
+    {
+      return R;
+    }
+
+  best = (distance_cull >= 0.0f) ?
+    distance_cull :
+    std::numeric_limits<float>::max();
+
+  stack[stack_size++] = 0u;
+  while (stack_size > 0u)
+    {
+      const Node &node(m_nodes[stack[--stack_size]]);
+
+      if (!winding_relevant(node.m_bb, pt) && distance_lower_bound(node.m_bb, pt) >= best)
+        {
+          continue;
+        }
+
+      if (node.m_children != 0u)
+        {
+          unsigned int near_child(node.m_children), far_child(node.m_children + 1u);
+
+          /* visit the nearer child first so that best
+           * shrinks as quickly as possible
+           */
+          if (distance_lower_bound(m_nodes[far_child].m_bb, pt) < distance_lower_bound(m_nodes[near_child].m_bb, pt))
+            {
+              std::swap(near_child, far_child);
+            }
+
+          ASTRALassert(stack_size + 2u <= max_depth);
+          stack[stack_size++] = far_child;
+          stack[stack_size++] = near_child;
+          continue;
+        }
+
+      for (unsigned int i = node.m_elements.m_begin; i < node.m_elements.m_end; ++i)
+        {
+          const Element &e(m_elements[i]);
+          bool w(winding_relevant(e.m_bb, pt));
+          float d, t;
+
+          if (e.m_source_curve < 0)
+            {
+              if (w)
+                {
+                  /* we do not care about the distance, only the impact on winding */
+                  d = compute_l1_distace_to_curve(pt, e.m_curve, &R.m_winding_impact, nullptr);
+                  ASTRALunused(d);
+                }
+              continue;
+            }
+
+          if (!w && distance_lower_bound(e.m_bb, pt) >= best)
+            {
+              continue;
+            }
+
+          d = compute_l1_distace_to_curve(pt, e.m_curve, &R.m_winding_impact, &t);
+          if (d < best)
+            {
+              best = d;
+              R.m_distance = d;
+              R.m_closest_contour = e.m_contour;
+              R.m_closest_curve = e.m_source_curve;
+              R.m_closest_point_t = e.m_source_range.m_begin + t * (e.m_source_range.m_end - e.m_source_range.m_begin);
+            }
+        }
+    }
+
+  return R;
+}
+
+int
+astral::detail::PointQueryHierarchy::
+winding_number(const vec2 &pt) const
+{
+  vecN<unsigned int, max_depth> stack;
+  unsigned int stack_size(0u);
+  int return_value(0);
+
+  if (m_nodes.empty())
+    {
+      return return_value;
+    }
+
+  stack[stack_size++] = 0u;
+  while (stack_size > 0u)
+    {
+      const Node &node(m_nodes[stack[--stack_size]]);
+
+      if (!winding_relevant(node.m_bb, pt))
+        {
+          continue;
+        }
+
+      if (node.m_children != 0u)
+        {
+          ASTRALassert(stack_size + 2u <= max_depth);
+          stack[stack_size++] = node.m_children;
+          stack[stack_size++] = node.m_children + 1u;
+          continue;
+        }
+
+      for (unsigned int i = node.m_elements.m_begin; i < node.m_elements.m_end; ++i)
+        {
+          const Element &e(m_elements[i]);
+
+          if (winding_relevant(e.m_bb, pt))
+            {
+              float ignored;
+
+              ignored = compute_l1_distace_to_curve(pt, e.m_curve, &return_value, nullptr);
+              ASTRALunused(ignored);
+            }
+        }
+    }
+
+  return return_value;
+}
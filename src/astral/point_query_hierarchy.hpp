@@ -0,0 +1,207 @@
+/*!
+ * \file point_query_hierarchy.hpp
+ * \brief file point_query_hierarchy.hpp
+ *
+ * Copyright 2019 by InvisionApp.
+ *
+ * Contact: kevinrogovin@invisionapp.com
+ *
+ * This Source Code Form is subject to the
+ * terms of the Mozilla Public License, v. 2.0.
+ * If a copy of the MPL was not distributed with
+ * this file, You can obtain one at
+ * http://mozilla.org/MPL/2.0/.
+ *
+ */
+
+#ifndef ASTRAL_POINT_QUERY_HIERARCHY_HPP
+#define ASTRAL_POINT_QUERY_HIERARCHY_HPP
+
+#include <vector>
+#include <astral/util/vecN.hpp>
+#include <astral/util/c_array.hpp>
+#include <astral/util/bounding_box.hpp>
+#include <astral/util/reference_counted.hpp>
+#include <astral/path.hpp>
+
+namespace astral
+{
+  namespace detail
+  {
+    /*!
+     * A PointQueryHierarchy is a bounding volume hierarchy over
+     * the curves of the approximations of all the contours of
+     * an astral::Path that are used for point queries, i.e.
+     * Path::distance_to_path() and Path::winding_number().
+     *
+     * Both queries use compute_l1_distace_to_curve(). The winding
+     * impact of a curve at a point p is from the crossings of the
+     * ray from p in the +y direction. Going through the root
+     * conditions of that computation, a curve can only have
+     * non-zero impact if min_x <= p.x() < max_x and p.y() <= max_y
+     * where min_x, max_x, max_y are from the bounding box of the
+     * start, control and end points of the curve. In addition,
+     * the L1-distance from p to the bounding box of the curve is
+     * a lower bound for the distance computed to the curve. These
+     * two observations are what allow for pruning the traversal.
+     */
+    class PointQueryHierarchy:public reference_counted<PointQueryHierarchy>::non_concurrent
+    {
+    public:
+      /*!
+       * An element is a single curve of the approximation
+       * of a contour.
+       */
+      class Element
+      {
+      public:
+        /*!
+         * Ctor for a curve of an approximation
+         * \param contour which contour of the astral::Path
+         * \param curve the approximating curve
+         * \param source_curve index of the curve of the contour
+         *                     that curve approximates
+         * \param source_range the range of the source curve
+         *                     that curve approximates
+         */
+        Element(int contour, const ContourCurve &curve,
+                int source_curve, range_type<float> source_range);
+
+        /*!
+         * Ctor for the implicit closing line segment of an
+         * open contour, such elements only contribute to the
+         * winding number.
+         */
+        Element(int contour, const vec2 &start, const vec2 &end);
+
+        /*!
+         * The curve, never a cubic
+         */
+        ContourCurve m_curve;
+
+        /*!
+         * Bounding box of the start, control and end
+         * points of \ref m_curve
+         */
+        BoundingBox<float> m_bb;
+
+        /*!
+         * Which contour of the astral::Path
+         */
+        int m_contour;
+
+        /*!
+         * Index into ContourData::curves() of the curve that
+         * \ref m_curve approximates; a negative value indicates
+         * that the element is the closing edge of an open contour
+         */
+        int m_source_curve;
+
+        /*!
+         * Range of the curve named by \ref m_source_curve that
+         * \ref m_curve approximates
+         */
+        range_type<float> m_source_range;
+      };
+
+      /*!
+       * Ctor.
+       * \param tol the tolerance passed to generate the approximations
+       * \param error the maximum of the errors of the approximations
+       * \param elements elements of the hierarchy; the contents are
+       *                 swapped into the created object
+       */
+      PointQueryHierarchy(float tol, float error, std::vector<Element> &elements);
+
+      /*!
+       * Returns the tolerance passed to the ctor.
+       */
+      float
+      tolerance(void) const
+      {
+        return m_tolerance;
+      }
+
+      /*!
+       * Returns the error passed to the ctor.
+       */
+      float
+      error(void) const
+      {
+        return m_error;
+      }
+
+      /*!
+       * Compute the closest curve and the winding number at a point.
+       * \param pt query point
+       * \param distance_cull if non-negative, curves whose distance
+       *                      is atleast this value are not considered
+       *                      for the closest curve
+       */
+      Path::PointQueryResult
+      query(const vec2 &pt, float distance_cull) const;
+
+      /*!
+       * Compute only the winding number at a point.
+       */
+      int
+      winding_number(const vec2 &pt) const;
+
+    private:
+      enum
+        {
+          max_elements_per_leaf = 4,
+
+          /* the builder splits at the median, so the depth is
+           * bounded by the log2 of the number of elements
+           */
+          max_depth = 64,
+        };
+
+      class Node
+      {
+      public:
+        BoundingBox<float> m_bb;
+
+        /* range into m_elements */
+        range_type<unsigned int> m_elements;
+
+        /* index of the first child, the second child is the
+         * one immediately after it; a value of 0 indicates
+         * that the node is a leaf
+         */
+        unsigned int m_children;
+      };
+
+      static
+      bool
+      winding_relevant(const BoundingBox<float> &bb, const vec2 &pt)
+      {
+        return bb.min_point().x() <= pt.x()
+          && pt.x() < bb.max_point().x()
+          && pt.y() <= bb.max_point().y();
+      }
+
+      static
+      float
+      distance_lower_bound(const BoundingBox<float> &bb, const vec2 &pt)
+      {
+        float dx, dy;
+
+        dx = t_max(0.0f, t_max(bb.min_point().x() - pt.x(), pt.x() - bb.max_point().x()));
+        dy = t_max(0.0f, t_max(bb.min_point().y() - pt.y(), pt.y() - bb.max_point().y()));
+
+        return dx + dy;
+      }
+
+      void
+      build(unsigned int node, unsigned int begin, unsigned int end);
+
+      float m_tolerance, m_error;
+      std::vector<Element> m_elements;
+      std::vector<Node> m_nodes;
+    };
+  }
+}
+
+#endif
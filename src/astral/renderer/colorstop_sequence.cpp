@@ -103,7 +103,9 @@ astral::ColorStopSequenceAtlas::
 ColorStopSequenceAtlas(const reference_counted_ptr<ColorStopSequenceAtlasBacking> &backing):
   m_backing(backing),
   m_interval_allocator(backing->layer_dimensions(), backing->number_layers()),
-  m_lock_resources(0)
+  m_lock_resources(0),
+  m_total_sequences_deduplicated(0u),
+  m_total_bytes_deduplicated(0u)
 {
   m_pool = ASTRALnew MemoryPool();
 }
@@ -150,6 +152,48 @@ create(c_array<const ColorStop<vec4>> colorstops, enum colorspace_t colorspace,
       opaque = opaque && v.m_color.w() >= 1.0f;
     }
 
+  reference_counted_ptr<ColorStopSequence> return_value;
+  std::unordered_map<uint64_t, HashEntry>::iterator iter;
+  uint64_t key;
+
+  if (sorted.size() <= ColorStopSequence::max_analytic_colorstops)
+    {
+      /* few enough color stops that the shader interpolates
+       * them directly, so there are no texels to generate
+       * or to store in the atlas.
+       */
+      key = compute_key(sorted, colorspace, opaque);
+      iter = m_hash_table.find(key);
+      if (iter != m_hash_table.end()
+          && iter->second.m_sequence->m_colorspace == colorspace
+          && iter->second.m_sequence->m_opaque == opaque
+          && iter->second.m_sequence->analytic_colorstops().size() == sorted.size()
+          && std::equal(sorted.begin(), sorted.end(),
+                        iter->second.m_sequence->analytic_colorstops().begin(),
+                        [](const ColorStop<vec4> &a, const ColorStop<vec4> &b)
+                        {
+                          return a.m_t == b.m_t && a.m_color == b.m_color;
+                        }))
+        {
+          ASTRALassert(iter->second.m_sequence->m_atlas == this);
+
+          ++m_total_sequences_deduplicated;
+          return iter->second.m_sequence;
+        }
+
+      return_value = m_pool->create();
+      return_value->m_atlas = this;
+      return_value->m_interval = nullptr;
+      return_value->m_opaque = opaque;
+      return_value->m_colorspace = colorspace;
+      return_value->m_number_analytic_colorstops = sorted.size();
+      std::copy(sorted.begin(), sorted.end(), return_value->m_analytic_colorstops.begin());
+      return_value->m_key = key;
+      return_value->m_in_hash_table = add_to_hash_table(key, return_value.get(), c_array<const u8vec4>());
+
+      return return_value;
+    }
+
   if (colorstops.size() >= 2)
     {
       /* num_texels finer than the layer dimensions or our
@@ -234,17 +278,100 @@ create(c_array<const ColorStop<vec4>> colorstops, enum colorspace_t colorspace,
       colors[0] = colors[1] = uint8_from_normalized(sorted.front().m_color);
     }
 
-  reference_counted_ptr<ColorStopSequence> return_value;
+  key = compute_key(colors, colorspace, opaque);
+  iter = m_hash_table.find(key);
+  if (iter != m_hash_table.end()
+      && iter->second.m_sequence->m_colorspace == colorspace
+      && iter->second.m_sequence->m_opaque == opaque
+      && iter->second.m_texels.size() == colors.size()
+      && std::equal(colors.begin(), colors.end(), iter->second.m_texels.begin()))
+    {
+      ASTRALassert(iter->second.m_sequence->m_atlas == this);
+      ASTRALassert(iter->second.m_sequence->m_interval->range().difference() == static_cast<int>(colors.size()));
+
+      ++m_total_sequences_deduplicated;
+      m_total_bytes_deduplicated += sizeof(u8vec4) * colors.size();
+      return iter->second.m_sequence;
+    }
 
   return_value = m_pool->create();
   return_value->m_atlas = this;
   return_value->m_interval = allocate_region(colors);
   return_value->m_opaque = opaque;
   return_value->m_colorspace = colorspace;
+  return_value->m_number_analytic_colorstops = 0u;
+  return_value->m_key = key;
+  return_value->m_in_hash_table = add_to_hash_table(key, return_value.get(), colors);
 
   return return_value;
 }
 
+bool
+astral::ColorStopSequenceAtlas::
+add_to_hash_table(uint64_t key, ColorStopSequence *sequence, c_array<const u8vec4> texels)
+{
+  std::pair<std::unordered_map<uint64_t, HashEntry>::iterator, bool> R;
+
+  /* if a different sequence has the same key, the new sequence
+   * is not added and is never returned by a later create()
+   */
+  R = m_hash_table.insert(std::make_pair(key, HashEntry()));
+  if (R.second)
+    {
+      R.first->second.m_sequence = sequence;
+      R.first->second.m_texels.assign(texels.begin(), texels.end());
+    }
+
+  return R.second;
+}
+
+uint64_t
+astral::ColorStopSequenceAtlas::
+compute_key(c_array<const ColorStop<vec4>> colorstops, enum colorspace_t colorspace, bool opaque)
+{
+  /* same hash as for texels, but started with a value that a
+   * texel count never is so that an analytic sequence does
+   * not share a key with a sequence backed by texels.
+   */
+  Hash64 h;
+
+  h.mix(~0u);
+  h.mix(colorspace);
+  h.mix(opaque);
+  h.mix(colorstops.size());
+  for (const ColorStop<vec4> &c : colorstops)
+    {
+      generic_data t;
+
+      t.f = c.m_t;
+      h.mix(t.u);
+      for (unsigned int i = 0; i < 4; ++i)
+        {
+          t.f = c.m_color[i];
+          h.mix(t.u);
+        }
+    }
+
+  return h.value();
+}
+
+uint64_t
+astral::ColorStopSequenceAtlas::
+compute_key(c_array<const u8vec4> colors, enum colorspace_t colorspace, bool opaque)
+{
+  Hash64 h;
+
+  h.mix(colorspace);
+  h.mix(opaque);
+  h.mix(colors.size());
+  for (const u8vec4 &t : colors)
+    {
+      h.mix(pack_u8vec4(t));
+    }
+
+  return h.value();
+}
+
 void
 astral::ColorStopSequenceAtlas::
 lock_resources(void)
@@ -323,6 +450,15 @@ delete_object(ColorStopSequence *p)
   reference_counted_ptr<ColorStopSequenceAtlas> atlas;
 
   atlas.swap(p->m_atlas);
-  atlas->deallocate_region(p->m_interval);
+  if (p->m_in_hash_table)
+    {
+      ASTRALassert(atlas->m_hash_table.find(p->m_key) != atlas->m_hash_table.end());
+      ASTRALassert(atlas->m_hash_table.find(p->m_key)->second.m_sequence == p);
+      atlas->m_hash_table.erase(p->m_key);
+    }
+  if (p->m_interval)
+    {
+      atlas->deallocate_region(p->m_interval);
+    }
   atlas->m_pool->reclaim(p);
 }
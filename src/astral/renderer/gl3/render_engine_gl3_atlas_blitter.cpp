@@ -188,6 +188,64 @@ clear_pixels_end(void)
   astral_glFramebufferTextureLayer(ASTRAL_GL_DRAW_FRAMEBUFFER, ASTRAL_GL_COLOR_ATTACHMENT0, 0, 0, 0);
 }
 
+void
+astral::gl::RenderEngineGL3::Implement::AtlasBlitter::
+copy_texels(Texture src, ivec2 src_min_corner,
+            Texture dst, ivec2 dst_min_corner, ivec2 size)
+{
+  ASTRALassert(src.m_texture != 0);
+  ASTRALassert(dst.m_texture != 0);
+  ASTRALassert(src.m_texture != dst.m_texture
+               || src.m_layer != dst.m_layer
+               || src.m_lod != dst.m_lod);
+
+  if (size.x() <= 0 || size.y() <= 0)
+    {
+      return;
+    }
+
+  /* The read framebuffer is only attached to the source layer,
+   * so copying from one layer of a texture array to another layer
+   * of the same texture array is not a feedback loop.
+   */
+  astral_glBindFramebuffer(ASTRAL_GL_READ_FRAMEBUFFER, m_fbo);
+  if (src.m_layer >= 0)
+    {
+      astral_glFramebufferTextureLayer(ASTRAL_GL_READ_FRAMEBUFFER, ASTRAL_GL_COLOR_ATTACHMENT0,
+                                       src.m_texture, src.m_lod, src.m_layer);
+    }
+  else
+    {
+      astral_glFramebufferTexture2D(ASTRAL_GL_READ_FRAMEBUFFER, ASTRAL_GL_COLOR_ATTACHMENT0,
+                                    ASTRAL_GL_TEXTURE_2D, src.m_texture, src.m_lod);
+    }
+  astral_glReadBuffer(ASTRAL_GL_COLOR_ATTACHMENT0);
+
+  if (dst.m_layer >= 0)
+    {
+      astral_glBindTexture(ASTRAL_GL_TEXTURE_2D_ARRAY, dst.m_texture);
+      astral_glCopyTexSubImage3D(ASTRAL_GL_TEXTURE_2D_ARRAY, dst.m_lod,
+                                 dst_min_corner.x(), dst_min_corner.y(), dst.m_layer,
+                                 src_min_corner.x(), src_min_corner.y(),
+                                 size.x(), size.y());
+    }
+  else
+    {
+      astral_glBindTexture(ASTRAL_GL_TEXTURE_2D, dst.m_texture);
+      astral_glCopyTexSubImage2D(ASTRAL_GL_TEXTURE_2D, dst.m_lod,
+                                 dst_min_corner.x(), dst_min_corner.y(),
+                                 src_min_corner.x(), src_min_corner.y(),
+                                 size.x(), size.y());
+    }
+
+  /* detach to allow for the texture memory to be released
+   * by the GL driver if the texture is deleted.
+   */
+  astral_glFramebufferTexture2D(ASTRAL_GL_READ_FRAMEBUFFER, ASTRAL_GL_COLOR_ATTACHMENT0, ASTRAL_GL_TEXTURE_2D, 0, 0);
+  astral_glFramebufferTextureLayer(ASTRAL_GL_READ_FRAMEBUFFER, ASTRAL_GL_COLOR_ATTACHMENT0, 0, 0, 0);
+  astral_glBindFramebuffer(ASTRAL_GL_READ_FRAMEBUFFER, 0);
+}
+
 void
 astral::gl::RenderEngineGL3::Implement::AtlasBlitter::
 blit_pixels_implement(enum blitter_fmt_t blit_fmt,
@@ -324,6 +324,22 @@ public:
                       dst, dst_dims, c_array<const BlitRect>(&dst_rect, 1));
   }
 
+  /* Copy texels from one texture to another via glCopyTexSubImage3D
+   * where both the source and destination have the same format and
+   * both are ASTRAL_GL_TEXTURE_2D or ASTRAL_GL_TEXTURE_2D_ARRAY textures.
+   * The source and destination may be the same texture as long as
+   * the source and destination layer or LOD differ. Does NOT restore
+   * GL state on exit.
+   * \param src source texture, layer and LOD of it
+   * \param src_min_corner min-min corner of the texels to copy
+   * \param dst destination texture, layer and LOD of it
+   * \param dst_min_corner min-min corner of where to copy texels
+   * \param size size of the region to copy
+   */
+  void
+  copy_texels(Texture src, ivec2 src_min_corner,
+              Texture dst, ivec2 dst_min_corner, ivec2 size);
+
 private:
   enum blitter_t:uint32_t
     {
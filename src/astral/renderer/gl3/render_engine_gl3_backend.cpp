@@ -52,6 +52,8 @@
  *   B. PackedValue<T> for Brush has a specialization for writing it
  *      to a buffer along with if it will fit because a Brush has as
  *      part of its value a number of RenderValue<S> for several classes S.
+ *      PackedValue<T> for Gradient has a specialization because a
+ *      gradient with analytic color stops occupies two elements.
  *   C. RenderEngineGL3::Implement::Backend::get(RenderValue<T> v) is essentially just
  *      returning a *reference* to m_foo[v.cookie()] where m_foo is the
  *      std::vector<PackedValue<T>> of RenderEngineGL3::Implement::Backend that stores
@@ -316,6 +318,44 @@ pack_data(Backend &backend)
   return m_location;
 }
 
+template<>
+void
+astral::gl::RenderEngineGL3::Implement::Backend::PackedValue<astral::Gradient, astral::gl::RenderEngineGL3::data_gradient>::
+data_freespace_requirement(Backend &backend,
+                           vecN<unsigned int, number_data_types> &out_incr)
+{
+  if (!on_buffer(backend))
+    {
+      /* a gradient with analytic color stops also takes the element after it */
+      out_incr[RenderEngineGL3::data_gradient] += Packing::gradient_element_count(m_value.value());
+    }
+}
+
+template<>
+uint32_t
+astral::gl::RenderEngineGL3::Implement::Backend::PackedValue<astral::Gradient, astral::gl::RenderEngineGL3::data_gradient>::
+pack_data(Backend &backend)
+{
+  if (!on_buffer(backend))
+    {
+      c_array<generic_data> dst;
+      unsigned int count;
+
+      ++backend.m_stats[number_items_bufferX + data_gradient];
+
+      count = Packing::gradient_element_count(m_value.value());
+      dst = backend.m_data_stashes[data_gradient].write_location(count, &m_location);
+      Packing::pack(dst, m_value.value());
+      m_item_stash = backend.m_current_item_stash;
+    }
+  else
+    {
+      ++backend.m_stats[number_reuses_bufferX + data_gradient];
+    }
+
+  return m_location;
+}
+
 template<>
 void
 astral::gl::RenderEngineGL3::Implement::Backend::PackedValue<astral::Brush, astral::gl::RenderEngineGL3::data_brush>::
@@ -398,16 +398,78 @@ downsample_pixels(unsigned int dst_lod, uvec3 dst_location, uvec2 dst_size,
   m_post_process_windows[dst_lod][dst_location.z()].push_back(AtlasBlitter::PostProcessWindow());
 }
 
+void
+astral::gl::RenderEngineGL3::Implement::ImageBacking::
+copy_texels(unsigned int lod, uvec3 dst_location, uvec2 size, uvec3 src_location)
+{
+  AtlasBlitter::Texture src_texture, dst_texture;
+
+  if (lod >= m_number_lod)
+    {
+      return;
+    }
+
+  ASTRALassert(src_location.z() < m_number_layers);
+  ASTRALassert(dst_location.z() < m_number_layers);
+
+  /* the copy must see all the uploads and copies issued before it */
+  flush();
+
+  src_texture
+    .texture(m_texture)
+    .layer(src_location.z())
+    .lod(lod);
+
+  dst_texture
+    .texture(m_texture)
+    .layer(dst_location.z())
+    .lod(lod);
+
+  if (src_location.z() == dst_location.z())
+    {
+      AtlasBlitter::Texture staging_texture;
+
+      /* reading and writing the same layer is a feedback loop,
+       * so first copy the texels to the staging texture which
+       * is idle after the flush() above.
+       */
+      ASTRALassert(size.x() <= (m_staging_width_height >> lod));
+      ASTRALassert(size.y() <= (m_staging_width_height >> lod));
+
+      staging_texture
+        .texture(m_staging_texture)
+        .layer(-1)
+        .lod(lod);
+
+      m_blitter->copy_texels(src_texture, ivec2(src_location.x(), src_location.y()),
+                             staging_texture, ivec2(0, 0), ivec2(size));
+      src_texture = staging_texture;
+      src_location = uvec3(0, 0, 0);
+    }
+
+  m_blitter->copy_texels(src_texture, ivec2(src_location.x(), src_location.y()),
+                         dst_texture, ivec2(dst_location.x(), dst_location.y()),
+                         ivec2(size));
+}
+
 void
 astral::gl::RenderEngineGL3::Implement::ImageBacking::
 on_resize(unsigned int new_size)
 {
   ASTRALassert(can_support_number_layers(m_tp, new_size));
-  if (new_size <= m_number_layers)
+  if (new_size == m_number_layers)
     {
       return;
     }
 
+  if (new_size < m_number_layers)
+    {
+      /* pending uploads to the layers that remain need to
+       * land in the current texture before it is replaced.
+       */
+      flush();
+    }
+
   for (unsigned int lod = 0; lod < m_number_lod; ++lod)
     {
       m_src_rects[lod].resize(new_size);
@@ -417,7 +479,7 @@ on_resize(unsigned int new_size)
     }
 
   astral_GLuint old_texture(m_texture);
-  unsigned int old_size(m_number_layers);
+  unsigned int old_size(t_min(m_number_layers, new_size));
 
   m_number_layers = new_size;
   m_texture = 0u;
@@ -141,6 +141,15 @@ public:
                     enum downsampling_processing_t downsamping_processing,
                     bool permute_src_x_y_coordinates);
 
+  /* Copy texels from one region of the texture to another
+   * region of the texture; the copy is performed immediately
+   * after flushing the pending uploads and copies. If the regions
+   * are on the same layer, the texels are copied through the
+   * staging texture.
+   */
+  void
+  copy_texels(unsigned int lod, uvec3 dst_location, uvec2 size, uvec3 src_location);
+
   /* Resize the underlying GL texture */
   void
   on_resize(unsigned int new_size);
@@ -292,6 +301,13 @@ public:
                     bool permute_src_x_y_coordinates) override;
 
 protected:
+  virtual
+  void
+  copy_texels(unsigned int lod, uvec3 location, uvec2 size, uvec3 src_location) override
+  {
+    m_backing.copy_texels(lod, location, size, src_location);
+  }
+
   virtual
   void
   on_resize(unsigned int new_number_layers) override
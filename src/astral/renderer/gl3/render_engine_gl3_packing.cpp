@@ -246,6 +246,7 @@ emit_unpack_code_texture(ShaderSource &dst)
         }
     }
   emit_unpack_code_framebuffer_pixels(dst, true, offset_names[data_item_transformation]);
+  emit_unpack_code_analytic_gradient_colors(dst, true, offset_names[data_gradient]);
 
   /* we also need to provide the function astral_read_item_dataf()
    * and astral_read_item_datau().
@@ -280,6 +281,7 @@ emit_unpack_code_ubo(ShaderSource &dst)
   emit_unpack_code(dst, false, "astral_ubo_shadow_maps", data_shadow_map);
   emit_unpack_code(dst, false, "astral_ubo_clip_elements", data_clip_mask);
   emit_unpack_code_framebuffer_pixels(dst, false, "astral_ubo_transformations");
+  emit_unpack_code_analytic_gradient_colors(dst, false, "astral_ubo_packed_gradients");
 }
 
 void
@@ -313,6 +315,33 @@ emit_unpack_code_framebuffer_pixels(ShaderSource &dst, bool use_texture, c_strin
   dst.remove_macro("astral_read");
 }
 
+void
+astral::gl::RenderEngineGL3::Implement::Packing::
+emit_unpack_code_analytic_gradient_colors(ShaderSource &dst, bool use_texture, c_string array_src)
+{
+  const enum data_t tp = data_gradient;
+
+  UnpackSourceGenerator unpacker("AstralAnalyticGradientColors", element_size_blocks(tp));
+  unpacker
+    .set_uint(analytic_gradient_colors_packing_offset + 0u, ".m_colors.x")
+    .set_uint(analytic_gradient_colors_packing_offset + 1u, ".m_colors.y")
+    .set_uint(analytic_gradient_colors_packing_offset + 2u, ".m_colors.z");
+
+  std::ostringstream macro;
+  if (use_texture)
+    {
+      macro << "astral_read_from_data_texture(uint(X) + uint(" << array_src << "))";
+    }
+  else
+    {
+      macro << array_src << "[X]";
+    }
+
+  dst.add_macro("astral_read(X)", macro.str().c_str());
+  unpacker.stream_unpack_function(dst, "astral_load", "astral_read");
+  dst.remove_macro("astral_read");
+}
+
 void
 astral::gl::RenderEngineGL3::Implement::Packing::
 emit_unpack_code(ShaderSource &dst, bool use_texture, c_string array_src, enum data_t tp)
@@ -524,11 +553,19 @@ pack(c_array<generic_data> dst, const ClipWindow &value)
   dst[clip_window_y_max_packing_offset].f = value.m_values.m_max_point.y();
 }
 
+unsigned int
+astral::gl::RenderEngineGL3::Implement::Packing::
+gradient_element_count(const Gradient &value)
+{
+  ASTRALassert(value.m_colorstops);
+  return value.m_colorstops->analytic_colorstops().empty() ? 1u : 2u;
+}
+
 void
 astral::gl::RenderEngineGL3::Implement::Packing::
 pack(c_array<generic_data> dst, const Gradient &value)
 {
-  ASTRALassert(dst.size() == element_size(data_gradient));
+  ASTRALassert(dst.size() == gradient_element_count(value) * element_size(data_gradient));
 
   dst[gradient_data_x_packing_offset].f = value.m_data.x();
   dst[gradient_data_y_packing_offset].f = value.m_data.y();
@@ -538,17 +575,51 @@ pack(c_array<generic_data> dst, const Gradient &value)
   dst[gradient_r1_packing_offset].f = value.m_r1;
 
   ASTRALassert(value.m_colorstops);
-  range_type<int> location(value.m_colorstops->location());
-
-  /* pack start and size into dst[6u] */
-  dst[gradient_colorstop_location_packing_offset].u = pack_pair(location.m_begin, location.m_end - location.m_begin);
 
   uint32_t gradient_bits;
+  c_array<const ColorStop<vec4>> analytic(value.m_colorstops->analytic_colorstops());
+
   gradient_bits = pack_bits(gradient_type_bit0, gradient_type_num_bits, value.m_type)
     | pack_bits(gradient_interpolate_tile_mode_bit0, gradient_interpolate_tile_mode_num_bits, value.m_interpolate_tile_mode)
     | pack_bits(gradient_colorspace_bit0, gradient_colorspace_num_bits, value.m_colorstops->colorspace());
 
-  dst[gradient_bits_layer_packing_offset].u = pack_pair(gradient_bits, value.m_colorstops->layer());
+  if (analytic.empty())
+    {
+      range_type<int> location(value.m_colorstops->location());
+
+      /* pack start and size into dst[6u] */
+      dst[gradient_colorstop_location_packing_offset].u = pack_pair(location.m_begin, location.m_end - location.m_begin);
+      dst[gradient_bits_layer_packing_offset].u = pack_pair(gradient_bits, value.m_colorstops->layer());
+    }
+  else
+    {
+      c_array<generic_data> colors(dst.sub_array(element_size(data_gradient)));
+      vecN<uint32_t, 3> t;
+
+      /* the shader always interpolates across three color stops,
+       * so repeat the last color stop to fill out to three.
+       */
+      for (unsigned int i = 0; i < 3u; ++i)
+        {
+          const ColorStop<vec4> &C(analytic[t_min(i, static_cast<unsigned int>(analytic.size() - 1u))]);
+          u8vec4 c(uint8_from_normalized(C.m_color));
+
+          t[i] = static_cast<uint32_t>(C.m_t * 65535.0f + 0.5f);
+          colors[analytic_gradient_colors_packing_offset + i].u = uint32_t(c.x())
+            | (uint32_t(c.y()) << 8u)
+            | (uint32_t(c.z()) << 16u)
+            | (uint32_t(c.w()) << 24u);
+        }
+
+      gradient_bits |= ASTRAL_BIT_MASK(gradient_analytic_bit);
+      dst[gradient_colorstop_location_packing_offset].u = pack_pair(t[0], t[1]);
+      dst[gradient_bits_layer_packing_offset].u = pack_pair(gradient_bits, t[2]);
+
+      for (unsigned int i = analytic_gradient_colors_packing_offset + 3u; i < colors.size(); ++i)
+        {
+          colors[i].u = 0u;
+        }
+    }
 }
 
 void
@@ -38,7 +38,13 @@ public:
 
       gradient_type_bit0 = 0,
       gradient_interpolate_tile_mode_bit0 = gradient_type_bit0 + gradient_type_num_bits,
-      gradient_colorspace_bit0 = gradient_interpolate_tile_mode_bit0 + gradient_interpolate_tile_mode_num_bits
+      gradient_colorspace_bit0 = gradient_interpolate_tile_mode_bit0 + gradient_interpolate_tile_mode_num_bits,
+
+      /*!
+       * If up, the color stops are analytic, see
+       * ColorStopSequence::analytic_colorstops()
+       */
+      gradient_analytic_bit = gradient_colorspace_bit0 + gradient_colorspace_num_bits,
     };
 
   enum invalid_render_index_t:uint32_t
@@ -478,21 +484,55 @@ public:
        * Packing offset at which to pack as a uint16-pair
        * - [0]: ColorStopSequence::location().m_begin
        * - [1]: ColorStopSequence::location().m_end - ColorStopSequence::location().m_begin
+       *
+       * If the color stops are analytic, instead
+       * - [0]: time of the first color stop as normalized uint16
+       * - [1]: time of the second color stop as normalized uint16
        */
       gradient_colorstop_location_packing_offset,
 
       /*!
        * Packing offset at which to pack as a uint16-pair
-       * - [0]: Gradient::m_type, Gradient::m_interpolate_tile_mode and
-       *        ColorStopSequence::colorspace() as according to \ref gradient_bits_t
-       * - [1]: ColorStopSequence::layer()
+       * - [0]: Gradient::m_type, Gradient::m_interpolate_tile_mode,
+       *        ColorStopSequence::colorspace() and if the color stops
+       *        are analytic as according to \ref gradient_bits_t
+       * - [1]: ColorStopSequence::layer(), or if the color stops
+       *        are analytic, the time of the third color stop as
+       *        normalized uint16
        */
       gradient_bits_layer_packing_offset,
     };
 
   /*!
-   * Pack a \ref to a destination buffer. The size of
-   * dst must be the same as element_size(\ref data_gradient).
+   * A gradient whose color stops are analytic occupies two
+   * consecutive elements of \ref data_gradient, the second
+   * element holds the colors of the color stops as packed
+   * below. A gradient that samples the color stop atlas
+   * occupies a single element.
+   */
+  enum analytic_gradient_colors_packing_t:uint32_t
+    {
+      /*!
+       * Packing offset at which to pack the colors of the analytic
+       * color stops, each color is packed as an RGBA8 value. Sequences
+       * with fewer than 3 color stops repeat their last color stop.
+       */
+      analytic_gradient_colors_packing_offset = 0u,
+    };
+
+  /*!
+   * Returns the number of elements of \ref data_gradient
+   * that a gradient occupies, i.e. 2 if its color stops
+   * are analytic and 1 otherwise.
+   */
+  static
+  unsigned int
+  gradient_element_count(const Gradient &value);
+
+  /*!
+   * Pack a \ref to a destination buffer. The size of dst must
+   * be the same as gradient_element_count(value) times
+   * element_size(\ref data_gradient).
    */
   static
   void
@@ -990,6 +1030,10 @@ private:
   void
   emit_unpack_code_framebuffer_pixels(ShaderSource &dst, bool use_texture, c_string array_src);
 
+  static
+  void
+  emit_unpack_code_analytic_gradient_colors(ShaderSource &dst, bool use_texture, c_string array_src);
+
   static
   void
   emit_unpack_code(ShaderSource &dst, bool use_texture, c_string array_src, enum data_t);
@@ -20,6 +20,7 @@
 #include <astral/renderer/shader/fill_stc_shader.hpp>
 #include <astral/renderer/gl3/shader_set_gl3.hpp>
 #include <astral/renderer/stroke_parameters.hpp>
+#include <astral/text/glyph.hpp>
 #include "render_engine_gl3_shader_builder.hpp"
 #include "render_engine_gl3_packing.hpp"
 #include "render_engine_gl3_image.hpp"
@@ -2363,6 +2364,7 @@ create_base_lib(void)
     .add_macro_u32("ASTRAL_GRADIENT_INTERPOLATE_TILE_MODE_NUM_BITS", Packing::gradient_interpolate_tile_mode_num_bits)
     .add_macro_u32("ASTRAL_GRADIENT_COLORSPACE_BIT0", Packing::gradient_colorspace_bit0)
     .add_macro_u32("ASTRAL_GRADIENT_COLORSPACE_NUM_BITS", Packing::gradient_colorspace_num_bits)
+    .add_macro_u32("ASTRAL_GRADIENT_ANALYTIC_MASK", ASTRAL_BIT_MASK(Packing::gradient_analytic_bit))
     .add_macro_u32("ASTRAL_GRADIENT_LINEAR", Gradient::linear)
     .add_macro_u32("ASTRAL_GRADIENT_SWEEP", Gradient::sweep)
     .add_macro_u32("ASTRAL_GRADIENT_RADIAL_UNEXTENDED_OPAQUE", Gradient::radial_unextended_opaque)
@@ -2404,7 +2406,9 @@ create_base_lib(void)
     .add_macro_u32("ASTRAL_CLIP_MASK_FILTER_NUM_BITS", Packing::ProcessedRenderClipElement::filter_num_bits)
     .add_macro_u32("ASTRAL_CLIP_MASK_CLIP_OUT_MASK", 1u << Packing::ProcessedRenderClipElement::clip_out_bit)
     // macros from GlyphShader::flags_t
-    .add_macro_u32("ASTRAL_GLYPH_SHADER_IS_COLORED_GLYPH", GlyphShader::is_colored_glyph);
+    .add_macro_u32("ASTRAL_GLYPH_SHADER_IS_COLORED_GLYPH", GlyphShader::is_colored_glyph)
+    .add_macro_u32("ASTRAL_GLYPH_SHADER_IS_DISTANCE_FIELD_GLYPH", GlyphShader::is_distance_field_glyph)
+    .add_macro_u32("ASTRAL_GLYPH_DISTANCE_FIELD_PADDING", Glyph::distance_field_padding);
 
   for (unsigned int bit = 0; bit < 32u; ++bit)
     {
@@ -2869,6 +2873,35 @@ create_rect_shaders(ShaderSet *out_shaders)
 
   out_shaders->m_dynamic_rect_aa_shader = out_shaders->dynamic_rect_shader(all_sides);
   out_shaders->m_dynamic_rect_shader = out_shaders->dynamic_rect_shader(ShaderSet::RectSideAAList());
+
+  ShaderSource::MacroSet blurred_rect_shader_macros;
+  reference_counted_ptr<const ItemShaderBackendGL3> blurred_rect_shader;
+
+  blurred_rect_shader_macros
+    .add_macro_u32("ASTRAL_BLURRED_RECT_RECT_OFFSET", BlurredRoundedRectShader::rect_offset)
+    .add_macro_u32("ASTRAL_BLURRED_RECT_MINY_RADII_OFFSET", BlurredRoundedRectShader::miny_radii_offset)
+    .add_macro_u32("ASTRAL_BLURRED_RECT_MAXY_RADII_OFFSET", BlurredRoundedRectShader::maxy_radii_offset)
+    .add_macro_u32("ASTRAL_BLURRED_RECT_SIGMA_OFFSET", BlurredRoundedRectShader::sigma_offset);
+
+  blurred_rect_shader =
+    ItemShaderBackendGL3::create(m_engine,
+                                 ItemShader::color_item_shader,
+                                 ShaderSource()
+                                 .add_macros(blurred_rect_shader_macros)
+                                 .add_source("astral_blurred_rounded_rect.vert.glsl.resource_string", ShaderSource::from_resource)
+                                 .remove_macros(blurred_rect_shader_macros),
+                                 ShaderSource()
+                                 .add_macros(blurred_rect_shader_macros)
+                                 .add_source("astral_blurred_rounded_rect.frag.glsl.resource_string", ShaderSource::from_resource)
+                                 .remove_macros(blurred_rect_shader_macros),
+                                 ShaderVaryings()
+                                 .add_varying("astral_blurred_rect_x", ShaderVaryings::interpolator_smooth)
+                                 .add_varying("astral_blurred_rect_y", ShaderVaryings::interpolator_smooth),
+                                 1u);
+
+  out_shaders->m_blurred_rounded_rect_shader =
+    ColorItemShader::create(*blurred_rect_shader,
+                            ColorItemShader::Properties().emits_partially_covered_fragments(true));
 }
 
 void
@@ -2998,6 +3031,9 @@ create_material_gl3_shaders(ShaderSetGL3 *out_shaders)
         .add_varying("astral_brush_gradient1_y", ShaderVaryings::interpolator_uint)
         .add_varying("astral_brush_gradient1_z", ShaderVaryings::interpolator_uint)
         .add_varying("astral_brush_gradient1_w", ShaderVaryings::interpolator_uint)
+        .add_varying("astral_brush_gradient2_x", ShaderVaryings::interpolator_uint)
+        .add_varying("astral_brush_gradient2_y", ShaderVaryings::interpolator_uint)
+        .add_varying("astral_brush_gradient2_z", ShaderVaryings::interpolator_uint)
         .add_varying("astral_brush_gradient_transformation_x", ShaderVaryings::interpolator_uint)
         .add_varying("astral_brush_gradient_transformation_y", ShaderVaryings::interpolator_uint)
         .add_varying("astral_brush_gradient_transformation_z", ShaderVaryings::interpolator_uint)
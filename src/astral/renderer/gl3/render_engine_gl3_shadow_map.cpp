@@ -144,7 +144,17 @@ on_resize(unsigned int new_height)
   reference_counted_ptr<RenderTargetGL_Texture> prev_rt;
   astral_GLbitfield blit_mask;
   astral_GLuint prev_texture;
-  ivec2 sz(width(), height());
+  ivec2 sz(width(), t_min(height(), new_height));
+
+  if (new_height == height())
+    {
+      return new_height;
+    }
+
+  /* pending copies need to land in the current texture
+   * before it is replaced
+   */
+  flush_gpu();
 
   prev_rt.swap(m_render_target);
   create_storage(width(), new_height);
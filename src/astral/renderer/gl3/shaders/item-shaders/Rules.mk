@@ -7,6 +7,8 @@ d		:= $(dir)
 ASTRAL_SHADERS += $(call filelist, \
 	astral_rect_shader.vert.glsl.resource_string \
 	astral_rect_shader.frag.glsl.resource_string \
+	astral_blurred_rounded_rect.vert.glsl.resource_string \
+	astral_blurred_rounded_rect.frag.glsl.resource_string \
 	astral_item_path_common.vert.glsl.resource_string \
 	astral_color_item_path.vert.glsl.resource_string \
 	astral_color_item_path.frag.glsl.resource_string \
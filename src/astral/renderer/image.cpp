@@ -15,10 +15,15 @@
  */
 
 #include <cstring>
+#include <algorithm>
+#include <unordered_map>
+#include <mutex>
+#include <condition_variable>
 #include <astral/renderer/image.hpp>
 #include <astral/util/memory_pool.hpp>
 #include <astral/util/object_pool.hpp>
 #include <astral/util/ostream_utility.hpp>
+#include <astral/util/texel_processing.hpp>
 
 /* Image/ImageMipElement Overview
  * ------------------------------
@@ -43,8 +48,36 @@ public:
   class ColorTile;
   class ColorUpload;
   class IndexUpload;
+  class AsyncUploadJob;
   typedef const TileAllocator::Tile IndexTile;
 
+  /* The key of the content of a write to a color tile made of two
+   * independent 64-bit hashes of the same values: m_table_key is
+   * the FNV style astral::Hash64 and is the key of
+   * m_color_tile_hash_table, m_check uses a multiply-rotate round
+   * per value and the MurmurHash3 finalizer. A key hit is only taken
+   * as a content match if both values match, so a false match needs
+   * a 128-bit collision and no copy of the texels needs to be kept
+   * to verify a hit.
+   */
+  class ColorTileKey
+  {
+  public:
+    ColorTileKey(void):
+      m_table_key(0u),
+      m_check(0u)
+    {}
+
+    bool
+    operator==(const ColorTileKey &rhs) const
+    {
+      return m_table_key == rhs.m_table_key
+        && m_check == rhs.m_check;
+    }
+
+    uint64_t m_table_key, m_check;
+  };
+
   class Counts
   {
   public:
@@ -201,6 +234,69 @@ public:
   IndexTile*
   allocate_index_tile(unsigned int log2_width, unsigned int log2_height);
 
+  /* Allocate the region on the color backing for a color tile,
+   * purging purgeable Image objects as needed to respect
+   * m_color_backing_byte_budget or if the allocation fails.
+   */
+  const TileAllocator::Tile*
+  allocate_color_tile_location(unsigned int log2_width, unsigned int log2_height);
+
+  /* bytes of LOD = 0 texels of the color tiles allocated
+   * for images, i.e. without m_reserved_color_bytes
+   */
+  uint64_t
+  color_bytes_allocated(void) const
+  {
+    uint64_t total;
+
+    total = static_cast<uint64_t>(m_color_tile_allocator.space_allocated()) * sizeof(u8vec4);
+    ASTRALassert(total >= m_reserved_color_bytes);
+    return total - m_reserved_color_bytes;
+  }
+
+  /* Purge purgeable images, least recently used first, until
+   * color_bytes_allocated() is no more than target_bytes.
+   * Images whose ImageMipElement objects are shared are skipped
+   * since purging them would not release any texels. Returns
+   * the number of bytes of the color backing released.
+   */
+  uint64_t
+  purge_images(uint64_t target_bytes);
+
+  /* Purge a single image; replaces each of the elements of its
+   * mip-chain with an ImageMipElement whose tiles are all empty.
+   * Returns the number of bytes of the color backing released.
+   */
+  uint64_t
+  purge_image(Image::Implement &image);
+
+  /* Returns true if the image is the only holder of each
+   * of the ImageMipElement objects of its mip-chain.
+   */
+  static
+  bool
+  owns_mip_chain(const Image::Implement &image);
+
+  void
+  remove_from_purgeable_images(Image::Implement &image);
+
+  void
+  remove_from_live_mip_elements(ImageMipElement::Implement &image);
+
+  /* Move up to max_texels texels of color tiles off of the last
+   * layer of the color backing to the layers below it and shrink
+   * the color backing when its last layers become empty. Returns
+   * the number of texels moved.
+   */
+  unsigned int
+  compact_implement(unsigned int max_texels);
+
+  /* Remove the trailing layers of the color backing that
+   * have no color tiles.
+   */
+  void
+  shrink_color_backing(void);
+
   void
   free_image_id(Image *image);
 
@@ -240,6 +336,11 @@ public:
   internal_upload_color_texels(unsigned int lod, uvec3 location, uvec2 size,
                                unsigned int row_width, c_array<const u8vec4> texels);
 
+  /* upload tightly packed texels, the contents of texels are taken */
+  void
+  internal_upload_color_texels(unsigned int lod, uvec3 location, uvec2 size,
+                               std::vector<u8vec4> *texels);
+
   void
   internal_upload_index_texels(uvec3 location, uvec2 size,
                                unsigned int row_width, c_array<const uvec3> texels);
@@ -300,9 +401,47 @@ public:
   void
   upload_index_values_for_single_tile_image(ImageMipElement::Implement &image);
 
+  /* Upload the index texels that reference the color tiles
+   * of the image, i.e. the single index texel if the image
+   * is a single tile or the first level of index tiles.
+   */
+  void
+  upload_index_values_for_color_tiles(ImageMipElement::Implement &image);
+
   void
   on_tile_allocation_failed(ImageMipElement::Implement &image);
 
+  /* Compute the key used for m_color_tile_hash_table for writing
+   * the texels of the region [dst, dst + size) of a color tile
+   * at the named LOD.
+   */
+  static
+  ColorTileKey
+  compute_color_tile_key(const ColorTile &tile, unsigned int lod, uvec2 dst, uvec2 size,
+                         unsigned int row_width, c_array<const u8vec4> texels);
+
+  /* Remove a ColorTile from m_color_tile_hash_table if it is in it */
+  void
+  remove_from_color_tile_hash_table(ColorTile *tile);
+
+  /* Called when a color tile is explicitly shared; such tiles are no
+   * longer deduplicated and writes to them are seen by all sharers.
+   */
+  void
+  disable_color_tile_deduplication(ColorTile *tile);
+
+  /* Queue a copy of the texels of all written LOD's of the tile src
+   * to the tile dst.
+   */
+  void
+  internal_copy_color_tile(ColorTile *src, ColorTile *dst);
+
+  /* Create the Image objects and upload the tiles of the
+   * AsyncUpload objects whose texels have been processed.
+   */
+  void
+  publish_async_uploads(void);
+
   TileAllocator m_color_tile_allocator;
   TileAllocator m_index_tile_allocator;
 
@@ -372,6 +511,91 @@ public:
 
   /* pool to allocate Image objects */
   MemoryPool *m_pool;
+
+  /* budget in bytes for the color tiles, 0 means no budget */
+  uint64_t m_color_backing_byte_budget;
+
+  /* bytes of the color backing taken by the tiles the atlas
+   * itself uses, i.e. m_empty_tile, m_white_tile and
+   * m_failed_tile; these are not counted against the budget
+   */
+  uint64_t m_reserved_color_bytes;
+
+  /* the callback to inform that an image was purged */
+  reference_counted_ptr<PurgeCallback> m_purge_callback;
+
+  /* list of images marked as purgeable, an Image::Implement
+   * stores its index into this array in m_purgeable_index
+   */
+  std::vector<Image*> m_purgeable_images;
+
+  /* work room for purge_images() */
+  std::vector<Image*> m_purge_workroom;
+
+  /* set to true while purge_images() is running */
+  bool m_purging;
+
+  /* number of images purged */
+  unsigned int m_total_images_purged;
+
+  /* list of all live ImageMipElement objects, an ImageMipElement::Implement
+   * stores its index into this array in m_live_index
+   */
+  std::vector<ImageMipElement::Implement*> m_live_mip_elements;
+
+  /* incremented on each call to compact_implement(); used
+   * to detect what ColorTile objects were moved in a pass
+   */
+  uint32_t m_compaction_pass;
+
+  /* index into m_live_mip_elements and into its tiles at which
+   * the next call to compact_implement() resumes its scan
+   */
+  unsigned int m_compaction_cursor, m_compaction_tile_cursor;
+
+  /* work room for compact_implement(), the elements whose
+   * tiles were moved
+   */
+  std::vector<ImageMipElement::Implement*> m_compaction_elements;
+
+  /* number of texels compact_implement() may move at lock_resources() */
+  unsigned int m_compaction_texels_per_frame;
+
+  /* number of texels moved by compact_implement() */
+  uint64_t m_total_color_texels_compacted;
+
+  /* number of layers removed from the color backing by compaction */
+  unsigned int m_total_color_layers_reclaimed;
+
+  /* if true, color tiles are deduplicated by content */
+  bool m_deduplicate_color_tiles;
+
+  /* maps ColorTileKey::m_table_key of the key computed by
+   * compute_color_tile_key() of the LOD = 0 texels of a color
+   * tile to a color tile having that content.
+   */
+  std::unordered_map<uint64_t, ColorTile*> m_color_tile_hash_table;
+
+  /* number of bytes of texel uploads avoided by deduplication */
+  uint64_t m_total_color_bytes_deduplicated;
+
+  /* Protects m_async_thread_pool and m_async_uploads; these are
+   * the only fields accessed from threads other than the thread
+   * using the ImageAtlas.
+   */
+  std::mutex m_async_mutex;
+
+  /* pool that processes the texels of upload_image_async() */
+  reference_counted_ptr<ThreadPool> m_async_thread_pool;
+
+  /* the uploads not yet published, in order of request; this
+   * is the reference that keeps an upload alive while a worker
+   * thread processes it
+   */
+  std::vector<reference_counted_ptr<AsyncUpload::Implement>> m_async_uploads;
+
+  /* work room for publish_async_uploads() */
+  std::vector<reference_counted_ptr<AsyncUpload::Implement>> m_async_publish_workroom;
 };
 
 class astral::ImageMipElement::Implement:public astral::ImageMipElement
@@ -448,6 +672,27 @@ public:
   void
   set_pixels_implement(int lod, ivec2 location, ivec2 size, unsigned int row_width, c_array<const u8vec4> pixels);
 
+  /* Called before writing to the color tile m_tiles[idx] at the named
+   * LOD; if the tile was shared by deduplication and the write cannot
+   * be performed in place, the tile is first replaced by a copy of it.
+   * Returns the color tile to write to or nullptr if the texels are
+   * not to be written.
+   */
+  ColorTile*
+  prepare_color_tile_write(ImageAtlas::Implement &atlas, unsigned int idx,
+                           int lod, bool covers_tile);
+
+  /* Upload texels to the region [dst, dst + size) of the color tile
+   * m_tiles[idx] at the named LOD where dst is relative to the tile;
+   * covers_tile indicates that the write covers all of the texels
+   * of the tile that are within the image at the LOD.
+   */
+  void
+  upload_color_tile_texels(ImageAtlas::Implement &atlas, unsigned int idx,
+                           int lod, uvec2 dst, uvec2 size, unsigned int row_width,
+                           c_array<const u8vec4> pixels, bool covers_tile,
+                           std::vector<u8vec4> *packed_texels = nullptr);
+
   /* If true, then the ColorTile objects are all allocated
    * AND the first index layer is also uploaded.
    */
@@ -511,6 +756,9 @@ public:
 
   /* true if allocation of color or index tiles failed */
   bool m_tile_allocation_failed;
+
+  /* index into ImageAtlas::Implement::m_live_mip_elements */
+  unsigned int m_live_index;
 };
 
 class astral::Image::Implement:public astral::Image
@@ -558,6 +806,146 @@ public:
    * data maintained by Renderer within a begin()/end() pair.
    */
   uint32_t m_offscreen_render_index;
+
+  /* index into ImageAtlas::Implement::m_purgeable_images or
+   * InvalidRenderValue if the image is not purgeable
+   */
+  uint32_t m_purgeable_index;
+
+  /* true if the image was purged by the ImageAtlas */
+  bool m_purged;
+};
+
+class astral::ImageAtlas::AsyncUpload::Implement:public astral::ImageAtlas::AsyncUpload
+{
+public:
+  enum status_t:uint32_t
+    {
+      /* the texels are waiting to be or are being processed */
+      status_queued,
+
+      /* the texels are processed and waiting for ImageAtlas::flush() */
+      status_processed,
+
+      /* the Image is created and its texels uploaded */
+      status_ready,
+    };
+
+  /* The texels for a region of a color tile at a LOD,
+   * tightly packed.
+   */
+  class Block
+  {
+  public:
+    Block(void):
+      m_lod(0u),
+      m_tile_index(0u),
+      m_dst(0u, 0u),
+      m_size(0u, 0u),
+      m_covers_tile(false)
+    {}
+
+    /* LOD of the Image */
+    unsigned int m_lod;
+
+    /* index into ImageMipElement::Implement::m_tiles */
+    unsigned int m_tile_index;
+
+    /* region within the tile */
+    uvec2 m_dst, m_size;
+
+    /* if the region covers the tile */
+    bool m_covers_tile;
+
+    std::vector<u8vec4> m_texels;
+  };
+
+  Implement(uvec2 sz, unsigned int row_width, c_array<const u8vec4> pixels,
+            const AsyncImageParams &params);
+
+  /* performs the colorspace conversion, pre-multiplication
+   * of alpha, mipmap generation and the splitting into tiles;
+   * called from a worker thread.
+   */
+  void
+  process(void);
+
+  /* the notify is within the lock because once the status is
+   * status_processed, the thread using the ImageAtlas may publish
+   * and release the upload as soon as the lock is released
+   */
+  void
+  set_status(enum status_t v)
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_status = v;
+    m_status_changed.notify_all();
+  }
+
+  enum status_t
+  status(void) const
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_status;
+  }
+
+  void
+  wait_processed(void) const
+  {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_status_changed.wait(lock, [this] { return m_status != status_queued; });
+  }
+
+  /* dimensions of LOD = 0 */
+  uvec2 m_size;
+
+  AsyncImageParams m_params;
+
+  /* the texels of LOD = 0 as passed, released by process() */
+  std::vector<u8vec4> m_pixels;
+
+  /* the output of process() */
+  std::vector<Block> m_blocks;
+
+  /* the image, only set and read on the thread using the ImageAtlas */
+  reference_counted_ptr<Image> m_image;
+
+private:
+  /* convert colorspace and pre-multiply alpha of m_pixels */
+  void
+  convert_pixels(void);
+
+  /* split the texels of a LOD into Block values */
+  void
+  add_blocks(unsigned int lod, uvec2 lod_size, c_array<const u8vec4> texels);
+
+  mutable std::mutex m_mutex;
+  mutable std::condition_variable m_status_changed;
+  enum status_t m_status;
+};
+
+/* The job does not own a reference to the upload; the upload is
+ * kept alive by ImageAtlas::Implement::m_async_uploads until it is
+ * processed, so that the last reference to the upload, and thus to
+ * its Image, is never released by a worker thread.
+ */
+class astral::ImageAtlas::Implement::AsyncUploadJob:public astral::ThreadPool::Job
+{
+public:
+  explicit
+  AsyncUploadJob(AsyncUpload::Implement *p):
+    m_upload(p)
+  {}
+
+  virtual
+  void
+  execute(void) override
+  {
+    m_upload->process();
+  }
+
+private:
+  AsyncUpload::Implement *m_upload;
 };
 
 /* A ColorTile can be used multiple times,
@@ -573,19 +961,31 @@ class astral::ImageAtlas::Implement::ColorTile
 {
 public:
   ColorTile(unsigned int log2_width, unsigned int log2_height, Implement &atlas, uvec2 actual_size):
+    m_lods_written(0u),
+    m_lods_hashed(0u),
+    m_hash(ColorTileKey()),
+    m_in_hash_table(false),
+    m_deduplication_disabled(false),
     m_atlas(atlas),
     m_location(nullptr),
     m_size(actual_size),
     m_log2_size(log2_width, log2_height),
-    m_reference_count(1)
+    m_reference_count(1),
+    m_compaction_pass(0u)
   {
   }
 
   ColorTile(const TileAllocator::Tile *L, Implement &atlas, uvec2 actual_size):
+    m_lods_written(0u),
+    m_lods_hashed(0u),
+    m_hash(ColorTileKey()),
+    m_in_hash_table(false),
+    m_deduplication_disabled(false),
     m_atlas(atlas),
     m_location(L),
     m_size(actual_size),
-    m_reference_count(1)
+    m_reference_count(1),
+    m_compaction_pass(0u)
   {
     ASTRALassert(L);
     ASTRALassert(L->location().x() + actual_size.x() <= m_atlas.m_color_tile_allocator.required_backing_size().x());
@@ -656,15 +1056,71 @@ public:
     return m_reference_count;
   }
 
+  uvec2
+  log2_size(void) const
+  {
+    return m_log2_size;
+  }
+
+  /* Change the backing of the tile to L, returning the previous
+   * backing; the caller is responsible for copying the texels
+   * and releasing the returned tile.
+   */
+  const TileAllocator::Tile*
+  move_backing(const TileAllocator::Tile *L, uint32_t compaction_pass)
+  {
+    const TileAllocator::Tile *return_value(m_location);
+
+    ASTRALassert(backing_allocated());
+    ASTRALassert(L && L->log2_size() == m_log2_size);
+
+    m_location = L;
+    m_compaction_pass = compaction_pass;
+
+    return return_value;
+  }
+
+  /* the value of ImageAtlas::Implement::m_compaction_pass
+   * when the tile was last moved.
+   */
+  uint32_t
+  compaction_pass(void) const
+  {
+    return m_compaction_pass;
+  }
+
+  /* Deduplication bookkeeping, maintained by ImageAtlas::Implement
+   * and ImageMipElement::Implement. A tile whose reference count is
+   * more than one and has m_deduplication_disabled as false is shared
+   * because of deduplication and writes to it are copy-on-write.
+   */
+
+  /* bit mask of the LOD's that have been written to */
+  uint32_t m_lods_written;
+
+  /* bit mask of the LOD's for which m_hash is valid */
+  uint32_t m_lods_hashed;
+
+  /* for each LOD, the key computed by compute_color_tile_key()
+   * of the last write to the LOD if it covered the tile
+   */
+  vecN<ColorTileKey, ImageMipElement::maximum_number_of_mipmaps> m_hash;
+
+  /* true if this tile is in ImageAtlas::Implement::m_color_tile_hash_table
+   * with the key m_hash[0].m_table_key
+   */
+  bool m_in_hash_table;
+
+  /* true if the tile has been shared explicitly */
+  bool m_deduplication_disabled;
+
 private:
   void
   allocate_backing_implement(void)
   {
     if (!m_location)
       {
-        m_location = allocate_tile(m_atlas.m_color_backing->max_number_layers(),
-                                   m_atlas.m_color_tile_allocator,
-                                   m_log2_size.x(), m_log2_size.y());
+        m_location = m_atlas.allocate_color_tile_location(m_log2_size.x(), m_log2_size.y());
 
         ASTRALassert(!m_location || m_location->location().x() + m_size.x() <= m_atlas.m_color_tile_allocator.required_backing_size().x());
         ASTRALassert(!m_location || m_location->location().y() + m_size.y() <= m_atlas.m_color_tile_allocator.required_backing_size().y());
@@ -680,6 +1136,7 @@ private:
   const TileAllocator::Tile *m_location;
   uvec2 m_size, m_log2_size;
   unsigned int m_reference_count;
+  uint32_t m_compaction_pass;
 };
 
 /* ImageMipElement has member fields with
@@ -715,6 +1172,9 @@ public:
     return_value->m_tile_allocation_failed = false;
     return_value->m_allocate_color_tile_backings_called = false;
 
+    return_value->m_live_index = atlas->m_live_mip_elements.size();
+    atlas->m_live_mip_elements.push_back(return_value);
+
     return return_value;
   }
 
@@ -783,6 +1243,15 @@ public:
   public:
     CPUUpload(unsigned int lod, uvec3 location, uvec2 size, unsigned int row_width, c_array<const u8vec4> texels);
 
+    /* takes the contents of texels which are tightly packed */
+    CPUUpload(unsigned int lod, uvec3 location, uvec2 size, std::vector<u8vec4> *texels):
+      m_lod(lod),
+      m_location(location),
+      m_size(size)
+    {
+      m_texels.swap(*texels);
+    }
+
     void
     upload_texels(ImageAtlasColorBacking &dst) const
     {
@@ -814,7 +1283,8 @@ public:
       m_permute_src_x_y_coordinates(permute_src_x_y_coordinates),
       m_downsample_pixels(false),
       m_post_process_window(post_process_window),
-      m_blit_processing(blit_processing)
+      m_blit_processing(blit_processing),
+      m_downsamping_processing(downsampling_simple)
     {}
 
     GPUUpload(unsigned int lod, uvec3 location, uvec2 size,
@@ -828,10 +1298,21 @@ public:
       m_src_location(src_location),
       m_permute_src_x_y_coordinates(permute_src_x_y_coordinates),
       m_downsample_pixels(true),
+      m_post_process_window(),
+      m_blit_processing(image_processing_none),
       m_downsamping_processing(downsamping_processing)
     {}
 
-    GPUUpload(void)
+    GPUUpload(void):
+      m_lod(0u),
+      m_location(0u, 0u, 0u),
+      m_size(0u, 0u),
+      m_src_location(0u, 0u),
+      m_permute_src_x_y_coordinates(false),
+      m_downsample_pixels(false),
+      m_post_process_window(),
+      m_blit_processing(image_processing_none),
+      m_downsamping_processing(downsampling_simple)
     {}
 
     void
@@ -855,7 +1336,39 @@ public:
     enum downsampling_processing_t m_downsamping_processing;
   };
 
-  ColorUpload(reference_counted_ptr<const CPUUpload> &c):
+  /* A BackingCopy copies texels from one region of the
+   * color backing to another, see ImageAtlasColorBacking::copy_texels()
+   */
+  class BackingCopy
+  {
+  public:
+    BackingCopy(unsigned int lod, uvec3 location, uvec2 size, uvec3 src_location):
+      m_lod(lod),
+      m_location(location),
+      m_size(size),
+      m_src_location(src_location)
+    {}
+
+    BackingCopy(void):
+      m_lod(0u),
+      m_location(0u, 0u, 0u),
+      m_size(0u, 0u),
+      m_src_location(0u, 0u, 0u)
+    {}
+
+    void
+    upload_texels(ImageAtlasColorBacking &dst) const
+    {
+      dst.copy_texels(m_lod, m_location, m_size, m_src_location);
+    }
+
+    unsigned int m_lod;
+    uvec3 m_location;
+    uvec2 m_size;
+    uvec3 m_src_location;
+  };
+
+  ColorUpload(const reference_counted_ptr<const CPUUpload> &c):
     m_cpu_upload(c)
   {}
 
@@ -863,16 +1376,26 @@ public:
     m_gpu_upload(g)
   {}
 
+  ColorUpload(const BackingCopy &b):
+    m_backing_copy(b)
+  {}
+
   void
   upload_texels(ImageAtlasColorBacking &dst) const;
 
   /* if non-null indicates to upload from CPU */
   reference_counted_ptr<const CPUUpload> m_cpu_upload;
 
-  /* if m_cpu_upload is nullptr, provides the
-   * the GPU upload information
+  /* if m_cpu_upload is nullptr and m_backing_copy
+   * has an empty size, provides the the GPU upload
+   * information
    */
   GPUUpload m_gpu_upload;
+
+  /* if m_backing_copy.m_size is non-zero, indicates
+   * to copy texels within the color backing
+   */
+  BackingCopy m_backing_copy;
 };
 
 class astral::ImageAtlas::Implement::IndexUpload
@@ -906,7 +1429,7 @@ public:
 class astral::ImageMipElement::Implement::SubRange
 {
 public:
-  SubRange(int location, int size, int tile, int lod)
+  SubRange(int location, int size, int tile, int lod, int image_size)
   {
     range_type<int> tile_range;
     range_type<int> intersect_range;
@@ -920,6 +1443,12 @@ public:
     m_upload_size = intersect_range.m_end - intersect_range.m_begin;
     m_upload_dst = intersect_range.m_begin - tile_range.m_begin;
     m_upload_src = intersect_range.m_begin - location;
+
+    /* the write covers the tile if it covers all texels of
+     * the tile that are within the image at the LOD.
+     */
+    m_covers_tile = (intersect_range.m_begin <= t_max(0, tile_range.m_begin)
+                     && intersect_range.m_end >= t_min(image_size >> lod, tile_range.m_end));
   }
 
   /* number of texels to upload */
@@ -930,6 +1459,9 @@ public:
 
   /* min-side in source texels to upload */
   int m_upload_src;
+
+  /* true if the upload covers all the texels of the tile within the image */
+  bool m_covers_tile;
 };
 
 ////////////////////////////////////////////////////////////////////////
@@ -1391,6 +1923,11 @@ copy_pixels(int lod, ivec2 location, ivec2 size,
   Implement *p;
 
   p = static_cast<Implement*>(this);
+
+  /* allocating color tiles can purge images, make sure
+   * this element stays alive for the duration of the call
+   */
+  reference_counted_ptr<const ImageMipElement> keep_alive(this);
   return p->copy_pixels_implement(lod, location, size,
                                   src, src_location,
                                   blit_processing,
@@ -1426,10 +1963,16 @@ copy_pixels_implement(int lod, ivec2 location, ivec2 size,
   /* step 0: special case of a single tile means that data is directly stored */
   if (m_on_single_unpadded_tile)
     {
-      if (!m_tiles.empty()
-          && m_tiles.front() != atlas->m_white_tile
-          && m_tiles.front() != atlas->m_empty_tile
-          && m_tiles.front()->tile() != atlas->m_failed_tile)
+      ColorTile *prev_tile, *tile;
+
+      prev_tile = (m_tiles.empty()) ? nullptr : m_tiles.front();
+      tile = (prev_tile) ? prepare_color_tile_write(*atlas, 0u, lod, false) : nullptr;
+      if (tile != prev_tile && m_allocate_color_tile_backings_called)
+        {
+          atlas->upload_index_values_for_color_tiles(*this);
+        }
+
+      if (tile)
         {
           uvec3 atlas_location;
 
@@ -1450,25 +1993,29 @@ copy_pixels_implement(int lod, ivec2 location, ivec2 size,
 
   /* step 1: find the range of tiles affected */
   unsigned int return_value(0u);
+  bool tiles_replaced(false);
   ivec2 min_tile, max_tile;
   compute_tile_range(lod, location, size, &min_tile, &max_tile);
 
   /* step 2: walk the affected tiles */
   for (int tile_y = min_tile.y(); tile_y <= max_tile.y(); ++tile_y)
     {
-      SubRange Ry(location.y(), size.y(), tile_y, lod);
+      SubRange Ry(location.y(), size.y(), tile_y, lod, m_size.y());
 
       for (int tile_x = min_tile.x(); tile_x <= max_tile.x(); ++tile_x)
         {
-          SubRange Rx(location.x(), size.x(), tile_x, lod);
-          ColorTile *tile(fetch_tile(tile_x, tile_y));
+          SubRange Rx(location.x(), size.x(), tile_x, lod, m_size.x());
+          unsigned int idx(color_tile_index(tile_x, tile_y));
+          ColorTile *prev_tile(m_tiles[idx]), *tile(nullptr);
           uvec3 atlas_location;
 
-          if (tile != atlas->m_white_tile
-              && tile != atlas->m_empty_tile
-              && tile->tile() != atlas->m_failed_tile
-              && Rx.m_upload_size > 0
-              && Ry.m_upload_size > 0)
+          if (Rx.m_upload_size > 0 && Ry.m_upload_size > 0)
+            {
+              tile = prepare_color_tile_write(*atlas, idx, lod, false);
+              tiles_replaced = tiles_replaced || (m_tiles[idx] != prev_tile);
+            }
+
+          if (tile)
             {
               atlas_location = tile->location();
               atlas_location.x() >>= lod;
@@ -1489,6 +2036,11 @@ copy_pixels_implement(int lod, ivec2 location, ivec2 size,
         }
     }
 
+  if (tiles_replaced && m_allocate_color_tile_backings_called)
+    {
+      atlas->upload_index_values_for_color_tiles(*this);
+    }
+
   return return_value;
 }
 
@@ -1502,6 +2054,11 @@ downsample_pixels(int lod, ivec2 location, ivec2 size,
   Implement *p;
 
   p = static_cast<Implement*>(this);
+
+  /* allocating color tiles can purge images, make sure
+   * this element stays alive for the duration of the call
+   */
+  reference_counted_ptr<const ImageMipElement> keep_alive(this);
   return p->downsample_pixels_implement(lod, location, size,
                                         src, src_location,
                                         downsamping_processing,
@@ -1532,10 +2089,16 @@ downsample_pixels_implement(int lod, ivec2 location, ivec2 size,
   /* step 0: special case of a single tile means that data is directly stored */
   if (m_on_single_unpadded_tile)
     {
-      if (!m_tiles.empty()
-          && m_tiles.front() != atlas->m_white_tile
-          && m_tiles.front() != atlas->m_empty_tile
-          && m_tiles.front()->tile() != atlas->m_failed_tile)
+      ColorTile *prev_tile, *tile;
+
+      prev_tile = (m_tiles.empty()) ? nullptr : m_tiles.front();
+      tile = (prev_tile) ? prepare_color_tile_write(*atlas, 0u, lod, false) : nullptr;
+      if (tile != prev_tile && m_allocate_color_tile_backings_called)
+        {
+          atlas->upload_index_values_for_color_tiles(*this);
+        }
+
+      if (tile)
         {
           uvec3 atlas_location;
 
@@ -1556,25 +2119,29 @@ downsample_pixels_implement(int lod, ivec2 location, ivec2 size,
 
   /* step 1: find the range of tiles affected */
   unsigned int return_value(0u);
+  bool tiles_replaced(false);
   ivec2 min_tile, max_tile;
   compute_tile_range(lod, location, size, &min_tile, &max_tile);
 
   /* step 2: walk the affected tiles */
   for (int tile_y = min_tile.y(); tile_y <= max_tile.y(); ++tile_y)
     {
-      SubRange Ry(location.y(), size.y(), tile_y, lod);
+      SubRange Ry(location.y(), size.y(), tile_y, lod, m_size.y());
 
       for (int tile_x = min_tile.x(); tile_x <= max_tile.x(); ++tile_x)
         {
-          SubRange Rx(location.x(), size.x(), tile_x, lod);
-          ColorTile *tile(fetch_tile(tile_x, tile_y));
+          SubRange Rx(location.x(), size.x(), tile_x, lod, m_size.x());
+          unsigned int idx(color_tile_index(tile_x, tile_y));
+          ColorTile *prev_tile(m_tiles[idx]), *tile(nullptr);
           uvec3 atlas_location;
 
-          if (tile != atlas->m_white_tile
-              && tile != atlas->m_empty_tile
-              && tile->tile() != atlas->m_failed_tile
-              && Rx.m_upload_size > 0
-              && Ry.m_upload_size > 0)
+          if (Rx.m_upload_size > 0 && Ry.m_upload_size > 0)
+            {
+              tile = prepare_color_tile_write(*atlas, idx, lod, false);
+              tiles_replaced = tiles_replaced || (m_tiles[idx] != prev_tile);
+            }
+
+          if (tile)
             {
               atlas_location = tile->location();
               atlas_location.x() >>= lod;
@@ -1598,6 +2165,11 @@ downsample_pixels_implement(int lod, ivec2 location, ivec2 size,
         }
     }
 
+  if (tiles_replaced && m_allocate_color_tile_backings_called)
+    {
+      atlas->upload_index_values_for_color_tiles(*this);
+    }
+
   return return_value;
 }
 
@@ -1608,6 +2180,11 @@ set_pixels(int lod, ivec2 location, ivec2 size, unsigned int row_width, c_array<
   Implement *p;
 
   p = static_cast<Implement*>(this);
+
+  /* allocating color tiles can purge images, make sure
+   * this element stays alive for the duration of the call
+   */
+  reference_counted_ptr<const ImageMipElement> keep_alive(this);
   p->set_pixels_implement(lod, location, size, row_width, pixels);
 }
 
@@ -1632,56 +2209,217 @@ set_pixels_implement(int lod, ivec2 location, ivec2 size, unsigned int row_width
   /* step 0: special case of a single tile means that data is directly stored */
   if (m_on_single_unpadded_tile)
     {
-      if (!m_tiles.empty()
-          && m_tiles.front() != atlas->m_white_tile
-          && m_tiles.front() != atlas->m_empty_tile
-          && m_tiles.front()->tile() != atlas->m_failed_tile)
+      if (!m_tiles.empty())
         {
-          uvec3 atlas_location;
+          ColorTile *prev_tile(m_tiles.front());
+          bool covers_tile;
 
+          ASTRALassert(location.x() >= 0);
+          ASTRALassert(location.y() >= 0);
           ASTRALassert(size.x() + location.x() <= static_cast<int>(m_size.x() >> lod));
           ASTRALassert(size.y() + location.y() <= static_cast<int>(m_size.y() >> lod));
-          atlas_location = translate_location(lod, location);
-          atlas->internal_upload_color_texels(lod, atlas_location, uvec2(size), row_width, pixels);
+
+          covers_tile = (location == ivec2(0, 0)
+                         && size.x() == static_cast<int>(m_size.x() >> lod)
+                         && size.y() == static_cast<int>(m_size.y() >> lod));
+
+          upload_color_tile_texels(*atlas, 0u, lod, uvec2(location), uvec2(size),
+                                   row_width, pixels, covers_tile);
+
+          if (m_tiles.front() != prev_tile && m_allocate_color_tile_backings_called)
+            {
+              atlas->upload_index_values_for_color_tiles(*this);
+            }
         }
       return;
     }
 
   /* step 1: find the range of tiles affected */
+  bool tiles_replaced(false);
   ivec2 min_tile, max_tile;
   compute_tile_range(lod, location, size, &min_tile, &max_tile);
 
   /* step 2: walk the affected tiles */
   for (int tile_y = min_tile.y(); tile_y <= max_tile.y(); ++tile_y)
     {
-      SubRange Ry(location.y(), size.y(), tile_y, lod);
+      SubRange Ry(location.y(), size.y(), tile_y, lod, m_size.y());
 
       for (int tile_x = min_tile.x(); tile_x <= max_tile.x(); ++tile_x)
         {
-          SubRange Rx(location.x(), size.x(), tile_x, lod);
-          ColorTile *tile(fetch_tile(tile_x, tile_y));
-          uvec3 atlas_location;
+          SubRange Rx(location.x(), size.x(), tile_x, lod, m_size.x());
+          unsigned int idx(color_tile_index(tile_x, tile_y));
+          ColorTile *prev_tile(m_tiles[idx]);
           int src_offset;
 
-          if (tile != atlas->m_white_tile
-              && tile != atlas->m_empty_tile
-              && tile->tile() != atlas->m_failed_tile
-              && Rx.m_upload_size > 0
-              && Ry.m_upload_size > 0)
+          if (Rx.m_upload_size > 0 && Ry.m_upload_size > 0)
             {
               src_offset = Rx.m_upload_src + row_width * Ry.m_upload_src;
-              atlas_location = tile->location();
-              atlas_location.x() >>= lod;
-              atlas_location.y() >>= lod;
-              atlas_location.x() += Rx.m_upload_dst;
-              atlas_location.y() += Ry.m_upload_dst;
+              upload_color_tile_texels(*atlas, idx, lod,
+                                       uvec2(Rx.m_upload_dst, Ry.m_upload_dst),
+                                       uvec2(Rx.m_upload_size, Ry.m_upload_size),
+                                       row_width, pixels.sub_array(src_offset),
+                                       Rx.m_covers_tile && Ry.m_covers_tile);
+              tiles_replaced = tiles_replaced || (m_tiles[idx] != prev_tile);
+            }
+        }
+    }
+
+  if (tiles_replaced && m_allocate_color_tile_backings_called)
+    {
+      atlas->upload_index_values_for_color_tiles(*this);
+    }
+}
+
+astral::ImageMipElement::Implement::ColorTile*
+astral::ImageMipElement::Implement::
+prepare_color_tile_write(ImageAtlas::Implement &atlas, unsigned int idx,
+                         int lod, bool covers_tile)
+{
+  ColorTile *tile(m_tiles[idx]);
+  uint32_t lod_bit(1u << lod);
+
+  if (tile == atlas.m_white_tile || tile == atlas.m_empty_tile)
+    {
+      return nullptr;
+    }
+
+  /* A tile that is shared because of deduplication can only be written
+   * in place if the write covers the tile at a LOD no user of the tile
+   * has written to yet; otherwise the write would change texels that
+   * the other users see, so this element gets its own copy of the tile.
+   */
+  if (!tile->unique()
+      && !tile->m_deduplication_disabled
+      && (!covers_tile || (tile->m_lods_written & lod_bit) != 0u))
+    {
+      ColorTile *copy;
+
+      if (tile->tile() == atlas.m_failed_tile)
+        {
+          return nullptr;
+        }
+
+      copy = atlas.allocate_color_tile(tile->log2_size().x(), tile->log2_size().y(), tile->size(), true);
+      if (!copy)
+        {
+          return nullptr;
+        }
+
+      atlas.internal_copy_color_tile(tile, copy);
+      m_tiles[idx] = copy;
+      atlas.release_tile(tile);
+      tile = copy;
+    }
+
+  if (tile->tile() == atlas.m_failed_tile)
+    {
+      return nullptr;
+    }
+
+  /* the write invalidates the hash of the LOD */
+  if (lod == 0)
+    {
+      atlas.remove_from_color_tile_hash_table(tile);
+    }
+  tile->m_lods_hashed &= ~lod_bit;
+  tile->m_lods_written |= lod_bit;
+
+  return tile;
+}
+
+void
+astral::ImageMipElement::Implement::
+upload_color_tile_texels(ImageAtlas::Implement &atlas, unsigned int idx,
+                         int lod, uvec2 dst, uvec2 size, unsigned int row_width,
+                         c_array<const u8vec4> pixels, bool covers_tile,
+                         std::vector<u8vec4> *packed_texels)
+{
+  ColorTile *tile(m_tiles[idx]);
+  uint32_t lod_bit(1u << lod);
+  ImageAtlas::Implement::ColorTileKey key;
+  uint64_t num_bytes;
+  bool hashed(false);
+  uvec3 atlas_location;
+
+  if (tile == atlas.m_white_tile || tile == atlas.m_empty_tile)
+    {
+      return;
+    }
+
+  num_bytes = static_cast<uint64_t>(sizeof(u8vec4)) * size.x() * size.y();
+  if (atlas.m_deduplicate_color_tiles && covers_tile && !tile->m_deduplication_disabled)
+    {
+      hashed = true;
+      key = ImageAtlas::Implement::compute_color_tile_key(*tile, lod, dst, size, row_width, pixels);
 
-              atlas->internal_upload_color_texels(lod, atlas_location,
-                                                  uvec2(Rx.m_upload_size, Ry.m_upload_size),
-                                                  row_width, pixels.sub_array(src_offset));
+      if ((tile->m_lods_hashed & lod_bit) != 0u
+          && tile->m_hash[lod] == key)
+        {
+          /* the tile already has these texels at the LOD */
+          atlas.m_total_color_bytes_deduplicated += num_bytes;
+          return;
+        }
+
+      /* only look for a matching tile if the tile has no content
+       * at the other LOD's that would be lost by the switch.
+       */
+      if (lod == 0 && (tile->m_lods_written & ~lod_bit) == 0u)
+        {
+          std::unordered_map<uint64_t, ColorTile*>::iterator iter;
+
+          iter = atlas.m_color_tile_hash_table.find(key.m_table_key);
+          if (iter != atlas.m_color_tile_hash_table.end()
+              && iter->second != tile
+              && iter->second->log2_size() == tile->log2_size()
+              && iter->second->size() == tile->size()
+              && iter->second->m_hash[0] == key)
+            {
+              ColorTile *match(iter->second);
+
+              ASTRALassert(match->backing_allocated());
+              ASTRALassert(!match->m_deduplication_disabled);
+
+              match->acquire();
+              m_tiles[idx] = match;
+              atlas.release_tile(tile);
+              atlas.m_total_color_bytes_deduplicated += num_bytes;
+
+              return;
             }
         }
     }
+
+  tile = prepare_color_tile_write(atlas, idx, lod, covers_tile);
+  if (!tile)
+    {
+      return;
+    }
+
+  atlas_location = tile->location();
+  atlas_location.x() >>= lod;
+  atlas_location.y() >>= lod;
+  atlas_location.x() += dst.x();
+  atlas_location.y() += dst.y();
+  if (packed_texels)
+    {
+      ASTRALassert(row_width == size.x());
+      atlas.internal_upload_color_texels(lod, atlas_location, size, packed_texels);
+    }
+  else
+    {
+      atlas.internal_upload_color_texels(lod, atlas_location, size, row_width, pixels);
+    }
+
+  if (hashed)
+    {
+      tile->m_hash[lod] = key;
+      tile->m_lods_hashed |= lod_bit;
+      if (lod == 0)
+        {
+          ASTRALassert(!tile->m_in_hash_table);
+          tile->m_in_hash_table = atlas.m_color_tile_hash_table.insert(std::make_pair(key.m_table_key, tile)).second;
+        }
+    }
 }
 
 astral::reference_counted_ptr<const astral::ImageMipElement>
@@ -1735,6 +2473,8 @@ delete_object(ImageMipElement *in_image)
         }
     }
 
+  atlas->remove_from_live_mip_elements(*image);
+
   /* clear all vectors */
   image->m_tiles.clear();
   image->m_index_images.clear();
@@ -1848,6 +2588,52 @@ tile_allocation_failed(void) const
   return false;
 }
 
+bool
+astral::Image::
+purgeable(void) const
+{
+  const Implement *p;
+
+  p = static_cast<const Implement*>(this);
+  return p->m_purgeable_index != InvalidRenderValue;
+}
+
+void
+astral::Image::
+purgeable(bool v)
+{
+  Implement *p;
+  ImageAtlas::Implement *atlas;
+
+  p = static_cast<Implement*>(this);
+  atlas = static_cast<ImageAtlas::Implement*>(p->m_atlas.get());
+
+  if (v == purgeable() || (v && p->m_purged))
+    {
+      return;
+    }
+
+  if (v)
+    {
+      p->m_purgeable_index = atlas->m_purgeable_images.size();
+      atlas->m_purgeable_images.push_back(this);
+    }
+  else
+    {
+      atlas->remove_from_purgeable_images(*p);
+    }
+}
+
+bool
+astral::Image::
+purged(void) const
+{
+  const Implement *p;
+
+  p = static_cast<const Implement*>(this);
+  return p->m_purged;
+}
+
 void
 astral::Image::
 delete_object(Image *in_image)
@@ -1859,6 +2645,11 @@ delete_object(Image *in_image)
 
   image->m_atlas = nullptr;
 
+  if (image->m_purgeable_index != InvalidRenderValue)
+    {
+      atlas->remove_from_purgeable_images(*image);
+    }
+
   /* clear the mipmap chain of mip-elements, this typically
    * triggers deletion of ImageMipElement objects.
    */
@@ -1933,6 +2724,39 @@ set_pixels(int lod, ivec2 location, ivec2 size, unsigned int row_width, c_array<
   p->mip_chain(idx).set_pixels(rel_lod, location, size, row_width, pixels);
 }
 
+void
+astral::Image::
+set_pixels_and_mipmaps(unsigned int row_width, c_array<const u8vec4> pixels,
+                       bool gamma_correct)
+{
+  std::vector<u8vec4> texels, next_texels;
+  uvec2 lod_size(size());
+  unsigned int num_lods(number_mipmap_levels());
+
+  ASTRALassert(row_width >= lod_size.x());
+  ASTRALassert(pixels.size() >= row_width * lod_size.y());
+
+  set_pixels(0, ivec2(0, 0), ivec2(lod_size), row_width, pixels);
+  gamma_correct = gamma_correct && colorspace() == colorspace_srgb;
+
+  for (unsigned int lod = 1; lod < num_lods; ++lod)
+    {
+      next_texels.resize((lod_size.x() >> 1u) * (lod_size.y() >> 1u));
+      if (lod == 1u)
+        {
+          lod_size = downsample_texels(lod_size, row_width, pixels, make_c_array(next_texels), gamma_correct);
+        }
+      else
+        {
+          lod_size = downsample_texels(lod_size, lod_size.x(), make_c_array(texels), make_c_array(next_texels), gamma_correct);
+        }
+
+      ASTRALassert(lod_size.x() > 0u && lod_size.y() > 0u);
+      texels.swap(next_texels);
+      set_pixels(lod, ivec2(0, 0), ivec2(lod_size), lod_size.x(), make_c_array(texels));
+    }
+}
+
 unsigned int
 astral::Image::
 copy_pixels(int lod, ivec2 location, ivec2 size,
@@ -2319,6 +3143,10 @@ upload_texels(ImageAtlasColorBacking &dst) const
     {
       m_cpu_upload->upload_texels(dst);
     }
+  else if (m_backing_copy.m_size.x() > 0u && m_backing_copy.m_size.y() > 0u)
+    {
+      m_backing_copy.upload_texels(dst);
+    }
   else
     {
       m_gpu_upload.upload_texels(dst);
@@ -2349,6 +3177,200 @@ IndexUpload(uvec3 location, uvec2 size, unsigned int row_width,
     }
 }
 
+//////////////////////////////////////////////
+// astral::ImageAtlas::AsyncUpload::Implement methods
+astral::ImageAtlas::AsyncUpload::Implement::
+Implement(uvec2 sz, unsigned int row_width, c_array<const u8vec4> pixels,
+          const AsyncImageParams &params):
+  m_size(sz),
+  m_params(params),
+  m_pixels(sz.x() * sz.y()),
+  m_status(status_queued)
+{
+  for (unsigned int y = 0, src_loc = 0u, dst_loc = 0u; y < m_size.y(); ++y, src_loc += row_width, dst_loc += m_size.x())
+    {
+      ASTRALassert(pixels.size() >= src_loc + m_size.x());
+      std::memcpy(&m_pixels[dst_loc], &pixels[src_loc], m_size.x() * sizeof(u8vec4));
+    }
+}
+
+void
+astral::ImageAtlas::AsyncUpload::Implement::
+convert_pixels(void)
+{
+  if (m_params.m_pixel_colorspace == m_params.m_colorspace)
+    {
+      if (m_params.m_premultiply_alpha)
+        {
+          premultiply_alpha_texels(make_c_array(m_pixels));
+        }
+      return;
+    }
+
+  /* the colorspace conversion is on the color
+   * values without alpha pre-multiplied
+   */
+  if (!m_params.m_premultiply_alpha)
+    {
+      for (u8vec4 &texel : m_pixels)
+        {
+          unsigned int a(texel.w());
+
+          if (a != 0u && a != 255u)
+            {
+              for (unsigned int c = 0; c < 3u; ++c)
+                {
+                  texel[c] = t_min(255u, (255u * texel[c] + (a >> 1u)) / a);
+                }
+            }
+        }
+    }
+
+  convert_colorspace_texels(m_params.m_colorspace, m_params.m_pixel_colorspace, make_c_array(m_pixels));
+  premultiply_alpha_texels(make_c_array(m_pixels));
+}
+
+void
+astral::ImageAtlas::AsyncUpload::Implement::
+add_blocks(unsigned int lod, uvec2 lod_size, c_array<const u8vec4> texels)
+{
+  unsigned int element_lod;
+  uvec2 element_size;
+
+  /* Image::mip_chain()[n] holds LOD's 2n and 2n + 1 */
+  ASTRALstatic_assert(ImageMipElement::maximum_number_of_mipmaps == 2u);
+  element_lod = lod & 1u;
+  element_size.x() = m_size.x() >> (lod - element_lod);
+  element_size.y() = m_size.y() >> (lod - element_lod);
+
+  ImageAtlas::Implement::Counts counts(element_size, true);
+  if (counts.m_count == uvec2(1, 1))
+    {
+      /* single unpadded tile, the texels are stored directly */
+      m_blocks.push_back(Block());
+      m_blocks.back().m_lod = lod;
+      m_blocks.back().m_tile_index = 0u;
+      m_blocks.back().m_dst = uvec2(0, 0);
+      m_blocks.back().m_size = lod_size;
+      m_blocks.back().m_covers_tile = true;
+      m_blocks.back().m_texels.assign(texels.begin(), texels.end());
+      return;
+    }
+
+  for (unsigned int tile_y = 0; tile_y < counts.m_count.y(); ++tile_y)
+    {
+      ImageMipElement::Implement::SubRange Ry(0, lod_size.y(), tile_y, element_lod, element_size.y());
+
+      if (Ry.m_upload_size <= 0)
+        {
+          continue;
+        }
+
+      for (unsigned int tile_x = 0; tile_x < counts.m_count.x(); ++tile_x)
+        {
+          ImageMipElement::Implement::SubRange Rx(0, lod_size.x(), tile_x, element_lod, element_size.x());
+          Block *block;
+
+          if (Rx.m_upload_size <= 0)
+            {
+              continue;
+            }
+
+          m_blocks.push_back(Block());
+          block = &m_blocks.back();
+
+          block->m_lod = lod;
+          block->m_tile_index = tile_x + tile_y * counts.m_count.x();
+          block->m_dst = uvec2(Rx.m_upload_dst, Ry.m_upload_dst);
+          block->m_size = uvec2(Rx.m_upload_size, Ry.m_upload_size);
+          block->m_covers_tile = Rx.m_covers_tile && Ry.m_covers_tile;
+          block->m_texels.resize(block->m_size.x() * block->m_size.y());
+
+          for (unsigned int y = 0, dst_loc = 0u; y < block->m_size.y(); ++y, dst_loc += block->m_size.x())
+            {
+              unsigned int src_loc;
+
+              src_loc = Rx.m_upload_src + (Ry.m_upload_src + y) * lod_size.x();
+              std::memcpy(&block->m_texels[dst_loc], &texels[src_loc], block->m_size.x() * sizeof(u8vec4));
+            }
+        }
+    }
+}
+
+void
+astral::ImageAtlas::AsyncUpload::Implement::
+process(void)
+{
+  std::vector<u8vec4> texels, next_texels;
+  uvec2 lod_size(m_size);
+
+  convert_pixels();
+  texels.swap(m_pixels);
+
+  for (unsigned int lod = 0; lod < m_params.m_number_mip_levels; ++lod)
+    {
+      if (lod != 0u)
+        {
+          uvec2 next_size(lod_size.x() >> 1u, lod_size.y() >> 1u);
+
+          ASTRALassert(next_size.x() > 0u && next_size.y() > 0u);
+
+          next_texels.resize(next_size.x() * next_size.y());
+          downsample_texels(lod_size, lod_size.x(), make_c_array(texels), make_c_array(next_texels),
+                            m_params.m_gamma_correct_mipmaps && m_params.m_colorspace == colorspace_srgb);
+
+          texels.swap(next_texels);
+          lod_size = next_size;
+        }
+
+      add_blocks(lod, lod_size, make_c_array(texels));
+    }
+
+  set_status(status_processed);
+}
+
+//////////////////////////////////////////////
+// astral::ImageAtlas::AsyncUpload methods
+bool
+astral::ImageAtlas::AsyncUpload::
+processed(void) const
+{
+  const Implement *p;
+
+  p = static_cast<const Implement*>(this);
+  return p->status() != Implement::status_queued;
+}
+
+bool
+astral::ImageAtlas::AsyncUpload::
+ready(void) const
+{
+  const Implement *p;
+
+  p = static_cast<const Implement*>(this);
+  return p->status() == Implement::status_ready;
+}
+
+void
+astral::ImageAtlas::AsyncUpload::
+wait(void) const
+{
+  const Implement *p;
+
+  p = static_cast<const Implement*>(this);
+  p->wait_processed();
+}
+
+const astral::reference_counted_ptr<astral::Image>&
+astral::ImageAtlas::AsyncUpload::
+image(void) const
+{
+  const Implement *p;
+
+  p = static_cast<const Implement*>(this);
+  return p->m_image;
+}
+
 ///////////////////////////////////////////////////////////////
 // astral::ImageAtlas and astral::ImageAtlas::Implement methods
 astral::reference_counted_ptr<astral::ImageAtlas>
@@ -2372,7 +3394,19 @@ Implement(ImageAtlasColorBacking &color_backing,
   m_resources_unlock_count(0u),
   m_color_backing(&color_backing),
   m_index_backing(&index_backing),
-  m_extra_color_backing_layers(0)
+  m_extra_color_backing_layers(0),
+  m_color_backing_byte_budget(0u),
+  m_reserved_color_bytes(0u),
+  m_purging(false),
+  m_total_images_purged(0u),
+  m_compaction_pass(0u),
+  m_compaction_cursor(0u),
+  m_compaction_tile_cursor(0u),
+  m_compaction_texels_per_frame(0u),
+  m_total_color_texels_compacted(0u),
+  m_total_color_layers_reclaimed(0u),
+  m_deduplicate_color_tiles(false),
+  m_total_color_bytes_deduplicated(0u)
 {
   const unsigned int log2_sz(ImageAtlas::log2_tile_size);
   const unsigned int sz(ImageAtlas::tile_size);
@@ -2392,6 +3426,8 @@ Implement(ImageAtlasColorBacking &color_backing,
   ASTRALassert(m_scratch_index_tile);
   ASTRALassert(m_failed_tile);
 
+  m_reserved_color_bytes = static_cast<uint64_t>(m_color_tile_allocator.space_allocated()) * sizeof(u8vec4);
+
   /* These must be true in order for images that failed allocation
    * to be able to use m_scratch_index_tile to map to m_empty_tile
    */
@@ -2435,6 +3471,13 @@ Implement(ImageAtlasColorBacking &color_backing,
 astral::ImageAtlas::Implement::
 ~Implement()
 {
+  /* the jobs of the uploads not yet processed use them */
+  for (const reference_counted_ptr<AsyncUpload::Implement> &upload : m_async_uploads)
+    {
+      upload->wait_processed();
+    }
+  m_async_uploads.clear();
+
   m_index_tile_allocator.release_tile(m_scratch_index_tile);
   release_tile(m_empty_tile);
   release_tile(m_white_tile);
@@ -2551,6 +3594,19 @@ internal_upload_color_texels(unsigned int lod, uvec3 location, uvec2 size,
   m_color_uploads.push_back(p);
 }
 
+void
+astral::ImageAtlas::Implement::
+internal_upload_color_texels(unsigned int lod, uvec3 location, uvec2 size,
+                             std::vector<u8vec4> *texels)
+{
+  reference_counted_ptr<ColorUpload::CPUUpload> p;
+
+  ASTRALassert(texels && texels->size() == size.x() * size.y());
+
+  p = ASTRALnew ColorUpload::CPUUpload(lod, location, size, texels);
+  m_color_uploads.push_back(reference_counted_ptr<const ColorUpload::CPUUpload>(p));
+}
+
 void
 astral::ImageAtlas::Implement::
 internal_upload_index_texels(uvec3 location, uvec2 size,
@@ -2600,6 +3656,9 @@ void
 astral::ImageAtlas::Implement::
 flush_implement(void)
 {
+  /* publishing async uploads queues color and index uploads */
+  publish_async_uploads();
+
   /* before processing the uploads, first resize the backings
    * as needed;
    */
@@ -2692,6 +3751,8 @@ create_image_implement(detail::RenderedImageTag tag,
   return_value->m_in_use_marker = 0u;
   return_value->m_image_id = allocate_image_id(return_value);
   return_value->m_offscreen_render_index = InvalidRenderValue;
+  return_value->m_purgeable_index = InvalidRenderValue;
+  return_value->m_purged = false;
 
   ASTRALassert(!mip_chain.empty());
   ASTRALassert(return_value->m_mip_chain.empty());
@@ -3082,8 +4143,11 @@ create_shared_common(ImageMipElement *in_return_value,
       return_value->fetch_tile(v.first.x(), v.first.y())
         = src->fetch_tile(v.second.m_tile.x(), v.second.m_tile.y());
 
-      /* aquire the tile */
+      /* aquire the tile; since the tile is now explicitly shared,
+       * writes to it are to be seen by all elements that share it
+       */
       return_value->fetch_tile(v.first.x(), v.first.y())->acquire();
+      disable_color_tile_deduplication(return_value->fetch_tile(v.first.x(), v.first.y()));
 
       return_value->m_element_tiles[ImageMipElement::color_element].push_back(v.first);
     }
@@ -3297,6 +4361,13 @@ allocate_color_tile_backings(ImageMipElement &in_image)
       std::cout << "Allocate " << cnt << "/" << total_cnt << " color tiles\n";
     }
 
+  upload_index_values_for_color_tiles(image);
+}
+
+void
+astral::ImageAtlas::Implement::
+upload_index_values_for_color_tiles(ImageMipElement::Implement &image)
+{
   /* When image.m_index_images is empty, that indicates
    * that the image is a single tile. However, it can
    * still have an index tile if tile_index_atlas_location()
@@ -3450,7 +4521,7 @@ allocate_color_tile(unsigned int log2_width, unsigned int log2_height, uvec2 act
 
   if (allocate_backing)
     {
-      location = allocate_tile(m_color_backing->max_number_layers(), m_color_tile_allocator, log2_width, log2_height);
+      location = allocate_color_tile_location(log2_width, log2_height);
       if (location)
         {
           return m_pool->create_color_tile(location, *this, actual_size);
@@ -3464,12 +4535,426 @@ allocate_color_tile(unsigned int log2_width, unsigned int log2_height, uvec2 act
   return m_pool->create_color_tile(log2_width, log2_height, *this, actual_size);
 }
 
-astral::ImageID
+const astral::TileAllocator::Tile*
 astral::ImageAtlas::Implement::
-allocate_image_id(Image *image)
+allocate_color_tile_location(unsigned int log2_width, unsigned int log2_height)
 {
-  ImageID ID;
-  if (!m_free_ids.empty())
+  const TileAllocator::Tile *return_value;
+  uint64_t needed_bytes;
+
+  needed_bytes = static_cast<uint64_t>(sizeof(u8vec4)) << (log2_width + log2_height);
+  if (m_color_backing_byte_budget > 0u
+      && color_bytes_allocated() + needed_bytes > m_color_backing_byte_budget)
+    {
+      uint64_t target;
+
+      target = (m_color_backing_byte_budget > needed_bytes) ?
+        m_color_backing_byte_budget - needed_bytes :
+        0u;
+
+      purge_images(target);
+    }
+
+  return_value = allocate_tile(m_color_backing->max_number_layers(), m_color_tile_allocator, log2_width, log2_height);
+
+  /* If the allocation failed, purge images to free atleast
+   * as many texels as the tile needs and try again; we need
+   * to loop because the freed tiles might not be usable for
+   * the tile size requested.
+   */
+  while (!return_value)
+    {
+      uint64_t allocated, target;
+
+      allocated = color_bytes_allocated();
+      target = (allocated > needed_bytes) ? allocated - needed_bytes : 0u;
+      if (purge_images(target) == 0u)
+        {
+          /* nothing was released, so retrying can only fail again */
+          break;
+        }
+
+      return_value = allocate_tile(m_color_backing->max_number_layers(), m_color_tile_allocator, log2_width, log2_height);
+    }
+
+  return return_value;
+}
+
+uint64_t
+astral::ImageAtlas::Implement::
+purge_images(uint64_t target_bytes)
+{
+  uint64_t return_value(0u);
+
+  if (m_purging || m_purgeable_images.empty())
+    {
+      return return_value;
+    }
+
+  m_purging = true;
+
+  /* Only images that are not in use can be purged. The value of
+   * Image::Implement::m_in_use_marker is the value of
+   * m_resources_unlock_count + 1 at the last time the image was
+   * marked as in use which gives us exactly the LRU ordering.
+   */
+  ASTRALassert(m_purge_workroom.empty());
+  for (Image *p : m_purgeable_images)
+    {
+      Image::Implement *image(static_cast<Image::Implement*>(p));
+
+      if (!image->in_use()
+          && image->m_offscreen_render_index == InvalidRenderValue
+          && owns_mip_chain(*image))
+        {
+          m_purge_workroom.push_back(image);
+        }
+    }
+
+  std::stable_sort(m_purge_workroom.begin(), m_purge_workroom.end(),
+                   [](const Image *lhs, const Image *rhs)
+                   {
+                     return static_cast<const Image::Implement*>(lhs)->m_in_use_marker
+                       < static_cast<const Image::Implement*>(rhs)->m_in_use_marker;
+                   });
+
+  for (Image *p : m_purge_workroom)
+    {
+      if (color_bytes_allocated() <= target_bytes)
+        {
+          break;
+        }
+
+      return_value += purge_image(*static_cast<Image::Implement*>(p));
+    }
+
+  m_purge_workroom.clear();
+  m_purging = false;
+
+  return return_value;
+}
+
+bool
+astral::ImageAtlas::Implement::
+owns_mip_chain(const Image::Implement &image)
+{
+  for (const reference_counted_ptr<const ImageMipElement> &mip : image.m_mip_chain)
+    {
+      if (mip->reference_count() != 1u)
+        {
+          return false;
+        }
+    }
+  return true;
+}
+
+uint64_t
+astral::ImageAtlas::Implement::
+purge_image(Image::Implement &image)
+{
+  uint64_t bytes_before(color_bytes_allocated()), bytes_released;
+
+  ASTRALassert(!image.in_use());
+  ASTRALassert(!image.m_purged);
+  ASTRALassert(image.m_offscreen_render_index == InvalidRenderValue);
+
+  /* The ImageMipElement objects of the image might be shared with
+   * other images, so we cannot change them; instead we replace them
+   * with ImageMipElement objects that are entirely empty tiles which
+   * releases the reference to the original ImageMipElement objects.
+   */
+  for (reference_counted_ptr<const ImageMipElement> &mip : image.m_mip_chain)
+    {
+      reference_counted_ptr<ImageMipElement> E;
+
+      E = create_mip_element_implement(mip->size(), mip->number_mipmap_levels(),
+                                       c_array<const vecN<range_type<int>, 2>>());
+      allocate_color_tile_backings(*E);
+      mip = E;
+    }
+
+  remove_from_purgeable_images(image);
+  image.m_purged = true;
+  image.m_opaque = false;
+  ++m_total_images_purged;
+
+  /* tiles of the image can still be shared with other
+   * images by deduplication, so only count what the
+   * color backing actually released.
+   */
+  ASTRALassert(color_bytes_allocated() <= bytes_before);
+  bytes_released = bytes_before - color_bytes_allocated();
+
+  if (m_purge_callback)
+    {
+      m_purge_callback->on_purge(image);
+    }
+
+  return bytes_released;
+}
+
+void
+astral::ImageAtlas::Implement::
+remove_from_purgeable_images(Image::Implement &image)
+{
+  uint32_t idx(image.m_purgeable_index);
+
+  ASTRALassert(idx < m_purgeable_images.size());
+  ASTRALassert(m_purgeable_images[idx] == &image);
+
+  m_purgeable_images[idx] = m_purgeable_images.back();
+  static_cast<Image::Implement*>(m_purgeable_images[idx])->m_purgeable_index = idx;
+  m_purgeable_images.pop_back();
+
+  image.m_purgeable_index = InvalidRenderValue;
+}
+
+void
+astral::ImageAtlas::Implement::
+remove_from_live_mip_elements(ImageMipElement::Implement &image)
+{
+  unsigned int idx(image.m_live_index);
+
+  ASTRALassert(idx < m_live_mip_elements.size());
+  ASTRALassert(m_live_mip_elements[idx] == &image);
+
+  m_live_mip_elements[idx] = m_live_mip_elements.back();
+  m_live_mip_elements[idx]->m_live_index = idx;
+  m_live_mip_elements.pop_back();
+}
+
+void
+astral::ImageAtlas::Implement::
+shrink_color_backing(void)
+{
+  unsigned int num_layers, backing_layers;
+
+  /* the layer 0 is never removed because it holds
+   * m_empty_tile, m_white_tile and m_failed_tile
+   */
+  num_layers = m_color_tile_allocator.number_layers();
+  while (num_layers > 1u && m_color_tile_allocator.space_allocated(num_layers - 1u) == 0u)
+    {
+      --num_layers;
+    }
+
+  if (num_layers == m_color_tile_allocator.number_layers())
+    {
+      return;
+    }
+
+  m_total_color_layers_reclaimed += m_color_tile_allocator.number_layers() - num_layers;
+  m_color_tile_allocator.number_layers(num_layers);
+  m_color_tile_allocator.preferred_layer_limit(~0u);
+
+  backing_layers = num_layers + m_extra_color_backing_layers;
+  backing_layers = t_min(backing_layers, m_color_backing->max_number_layers());
+  if (m_color_backing->number_layers() > backing_layers)
+    {
+      m_color_backing->number_layers(backing_layers);
+    }
+}
+
+unsigned int
+astral::ImageAtlas::Implement::
+compact_implement(unsigned int max_texels)
+{
+  unsigned int src_layer, texels_per_layer, space_on_src, space_below;
+  unsigned int texels_moved(0u);
+
+  /* while resources are locked, the locations of the
+   * color tiles may already have been baked into the
+   * data sent to the GPU.
+   */
+  if (m_resources_locked > 0 || max_texels == 0u)
+    {
+      return 0u;
+    }
+
+  /* make sure all uploads and copies to the color tiles have
+   * landed and that all index uploads (which refer to the
+   * current locations of color tiles) are done.
+   */
+  flush_implement();
+  shrink_color_backing();
+
+  if (m_color_tile_allocator.number_layers() <= 1u)
+    {
+      return 0u;
+    }
+
+  src_layer = m_color_tile_allocator.number_layers() - 1u;
+  texels_per_layer = m_color_backing->width_height() * m_color_backing->width_height();
+  space_on_src = m_color_tile_allocator.space_allocated(src_layer);
+  space_below = m_color_tile_allocator.space_allocated() - space_on_src;
+
+  if (space_below + space_on_src > src_layer * texels_per_layer)
+    {
+      /* the content of the last layer cannot fit on the
+       * layers below it, so there is nothing to gain.
+       */
+      m_color_tile_allocator.preferred_layer_limit(~0u);
+      return 0u;
+    }
+
+  /* make new allocations avoid the layer being evacuated */
+  m_color_tile_allocator.preferred_layer_limit(src_layer);
+  ++m_compaction_pass;
+
+  /* The scan resumes where the previous pass stopped and examining
+   * a tile is charged against max_texels as well, so that the cost
+   * of a pass is bounded by max_texels and not by the number of
+   * live tiles.
+   */
+  const unsigned int scan_cost(64u);
+  unsigned int budget_used(0u), elements_scanned(0u);
+  bool moved_shared_tile(false), fragmented(false);
+
+  ASTRALassert(m_compaction_elements.empty());
+  while (!m_live_mip_elements.empty()
+         && elements_scanned <= m_live_mip_elements.size()
+         && budget_used < max_texels && !fragmented)
+    {
+      bool moved_from_element(false);
+      unsigned int t;
+
+      if (m_compaction_cursor >= m_live_mip_elements.size())
+        {
+          /* wrapped or elements were removed since the last pass */
+          m_compaction_cursor = 0u;
+          m_compaction_tile_cursor = 0u;
+        }
+
+      ImageMipElement::Implement &image(*m_live_mip_elements[m_compaction_cursor]);
+      for (t = m_compaction_tile_cursor; t < image.m_tiles.size() && budget_used < max_texels && !fragmented; ++t)
+        {
+          ColorTile *tile(image.m_tiles[t]);
+          const TileAllocator::Tile *dst, *src;
+          uvec3 src_location, dst_location;
+          uvec2 log2_size, size;
+
+          budget_used += scan_cost;
+          if (tile == m_empty_tile
+              || tile == m_white_tile
+              || !tile->backing_allocated()
+              || tile->compaction_pass() == m_compaction_pass
+              || tile->location().z() != src_layer)
+            {
+              continue;
+            }
+
+          log2_size = tile->log2_size();
+          dst = m_color_tile_allocator.allocate_tile(log2_size.x(), log2_size.y());
+          if (!dst || dst->location().z() >= src_layer)
+            {
+              /* fragmentation of the layers below prevents the move */
+              if (dst)
+                {
+                  m_color_tile_allocator.release_tile(dst);
+                }
+              fragmented = true;
+              continue;
+            }
+
+          src_location = tile->location();
+          dst_location = dst->location();
+          size = uvec2(1u << log2_size.x(), 1u << log2_size.y());
+
+          for (unsigned int lod = 0; lod < ImageMipElement::maximum_number_of_mipmaps; ++lod)
+            {
+              uvec3 S(src_location.x() >> lod, src_location.y() >> lod, src_location.z());
+              uvec3 D(dst_location.x() >> lod, dst_location.y() >> lod, dst_location.z());
+              uvec2 sz(size.x() >> lod, size.y() >> lod);
+
+              if (sz.x() > 0u && sz.y() > 0u)
+                {
+                  m_color_backing->copy_texels(lod, D, sz, S);
+                }
+            }
+
+          src = tile->move_backing(dst, m_compaction_pass);
+          m_color_tile_allocator.release_tile(src);
+          texels_moved += size.x() * size.y();
+          budget_used += size.x() * size.y();
+          moved_from_element = true;
+          moved_shared_tile = moved_shared_tile || !tile->unique();
+        }
+
+      if (moved_from_element)
+        {
+          m_compaction_elements.push_back(&image);
+        }
+
+      if (fragmented)
+        {
+          /* resume at the same tile on the next pass */
+          m_compaction_tile_cursor = t - 1u;
+        }
+      else if (t < image.m_tiles.size())
+        {
+          /* out of budget within the element */
+          m_compaction_tile_cursor = t;
+        }
+      else
+        {
+          m_compaction_tile_cursor = 0u;
+          ++m_compaction_cursor;
+          ++elements_scanned;
+        }
+    }
+
+  if (texels_moved == 0u)
+    {
+      m_compaction_elements.clear();
+      return 0u;
+    }
+
+  /* A ColorTile shared by deduplication can be used by several
+   * ImageMipElement objects, so the index texels of every element
+   * that uses a moved shared tile need to be rewritten; that is
+   * the only case where all live elements are walked.
+   */
+  if (moved_shared_tile)
+    {
+      m_compaction_elements.clear();
+      for (ImageMipElement::Implement *image : m_live_mip_elements)
+        {
+          for (ColorTile *tile : image->m_tiles)
+            {
+              if (tile->compaction_pass() == m_compaction_pass)
+                {
+                  m_compaction_elements.push_back(image);
+                  break;
+                }
+            }
+        }
+    }
+
+  for (ImageMipElement::Implement *image : m_compaction_elements)
+    {
+      /* if the backings are not yet allocated, the index
+       * texels will be set when they are
+       */
+      if (image->m_allocate_color_tile_backings_called)
+        {
+          upload_index_values_for_color_tiles(*image);
+        }
+    }
+  m_compaction_elements.clear();
+
+  m_total_color_texels_compacted += texels_moved;
+  flush_implement();
+  shrink_color_backing();
+
+  return texels_moved;
+}
+
+astral::ImageID
+astral::ImageAtlas::Implement::
+allocate_image_id(Image *image)
+{
+  ImageID ID;
+  if (!m_free_ids.empty())
     {
       ID = m_free_ids.back();
       m_free_ids.pop_back();
@@ -3516,6 +5001,7 @@ release_tile(ColorTile *tile)
 {
   if (tile->release())
     {
+      remove_from_color_tile_hash_table(tile);
       if (tile->backing_allocated())
         {
           m_color_tile_allocator.release_tile(tile->tile());
@@ -3531,6 +5017,119 @@ release_tile(IndexTile *tile)
   m_index_tile_allocator.release_tile(tile);
 }
 
+astral::ImageAtlas::Implement::ColorTileKey
+astral::ImageAtlas::Implement::
+compute_color_tile_key(const ColorTile &tile, unsigned int lod, uvec2 dst, uvec2 size,
+                       unsigned int row_width, c_array<const u8vec4> texels)
+{
+  const uint64_t c1(0x87c37b91114253d5u), c2(0x4cf5ad432745937fu);
+  ColorTileKey return_value;
+  Hash64 h;
+  uint64_t check(0x9e3779b97f4a7c15u);
+  const uint32_t header[] =
+    {
+      lod, dst.x(), dst.y(), size.x(), size.y(),
+      tile.size().x(), tile.size().y(),
+      tile.log2_size().x(), tile.log2_size().y()
+    };
+  auto mix = [&](uint32_t v)
+    {
+      uint64_t k(v * c1);
+
+      h.mix(v);
+      k = (k << 31u) | (k >> 33u);
+      check ^= k * c2;
+      check = ((check << 27u) | (check >> 37u)) * 5u + 0x52dce729u;
+    };
+
+  for (uint32_t v : header)
+    {
+      mix(v);
+    }
+
+  for (unsigned int y = 0, src_loc = 0u; y < size.y(); ++y, src_loc += row_width)
+    {
+      ASTRALassert(texels.size() >= src_loc + size.x());
+      for (unsigned int x = 0; x < size.x(); ++x)
+        {
+          mix(pack_u8vec4(texels[src_loc + x]));
+        }
+    }
+
+  /* MurmurHash3 finalizer so that every bit of check
+   * depends on every value mixed
+   */
+  check ^= check >> 33u;
+  check *= 0xff51afd7ed558ccdu;
+  check ^= check >> 33u;
+  check *= 0xc4ceb9fe1a85ec53u;
+  check ^= check >> 33u;
+
+  return_value.m_table_key = h.value();
+  return_value.m_check = check;
+
+  return return_value;
+}
+
+void
+astral::ImageAtlas::Implement::
+remove_from_color_tile_hash_table(ColorTile *tile)
+{
+  std::unordered_map<uint64_t, ColorTile*>::iterator iter;
+
+  if (!tile->m_in_hash_table)
+    {
+      return;
+    }
+
+  iter = m_color_tile_hash_table.find(tile->m_hash[0].m_table_key);
+  ASTRALassert(iter != m_color_tile_hash_table.end());
+  ASTRALassert(iter->second == tile);
+
+  m_color_tile_hash_table.erase(iter);
+  tile->m_in_hash_table = false;
+}
+
+void
+astral::ImageAtlas::Implement::
+disable_color_tile_deduplication(ColorTile *tile)
+{
+  if (tile != m_empty_tile && tile != m_white_tile)
+    {
+      remove_from_color_tile_hash_table(tile);
+      tile->m_lods_hashed = 0u;
+      tile->m_deduplication_disabled = true;
+    }
+}
+
+void
+astral::ImageAtlas::Implement::
+internal_copy_color_tile(ColorTile *src, ColorTile *dst)
+{
+  uvec3 src_location(src->location()), dst_location(dst->location());
+  uvec2 size(1u << src->log2_size().x(), 1u << src->log2_size().y());
+
+  ASTRALassert(src->log2_size() == dst->log2_size());
+  for (unsigned int lod = 0; lod < ImageMipElement::maximum_number_of_mipmaps; ++lod)
+    {
+      if (src->m_lods_written & (1u << lod))
+        {
+          uvec3 S(src_location), D(dst_location);
+          uvec2 sz(t_max(1u, size.x() >> lod), t_max(1u, size.y() >> lod));
+
+          S.x() >>= lod;
+          S.y() >>= lod;
+          D.x() >>= lod;
+          D.y() >>= lod;
+          m_color_uploads.push_back(ColorUpload::BackingCopy(lod, D, sz, S));
+        }
+    }
+
+  dst->m_lods_written = src->m_lods_written;
+  dst->m_lods_hashed = src->m_lods_hashed;
+  dst->m_hash = src->m_hash;
+}
+
 void
 astral::ImageAtlas::
 lock_resources(void)
@@ -3538,6 +5137,10 @@ lock_resources(void)
   Implement *p;
 
   p = static_cast<Implement*>(this);
+  if (p->m_resources_locked == 0 && p->m_compaction_texels_per_frame > 0u)
+    {
+      p->compact_implement(p->m_compaction_texels_per_frame);
+    }
   ++p->m_resources_locked;
 }
 
@@ -3618,6 +5221,288 @@ total_image_mip_elements_allocated(void) const
   return p->m_pool->total_image_mip_elements_allocated();
 }
 
+void
+astral::ImageAtlas::
+color_backing_byte_budget(uint64_t bytes)
+{
+  Implement *p;
+
+  p = static_cast<Implement*>(this);
+  p->m_color_backing_byte_budget = bytes;
+}
+
+uint64_t
+astral::ImageAtlas::
+color_backing_byte_budget(void) const
+{
+  const Implement *p;
+
+  p = static_cast<const Implement*>(this);
+  return p->m_color_backing_byte_budget;
+}
+
+void
+astral::ImageAtlas::
+purge_callback(const reference_counted_ptr<PurgeCallback> &v)
+{
+  Implement *p;
+
+  p = static_cast<Implement*>(this);
+  p->m_purge_callback = v;
+}
+
+uint64_t
+astral::ImageAtlas::
+total_color_bytes_allocated(void) const
+{
+  const Implement *p;
+
+  p = static_cast<const Implement*>(this);
+  return p->color_bytes_allocated();
+}
+
+unsigned int
+astral::ImageAtlas::
+total_images_purged(void) const
+{
+  const Implement *p;
+
+  p = static_cast<const Implement*>(this);
+  return p->m_total_images_purged;
+}
+
+unsigned int
+astral::ImageAtlas::
+compact(unsigned int max_texels)
+{
+  Implement *p;
+
+  p = static_cast<Implement*>(this);
+  return p->compact_implement(max_texels);
+}
+
+void
+astral::ImageAtlas::
+compaction_texels_per_frame(unsigned int v)
+{
+  Implement *p;
+
+  p = static_cast<Implement*>(this);
+  p->m_compaction_texels_per_frame = v;
+}
+
+unsigned int
+astral::ImageAtlas::
+compaction_texels_per_frame(void) const
+{
+  const Implement *p;
+
+  p = static_cast<const Implement*>(this);
+  return p->m_compaction_texels_per_frame;
+}
+
+uint64_t
+astral::ImageAtlas::
+total_color_texels_compacted(void) const
+{
+  const Implement *p;
+
+  p = static_cast<const Implement*>(this);
+  return p->m_total_color_texels_compacted;
+}
+
+astral::reference_counted_ptr<astral::ImageAtlas::AsyncUpload>
+astral::ImageAtlas::
+upload_image_async(uvec2 sz, unsigned int row_width, c_array<const u8vec4> pixels,
+                   const AsyncImageParams &in_params)
+{
+  Implement *p;
+  AsyncImageParams params(in_params);
+  reference_counted_ptr<AsyncUpload::Implement> return_value;
+  reference_counted_ptr<ThreadPool> pool;
+
+  ASTRALassert(sz.x() > 0u && sz.y() > 0u);
+  ASTRALassert(row_width >= sz.x());
+  p = static_cast<Implement*>(this);
+
+  /* clamp the number of mipmap levels to what the size supports */
+  params.m_number_mip_levels = t_max(1u, params.m_number_mip_levels);
+  params.m_number_mip_levels = t_min(params.m_number_mip_levels, 1u + uint32_log2_floor(t_min(sz.x(), sz.y())));
+
+  return_value = ASTRALnew AsyncUpload::Implement(sz, row_width, pixels, params);
+  {
+    std::lock_guard<std::mutex> lock(p->m_async_mutex);
+
+    if (!p->m_async_thread_pool)
+      {
+        p->m_async_thread_pool = ThreadPool::create();
+      }
+    pool = p->m_async_thread_pool;
+    p->m_async_uploads.push_back(return_value);
+  }
+
+  pool->add_job(ASTRALnew Implement::AsyncUploadJob(return_value.get()));
+
+  return return_value;
+}
+
+void
+astral::ImageAtlas::
+async_upload_thread_pool(const reference_counted_ptr<ThreadPool> &pool)
+{
+  Implement *p;
+
+  p = static_cast<Implement*>(this);
+
+  std::lock_guard<std::mutex> lock(p->m_async_mutex);
+  p->m_async_thread_pool = pool;
+}
+
+astral::reference_counted_ptr<astral::ThreadPool>
+astral::ImageAtlas::
+async_upload_thread_pool(void)
+{
+  Implement *p;
+
+  p = static_cast<Implement*>(this);
+
+  std::lock_guard<std::mutex> lock(p->m_async_mutex);
+  if (!p->m_async_thread_pool)
+    {
+      p->m_async_thread_pool = ThreadPool::create();
+    }
+  return p->m_async_thread_pool;
+}
+
+void
+astral::ImageAtlas::Implement::
+publish_async_uploads(void)
+{
+  std::vector<reference_counted_ptr<AsyncUpload::Implement>> &processed(m_async_publish_workroom);
+
+  ASTRALassert(processed.empty());
+  {
+    std::lock_guard<std::mutex> lock(m_async_mutex);
+    unsigned int dst(0);
+
+    for (unsigned int src = 0; src < m_async_uploads.size(); ++src)
+      {
+        if (m_async_uploads[src]->status() == AsyncUpload::Implement::status_processed)
+          {
+            processed.push_back(m_async_uploads[src]);
+          }
+        else
+          {
+            m_async_uploads[dst].swap(m_async_uploads[src]);
+            ++dst;
+          }
+      }
+    m_async_uploads.resize(dst);
+  }
+
+  for (const reference_counted_ptr<AsyncUpload::Implement> &upload : processed)
+    {
+      reference_counted_ptr<Image> image;
+      vecN<bool, 16> tiles_replaced(false);
+
+      image = create_image_implement(detail::RenderedImageTag(InvalidRenderValue),
+                                     upload->m_params.m_number_mip_levels,
+                                     upload->m_size, upload->m_params.m_colorspace);
+
+      for (AsyncUpload::Implement::Block &block : upload->m_blocks)
+        {
+          ImageMipElement::Implement *element;
+          unsigned int idx, element_lod;
+          ColorTile *prev_tile;
+
+          idx = block.m_lod >> 1u;
+          element_lod = block.m_lod & 1u;
+          ASTRALassert(idx < image->mip_chain().size());
+          ASTRALassert(idx < tiles_replaced.size());
+
+          element = static_cast<ImageMipElement::Implement*>(&static_cast<Image::Implement*>(image.get())->mip_chain(idx));
+          if (element_lod >= element->m_number_mipmap_levels)
+            {
+              continue;
+            }
+
+          ASTRALassert(block.m_tile_index < element->m_tiles.size());
+          prev_tile = element->m_tiles[block.m_tile_index];
+          element->upload_color_tile_texels(*this, block.m_tile_index, element_lod,
+                                            block.m_dst, block.m_size, block.m_size.x(),
+                                            make_c_array(block.m_texels), block.m_covers_tile,
+                                            &block.m_texels);
+          tiles_replaced[idx] = tiles_replaced[idx] || (element->m_tiles[block.m_tile_index] != prev_tile);
+        }
+
+      for (unsigned int idx = 0; idx < image->mip_chain().size() && idx < tiles_replaced.size(); ++idx)
+        {
+          ImageMipElement::Implement *element;
+
+          element = static_cast<ImageMipElement::Implement*>(&static_cast<Image::Implement*>(image.get())->mip_chain(idx));
+          if (tiles_replaced[idx] && element->m_allocate_color_tile_backings_called)
+            {
+              upload_index_values_for_color_tiles(*element);
+            }
+        }
+
+      upload->m_blocks.clear();
+      upload->m_image = image;
+      upload->set_status(AsyncUpload::Implement::status_ready);
+    }
+
+  processed.clear();
+}
+
+void
+astral::ImageAtlas::
+deduplicate_color_tiles(bool v)
+{
+  Implement *p;
+
+  p = static_cast<Implement*>(this);
+  if (!v)
+    {
+      /* the hash table is only meaningful while deduplication is on */
+      for (const auto &e : p->m_color_tile_hash_table)
+        {
+          e.second->m_in_hash_table = false;
+        }
+      p->m_color_tile_hash_table.clear();
+    }
+  p->m_deduplicate_color_tiles = v;
+}
+
+bool
+astral::ImageAtlas::
+deduplicate_color_tiles(void) const
+{
+  const Implement *p;
+
+  p = static_cast<const Implement*>(this);
+  return p->m_deduplicate_color_tiles;
+}
+
+uint64_t
+astral::ImageAtlas::
+total_color_bytes_deduplicated(void) const
+{
+  const Implement *p;
+
+  p = static_cast<const Implement*>(this);
+  return p->m_total_color_bytes_deduplicated;
+}
+
+unsigned int
+astral::ImageAtlas::
+total_color_layers_reclaimed(void) const
+{
+  const Implement *p;
+
+  p = static_cast<const Implement*>(this);
+  return p->m_total_color_layers_reclaimed;
+}
+
 astral::Image*
 astral::ImageAtlas::
 fetch_image(ImageID ID)
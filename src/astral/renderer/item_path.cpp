@@ -14,6 +14,7 @@
  *
  */
 #include <sstream>
+#include <cstring>
 
 #include <astral/path.hpp>
 #include <astral/util/ostream_utility.hpp>
@@ -23,6 +24,7 @@
 #include <astral/renderer/static_data.hpp>
 #include <astral/renderer/render_engine.hpp>
 #include <astral/renderer/item_path.hpp>
+#include "../serialized_data.hpp"
 
 /* Overview
  *
@@ -1200,6 +1202,74 @@ astral::ItemPath::
 {
 }
 
+bool
+astral::ItemPath::
+serialize(detail::SerializedWriter &dst, detail::SerializedItemPath *out_record) const
+{
+  if (m_bands)
+    {
+      return false;
+    }
+
+  std::memset(out_record, 0, sizeof(*out_record));
+  out_record->m_header_data = dst.write_array(make_c_array(m_header_data));
+  out_record->m_header_size = m_header_data.size();
+  out_record->m_band_data = dst.write_array(make_c_array(m_band_data));
+  out_record->m_band_size = m_band_data.size();
+  out_record->m_error = m_properties.m_error;
+  out_record->m_number_bands[0] = m_properties.m_number_bands.x();
+  out_record->m_number_bands[1] = m_properties.m_number_bands.y();
+  out_record->m_average_render_cost[0] = m_properties.m_average_render_cost.x();
+  out_record->m_average_render_cost[1] = m_properties.m_average_render_cost.y();
+  out_record->m_bb.set(m_properties.m_bb);
+  out_record->m_tr_translate[0] = m_tr.m_translate.x();
+  out_record->m_tr_translate[1] = m_tr.m_translate.y();
+  out_record->m_tr_scale[0] = m_tr.m_scale.x();
+  out_record->m_tr_scale[1] = m_tr.m_scale.y();
+  out_record->m_params_cost = m_params.m_cost;
+  out_record->m_params_max_recursion = m_params.m_max_recursion;
+
+  return true;
+}
+
+astral::reference_counted_ptr<astral::ItemPath>
+astral::ItemPath::
+deserialize(const detail::SerializedReader &src, const detail::SerializedItemPath &record)
+{
+  reference_counted_ptr<ItemPath> return_value;
+  c_array<const gvec4> header_data;
+  c_array<const vec4> band_data;
+
+  /* the header data has a header texel and then
+   * one texel for each band
+   */
+  if (!src.read_array(record.m_header_data, record.m_header_size, &header_data)
+      || !src.read_array(record.m_band_data, record.m_band_size, &band_data)
+      || header_data.empty()
+      || header_data.size() < 1u + record.m_number_bands[0] + record.m_number_bands[1])
+    {
+      return nullptr;
+    }
+
+  return_value = ASTRALnew ItemPath();
+  return_value->m_header_data.assign(header_data.begin(), header_data.end());
+  return_value->m_band_data.assign(band_data.begin(), band_data.end());
+
+  return_value->m_properties.m_error = record.m_error;
+  return_value->m_properties.m_bb = record.m_bb.get();
+  return_value->m_properties.m_number_bands = uvec2(record.m_number_bands[0], record.m_number_bands[1]);
+  return_value->m_properties.m_fp16_data_size = record.m_band_size;
+  return_value->m_properties.m_generic_data_size = record.m_header_size;
+  return_value->m_properties.m_average_render_cost = vec2(record.m_average_render_cost[0], record.m_average_render_cost[1]);
+
+  return_value->m_tr.m_translate = vec2(record.m_tr_translate[0], record.m_tr_translate[1]);
+  return_value->m_tr.m_scale = vec2(record.m_tr_scale[0], record.m_tr_scale[1]);
+  return_value->m_params.m_cost = record.m_params_cost;
+  return_value->m_params.m_max_recursion = record.m_params_max_recursion;
+
+  return return_value;
+}
+
 uint32_t
 astral::ItemPath::
 header_location(RenderEngine &engine) const
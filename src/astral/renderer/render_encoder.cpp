@@ -667,6 +667,25 @@ draw_rect(const Rect &rect, bool with_aa,
   draw_rect(*shader, rect, material, blend_mode);
 }
 
+void
+astral::RenderEncoderBase::
+draw_blurred_rounded_rect(const RoundedRect &rect, float sigma,
+                          const ItemMaterial &material,
+                          enum blend_mode_t blend_mode) const
+{
+  vecN<gvec4, BlurredRoundedRectShader::item_data_size> data;
+  const ColorItemShader *shader;
+  Rect draw_rect;
+
+  ASTRALassert(valid());
+
+  shader = renderer_implement().m_default_shaders.m_blurred_rounded_rect_shader.get();
+  draw_rect = BlurredRoundedRectShader::pack_item_data(rect, sigma, data);
+
+  RectItem item(*shader, create_item_data(data, no_item_data_value_mapping));
+  draw_custom_rect(draw_rect, item, material, blend_mode);
+}
+
 void
 astral::RenderEncoderBase::
 draw_custom_rect(const RectRegion &region, const RectItem &rect_item,
@@ -2213,6 +2232,41 @@ encoder_shadow_map_relative(int dimensions, vec2 light_p) const
   return M;
 }
 
+astral::RenderEncoderShadowMap
+astral::RenderEncoderBase::
+encoder_shadow_map(const reference_counted_ptr<ShadowMap> &shadow_map) const
+{
+  RenderEncoderBase return_value;
+  reference_counted_ptr<ShadowMap> dst;
+
+  ASTRALassert(shadow_map);
+
+  /* A shadow map that is already used by a draw or rendered to
+   * in this begin()/end() pair cannot have its content changed,
+   * so render to a fresh shadow map instead.
+   */
+  dst = shadow_map;
+  if (dst->in_use())
+    {
+      dst = render_engine().shadow_map_atlas().create(shadow_map->dimensions(),
+                                                      shadow_map->light_position());
+    }
+
+  return_value = renderer_implement().m_storage->create_virtual_buffer(VB_TAG, dst, dst->light_position());
+  return_value.render_accuracy(render_accuracy());
+  return_value.use_sub_ubers(use_sub_ubers());
+  return RenderEncoderShadowMap(return_value);
+}
+
+astral::RenderEncoderShadowMap
+astral::RenderEncoderBase::
+encoder_shadow_map_relative(const reference_counted_ptr<ShadowMap> &shadow_map) const
+{
+  RenderEncoderShadowMap M(encoder_shadow_map(shadow_map));
+  M.transformation(transformation());
+  return M;
+}
+
 astral::RenderEncoderStrokeMask
 astral::RenderEncoderBase::
 encoder_stroke(const StrokeMaskProperties &mask_properties) const
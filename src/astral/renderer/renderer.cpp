@@ -457,6 +457,8 @@ Implement(RenderEngine &engine):
   m_stat_labels[number_sparse_fill_subrect_skip_clipping] = "renderer_sparse_fill_number_subrect_skip_clipping";
   m_stat_labels[number_sparse_fill_contour_skip_clipping] = "renderer_sparse_fill_number_contour_skip_clipping";
   m_stat_labels[number_sparse_fill_awkward_fully_clipped_or_unclipped] = "renderer_sparse_fill_number_awkward_fully_clipped_or_unclipped";
+  m_stat_labels[number_sparse_stroke_nodes_visited] = "renderer_sparse_stroke_number_nodes_visited";
+  m_stat_labels[number_sparse_stroke_leaves_visited] = "renderer_sparse_stroke_number_leaves_visited";
 }
 
 bool
@@ -577,6 +579,7 @@ begin_implement(enum colorspace_t c)
   std::fill(m_stats.begin(), m_stats.end(), 0u);
   m_engine->image_atlas().lock_resources();
   m_engine->colorstop_sequence_atlas().lock_resources();
+  m_engine->shadow_map_atlas().lock_resources();
   m_engine->vertex_data_allocator().lock_resources();
   m_engine->static_data_allocator32().lock_resources();
   m_engine->static_data_allocator16().lock_resources();
@@ -1474,6 +1477,7 @@ end_abort_implement(void)
 
   m_engine->image_atlas().unlock_resources();
   m_engine->colorstop_sequence_atlas().unlock_resources();
+  m_engine->shadow_map_atlas().unlock_resources();
   m_engine->vertex_data_allocator().unlock_resources();
   m_engine->static_data_allocator32().unlock_resources();
   m_engine->static_data_allocator16().unlock_resources();
@@ -1656,6 +1660,7 @@ end_implement(OffscreenBufferAllocInfo *p)
 
   m_engine->image_atlas().unlock_resources();
   m_engine->colorstop_sequence_atlas().unlock_resources();
+  m_engine->shadow_map_atlas().unlock_resources();
   m_engine->vertex_data_allocator().unlock_resources();
   m_engine->static_data_allocator32().unlock_resources();
   m_engine->static_data_allocator16().unlock_resources();
@@ -320,7 +320,8 @@ init(Renderer::Implement &renderer,
 
   m_renderer = src.m_renderer;
   m_cull_geometry = src.m_cull_geometry;
-  m_cull_geometry_token = src.m_cull_geometry_token;
+  m_cull_geometry_token = src.cull_geometry_token();
+  m_begin_cnt = m_renderer->m_begin_cnt;
   m_mip_front = src.m_mip_front;
   m_mask_channels = src.m_mask_channels;
 
@@ -348,6 +349,7 @@ init(Renderer::Implement &renderer,
   m_renderer = &renderer;
   m_cull_geometry = cull_geometry;
   m_cull_geometry_token = token;
+  m_begin_cnt = renderer.m_begin_cnt;
   m_mask_details.m_mask = image;
   m_mask_channels = mask_channels;
 
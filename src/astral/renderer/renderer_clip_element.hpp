@@ -58,10 +58,19 @@ public:
     return m_cull_geometry;
   }
 
+  /* The token refers to sub-rects held by Storage which is
+   * cleared at the end of each frame, thus when the ClipElement
+   * is used in a later frame (i.e. it was retained by the caller)
+   * the token is dropped and the full rect of the cull geometry
+   * is used instead.
+   */
   CullGeometryGroup::Token
   cull_geometry_token(void) const
   {
-    return m_cull_geometry_token;
+    ASTRALassert(m_renderer);
+    return (m_begin_cnt == m_renderer->m_begin_cnt) ?
+      m_cull_geometry_token :
+      CullGeometryGroup::Token();
   }
 
   /* returns the mask channel for the type returned by mask_type(void) const */
@@ -123,6 +132,9 @@ private:
   CullGeometrySimple m_cull_geometry;
   CullGeometryGroup::Token m_cull_geometry_token;
   reference_counted_ptr<const ImageMipElement> m_mip_front;
+
+  /* value of Renderer::Implement::m_begin_cnt when created */
+  unsigned int m_begin_cnt;
   MaskDetails m_mask_details;
 
   mutable RenderValue<const RenderClipElement*> m_render_value;
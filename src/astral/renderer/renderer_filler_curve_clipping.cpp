@@ -19,6 +19,28 @@
 #include "renderer_virtual_buffer.hpp"
 #include "renderer_streamer.hpp"
 #include "renderer_filler_curve_clipping.hpp"
+#include "../util/simd.hpp"
+
+namespace
+{
+  using namespace astral::detail::simd;
+
+  /* The SIMD computation of Intersection values must perform
+   * exactly the same operations in the same order as the scalar
+   * Intersection ctor so that the clipping is unchanged. It needs
+   * exact division and square root, so ARMv7 NEON takes the scalar
+   * path.
+   */
+#if defined(ASTRAL_SIMD_NATIVE_DIV_SQRT)
+  /* t_max(a, b) > 0 */
+  inline
+  simd_mask
+  simd_max_positive(simd_float a, simd_float b)
+  {
+    return simd_less(simd_splat(0.0f), simd_select(simd_less(a, b), b, a));
+  }
+#endif
+}
 
 class astral::Renderer::Implement::Filler::CurveClipper::Helper
 {
@@ -257,6 +279,13 @@ Intersection(enum line_t tp, float ref_p, const ContourCurve &curve)
       t1 = t2 = 0.5f * C / B;
     }
 
+  set_roots(t1, t2, use_t1, use_t2);
+}
+
+void
+astral::Renderer::Implement::Filler::CurveClipper::Intersection::
+set_roots(float t1, float t2, bool use_t1, bool use_t2)
+{
   /* a double root numerically, view as a no roots */
   if (use_t1 && use_t2 && t1 == t2)
     {
@@ -280,6 +309,117 @@ Intersection(enum line_t tp, float ref_p, const ContourCurve &curve)
     }
 }
 
+void
+astral::Renderer::Implement::Filler::CurveClipper::Intersection::
+create(enum line_t tp, c_array<const float> ref_p,
+       const ContourCurve &curve, c_array<Intersection> out)
+{
+  unsigned int i(0);
+
+  ASTRALassert(ref_p.size() == out.size());
+  ASTRALassert(curve.number_control_pts() <= 1u);
+
+  #if defined(ASTRAL_SIMD_NATIVE_DIV_SQRT)
+    {
+      int coord;
+      bool is_line;
+      float w;
+      simd_float start, ctrl, end, zero, two_w, vw, thresh;
+
+      /* This follows the Intersection ctor exactly, computing
+       * both branches for each of the 4 lines and selecting
+       * the one the ctor would take.
+       */
+      coord = fixed_coordinate(tp);
+      is_line = (curve.type() == ContourCurve::line_segment);
+      w = (!is_line) ? curve.conic_weight() : 1.0f;
+
+      start = simd_splat(curve.start_pt()[coord]);
+      end = simd_splat(curve.end_pt()[coord]);
+      ctrl = simd_splat((!is_line) ? curve.control_pt(0)[coord] : 0.0f);
+      zero = simd_splat(0.0f);
+      two_w = simd_splat(2.0f * w);
+      vw = simd_splat(w);
+      thresh = simd_splat(1e-6f);
+
+      for (; i + 4u <= ref_p.size(); i += 4u)
+        {
+          simd_float r, p1, p2, p3, A, B, C, D, recipA, rootD;
+          simd_float B_minus, B_plus, t1, t2, linear_t;
+          simd_mask use_t1, use_t2, quad, B_negative;
+          unsigned int use_t1_bits, use_t2_bits, no_root_bits;
+          float tt1[4], tt2[4];
+
+          r = simd_load(&ref_p[i]);
+          p1 = simd_sub(start, r);
+          p3 = simd_sub(end, r);
+          p2 = (is_line) ?
+            simd_mul(simd_splat(0.5f), simd_add(p1, p3)) :
+            simd_sub(ctrl, r);
+
+          use_t1 = simd_or(simd_and(simd_less(p3, zero), simd_max_positive(p1, p2)),
+                           simd_and(simd_less(zero, p1), simd_less(p2, zero)));
+          use_t2 = simd_or(simd_and(simd_less(p1, zero), simd_max_positive(p2, p3)),
+                           simd_and(simd_less(zero, p3), simd_less(p2, zero)));
+
+          A = simd_add(simd_sub(p1, simd_mul(two_w, p2)), p3);
+          B = simd_sub(p1, simd_mul(vw, p2));
+          C = p1;
+
+          linear_t = simd_div(simd_mul(simd_splat(0.5f), C), B);
+          if (is_line)
+            {
+              t1 = t2 = linear_t;
+              no_root_bits = 0u;
+            }
+          else
+            {
+              simd_float abs_B, abs_C, max_B_C;
+
+              abs_B = simd_abs(B);
+              abs_C = simd_abs(C);
+              max_B_C = simd_select(simd_less(abs_B, abs_C), abs_C, abs_B);
+              quad = simd_less(simd_mul(thresh, max_B_C), simd_abs(A));
+
+              D = simd_sub(simd_mul(B, B), simd_mul(A, C));
+              recipA = simd_div(simd_splat(1.0f), A);
+              rootD = simd_sqrt(D);
+              B_minus = simd_sub(B, rootD);
+              B_plus = simd_add(B, rootD);
+              B_negative = simd_less(B, zero);
+
+              t1 = simd_select(B_negative, simd_mul(B_minus, recipA), simd_div(C, B_plus));
+              t2 = simd_select(B_negative, simd_div(C, B_minus), simd_mul(B_plus, recipA));
+
+              /* lanes with a negative discriminant have no roots */
+              no_root_bits = simd_mask_bits(simd_and(quad, simd_less(D, zero)));
+              t1 = simd_select(quad, t1, linear_t);
+              t2 = simd_select(quad, t2, linear_t);
+            }
+
+          use_t1_bits = simd_mask_bits(use_t1) & ~no_root_bits;
+          use_t2_bits = simd_mask_bits(use_t2) & ~no_root_bits;
+          simd_store(tt1, t1);
+          simd_store(tt2, t2);
+
+          for (unsigned int k = 0; k < 4; ++k)
+            {
+              unsigned int bit(1u << k);
+
+              out[i + k].set_roots(tt1[k], tt2[k],
+                                   (use_t1_bits & bit) != 0u,
+                                   (use_t2_bits & bit) != 0u);
+            }
+        }
+    }
+  #endif
+
+  for (; i < ref_p.size(); ++i)
+    {
+      out[i] = Intersection(tp, ref_p[i], curve);
+    }
+}
+
 bool
 astral::Renderer::Implement::Filler::CurveClipper::Intersection::
 on_one_open_side(int coord, const ContourCurve &curve, float ref_p)
@@ -376,10 +516,15 @@ MappedCurve(Filler::CurveClipper &filler,
       l = fixed_coordinate(ll);
       m_intersections[ss] = filler.m_intersection_backing.size();
 
+      filler.m_workroom_side_values.clear();
       for (int v = m_subrect_range[l].m_begin; v < m_subrect_range[l].m_end; ++v)
         {
-          filler.m_intersection_backing.push_back(Intersection(ll, filler.side_value(v, ss), m_mapped_curve));
+          filler.m_workroom_side_values.push_back(filler.side_value(v, ss));
         }
+
+      filler.m_intersection_backing.resize(m_intersections[ss] + filler.m_workroom_side_values.size());
+      Intersection::create(ll, make_c_array(filler.m_workroom_side_values), m_mapped_curve,
+                           make_c_array(filler.m_intersection_backing).sub_array(m_intersections[ss]));
     }
 }
 
@@ -166,7 +166,23 @@ private:
     bool
     on_one_open_side(int coord, const ContourCurve &curve, float v);
 
+    /* Computes the intersections of the curve against the lines
+     * at each of the values v[i], writing them to out[i]; the
+     * result is the same as Intersection(tp, v[i], curve), but
+     * the lines are processed four at a time with SIMD.
+     */
+    static
+    void
+    create(enum line_t tp, c_array<const float> v,
+           const ContourCurve &curve, c_array<Intersection> out);
+
   private:
+    /* set m_count and m_data from the roots t1 and t2 and
+     * which of them are within the curve
+     */
+    void
+    set_roots(float t1, float t2, bool use_t1, bool use_t2);
+
     /* number of intersections, can be 0, 1 or 2; a value of zero
      * represents that there is no intersection.
      */
@@ -751,6 +767,11 @@ private:
   /* workroom for computing animated contour values */
   std::vector<ContourCurve> m_workroom_curves;
 
+  /* workroom for the side values against which a
+   * MappedCurve computes its Intersection values
+   */
+  std::vector<float> m_workroom_side_values;
+
   /* workroom for clipping mapped contours
    *  - m_clipped_contourA is used to prepare the clipping to columns
    *  - m_clipped_contourB is used to take clipped against a column
@@ -429,10 +429,14 @@ compute_cap_bb(const Contour &contour)
 {
   BoundingBox<float> return_value;
 
-  if (m_current_stroke_params.m_cap != cap_flat && !contour.closed() && !contour.curves().empty())
+  if (m_current_stroke_params.m_cap != cap_flat && !contour.closed() && !contour.empty())
     {
-      return_value.union_point(contour.curves().front().start_pt());
-      return_value.union_point(contour.curves().front().end_pt());
+      /* the caps are at the start of the first curve and at
+       * the end of the last curve; using start() and current_pt()
+       * does not require decoding the curves of a compact contour.
+       */
+      return_value.union_point(contour.start());
+      return_value.union_point(contour.current_pt());
     }
 
   return return_value;
@@ -614,6 +618,8 @@ compute_mask(void)
     }
 
   stroke_query.end_query(Renderer::VirtualBuffer::max_renderable_buffer_size);
+  m_renderer->m_stats[Renderer::number_sparse_stroke_nodes_visited] += stroke_query.number_nodes_visited();
+  m_renderer->m_stats[Renderer::number_sparse_stroke_leaves_visited] += stroke_query.number_leaves_visited();
 
   /* Step 3: make the image and the needed encoders */
   unsigned int count;
@@ -15,8 +15,70 @@
  */
 
 #include <limits>
+#include <algorithm>
 #include "stroke_data_hierarchy.hpp"
 #include "stroke_shader_vertex_index_roles.hpp"
+#include "../../util/simd.hpp"
+
+namespace
+{
+  using namespace astral::detail::simd;
+
+  /* The entries of a Transformation splatted to all lanes */
+  class SIMDTransformation
+  {
+  public:
+    explicit
+    SIMDTransformation(const astral::Transformation &tr)
+    {
+      for (unsigned int r = 0; r < 2; ++r)
+        {
+          for (unsigned int c = 0; c < 2; ++c)
+            {
+              m_matrix[r][c] = simd_splat(tr.m_matrix.row_col(r, c));
+            }
+          m_translate[r] = simd_splat(tr.m_translate[r]);
+        }
+    }
+
+    /* Computes the bounding box of the transformation of four
+     * boxes with the same operations in the same order as
+     * Transformation::apply_to_bb() so that the results do not
+     * depend on the instruction set.
+     */
+    void
+    apply_to_boxes(simd_float *min_x, simd_float *min_y,
+                   simd_float *max_x, simd_float *max_y) const
+    {
+      simd_float x[4] = { *min_x, *min_x, *max_x, *max_x };
+      simd_float y[4] = { *min_y, *max_y, *min_y, *max_y };
+
+      for (unsigned int i = 0; i < 4; ++i)
+        {
+          simd_float px, py;
+
+          px = simd_add(simd_add(simd_mul(m_matrix[0][0], x[i]), simd_mul(m_matrix[0][1], y[i])), m_translate[0]);
+          py = simd_add(simd_add(simd_mul(m_matrix[1][0], x[i]), simd_mul(m_matrix[1][1], y[i])), m_translate[1]);
+          if (i == 0)
+            {
+              *min_x = *max_x = px;
+              *min_y = *max_y = py;
+            }
+          else
+            {
+              *min_x = simd_min(*min_x, px);
+              *min_y = simd_min(*min_y, py);
+              *max_x = simd_max(*max_x, px);
+              *max_y = simd_max(*max_y, py);
+            }
+        }
+    }
+
+  private:
+    simd_float m_matrix[2][2];
+    simd_float m_translate[2];
+  };
+}
 
 //////////////////////////////////////////////////
 // astral::detail::StrokeDataHierarchy::Base methods
@@ -155,6 +217,46 @@ child_node(unsigned int I, const StrokeDataHierarchy &src) const
   return src.get_node(I + m_child_nodes_range.m_begin);
 }
 
+/////////////////////////////////////////////////////////
+// astral::detail::StrokeDataHierarchy methods
+void
+astral::detail::StrokeDataHierarchy::
+child_bounding_boxes(const Base &node,
+                     const Transformation &pixel_transformation_logical,
+                     const Transformation &logical_transformation_path,
+                     float t, const StrokeQuery::StrokeRadii &stroke_params,
+                     const QueryRegion *cull_region,
+                     c_array<BoundingBox<float>> out_values) const
+{
+  unsigned int num_leaves(node.number_child_leaves());
+
+  ASTRALassert(out_values.size() == num_leaves + node.number_child_nodes());
+  for (unsigned int i = 0; i < num_leaves; ++i)
+    {
+      out_values[i] = node.child_leaf(i, *this).bounding_box(pixel_transformation_logical,
+                                                             logical_transformation_path,
+                                                             t, stroke_params);
+    }
+
+  for (unsigned int i = 0, endi = node.number_child_nodes(); i < endi; ++i)
+    {
+      out_values[i + num_leaves] = node.child_node(i, *this).bounding_box(pixel_transformation_logical,
+                                                                          logical_transformation_path,
+                                                                          t, stroke_params);
+    }
+
+  if (cull_region)
+    {
+      for (BoundingBox<float> &bb : out_values)
+        {
+          if (!bb.empty() && cull_region->misses(bb))
+            {
+              bb.clear();
+            }
+        }
+    }
+}
+
 /////////////////////////////////////////////////////////
 // astral::detail::StrokeDataHierarchy::AABB methods
 astral::BoundingBox<float>
@@ -553,10 +655,608 @@ create_hierarchy(unsigned int max_depth, unsigned int split_threshhold,
     }
 }
 
+/////////////////////////////////////////////////////////////////////////////
+// astral::detail::StrokeDataHierarchy::StaticHierarchy::SAHBuilder methods
+
+/* An SAHBuilder builds a binary tree over the leaves where
+ * each tree node is split in two at the binned split of the
+ * centers of the leaves that minimizes the surface area
+ * heuristic. Since the hierarchy is 2D, the "surface area"
+ * of a box is its half-perimeter; this keeps thin boxes of
+ * horizontal and vertical lines from having zero cost.
+ *
+ * The tree nodes of the leaves [begin, end) occupy the
+ * 2 * (end - begin) - 1 consecutive elements of m_tree
+ * starting at the location passed to build(); the children
+ * occupy the front of that range and the tree node itself
+ * the last element. Together with the leaves of a sub-tree
+ * being a range of m_order, this means that sub-trees are
+ * built concurrently without any locking; large sub-trees
+ * are built by jobs of the ThreadPool passed to the ctor.
+ */
+class astral::detail::StrokeDataHierarchy::StaticHierarchy::SAHBuilder:astral::noncopyable
+{
+public:
+  class TreeNode
+  {
+  public:
+    /* range into leaves() of the leaves of the tree node */
+    range_type<unsigned int> m_range;
+
+    /* if m_is_leaf_node is false, the tree nodes of the children */
+    vecN<unsigned int, 2> m_children;
+
+    /* if true, the tree node is realized as a node_of_leaves */
+    bool m_is_leaf_node;
+  };
+
+  SAHBuilder(c_array<const StaticLeafData> leaves, ThreadPool *thread_pool);
+
+  unsigned int
+  root(void) const
+  {
+    return m_root;
+  }
+
+  const TreeNode&
+  tree_node(unsigned int I) const
+  {
+    ASTRALassert(I < m_tree.size());
+    return m_tree[I];
+  }
+
+  /* the leaves ordered so that the leaves of each
+   * tree node are a range.
+   */
+  c_array<const StaticLeafData>
+  leaves(range_type<unsigned int> R) const
+  {
+    return make_c_array(m_sorted_leaves).sub_array(R);
+  }
+
+private:
+  enum
+    {
+      /* number of bins per axis for finding a split */
+      number_bins = 16,
+
+      /* tree nodes with fewer leaves are not split */
+      min_split_size = 8,
+
+      /* tree nodes with more leaves are always split */
+      max_leaf_node_size = 16,
+
+      /* sub-trees with fewer leaves are built on the
+       * thread that built their parent
+       */
+      min_parallel_size = 4096,
+
+      /* limit on the depth of the tree */
+      max_depth = 64,
+    };
+
+  /* cost of visiting a node relative to visiting a leaf;
+   * the bounding box of a node is computed with two
+   * transformations of a box instead of one.
+   */
+  static const float node_cost;
+
+  class BuildJob;
+
+  class Bin
+  {
+  public:
+    Bin(void):
+      m_count(0u)
+    {}
+
+    BoundingBox<float> m_bb;
+    unsigned int m_count;
+  };
+
+  static
+  float
+  half_perimeter(const BoundingBox<float> &bb)
+  {
+    vec2 sz(bb.size());
+    return sz.x() + sz.y();
+  }
+
+  unsigned int
+  compute_bin(unsigned int leaf, unsigned int coord,
+              float min_value, float scale) const
+  {
+    int b;
+
+    b = static_cast<int>((m_centers[leaf][coord] - min_value) * scale);
+    return t_max(0, t_min(static_cast<int>(number_bins) - 1, b));
+  }
+
+  /* Returns true if the leaves R should be split and if so
+   * partitions the range of m_order and gives where the
+   * second child starts.
+   */
+  bool
+  split_leaves(range_type<unsigned int> R, const BoundingBox<float> &bb,
+               const BoundingBox<float> &center_bb, unsigned int *out_mid);
+
+  void
+  build(range_type<unsigned int> R, unsigned int location,
+        unsigned int depth, unsigned int spawn_depth);
+
+  ThreadPool *m_thread_pool;
+  c_array<const StaticLeafData> m_leaves;
+  std::vector<vec2> m_centers;
+  std::vector<unsigned int> m_order;
+  std::vector<TreeNode> m_tree;
+  std::vector<StaticLeafData> m_sorted_leaves;
+  unsigned int m_root;
+};
+
+/* A BuildJob builds a sub-tree of an SAHBuilder */
+class astral::detail::StrokeDataHierarchy::StaticHierarchy::SAHBuilder::BuildJob:
+  public astral::ThreadPool::Job
+{
+public:
+  BuildJob(SAHBuilder &builder, range_type<unsigned int> R,
+           unsigned int location, unsigned int depth,
+           unsigned int spawn_depth):
+    m_builder(builder),
+    m_range(R),
+    m_location(location),
+    m_depth(depth),
+    m_spawn_depth(spawn_depth)
+  {}
+
+  virtual
+  void
+  execute(void) override
+  {
+    m_builder.build(m_range, m_location, m_depth, m_spawn_depth);
+  }
+
+private:
+  SAHBuilder &m_builder;
+  range_type<unsigned int> m_range;
+  unsigned int m_location, m_depth, m_spawn_depth;
+};
+
+const float astral::detail::StrokeDataHierarchy::StaticHierarchy::SAHBuilder::node_cost = 2.0f;
+
+astral::detail::StrokeDataHierarchy::StaticHierarchy::SAHBuilder::
+SAHBuilder(c_array<const StaticLeafData> leaves, ThreadPool *thread_pool):
+  m_thread_pool(thread_pool),
+  m_leaves(leaves),
+  m_centers(leaves.size()),
+  m_order(leaves.size()),
+  m_tree(2u * leaves.size() - 1u),
+  m_root(m_tree.size() - 1u)
+{
+  unsigned int spawn_depth(0u);
+
+  ASTRALassert(!leaves.empty());
+  for (unsigned int i = 0; i < leaves.size(); ++i)
+    {
+      const BoundingBox<float> &bb(leaves[i].m_containing_bb);
+
+      m_order[i] = i;
+      m_centers[i] = (bb.empty()) ?
+        vec2(0.0f, 0.0f) :
+        0.5f * (bb.min_point() + bb.max_point());
+    }
+
+  /* allow forking until there is a sub-tree for each thread
+   * of the pool and the thread that waits on the pool
+   */
+  if (m_thread_pool)
+    {
+      for (unsigned int n = 1u, endn = m_thread_pool->number_threads() + 1u; n < endn; n *= 2u)
+        {
+          ++spawn_depth;
+        }
+    }
+
+  build(range_type<unsigned int>(0u, leaves.size()), 0u, 0u, spawn_depth);
+
+  m_sorted_leaves.reserve(leaves.size());
+  for (unsigned int i : m_order)
+    {
+      m_sorted_leaves.push_back(leaves[i]);
+    }
+}
+
+bool
+astral::detail::StrokeDataHierarchy::StaticHierarchy::SAHBuilder::
+split_leaves(range_type<unsigned int> R, const BoundingBox<float> &bb,
+             const BoundingBox<float> &center_bb, unsigned int *out_mid)
+{
+  vecN<vecN<Bin, number_bins>, 2> bins;
+  float best_cost, leaf_cost, bb_area;
+  unsigned int best_coord(2u), best_bin(0u);
+  vec2 scale(0.0f, 0.0f);
+
+  if (R.difference() < min_split_size)
+    {
+      return false;
+    }
+
+  /* the cost of a leaf node is the number of leaves to test;
+   * the cost of a split is node_cost for the node test plus the
+   * expected number of leaves to test where the probability
+   * of hitting a child is the ratio of the half-perimeters.
+   */
+  leaf_cost = static_cast<float>(R.difference());
+  best_cost = leaf_cost;
+  bb_area = half_perimeter(bb);
+
+  for (unsigned int coord = 0; coord < 2; ++coord)
+    {
+      float extent(center_bb.size()[coord]);
+
+      if (extent > 0.0f && bb_area > 0.0f)
+        {
+          scale[coord] = static_cast<float>(number_bins) / extent;
+        }
+    }
+
+  for (unsigned int i = R.m_begin; i < R.m_end; ++i)
+    {
+      unsigned int leaf(m_order[i]);
+
+      for (unsigned int coord = 0; coord < 2; ++coord)
+        {
+          unsigned int b;
+
+          b = compute_bin(leaf, coord, center_bb.min_point()[coord], scale[coord]);
+          bins[coord][b].m_bb.union_box(m_leaves[leaf].m_containing_bb);
+          ++bins[coord][b].m_count;
+        }
+    }
+
+  for (unsigned int coord = 0; coord < 2; ++coord)
+    {
+      vecN<float, number_bins> before_area;
+      vecN<unsigned int, number_bins> before_count;
+      BoundingBox<float> before_bb, after_bb;
+      unsigned int count(0u), after_count(0u);
+
+      if (scale[coord] <= 0.0f)
+        {
+          continue;
+        }
+
+      /* before_area[b] and before_count[b] are for the
+       * bins [0, b], i.e. splitting after bin b
+       */
+      for (unsigned int b = 0; b < number_bins; ++b)
+        {
+          before_bb.union_box(bins[coord][b].m_bb);
+          count += bins[coord][b].m_count;
+          before_area[b] = half_perimeter(before_bb);
+          before_count[b] = count;
+        }
+
+      for (unsigned int b = number_bins - 1u; b > 0u; --b)
+        {
+          float cost;
+
+          after_bb.union_box(bins[coord][b].m_bb);
+          after_count += bins[coord][b].m_count;
+          if (after_count == 0u || before_count[b - 1u] == 0u)
+            {
+              continue;
+            }
+
+          cost = node_cost + (before_area[b - 1u] * static_cast<float>(before_count[b - 1u])
+                         + half_perimeter(after_bb) * static_cast<float>(after_count)) / bb_area;
+          if (cost < best_cost)
+            {
+              best_cost = cost;
+              best_coord = coord;
+              best_bin = b;
+            }
+        }
+    }
+
+  if (best_coord == 2u)
+    {
+      if (R.difference() <= max_leaf_node_size)
+        {
+          return false;
+        }
+
+      /* no split is better than a leaf node, but the leaf node
+       * would be too large; if the centers are all the same
+       * point, split by index, otherwise split at the median
+       * along the longer side of the centers.
+       */
+      *out_mid = R.m_begin + R.difference() / 2u;
+      if (center_bb.size().x() > 0.0f || center_bb.size().y() > 0.0f)
+        {
+          unsigned int coord;
+
+          coord = (center_bb.size().x() >= center_bb.size().y()) ? 0u : 1u;
+          std::nth_element(m_order.begin() + R.m_begin,
+                           m_order.begin() + *out_mid,
+                           m_order.begin() + R.m_end,
+                           [this, coord](unsigned int a, unsigned int b)
+                           {
+                             return m_centers[a][coord] < m_centers[b][coord];
+                           });
+        }
+      return true;
+    }
+
+  std::vector<unsigned int>::iterator iter;
+  float min_value(center_bb.min_point()[best_coord]);
+  float sc(scale[best_coord]);
+
+  iter = std::partition(m_order.begin() + R.m_begin,
+                        m_order.begin() + R.m_end,
+                        [=](unsigned int leaf)
+                        {
+                          return compute_bin(leaf, best_coord, min_value, sc) < best_bin;
+                        });
+  *out_mid = iter - m_order.begin();
+  ASTRALassert(*out_mid > R.m_begin && *out_mid < R.m_end);
+
+  return true;
+}
+
+void
+astral::detail::StrokeDataHierarchy::StaticHierarchy::SAHBuilder::
+build(range_type<unsigned int> R, unsigned int location,
+      unsigned int depth, unsigned int spawn_depth)
+{
+  BoundingBox<float> bb, center_bb;
+  unsigned int mid, node_location;
+
+  ASTRALassert(R.m_begin < R.m_end);
+  node_location = location + 2u * R.difference() - 2u;
+  ASTRALassert(node_location < m_tree.size());
+
+  for (unsigned int i = R.m_begin; i < R.m_end; ++i)
+    {
+      bb.union_box(m_leaves[m_order[i]].m_containing_bb);
+      center_bb.union_point(m_centers[m_order[i]]);
+    }
+
+  TreeNode &tree_node(m_tree[node_location]);
+
+  tree_node.m_range = R;
+  if (depth >= max_depth || !split_leaves(R, bb, center_bb, &mid))
+    {
+      tree_node.m_is_leaf_node = true;
+      return;
+    }
+
+  range_type<unsigned int> R0(R.m_begin, mid), R1(mid, R.m_end);
+  unsigned int location0(location), location1(location + 2u * R0.difference() - 1u);
+
+  tree_node.m_is_leaf_node = false;
+  tree_node.m_children[0] = location0 + 2u * R0.difference() - 2u;
+  tree_node.m_children[1] = location1 + 2u * R1.difference() - 2u;
+
+  if (spawn_depth > 0u && R.difference() >= min_parallel_size)
+    {
+      ThreadPool::Batch batch;
+
+      /* wait() runs the job on this thread if no thread of
+       * the pool has started it, so waiting from within
+       * a job of the pool does not deadlock.
+       */
+      ASTRALassert(m_thread_pool);
+      m_thread_pool->add_job(ASTRALnew BuildJob(*this, R0, location0, depth + 1u, spawn_depth - 1u), batch);
+      build(R1, location1, depth + 1u, spawn_depth - 1u);
+      m_thread_pool->wait(batch);
+    }
+  else
+    {
+      build(R0, location0, depth + 1u, spawn_depth);
+      build(R1, location1, depth + 1u, spawn_depth);
+    }
+}
+
+astral::detail::StrokeDataHierarchy::StaticHierarchy::Node
+astral::detail::StrokeDataHierarchy::StaticHierarchy::
+create_hierarchy(const SAHBuilder &builder, unsigned int tree_node,
+                 unsigned int *id, Ordering *element_ordering)
+{
+  const SAHBuilder::TreeNode &T(builder.tree_node(tree_node));
+
+  if (T.m_is_leaf_node)
+    {
+      return create_node(builder.leaves(T.m_range), id, element_ordering);
+    }
+
+  /* the binary tree is collapsed so that each node has up
+   * to four children, halving the depth of the hierarchy
+   */
+  vecN<unsigned int, 4> child_tree_nodes;
+  unsigned int num_children(0u);
+  std::vector<Node> tmp;
+  range_type<unsigned int> children;
+
+  for (unsigned int c = 0; c < 2; ++c)
+    {
+      const SAHBuilder::TreeNode &C(builder.tree_node(T.m_children[c]));
+
+      if (C.m_is_leaf_node)
+        {
+          child_tree_nodes[num_children++] = T.m_children[c];
+        }
+      else
+        {
+          child_tree_nodes[num_children++] = C.m_children[0];
+          child_tree_nodes[num_children++] = C.m_children[1];
+        }
+    }
+
+  for (unsigned int c = 0; c < num_children; ++c)
+    {
+      tmp.push_back(create_hierarchy(builder, child_tree_nodes[c], id, element_ordering));
+    }
+
+  children.m_begin = m_nodes.size();
+  for (const auto &c : tmp)
+    {
+      m_nodes.push_back(c);
+    }
+  children.m_end = m_nodes.size();
+
+  return Node(*this, Node::node_of_nodes, children, id);
+}
+
+void
+astral::detail::StrokeDataHierarchy::StaticHierarchy::
+create_packets(void)
+{
+  for (Node &node : m_nodes)
+    {
+      unsigned int num_leaves(node.number_child_leaves());
+      unsigned int num_children(num_leaves + node.number_child_nodes());
+
+      node.m_packets_begin = m_packets.size();
+      for (unsigned int i = 0; i < num_children; ++i)
+        {
+          const BoundingBox<float> *bb;
+          uint32_t radius;
+
+          if (i % 4u == 0u)
+            {
+              m_packets.push_back(BoxPacket());
+            }
+
+          if (i < num_leaves)
+            {
+              const Leaf &leaf(static_cast<const Leaf&>(node.child_leaf(i, *this)));
+
+              bb = &leaf.aabb().bb();
+              radius = leaf.aabb().flags();
+              ASTRALassert(radius < BoxPacket::node_radius);
+            }
+          else
+            {
+              const Node &child(static_cast<const Node&>(node.child_node(i - num_leaves, *this)));
+
+              bb = &child.bb();
+              radius = BoxPacket::node_radius;
+            }
+
+          if (!bb->empty())
+            {
+              BoxPacket &packet(m_packets.back());
+
+              packet.m_radius[i % 4u] = radius;
+              packet.m_coords[0][i % 4u] = bb->min_point().x();
+              packet.m_coords[1][i % 4u] = bb->min_point().y();
+              packet.m_coords[2][i % 4u] = bb->max_point().x();
+              packet.m_coords[3][i % 4u] = bb->max_point().y();
+            }
+        }
+    }
+}
+
+void
+astral::detail::StrokeDataHierarchy::StaticHierarchy::
+child_bounding_boxes(const Base &base,
+                     const Transformation &pixel_transformation_logical,
+                     const Transformation &logical_transformation_path,
+                     float t, const StrokeQuery::StrokeRadii &stroke_params,
+                     const QueryRegion *cull_region,
+                     c_array<BoundingBox<float>> out_values) const
+{
+  const Node &node(static_cast<const Node&>(base));
+  SIMDTransformation logical_tr(logical_transformation_path);
+  SIMDTransformation pixel_tr(pixel_transformation_logical);
+  vecN<float, BoxPacket::number_radius_types> radii;
+
+  ASTRALunused(t);
+  ASTRALassert(node.is_node());
+  ASTRALassert(out_values.size() == node.number_child_leaves() + node.number_child_nodes());
+
+  /* the same radii as AABB::compute() and Node::bounding_box() */
+  radii[0] = stroke_params.edge_radius();
+  radii[AABB::join_point] = t_max(radii[0], stroke_params.join_radius());
+  radii[AABB::cap_point] = t_max(radii[0], stroke_params.cap_radius());
+  radii[AABB::join_point | AABB::cap_point] = t_max(radii[AABB::join_point], stroke_params.cap_radius());
+  radii[BoxPacket::node_radius] = stroke_params.max_radius();
+  radii[BoxPacket::no_box] = 0.0f;
+
+  for (unsigned int i = 0, p = node.m_packets_begin; i < out_values.size(); i += 4u, ++p)
+    {
+      const BoxPacket &packet(m_packets[p]);
+      simd_float min_x, min_y, max_x, max_y, r;
+      vecN<vecN<float, 4>, 4> coords;
+      vecN<float, 4> lane_radii;
+      unsigned int missed;
+
+      ASTRALassert(p < m_packets.size());
+      for (unsigned int lane = 0; lane < 4; ++lane)
+        {
+          lane_radii[lane] = radii[packet.m_radius[lane]];
+        }
+
+      min_x = simd_load(packet.m_coords[0].c_ptr());
+      min_y = simd_load(packet.m_coords[1].c_ptr());
+      max_x = simd_load(packet.m_coords[2].c_ptr());
+      max_y = simd_load(packet.m_coords[3].c_ptr());
+      r = simd_load(lane_radii.c_ptr());
+
+      logical_tr.apply_to_boxes(&min_x, &min_y, &max_x, &max_y);
+
+      /* same as BoundingBox::enlarge() */
+      min_x = simd_sub(min_x, r);
+      min_y = simd_sub(min_y, r);
+      max_x = simd_add(max_x, r);
+      max_y = simd_add(max_y, r);
+
+      pixel_tr.apply_to_boxes(&min_x, &min_y, &max_x, &max_y);
+
+      simd_store(coords[0].c_ptr(), min_x);
+      simd_store(coords[1].c_ptr(), min_y);
+      simd_store(coords[2].c_ptr(), max_x);
+      simd_store(coords[3].c_ptr(), max_y);
+
+      missed = 0u;
+      if (cull_region)
+        {
+          simd_float padding(simd_splat(cull_region->m_padding));
+          simd_float scale(simd_splat(cull_region->m_scale));
+          simd_float neg_one(simd_splat(-1.0f));
+
+          /* same as QueryRegion::misses() */
+          min_x = simd_mul(simd_sub(min_x, padding), scale);
+          min_y = simd_mul(simd_sub(min_y, padding), scale);
+          max_x = simd_mul(simd_add(max_x, padding), scale);
+          max_y = simd_mul(simd_add(max_y, padding), scale);
+
+          missed = simd_mask_bits(simd_or(simd_or(simd_le(max_x, neg_one),
+                                             simd_le(max_y, neg_one)),
+                                     simd_or(simd_ge(min_x, simd_splat(cull_region->m_count.x())),
+                                             simd_ge(min_y, simd_splat(cull_region->m_count.y())))));
+        }
+
+      for (unsigned int lane = 0, end_lane = t_min(4u, static_cast<unsigned int>(out_values.size() - i)); lane < end_lane; ++lane)
+        {
+          if (packet.m_radius[lane] == BoxPacket::no_box || (missed & (1u << lane)) != 0u)
+            {
+              out_values[i + lane].clear();
+            }
+          else
+            {
+              out_values[i + lane] = BoundingBox<float>(vec2(coords[0][lane], coords[1][lane]),
+                                                        vec2(coords[2][lane], coords[3][lane]));
+            }
+        }
+    }
+}
+
 astral::reference_counted_ptr<astral::detail::StrokeDataHierarchy>
 astral::detail::StrokeDataHierarchy::StaticHierarchy::
 create(const RawData &input, unsigned int *out_hierarchy_size,
-       Ordering *element_ordering)
+       Ordering *element_ordering, builder_t builder,
+       ThreadPool *thread_pool)
 {
   static const unsigned int max_depth = 8u;
   static const unsigned int split_thresh = 4u;
@@ -570,12 +1270,26 @@ create(const RawData &input, unsigned int *out_hierarchy_size,
   return_value = ASTRALnew StaticHierarchy();
   return_value->m_leaves.reserve(leaves.size());
 
-  Node root(return_value->create_hierarchy(max_depth, split_thresh,
-                                           bb, make_c_array(leaves),
-                                           out_hierarchy_size,
-                                           element_ordering));
-  return_value->m_nodes.push_back(root);
+  if (builder == StrokeShader::sah_hierarchy_builder)
+    {
+      SAHBuilder sah(make_c_array(leaves), thread_pool);
+
+      return_value->m_nodes.reserve(leaves.size());
+      Node root(return_value->create_hierarchy(sah, sah.root(),
+                                               out_hierarchy_size,
+                                               element_ordering));
+      return_value->m_nodes.push_back(root);
+    }
+  else
+    {
+      Node root(return_value->create_hierarchy(max_depth, split_thresh,
+                                               bb, make_c_array(leaves),
+                                               out_hierarchy_size,
+                                               element_ordering));
+      return_value->m_nodes.push_back(root);
+    }
   ASTRALassert(return_value->m_leaves.size() == leaves.size());
+  return_value->create_packets();
 
   return return_value;
 }
@@ -19,6 +19,7 @@
 
 #include <astral/renderer/shader/stroke_shader.hpp>
 #include <astral/renderer/shader/stroke_query.hpp>
+#include <astral/util/thread_pool.hpp>
 
 /* Oversimplified overview of data construction.
  *  1. Create the hierarchy tree for sparse stroking from
@@ -67,6 +68,11 @@ public:
   class StaticHierarchy;
   class AnimatedHierarchy;
 
+  /* How StaticHierarchy::create() places the leaves into
+   * the hierarchy; see StrokeShader::hierarchy_builder_t.
+   */
+  typedef enum StrokeShader::hierarchy_builder_t builder_t;
+
   class Split
   {
   public:
@@ -95,6 +101,58 @@ public:
   virtual
   const Base&
   get_node(unsigned int I) const = 0;
+
+  /* A QueryRegion gives the elementary rects of a StrokeQuery
+   * so that child_bounding_boxes() can cull the boxes that hit
+   * none of them. The test uses the same operations in the
+   * same order as StrokeQuery computes the range of elementary
+   * rects a box hits, so a box is culled exactly when that
+   * range would be empty.
+   */
+  class QueryRegion
+  {
+  public:
+    /* Returns true if the non-empty box bb, in pixel
+     * coordinates, hits none of the elementary rects.
+     */
+    bool
+    misses(const BoundingBox<float> &bb) const
+    {
+      vec2 min_pt(bb.min_point() - vec2(m_padding));
+      vec2 max_pt(bb.max_point() + vec2(m_padding));
+
+      min_pt *= m_scale;
+      max_pt *= m_scale;
+
+      return max_pt.x() <= -1.0f || max_pt.y() <= -1.0f
+        || min_pt.x() >= m_count.x() || min_pt.y() >= m_count.y();
+    }
+
+    /* amount by which to enlarge boxes before the test */
+    float m_padding;
+
+    /* reciprocal of the size of an elementary rect */
+    float m_scale;
+
+    /* number of elementary rects in each dimension */
+    vec2 m_count;
+  };
+
+  /* Computes the values of Base::bounding_box() of each of
+   * the children of a node; the child leaves come first
+   * followed by the child nodes. If cull_region is non-null,
+   * the boxes that miss it are written as empty boxes. The
+   * default implementation calls Base::bounding_box() on each
+   * child and QueryRegion::misses() on each box.
+   */
+  virtual
+  void
+  child_bounding_boxes(const Base &node,
+                       const Transformation &pixel_transformation_logical,
+                       const Transformation &logical_transformation_path,
+                       float t, const StrokeQuery::StrokeRadii &stroke_params,
+                       const QueryRegion *cull_region,
+                       c_array<BoundingBox<float>> out_values) const;
 };
 
 class astral::detail::StrokeDataHierarchy::AABB
@@ -129,6 +187,18 @@ public:
     m_flags = 0u;
   }
 
+  const BoundingBox<float>&
+  bb(void) const
+  {
+    return m_bb;
+  }
+
+  uint32_t
+  flags(void) const
+  {
+    return m_flags;
+  }
+
 private:
   uint32_t m_flags;
   BoundingBox<float> m_bb;
@@ -165,7 +235,8 @@ public:
     m_input(input),
     m_currentR(0),
     m_prevR(0),
-    m_aabb_inited(false)
+    m_aabb_inited(false),
+    m_waiting_flags(0u)
   {}
 
   /* Returns true if the element at info should trigger starting a new leaf;
@@ -361,9 +432,15 @@ class astral::detail::StrokeDataHierarchy::StaticHierarchy:
   public astral::detail::StrokeDataHierarchy
 {
 public:
+  /* If thread_pool is non-null and builder is StrokeShader::sah_hierarchy_builder,
+   * large sub-trees are built by jobs added to thread_pool;
+   * create() returns only once all of those jobs finish.
+   */
   static
   reference_counted_ptr<StrokeDataHierarchy>
-  create(const RawData &input, unsigned int *out_hierarchy_size, Ordering *out_element_ordering);
+  create(const RawData &input, unsigned int *out_hierarchy_size, Ordering *out_element_ordering,
+         builder_t builder = StrokeShader::midpoint_hierarchy_builder,
+         ThreadPool *thread_pool = nullptr);
 
   virtual
   const Base&
@@ -388,7 +465,47 @@ public:
     return m_nodes[I];
   }
 
+  virtual
+  void
+  child_bounding_boxes(const Base &node,
+                       const Transformation &pixel_transformation_logical,
+                       const Transformation &logical_transformation_path,
+                       float t, const StrokeQuery::StrokeRadii &stroke_params,
+                       const QueryRegion *cull_region,
+                       c_array<BoundingBox<float>> out_values) const override final;
+
 private:
+  /* The boxes, in path coordinates, of the children of a Node
+   * are stored four at a time as structure of arrays so that
+   * child_bounding_boxes() computes and culls the bounding
+   * boxes of four children at once with SIMD instructions.
+   */
+  class BoxPacket
+  {
+  public:
+    enum
+      {
+        /* values [0, node_radius) are the AABB::flags() of a leaf */
+        node_radius = 4u,
+
+        /* the lane does not hold a box or the box is empty */
+        no_box,
+
+        number_radius_types
+      };
+
+    BoxPacket(void):
+      m_coords(vecN<float, 4>(0.0f)),
+      m_radius(no_box)
+    {}
+
+    /* the min-x, min-y, max-x and max-y of each of the boxes */
+    vecN<vecN<float, 4>, 4> m_coords;
+
+    /* the radius by which to enlarge each of the boxes */
+    vecN<uint32_t, 4> m_radius;
+  };
+
   class Leaf:public Base
   {
   public:
@@ -411,6 +528,12 @@ private:
                            stroke_params);
     }
 
+    const AABB&
+    aabb(void) const
+    {
+      return m_aabb;
+    }
+
   private:
     AABB m_aabb;
   };
@@ -423,7 +546,8 @@ private:
          enum node_type_t node_type,
          range_type<unsigned int> child_range,
          unsigned int *id):
-      Base(src, node_type, child_range, id)
+      Base(src, node_type, child_range, id),
+      m_packets_begin(0u)
     {
       StrokeQuery::StrokeRadii S;
       Transformation tr;
@@ -461,10 +585,26 @@ private:
       return return_value;
     }
 
+    const BoundingBox<float>&
+    bb(void) const
+    {
+      return m_bb;
+    }
+
+    /* index into StaticHierarchy::m_packets of the
+     * first BoxPacket of the children of the node
+     */
+    unsigned int m_packets_begin;
+
   private:
     BoundingBox<float> m_bb;
   };
 
+  void
+  create_packets(void);
+
+  class SAHBuilder;
+
   static
   void
   compute_split(unsigned int coord, const BoundingBox<float> &bb,
@@ -480,8 +620,18 @@ private:
                    const BoundingBox<float> &bb, c_array<const StaticLeafData> leaf_data,
                    unsigned int *id, Ordering *element_ordering);
 
+  /* Create the Node and Leaf objects of the tree built by an
+   * SAHBuilder; the tree is walked depth first so that the
+   * nodes and leaves are placed into m_nodes and m_leaves in
+   * the same order as create_hierarchy() places them.
+   */
+  Node
+  create_hierarchy(const SAHBuilder &builder, unsigned int tree_node,
+                   unsigned int *id, Ordering *element_ordering);
+
   std::vector<Leaf> m_leaves;
   std::vector<Node> m_nodes;
+  std::vector<BoxPacket> m_packets;
 };
 
 class astral::detail::StrokeDataHierarchy::AnimatedHierarchy:
@@ -316,6 +316,7 @@ add_sources_lit_leaf(StrokeQuery::Implement &caller,
   vecN<range_type<int>, 2> R;
 
   ASTRALassert(m_query_result);
+  caller.count_visit(base);
   bb_idx = q.m_box_location + base.id();
 
   ASTRALassert(bb_idx < caller.m_workroom_boxes.size());
@@ -398,7 +399,11 @@ add_sources(StrokeQuery::Implement &caller,
 // astral::StrokeQuery::Implement methods
 astral::StrokeQuery::Implement::
 Implement(void):
-  m_mode(mode_no_query)
+  m_mode(mode_no_query),
+  m_number_nodes_visited(0u),
+  m_number_leaves_visited(0u),
+  m_child_culling(detail::StrokeQueryCullingTest::child_culling_simd),
+  m_number_child_culling_mismatches(0u)
 {
   m_pool = ASTRALnew RectHierarchyPool();
 }
@@ -428,6 +433,9 @@ clear_implement(void)
   m_empty_tiles.clear();
   m_rect_hierarchy = nullptr;
   m_mode = mode_no_query;
+  m_number_nodes_visited = 0u;
+  m_number_leaves_visited = 0u;
+  m_number_child_culling_mismatches = 0u;
 }
 
 void
@@ -485,6 +493,10 @@ begin_query_implement(const ScaleTranslate &rect_transformation_elements,
    */
   m_reciprocal_elementary_rect_size = 1.0f / static_cast<float>(ImageAtlas::tile_size_without_padding);
 
+  m_cull_region.m_padding = ImageAtlas::tile_padding;
+  m_cull_region.m_scale = m_reciprocal_elementary_rect_size;
+  m_cull_region.m_count = vec2(m_number_elementary_rects);
+
   ASTRALassert(m_elementary_rects_is_lit.empty());
   if (restrict_rects.empty())
     {
@@ -579,26 +591,28 @@ add_element_implement(unsigned int client_id,
   query_element.m_rect_transformation_stroking = &rect_transformation_stroking;
   query_element.m_stroking_transformation_path = &stroking_transformation_path;
 
-  light_elementary_rects_of_query_element(m_query_elements.back().m_hierarchy->root(),
-                                          query_element);
+  const detail::StrokeDataHierarchy::Base &root(m_query_elements.back().m_hierarchy->root());
+  BoundingBox<float> root_bb;
+
+  root_bb = root.bounding_box(rect_transformation_stroking, stroking_transformation_path,
+                              animation_t, stroke_radii);
+  light_elementary_rects_of_query_element(root, root_bb, query_element);
 }
 
 void
 astral::StrokeQuery::Implement::
 light_elementary_rects_of_query_element(const detail::StrokeDataHierarchy::Base &base,
+                                        BoundingBox<float> bb,
                                         const QueryElementDetailed &q)
 {
   /* compute the range of rects that the bounding box
    * the hierarchy hits
    */
   unsigned int bb_idx;
-  BoundingBox<float> bb;
   const detail::StrokeDataHierarchy &hierarchy(*q.m_hierarchy);
 
+  count_visit(base);
   bb_idx = q.m_box_location + base.id();
-  bb = base.bounding_box(*q.m_rect_transformation_stroking,
-                         *q.m_stroking_transformation_path,
-                         q.m_animation_t, q.m_stroke_radii);
 
   ASTRALassert(bb_idx < m_workroom_boxes.size());
 
@@ -644,15 +658,98 @@ light_elementary_rects_of_query_element(const detail::StrokeDataHierarchy::Base
     }
   else
     {
-      /* otherwise recurse to the children */
-      for (unsigned int leaf = 0, num_leaves = base.number_child_leaves(); leaf < num_leaves; ++leaf)
+      /* otherwise recurse to the children; the bounding boxes of
+       * the children are computed together so that the hierarchy
+       * can compute them and reject those that miss the query
+       * several at a time; a rejected box is empty and so takes
+       * the early return above. The recursion also uses
+       * m_workroom_child_bbs, which is why the boxes are accessed
+       * by index and passed by value.
+       */
+      unsigned int num_leaves(base.number_child_leaves());
+      unsigned int num_children(num_leaves + base.number_child_nodes());
+      unsigned int child_bbs_begin(m_workroom_child_bbs.size());
+
+      m_workroom_child_bbs.resize(child_bbs_begin + num_children);
+      child_bounding_boxes(base, q, make_c_array(m_workroom_child_bbs).sub_array(child_bbs_begin, num_children));
+
+      for (unsigned int leaf = 0; leaf < num_leaves; ++leaf)
         {
-          light_elementary_rects_of_query_element(base.child_leaf(leaf, hierarchy), q);
+          light_elementary_rects_of_query_element(base.child_leaf(leaf, hierarchy),
+                                                  m_workroom_child_bbs[child_bbs_begin + leaf],
+                                                  q);
         }
 
-      for (unsigned int node = 0, num_nodes = base.number_child_nodes(); node < num_nodes; ++node)
+      for (unsigned int node = 0; node < num_children - num_leaves; ++node)
         {
-          light_elementary_rects_of_query_element(base.child_node(node, hierarchy), q);
+          light_elementary_rects_of_query_element(base.child_node(node, hierarchy),
+                                                  m_workroom_child_bbs[child_bbs_begin + num_leaves + node],
+                                                  q);
+        }
+      m_workroom_child_bbs.resize(child_bbs_begin);
+    }
+}
+
+void
+astral::StrokeQuery::Implement::
+child_bounding_boxes(const detail::StrokeDataHierarchy::Base &base,
+                     const QueryElementDetailed &q,
+                     c_array<BoundingBox<float>> out_values)
+{
+  const detail::StrokeDataHierarchy &hierarchy(*q.m_hierarchy);
+
+  if (m_child_culling == detail::StrokeQueryCullingTest::child_culling_scalar)
+    {
+      /* the boxes one at a time without culling */
+      hierarchy.detail::StrokeDataHierarchy::child_bounding_boxes(base,
+                                                                  *q.m_rect_transformation_stroking,
+                                                                  *q.m_stroking_transformation_path,
+                                                                  q.m_animation_t, q.m_stroke_radii,
+                                                                  nullptr, out_values);
+      return;
+    }
+
+  hierarchy.child_bounding_boxes(base,
+                                 *q.m_rect_transformation_stroking,
+                                 *q.m_stroking_transformation_path,
+                                 q.m_animation_t, q.m_stroke_radii,
+                                 &m_cull_region, out_values);
+
+  if (m_child_culling == detail::StrokeQueryCullingTest::child_culling_checked)
+    {
+      c_array<BoundingBox<float>> scalar_values;
+
+      m_workroom_checked_bbs.resize(out_values.size());
+      scalar_values = make_c_array(m_workroom_checked_bbs);
+      hierarchy.detail::StrokeDataHierarchy::child_bounding_boxes(base,
+                                                                  *q.m_rect_transformation_stroking,
+                                                                  *q.m_stroking_transformation_path,
+                                                                  q.m_animation_t, q.m_stroke_radii,
+                                                                  nullptr, scalar_values);
+
+      for (unsigned int i = 0; i < out_values.size(); ++i)
+        {
+          const BoundingBox<float> &simd_bb(out_values[i]);
+          const BoundingBox<float> &scalar_bb(scalar_values[i]);
+          bool matches;
+
+          if (simd_bb.empty())
+            {
+              /* either both are empty or the box misses the query */
+              matches = scalar_bb.empty() || m_cull_region.misses(scalar_bb);
+            }
+          else
+            {
+              matches = !scalar_bb.empty()
+                && !m_cull_region.misses(scalar_bb)
+                && simd_bb.min_point() == scalar_bb.min_point()
+                && simd_bb.max_point() == scalar_bb.max_point();
+            }
+
+          if (!matches)
+            {
+              ++m_number_child_culling_mismatches;
+            }
         }
     }
 }
@@ -840,9 +937,39 @@ number_elementary_rects(void) const
   return implement().number_elementary_rects_implement();
 }
 
+unsigned int
+astral::StrokeQuery::
+number_nodes_visited(void) const
+{
+  return implement().number_nodes_visited_implement();
+}
+
+unsigned int
+astral::StrokeQuery::
+number_leaves_visited(void) const
+{
+  return implement().number_leaves_visited_implement();
+}
+
 void
 astral::StrokeQuery::
 clear(void)
 {
   implement().clear_implement();
 }
+
+////////////////////////////////////////////////
+// astral::detail::StrokeQueryCullingTest methods
+void
+astral::detail::StrokeQueryCullingTest::
+child_culling(StrokeQuery &query, enum child_culling_t v)
+{
+  query.implement().m_child_culling = v;
+}
+
+unsigned int
+astral::detail::StrokeQueryCullingTest::
+number_child_culling_mismatches(const StrokeQuery &query)
+{
+  return query.implement().number_child_culling_mismatches_implement();
+}
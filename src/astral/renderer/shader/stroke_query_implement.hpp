@@ -79,11 +79,30 @@ public:
     return m_number_elementary_rects;
   }
 
+  unsigned int
+  number_nodes_visited_implement(void) const
+  {
+    return m_number_nodes_visited;
+  }
+
+  unsigned int
+  number_leaves_visited_implement(void) const
+  {
+    return m_number_leaves_visited;
+  }
+
+  unsigned int
+  number_child_culling_mismatches_implement(void) const
+  {
+    return m_number_child_culling_mismatches;
+  }
+
   void
   clear_implement(void);
 
 private:
   friend class StrokeQuery;
+  friend class detail::StrokeQueryCullingTest;
 
   class QueryElement;
   class QueryElementDetailed;
@@ -108,9 +127,14 @@ private:
   /* Computes the bounding boxes of the elements hit
    * lights what boxes that are hit; to be called on
    * each element of the query
+   * \param base element of the hierarchy
+   * \param bb value of base.bounding_box() for the query, passed
+   *           by value since it may be from m_workroom_child_bbs
+   * \param q query element
    */
   void
   light_elementary_rects_of_query_element(const detail::StrokeDataHierarchy::Base &base,
+                                          BoundingBox<float> bb,
                                           const QueryElementDetailed &q);
 
   /* Creates a rect-heirarchy whose leaves are merged
@@ -157,6 +181,27 @@ private:
   void
   mark_rects_as_unlit(c_array<const BoundingBox<float>> restrict_rects);
 
+  /* Computes the bounding boxes of the children of a node
+   * as specified by m_child_culling.
+   */
+  void
+  child_bounding_boxes(const detail::StrokeDataHierarchy::Base &base,
+                       const QueryElementDetailed &q,
+                       c_array<BoundingBox<float>> out_values);
+
+  void
+  count_visit(const detail::StrokeDataHierarchy::Base &base)
+  {
+    if (base.is_node())
+      {
+        ++m_number_nodes_visited;
+      }
+    else
+      {
+        ++m_number_leaves_visited;
+      }
+  }
+
   enum mode_t m_mode;
   Transformation m_rect_transformation_elements;
   bool m_sparse_query;
@@ -225,6 +270,14 @@ private:
   /* work room to cache the bounding box values */
   std::vector<vecN<range_type<int>, 2>> m_workroom_boxes;
 
+  /* work room used as a stack by light_elementary_rects_of_query_element()
+   * for the bounding boxes of the children of the node being visited
+   */
+  std::vector<BoundingBox<float>> m_workroom_child_bbs;
+
+  /* work room for the scalar values of child_culling_checked */
+  std::vector<BoundingBox<float>> m_workroom_checked_bbs;
+
   /* backing for Source array values to avoid malloc/free noise */
   ObjectPoolClear<std::vector<Source>> m_query_src_pool;
 
@@ -233,6 +286,22 @@ private:
 
   /* pool for rect-hierarchy objects, needed for phase 2 */
   RectHierarchyPool *m_pool;
+
+  /* number of nodes and leaves of the hierarchies visited
+   * in phases 1 and 3 since the last clear()
+   */
+  unsigned int m_number_nodes_visited, m_number_leaves_visited;
+
+  /* how child bounding boxes are computed and culled */
+  enum detail::StrokeQueryCullingTest::child_culling_t m_child_culling;
+
+  /* region of the elementary rects of the query for culling */
+  detail::StrokeDataHierarchy::QueryRegion m_cull_region;
+
+  /* number of mismatches found by child_culling_checked
+   * since the last clear()
+   */
+  unsigned int m_number_child_culling_mismatches;
 };
 
 class astral::StrokeQuery::Implement::QueryElement
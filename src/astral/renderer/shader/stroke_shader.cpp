@@ -1699,7 +1699,8 @@ create_render_data(RenderEngine &engine, const RawData &input, SimpleCookedData
 
 void
 astral::StrokeShader::
-create_render_data(RenderEngine &engine, const RawData &input, CookedData *output)
+create_render_data(RenderEngine &engine, const RawData &input, CookedData *output,
+                   enum hierarchy_builder_t builder, ThreadPool *thread_pool)
 {
   Ordering ordering;
   unsigned int h_sz;
@@ -1710,7 +1711,7 @@ create_render_data(RenderEngine &engine, const RawData &input, CookedData *outpu
   output->m_base.m_inner_glue_offset = 0u;
 
   /* first create the hierarchy */
-  h = detail::StrokeDataHierarchy::StaticHierarchy::create(input, &h_sz, &ordering);
+  h = detail::StrokeDataHierarchy::StaticHierarchy::create(input, &h_sz, &ordering, builder, thread_pool);
 
   /* feed the reordered data into the data builders */
   create_static_render_data(engine, input, &ordering, &output->m_base);
@@ -52,6 +52,12 @@ public:
     --m_number_alive;
   }
 
+  int
+  number_alive(void) const
+  {
+    return m_number_alive;
+  }
+
 private:
   int m_number_alive;
   astral::MemoryPool<ShadowMap, 512> m_pool;
@@ -64,7 +70,12 @@ ShadowMapAtlas(ShadowMapAtlasBacking &backing):
   m_backing(&backing),
   m_interval_allocator(backing.width(), backing.height() >> 2u),
   m_resources_locked(0),
-  m_resources_unlock_count(0u)
+  m_resources_unlock_count(0u),
+  m_initial_height(backing.height()),
+  m_shrink_after_idle_frames(0u),
+  m_idle_frames(0u),
+  m_dimensions_used(0u),
+  m_total_rows_reclaimed(0u)
 {
   ASTRALassert((backing.height() & 3u) == 0u);
   m_pool = ASTRALnew MemoryPool();
@@ -100,7 +111,72 @@ unlock_resources(void)
           m_interval_allocator.release(p);
         }
       m_delayed_frees.clear();
+      shrink_if_idle();
+    }
+}
+
+void
+astral::ShadowMapAtlas::
+shrink_if_idle(void)
+{
+  unsigned int N, needed_layers, min_layers;
+
+  if (m_shrink_after_idle_frames == 0u)
+    {
+      return;
+    }
+
+  /* find the number of layers needed to hold all
+   * alive shadow maps, i.e. one more than the last
+   * layer with an allocation on it
+   */
+  N = m_interval_allocator.number_layers();
+  for (needed_layers = N; needed_layers > 0u && m_interval_allocator.number_allocated(needed_layers - 1u) == 0u; --needed_layers)
+    {}
+
+  min_layers = m_initial_height >> 2u;
+  needed_layers = t_max(needed_layers, min_layers);
+
+  if (needed_layers >= N)
+    {
+      m_idle_frames = 0u;
+      return;
     }
+
+  ++m_idle_frames;
+  if (m_idle_frames < m_shrink_after_idle_frames)
+    {
+      return;
+    }
+
+  /* the backing may choose a larger height than requested */
+  m_idle_frames = 0u;
+  needed_layers = t_min(N, m_backing->height(needed_layers << 2u) >> 2u);
+  if (needed_layers < N)
+    {
+      m_interval_allocator.number_layers(needed_layers);
+      m_total_rows_reclaimed += (N - needed_layers) << 2u;
+    }
+  m_render_target = m_backing->render_target();
+}
+
+unsigned int
+astral::ShadowMapAtlas::
+number_shadow_maps(void) const
+{
+  return m_pool->number_alive();
+}
+
+unsigned int
+astral::ShadowMapAtlas::
+size_class(unsigned int D) const
+{
+  /* smallest size class */
+  const unsigned int min_size_class = 16u;
+  unsigned int return_value;
+
+  return_value = t_max(min_size_class, next_power_of_2(D));
+  return t_min(return_value, static_cast<unsigned int>(m_interval_allocator.layer_length()));
 }
 
 const astral::IntervalAllocator::Interval*
@@ -109,6 +185,9 @@ allocate_interval(unsigned int length)
 {
   const IntervalAllocator::Interval *p;
 
+  ASTRALassert(length <= static_cast<unsigned int>(m_interval_allocator.layer_length()));
+  length = size_class(length);
+
   p = m_interval_allocator.allocate(length);
   if (!p)
     {
@@ -160,6 +239,7 @@ create(int D, const vec2 &light_position)
   p->m_in_use_marker = 0u;
   p->m_dimensions = D;
   p->m_offscreen_render_index = InvalidRenderValue;
+  m_dimensions_used += D;
   p->m_shadow_map_id = allocate_shadow_map_id(p);
 
   p->m_interval = allocate_interval(D);
@@ -271,6 +351,8 @@ delete_object(ShadowMap *p)
   reference_counted_ptr<ShadowMapAtlas> atlas;
 
   atlas.swap(p->m_atlas);
+  ASTRALassert(atlas->m_dimensions_used >= p->m_dimensions);
+  atlas->m_dimensions_used -= p->m_dimensions;
   atlas->release(p->m_interval);
   atlas->free_shadow_map_id(p);
   atlas->m_pool->reclaim(p);
@@ -0,0 +1,423 @@
+/*!
+ * \file serialized_data.hpp
+ * \brief file serialized_data.hpp
+ *
+ * Copyright 2019 by InvisionApp.
+ *
+ * Contact: kevinrogovin@invisionapp.com
+ *
+ * This Source Code Form is subject to the
+ * terms of the Mozilla Public License, v. 2.0.
+ * If a copy of the MPL was not distributed with
+ * this file, You can obtain one at
+ * http://mozilla.org/MPL/2.0/.
+ *
+ */
+
+#ifndef ASTRAL_SERIALIZED_DATA_HPP
+#define ASTRAL_SERIALIZED_DATA_HPP
+
+#include <vector>
+#include <cstring>
+#include <type_traits>
+#include <astral/util/util.hpp>
+#include <astral/util/c_array.hpp>
+#include <astral/util/bounding_box.hpp>
+#include <astral/contour_curve.hpp>
+#include "contour_approximator.hpp"
+
+namespace astral
+{
+  namespace detail
+  {
+    /* The serialized format of Path and AnimatedPath is a single
+     * buffer of records; a record refers to another record or to an
+     * array by its byte offset from the start of the buffer. Every
+     * record and array starts at an offset that is a multiple of
+     * serialized_alignment and the arrays of ContourCurve values are
+     * stored in the in-memory layout of ContourCurve. Thus when the
+     * buffer is itself aligned, e.g. memory mapped from a file, an
+     * array is viewed in place by SerializedReader::read_array() and
+     * is validated and then copied in one bulk assign into the
+     * object being read (for example by ContourData::deserialize_data()
+     * and ItemPath::deserialize()) instead of being parsed element by
+     * element; the loaded objects do not refer to the buffer, so it
+     * can be released once reading is done.
+     *
+     * The format is native endian; SerializedHeader::m_byte_order
+     * and SerializedHeader::m_curve_size are checked on reading to
+     * reject a buffer written by an incompatible build.
+     */
+    enum
+      {
+        serialized_alignment = 8u,
+
+        /* increment whenever any of the records below changes */
+        serialized_version = 1u,
+
+        serialized_byte_order = 0x01020304u,
+
+        /* "ASTP", "ASTA" and "ASTG" */
+        serialized_path_magic = 0x50545341u,
+        serialized_animated_path_magic = 0x41545341u,
+        serialized_glyph_cache_magic = 0x47545341u,
+
+        /* number of LOD chains of a Contour that are serialized:
+         * one for each contour_fill_approximation_t, then stroking
+         * and then the approximations used by ItemPath; the index
+         * of the chain is also the bit in contour_prepare_bits.
+         */
+        serialized_stroke_lod = number_contour_fill_approximation,
+        serialized_item_path_lod,
+        serialized_number_lods
+      };
+
+    static_assert(std::is_trivially_copyable<ContourCurve>::value,
+                  "ContourCurve must be trivially copyable to be serialized");
+    static_assert(std::is_trivially_copyable<ContourApproximator::SourceTag>::value,
+                  "ContourApproximator::SourceTag must be trivially copyable to be serialized");
+    static_assert(std::is_trivially_copyable<gvec4>::value,
+                  "gvec4 must be trivially copyable to be serialized");
+
+    class SerializedBoundingBox
+    {
+    public:
+      void
+      set(const BoundingBox<float> &bb)
+      {
+        m_empty = bb.empty() ? 1u : 0u;
+        m_pts[0] = m_pts[1] = m_pts[2] = m_pts[3] = 0.0f;
+        if (!bb.empty())
+          {
+            m_pts[0] = bb.min_point().x();
+            m_pts[1] = bb.min_point().y();
+            m_pts[2] = bb.max_point().x();
+            m_pts[3] = bb.max_point().y();
+          }
+      }
+
+      BoundingBox<float>
+      get(void) const
+      {
+        BoundingBox<float> return_value;
+
+        if (!m_empty)
+          {
+            return_value.union_point(vec2(m_pts[0], m_pts[1]));
+            return_value.union_point(vec2(m_pts[2], m_pts[3]));
+          }
+        return return_value;
+      }
+
+      /* min-x, min-y, max-x, max-y */
+      float m_pts[4];
+      uint32_t m_empty, m_padding;
+    };
+
+    class SerializedHeader
+    {
+    public:
+      uint32_t m_magic, m_version, m_byte_order, m_curve_size;
+      uint64_t m_size;
+
+      /* offset to an array of uint64_t of the offsets
+       * of the records of the contours
+       */
+      uint64_t m_contours;
+      uint32_t m_number_contours;
+
+      /* flags of the Path or AnimatedPath */
+      uint32_t m_flags;
+
+      /* offset to an array of SerializedItemPath, sorted
+       * in order of decreasing error
+       */
+      uint64_t m_item_paths;
+      uint32_t m_number_item_paths, m_padding;
+    };
+
+    class SerializedContourData
+    {
+    public:
+      enum
+        {
+          closed_flag = 1u,
+          sanitized_flag = 2u,
+          santize_curves_on_adding_flag = 4u,
+        };
+
+      /* offset to an array of ContourCurve */
+      uint64_t m_curves;
+      uint32_t m_number_curves, m_flags;
+      float m_start_pt[2], m_last_end_pt[2];
+      SerializedBoundingBox m_bb, m_join_bb, m_control_point_bb;
+    };
+
+    /* one element of a LOD chain of a Contour */
+    class SerializedLOD
+    {
+    public:
+      /* offsets to an array of ContourCurve and to an array
+       * of ContourApproximator::SourceTag, both of size
+       * m_number_curves
+       */
+      uint64_t m_curves, m_tags;
+      uint32_t m_number_curves;
+      float m_error;
+    };
+
+    class SerializedContour
+    {
+    public:
+      SerializedContourData m_data;
+
+      /* offset to an array of SerializedLOD, sorted in order
+       * of decreasing error, for each LOD chain
+       */
+      uint64_t m_lods[serialized_number_lods];
+      uint32_t m_number_lods[serialized_number_lods];
+    };
+
+    class SerializedAnimatedContour
+    {
+    public:
+      SerializedContourData m_start, m_end;
+    };
+
+    class SerializedItemPath
+    {
+    public:
+      /* offsets to the arrays of the header (gvec4) and
+       * band data (vec4) of the ItemPath
+       */
+      uint64_t m_header_data, m_band_data;
+      uint32_t m_header_size, m_band_size;
+      float m_error;
+      uint32_t m_number_bands[2];
+      float m_average_render_cost[2];
+      SerializedBoundingBox m_bb;
+      float m_tr_translate[2], m_tr_scale[2];
+      float m_params_cost;
+      uint32_t m_params_max_recursion;
+    };
+
+    /* The on-disk glyph cache of a Typeface is a single buffer
+     * starting with a SerializedGlyphCacheHeader; each glyph
+     * present is a self-contained buffer starting with a
+     * SerializedGlyph whose offsets are relative to the start
+     * of the glyph's buffer.
+     */
+    class SerializedGlyphCacheHeader
+    {
+    public:
+      uint32_t m_magic, m_version, m_byte_order, m_curve_size;
+      uint64_t m_size;
+
+      /* offset to the characters of the cache key of the
+       * GlyphGenerator of the Typeface
+       */
+      uint64_t m_key;
+      uint32_t m_key_size;
+
+      /* number of glyphs of the Typeface */
+      uint32_t m_number_glyphs;
+
+      /* offset to an array of m_number_glyphs SerializedGlyphLocation */
+      uint64_t m_glyphs;
+
+      /* ItemPath::GenerationParams of the Typeface */
+      float m_params_cost;
+      uint32_t m_params_max_recursion;
+    };
+
+    class SerializedGlyphLocation
+    {
+    public:
+      /* offset and size of the buffer of the glyph,
+       * a size of zero indicates the glyph is not
+       * present
+       */
+      uint64_t m_offset, m_size;
+    };
+
+    class SerializedGlyph
+    {
+    public:
+      /* GlyphMetrics of the glyph */
+      float m_horizontal_layout_offset[2], m_vertical_layout_offset[2];
+      float m_size[2], m_advance[2];
+      SerializedBoundingBox m_bb;
+
+      /* offset to the buffer written by Path::serialize() */
+      uint64_t m_path;
+      uint32_t m_path_size;
+
+      /* value of the enum fill_rule_t of the glyph */
+      uint32_t m_fill_rule;
+
+      SerializedItemPath m_item_path;
+    };
+
+    static_assert(sizeof(SerializedHeader) % serialized_alignment == 0, "Bad SerializedHeader size");
+    static_assert(sizeof(SerializedGlyphCacheHeader) % serialized_alignment == 0, "Bad SerializedGlyphCacheHeader size");
+    static_assert(sizeof(SerializedGlyphLocation) % serialized_alignment == 0, "Bad SerializedGlyphLocation size");
+    static_assert(sizeof(SerializedGlyph) % serialized_alignment == 0, "Bad SerializedGlyph size");
+    static_assert(sizeof(SerializedContourData) % serialized_alignment == 0, "Bad SerializedContourData size");
+    static_assert(sizeof(SerializedLOD) % serialized_alignment == 0, "Bad SerializedLOD size");
+    static_assert(sizeof(SerializedContour) % serialized_alignment == 0, "Bad SerializedContour size");
+    static_assert(sizeof(SerializedAnimatedContour) % serialized_alignment == 0, "Bad SerializedAnimatedContour size");
+    static_assert(sizeof(SerializedItemPath) % serialized_alignment == 0, "Bad SerializedItemPath size");
+
+    /* A SerializedWriter appends records and arrays to a
+     * std::vector<uint8_t>; because the vector may reallocate,
+     * records are referred to by their offsets.
+     */
+    class SerializedWriter
+    {
+    public:
+      /* clears dst */
+      explicit
+      SerializedWriter(std::vector<uint8_t> *dst):
+        m_dst(dst)
+      {
+        m_dst->clear();
+      }
+
+      /* Allocate zero-filled room for count values of type T
+       * and return the offset to the room
+       */
+      template<typename T>
+      uint64_t
+      allocate(unsigned int count = 1u)
+      {
+        uint64_t return_value;
+
+        return_value = m_dst->size();
+        return_value += (serialized_alignment - return_value % serialized_alignment) % serialized_alignment;
+        m_dst->resize(return_value + count * sizeof(T), 0u);
+
+        return return_value;
+      }
+
+      template<typename T>
+      void
+      write(uint64_t offset, const T &value)
+      {
+        ASTRALassert(offset + sizeof(T) <= m_dst->size());
+        std::memcpy(m_dst->data() + offset, &value, sizeof(T));
+      }
+
+      template<typename T>
+      void
+      write(uint64_t offset, unsigned int index, const T &value)
+      {
+        write(offset + index * sizeof(T), value);
+      }
+
+      /* Append an array and return the offset to it */
+      template<typename T>
+      uint64_t
+      write_array(c_array<T> values)
+      {
+        uint64_t return_value;
+
+        return_value = allocate<T>(values.size());
+        if (!values.empty())
+          {
+            std::memcpy(m_dst->data() + return_value, values.c_ptr(), values.size() * sizeof(T));
+          }
+
+        return return_value;
+      }
+
+      uint64_t
+      size(void) const
+      {
+        return m_dst->size();
+      }
+
+    private:
+      std::vector<uint8_t> *m_dst;
+    };
+
+    /* A SerializedReader reads records and arrays from a
+     * buffer with bounds and alignment checking.
+     */
+    class SerializedReader
+    {
+    public:
+      explicit
+      SerializedReader(c_array<const uint8_t> src):
+        m_src(src)
+      {}
+
+      template<typename T>
+      bool
+      read(uint64_t offset, T *out_value) const
+      {
+        if (!in_bounds(offset, 1u, sizeof(T)))
+          {
+            return false;
+          }
+
+        std::memcpy(out_value, m_src.c_ptr() + offset, sizeof(T));
+        return true;
+      }
+
+      template<typename T>
+      bool
+      read(uint64_t offset, unsigned int index, T *out_value) const
+      {
+        return read(offset + uint64_t(index) * sizeof(T), out_value);
+      }
+
+      /* Returns, without copying, an array of the buffer; fails
+       * if the array is not aligned in memory for the type T.
+       */
+      template<typename T>
+      bool
+      read_array(uint64_t offset, uint32_t count, c_array<const T> *out_values) const
+      {
+        const uint8_t *p;
+
+        if (count == 0u)
+          {
+            *out_values = c_array<const T>();
+            return true;
+          }
+
+        if (!in_bounds(offset, count, sizeof(T)))
+          {
+            return false;
+          }
+
+        p = m_src.c_ptr() + offset;
+        if (reinterpret_cast<uintptr_t>(p) % alignof(T) != 0u)
+          {
+            return false;
+          }
+
+        *out_values = c_array<const T>(reinterpret_cast<const T*>(p), count);
+        return true;
+      }
+
+      uint64_t
+      size(void) const
+      {
+        return m_src.size();
+      }
+
+    private:
+      bool
+      in_bounds(uint64_t offset, uint64_t count, uint64_t element_size) const
+      {
+        return offset <= m_src.size()
+          && count <= (m_src.size() - offset) / element_size;
+      }
+
+      c_array<const uint8_t> m_src;
+    };
+  }
+}
+
+#endif
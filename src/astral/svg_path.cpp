@@ -0,0 +1,894 @@
+/*!
+ * \file svg_path.cpp
+ * \brief file svg_path.cpp
+ *
+ * Copyright 2019 by InvisionApp.
+ *
+ * Contact: kevinrogovin@invisionapp.com
+ *
+ * This Source Code Form is subject to the
+ * terms of the Mozilla Public License, v. 2.0.
+ * If a copy of the MPL was not distributed with
+ * this file, You can obtain one at
+ * http://mozilla.org/MPL/2.0/.
+ *
+ */
+
+#include <cstring>
+#include <cmath>
+#include <astral/util/math.hpp>
+#include <astral/svg_path.hpp>
+
+namespace
+{
+  /* Reads the tokens of SVG path data and of SVG points lists,
+   * the grammar is from the SVG 1.1 specification, section 8.3.9
+   * and section 9.7.1. Numbers are read directly from the
+   * characters rather than with strtod(), which depends on the
+   * locale and does not allow the SVG short hand of "1.5.5"
+   * for the two numbers 1.5 and 0.5.
+   */
+  class Tokenizer
+  {
+  public:
+    Tokenizer(const char *begin, const char *end):
+      m_p(begin),
+      m_end(end)
+    {}
+
+    bool
+    at_end(void) const
+    {
+      return m_p == m_end;
+    }
+
+    char
+    peek(void) const
+    {
+      ASTRALassert(!at_end());
+      return *m_p;
+    }
+
+    void
+    advance(void)
+    {
+      ASTRALassert(!at_end());
+      ++m_p;
+    }
+
+    void
+    skip_wsp(void)
+    {
+      while (m_p < m_end && is_wsp(*m_p))
+        {
+          ++m_p;
+        }
+    }
+
+    /* skip white space with at most one comma */
+    void
+    skip_comma_wsp(void)
+    {
+      skip_wsp();
+      if (m_p < m_end && *m_p == ',')
+        {
+          ++m_p;
+          skip_wsp();
+        }
+    }
+
+    /* returns true if the next token starts a number */
+    bool
+    at_number(void) const
+    {
+      return m_p < m_end
+        && (is_digit(*m_p) || *m_p == '.' || *m_p == '-' || *m_p == '+');
+    }
+
+    bool
+    read_number(float *out_value);
+
+    bool
+    read_point(astral::vec2 *out_value)
+    {
+      bool return_value;
+
+      return_value = read_number(&out_value->x());
+      skip_comma_wsp();
+      return return_value && read_number(&out_value->y());
+    }
+
+    /* an arc flag is the single character 0 or 1 and
+     * need not be separated from what follows it
+     */
+    bool
+    read_flag(bool *out_value)
+    {
+      if (m_p < m_end && (*m_p == '0' || *m_p == '1'))
+        {
+          *out_value = (*m_p == '1');
+          ++m_p;
+          return true;
+        }
+      return false;
+    }
+
+  private:
+    static
+    bool
+    is_digit(char c)
+    {
+      return c >= '0' && c <= '9';
+    }
+
+    static
+    bool
+    is_wsp(char c)
+    {
+      return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f';
+    }
+
+    const char *m_p, *m_end;
+  };
+
+  /* Adds the commands of SVG path data to an astral::Path
+   * as they are read.
+   */
+  class PathDataParser
+  {
+  public:
+    PathDataParser(const char *begin, const char *end, astral::Path *dst):
+      m_tokens(begin, end),
+      m_dst(dst),
+      m_current(0.0f, 0.0f),
+      m_start(0.0f, 0.0f),
+      m_last_control(0.0f, 0.0f),
+      m_prev_command(0),
+      m_contour_open(false),
+      m_needs_move(false)
+    {}
+
+    enum astral::return_code
+    parse(void);
+
+  private:
+    bool
+    execute(char command);
+
+    /* read a point; if relative, the point is relative
+     * to the current point
+     */
+    bool
+    read_point(bool relative, astral::vec2 *out_value)
+    {
+      m_tokens.skip_comma_wsp();
+      if (!m_tokens.read_point(out_value))
+        {
+          return false;
+        }
+
+      if (relative)
+        {
+          *out_value += m_current;
+        }
+      return true;
+    }
+
+    bool
+    read_coordinate(bool relative, int coordinate, astral::vec2 *out_value)
+    {
+      float v;
+
+      m_tokens.skip_comma_wsp();
+      if (!m_tokens.read_number(&v))
+        {
+          return false;
+        }
+
+      *out_value = m_current;
+      (*out_value)[coordinate] = (relative) ? m_current[coordinate] + v : v;
+      return true;
+    }
+
+    /* after a closepath, drawing starts a new contour
+     * at the start of the closed contour
+     */
+    void
+    prepare_to_draw(void)
+    {
+      if (m_needs_move)
+        {
+          m_dst->move(m_current);
+          m_needs_move = false;
+          m_contour_open = true;
+        }
+    }
+
+    void
+    add_arc(astral::vec2 radii, float x_axis_rotation,
+            bool large_arc, bool sweep, astral::vec2 end_pt);
+
+    Tokenizer m_tokens;
+    astral::Path *m_dst;
+
+    astral::vec2 m_current, m_start;
+
+    /* the last control point of the previous command, used by
+     * the smooth curve commands S, s, T and t
+     */
+    astral::vec2 m_last_control;
+    char m_prev_command;
+
+    bool m_contour_open, m_needs_move;
+  };
+
+  bool
+  is_command(char c)
+  {
+    return c != 0 && std::strchr("MmZzLlHhVvCcSsQqTtAa", c) != nullptr;
+  }
+}
+
+//////////////////////////////////////
+// Tokenizer methods
+bool
+Tokenizer::
+read_number(float *out_value)
+{
+  /* To avoid overflow, the mantissa keeps only its first 18
+   * digits; a float only has 9 significant digits anyways.
+   */
+  const uint64_t max_mantissa(100000000000000000ull);
+  const char *p(m_p);
+  uint64_t mantissa(0u);
+  int exponent(0), num_digits(0);
+  bool negative(false);
+  double value;
+
+  if (p < m_end && (*p == '-' || *p == '+'))
+    {
+      negative = (*p == '-');
+      ++p;
+    }
+
+  for (; p < m_end && is_digit(*p); ++p, ++num_digits)
+    {
+      if (mantissa < max_mantissa)
+        {
+          mantissa = 10u * mantissa + static_cast<uint64_t>(*p - '0');
+        }
+      else
+        {
+          ++exponent;
+        }
+    }
+
+  if (p < m_end && *p == '.')
+    {
+      for (++p; p < m_end && is_digit(*p); ++p, ++num_digits)
+        {
+          if (mantissa < max_mantissa)
+            {
+              mantissa = 10u * mantissa + static_cast<uint64_t>(*p - '0');
+              --exponent;
+            }
+        }
+    }
+
+  if (num_digits == 0)
+    {
+      return false;
+    }
+
+  /* an exponent is only taken if it has digits */
+  if (p < m_end && (*p == 'e' || *p == 'E'))
+    {
+      const char *q(p + 1);
+      bool negative_exponent(false);
+
+      if (q < m_end && (*q == '-' || *q == '+'))
+        {
+          negative_exponent = (*q == '-');
+          ++q;
+        }
+
+      if (q < m_end && is_digit(*q))
+        {
+          int e(0);
+
+          for (; q < m_end && is_digit(*q); ++q)
+            {
+              e = astral::t_min(10 * e + (*q - '0'), 1000);
+            }
+          exponent += (negative_exponent) ? -e : e;
+          p = q;
+        }
+    }
+
+  /* powers of 10 up to 10^22 are exact in double, dividing
+   * by an exact power is more accurate than multiplying by
+   * an inexact negative power.
+   */
+  value = static_cast<double>(mantissa);
+  if (exponent < 0)
+    {
+      value /= std::pow(10.0, static_cast<double>(-exponent));
+    }
+  else if (exponent > 0)
+    {
+      value *= std::pow(10.0, static_cast<double>(exponent));
+    }
+
+  *out_value = static_cast<float>((negative) ? -value : value);
+  m_p = p;
+
+  return true;
+}
+
+//////////////////////////////////////
+// PathDataParser methods
+enum astral::return_code
+PathDataParser::
+parse(void)
+{
+  m_tokens.skip_wsp();
+  while (!m_tokens.at_end())
+    {
+      char command;
+
+      if (is_command(m_tokens.peek()))
+        {
+          command = m_tokens.peek();
+          m_tokens.advance();
+        }
+      else if (m_tokens.at_number() && m_prev_command != 0
+               && m_prev_command != 'Z' && m_prev_command != 'z')
+        {
+          /* repeated arguments repeat the command, except that
+           * the repetition of a moveto is a lineto
+           */
+          command = m_prev_command;
+          if (command == 'M')
+            {
+              command = 'L';
+            }
+          else if (command == 'm')
+            {
+              command = 'l';
+            }
+        }
+      else
+        {
+          return astral::routine_fail;
+        }
+
+      /* path data must start with a moveto */
+      if (m_prev_command == 0 && command != 'M' && command != 'm')
+        {
+          return astral::routine_fail;
+        }
+
+      if (!execute(command))
+        {
+          return astral::routine_fail;
+        }
+
+      m_prev_command = command;
+      m_tokens.skip_comma_wsp();
+    }
+
+  return astral::routine_success;
+}
+
+bool
+PathDataParser::
+execute(char command)
+{
+  bool relative(command >= 'a' && command <= 'z');
+  astral::vec2 pt, ct1, ct2;
+
+  switch (command)
+    {
+    case 'M':
+    case 'm':
+      {
+        if (!read_point(relative, &pt))
+          {
+            return false;
+          }
+        m_dst->move(pt);
+        m_start = m_current = pt;
+        m_contour_open = true;
+        m_needs_move = false;
+      }
+      return true;
+
+    case 'Z':
+    case 'z':
+      {
+        if (m_contour_open)
+          {
+            m_dst->close();
+            m_contour_open = false;
+          }
+        m_current = m_start;
+        m_needs_move = true;
+      }
+      return true;
+
+    case 'L':
+    case 'l':
+    case 'H':
+    case 'h':
+    case 'V':
+    case 'v':
+      {
+        bool r;
+
+        if (command == 'L' || command == 'l')
+          {
+            r = read_point(relative, &pt);
+          }
+        else
+          {
+            r = read_coordinate(relative, (command == 'H' || command == 'h') ? 0 : 1, &pt);
+          }
+
+        if (!r)
+          {
+            return false;
+          }
+        prepare_to_draw();
+        m_dst->line_to(pt);
+        m_current = pt;
+      }
+      return true;
+
+    case 'C':
+    case 'c':
+    case 'S':
+    case 's':
+      {
+        if (command == 'C' || command == 'c')
+          {
+            if (!read_point(relative, &ct1))
+              {
+                return false;
+              }
+          }
+        else
+          {
+            /* the first control point is the reflection of the
+             * last control point of a previous cubic
+             */
+            bool prev_cubic;
+
+            prev_cubic = (m_prev_command == 'C' || m_prev_command == 'c'
+                          || m_prev_command == 'S' || m_prev_command == 's');
+            ct1 = (prev_cubic) ? 2.0f * m_current - m_last_control : m_current;
+          }
+
+        if (!read_point(relative, &ct2) || !read_point(relative, &pt))
+          {
+            return false;
+          }
+        prepare_to_draw();
+        m_dst->cubic_to(ct1, ct2, pt);
+        m_last_control = ct2;
+        m_current = pt;
+      }
+      return true;
+
+    case 'Q':
+    case 'q':
+    case 'T':
+    case 't':
+      {
+        if (command == 'Q' || command == 'q')
+          {
+            if (!read_point(relative, &ct1))
+              {
+                return false;
+              }
+          }
+        else
+          {
+            bool prev_quadratic;
+
+            prev_quadratic = (m_prev_command == 'Q' || m_prev_command == 'q'
+                              || m_prev_command == 'T' || m_prev_command == 't');
+            ct1 = (prev_quadratic) ? 2.0f * m_current - m_last_control : m_current;
+          }
+
+        if (!read_point(relative, &pt))
+          {
+            return false;
+          }
+        prepare_to_draw();
+        m_dst->quadratic_to(ct1, pt);
+        m_last_control = ct1;
+        m_current = pt;
+      }
+      return true;
+
+    case 'A':
+    case 'a':
+      {
+        astral::vec2 radii;
+        float rotation;
+        bool large_arc, sweep;
+
+        m_tokens.skip_comma_wsp();
+        if (!m_tokens.read_point(&radii))
+          {
+            return false;
+          }
+
+        m_tokens.skip_comma_wsp();
+        if (!m_tokens.read_number(&rotation))
+          {
+            return false;
+          }
+
+        m_tokens.skip_comma_wsp();
+        if (!m_tokens.read_flag(&large_arc))
+          {
+            return false;
+          }
+
+        m_tokens.skip_comma_wsp();
+        if (!m_tokens.read_flag(&sweep))
+          {
+            return false;
+          }
+
+        if (!read_point(relative, &pt))
+          {
+            return false;
+          }
+        prepare_to_draw();
+        add_arc(radii, rotation, large_arc, sweep, pt);
+        m_current = pt;
+      }
+      return true;
+    }
+
+  return false;
+}
+
+void
+PathDataParser::
+add_arc(astral::vec2 radii, float x_axis_rotation,
+        bool large_arc, bool sweep, astral::vec2 end_pt)
+{
+  /* Conversion from endpoint to center parameterization
+   * from the SVG 1.1 specification, appendix F.6.5 and
+   * the correction of out of range radii of F.6.6.
+   */
+  const float circular_tol(1e-5f);
+  float rx, ry, phi, cos_phi, sin_phi, lambda;
+  float rx2, ry2, num, den, coeff, theta1, delta_theta;
+  astral::vec2 d, p, c_prime, center, u, v;
+
+  /* endpoints equal means that the arc is omitted */
+  if (end_pt == m_current)
+    {
+      return;
+    }
+
+  rx = astral::t_abs(radii.x());
+  ry = astral::t_abs(radii.y());
+  if (rx == 0.0f || ry == 0.0f)
+    {
+      m_dst->line_to(end_pt);
+      return;
+    }
+
+  phi = x_axis_rotation * (ASTRAL_PI / 180.0f);
+  cos_phi = astral::t_cos(phi);
+  sin_phi = astral::t_sin(phi);
+
+  d = 0.5f * (m_current - end_pt);
+  p.x() = cos_phi * d.x() + sin_phi * d.y();
+  p.y() = -sin_phi * d.x() + cos_phi * d.y();
+
+  lambda = (p.x() * p.x()) / (rx * rx) + (p.y() * p.y()) / (ry * ry);
+  if (lambda > 1.0f)
+    {
+      float s(astral::t_sqrt(lambda));
+
+      rx *= s;
+      ry *= s;
+    }
+
+  rx2 = rx * rx;
+  ry2 = ry * ry;
+  num = rx2 * ry2 - rx2 * p.y() * p.y() - ry2 * p.x() * p.x();
+  den = rx2 * p.y() * p.y() + ry2 * p.x() * p.x();
+  coeff = astral::t_sqrt(astral::t_max(0.0f, num / den));
+  if (large_arc == sweep)
+    {
+      coeff = -coeff;
+    }
+
+  c_prime.x() = coeff * rx * p.y() / ry;
+  c_prime.y() = -coeff * ry * p.x() / rx;
+
+  center.x() = cos_phi * c_prime.x() - sin_phi * c_prime.y() + 0.5f * (m_current.x() + end_pt.x());
+  center.y() = sin_phi * c_prime.x() + cos_phi * c_prime.y() + 0.5f * (m_current.y() + end_pt.y());
+
+  u = astral::vec2((p.x() - c_prime.x()) / rx, (p.y() - c_prime.y()) / ry);
+  v = astral::vec2((-p.x() - c_prime.x()) / rx, (-p.y() - c_prime.y()) / ry);
+
+  theta1 = astral::t_atan2(u.y(), u.x());
+  delta_theta = astral::t_atan2(u.x() * v.y() - u.y() * v.x(), astral::dot(u, v));
+  if (!sweep && delta_theta > 0.0f)
+    {
+      delta_theta -= 2.0f * ASTRAL_PI;
+    }
+  else if (sweep && delta_theta < 0.0f)
+    {
+      delta_theta += 2.0f * ASTRAL_PI;
+    }
+
+  /* a positive angle of Path::arc_to() is the direction
+   * of increasing angle, the same as an SVG sweep-flag of 1
+   */
+  if (astral::t_abs(rx - ry) <= circular_tol * astral::t_max(rx, ry))
+    {
+      m_dst->arc_to(delta_theta, end_pt);
+      return;
+    }
+
+  /* An elliptic arc is the image of a circular arc under an
+   * affine map and the image of a conic under an affine map is
+   * the conic of the mapped control points with the same weight,
+   * so break the arc into pieces of at most 90 degrees and add
+   * each as the conic of the unit circle arc mapped by the
+   * ellipse.
+   */
+  unsigned int n;
+  float step, half_step, w;
+
+  n = static_cast<unsigned int>(std::ceil(astral::t_abs(delta_theta) / (0.5f * ASTRAL_PI)));
+  n = astral::t_max(n, 1u);
+  step = delta_theta / static_cast<float>(n);
+  half_step = 0.5f * step;
+  w = astral::t_cos(half_step);
+
+  for (unsigned int i = 0; i < n; ++i)
+    {
+      float a0, mid, a1;
+      astral::vec2 unit_ct, unit_pt, ct, pt;
+
+      a0 = theta1 + static_cast<float>(i) * step;
+      mid = a0 + half_step;
+      a1 = a0 + step;
+
+      unit_ct = astral::vec2(astral::t_cos(mid), astral::t_sin(mid)) / w;
+      ct.x() = center.x() + rx * cos_phi * unit_ct.x() - ry * sin_phi * unit_ct.y();
+      ct.y() = center.y() + rx * sin_phi * unit_ct.x() + ry * cos_phi * unit_ct.y();
+
+      if (i + 1u == n)
+        {
+          pt = end_pt;
+        }
+      else
+        {
+          unit_pt = astral::vec2(astral::t_cos(a1), astral::t_sin(a1));
+          pt.x() = center.x() + rx * cos_phi * unit_pt.x() - ry * sin_phi * unit_pt.y();
+          pt.y() = center.y() + rx * sin_phi * unit_pt.x() + ry * cos_phi * unit_pt.y();
+        }
+
+      m_dst->conic_to(w, ct, pt);
+    }
+}
+
+//////////////////////////////////////
+// global methods
+enum astral::return_code
+astral::
+add_svg_path_data(const char *begin, const char *end, Path *dst)
+{
+  PathDataParser parser(begin, end, dst);
+
+  ASTRALassert(dst);
+  return parser.parse();
+}
+
+enum astral::return_code
+astral::
+add_svg_path_data(c_string d, Path *dst)
+{
+  return add_svg_path_data(d, d + std::strlen(d), dst);
+}
+
+enum astral::return_code
+astral::
+add_svg_points(const char *begin, const char *end, bool closed, Path *dst)
+{
+  Tokenizer tokens(begin, end);
+  unsigned int count(0);
+
+  ASTRALassert(dst);
+  tokens.skip_wsp();
+  while (!tokens.at_end())
+    {
+      vec2 pt;
+
+      if (!tokens.read_point(&pt))
+        {
+          break;
+        }
+
+      if (count == 0u)
+        {
+          dst->move(pt);
+        }
+      else
+        {
+          dst->line_to(pt);
+        }
+      ++count;
+      tokens.skip_comma_wsp();
+    }
+
+  if (closed && count > 0u)
+    {
+      dst->close();
+    }
+
+  return (tokens.at_end()) ? routine_success : routine_fail;
+}
+
+enum astral::return_code
+astral::
+add_svg_points(c_string points, bool closed, Path *dst)
+{
+  return add_svg_points(points, points + std::strlen(points), closed, dst);
+}
+
+void
+astral::
+add_svg_rect(const Rect &rect, vec2 radii, Path *dst)
+{
+  vec2 sz(rect.size());
+
+  ASTRALassert(dst);
+  if (sz.x() <= 0.0f || sz.y() <= 0.0f)
+    {
+      return;
+    }
+
+  /* resolve the radii as in SVG 1.1, section 9.2 */
+  if (radii.x() < 0.0f)
+    {
+      radii.x() = radii.y();
+    }
+  if (radii.y() < 0.0f)
+    {
+      radii.y() = radii.x();
+    }
+  radii.x() = t_max(0.0f, t_min(radii.x(), 0.5f * sz.x()));
+  radii.y() = t_max(0.0f, t_min(radii.y(), 0.5f * sz.y()));
+
+  const vec2 &p(rect.m_min_point);
+  const vec2 &q(rect.m_max_point);
+
+  if (radii.x() == 0.0f || radii.y() == 0.0f)
+    {
+      dst->move(p);
+      dst->line_to(vec2(q.x(), p.y()));
+      dst->line_to(q);
+      dst->line_to(vec2(p.x(), q.y()));
+      dst->line_close();
+      return;
+    }
+
+  /* the corners go in the direction of increasing angle, each
+   * corner is a quarter of an ellipse whose conic control point
+   * is the corner of the rect
+   */
+  bool circular(radii.x() == radii.y());
+  vecN<vec2, 4> corner, corner_end, side_end;
+
+  corner[0] = vec2(q.x(), p.y());
+  corner[1] = q;
+  corner[2] = vec2(p.x(), q.y());
+  corner[3] = p;
+
+  side_end[0] = vec2(q.x() - radii.x(), p.y());
+  corner_end[0] = vec2(q.x(), p.y() + radii.y());
+  side_end[1] = vec2(q.x(), q.y() - radii.y());
+  corner_end[1] = vec2(q.x() - radii.x(), q.y());
+  side_end[2] = vec2(p.x() + radii.x(), q.y());
+  corner_end[2] = vec2(p.x(), q.y() - radii.y());
+  side_end[3] = vec2(p.x(), p.y() + radii.y());
+  corner_end[3] = vec2(p.x() + radii.x(), p.y());
+
+  dst->move(corner_end[3]);
+  for (unsigned int i = 0; i < 4; ++i)
+    {
+      /* the sides vanish when a radius is half the size */
+      if (side_end[i] != ((i == 0u) ? corner_end[3] : corner_end[i - 1u]))
+        {
+          dst->line_to(side_end[i]);
+        }
+
+      if (i == 3u)
+        {
+          if (circular)
+            {
+              dst->arc_close(0.5f * ASTRAL_PI);
+            }
+          else
+            {
+              dst->conic_close(ASTRAL_HALF_SQRT2, corner[i]);
+            }
+        }
+      else if (circular)
+        {
+          dst->arc_to(0.5f * ASTRAL_PI, corner_end[i]);
+        }
+      else
+        {
+          dst->conic_to(ASTRAL_HALF_SQRT2, corner[i], corner_end[i]);
+        }
+    }
+}
+
+void
+astral::
+add_svg_ellipse(vec2 center, vec2 radii, Path *dst)
+{
+  ASTRALassert(dst);
+  if (radii.x() <= 0.0f || radii.y() <= 0.0f)
+    {
+      return;
+    }
+
+  /* start at angle 0 and go in the direction of increasing
+   * angle as the SVG specification requires; each quarter
+   * of the ellipse is a conic whose control point is a
+   * corner of the bounding box of the ellipse
+   */
+  vec2 rx(radii.x(), 0.0f), ry(0.0f, radii.y());
+  vecN<vec2, 4> pts, corners;
+
+  pts[0] = center + rx;
+  pts[1] = center + ry;
+  pts[2] = center - rx;
+  pts[3] = center - ry;
+
+  corners[0] = center + rx + ry;
+  corners[1] = center - rx + ry;
+  corners[2] = center - rx - ry;
+  corners[3] = center + rx - ry;
+
+  dst->move(pts[0]);
+  if (radii.x() == radii.y())
+    {
+      for (unsigned int i = 1; i < 4; ++i)
+        {
+          dst->arc_to(0.5f * ASTRAL_PI, pts[i]);
+        }
+      dst->arc_close(0.5f * ASTRAL_PI);
+    }
+  else
+    {
+      for (unsigned int i = 1; i < 4; ++i)
+        {
+          dst->conic_to(ASTRAL_HALF_SQRT2, corners[i - 1u], pts[i]);
+        }
+      dst->conic_close(ASTRAL_HALF_SQRT2, corners[3]);
+    }
+}
+
+void
+astral::
+add_svg_line(vec2 p0, vec2 p1, Path *dst)
+{
+  ASTRALassert(dst);
+  dst->move(p0);
+  dst->line_to(p1);
+}
@@ -7,7 +7,7 @@ d		:= $(dir)
 ASTRAL_SOURCES += $(call filelist, freetype_lib.cpp \
 	freetype_face.cpp font.cpp \
 	typeface.cpp freetype_face_generator.cpp \
-	text_item.cpp glyph_generator.cpp)
+	text_item.cpp glyph_generator.cpp distance_field_generator.cpp)
 
 # Begin standard footer
 d		:= $(dirstack_$(sp))
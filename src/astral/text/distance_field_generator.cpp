@@ -0,0 +1,242 @@
+/*!
+ * \file distance_field_generator.cpp
+ * \brief file distance_field_generator.cpp
+ *
+ * Copyright 2020 by InvisionApp.
+ *
+ * Contact: kevinrogovin@invisionapp.com
+ *
+ * This Source Code Form is subject to the
+ * terms of the Mozilla Public License, v. 2.0.
+ * If a copy of the MPL was not distributed with
+ * this file, You can obtain one at
+ * http://mozilla.org/MPL/2.0/.
+ *
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <astral/path.hpp>
+#include <astral/util/math.hpp>
+#include "distance_field_generator.hpp"
+
+namespace
+{
+  /* Tolerance, in texels of level 0, to which curves are
+   * flattened into line segments.
+   */
+  const float flatten_tolerance = 1.0f / 16.0f;
+
+  /* The maximum number of line segments a single curve
+   * is flattened into.
+   */
+  const unsigned int max_segments_per_curve = 128u;
+
+  float
+  distance_to_segment(const astral::vec2 &p,
+                      const astral::vec2 &a,
+                      const astral::vec2 &b)
+  {
+    astral::vec2 ab(b - a), ap(p - a);
+    float t, denom;
+
+    denom = astral::dot(ab, ab);
+    t = (denom > 0.0f) ? astral::t_max(0.0f, astral::t_min(1.0f, astral::dot(ap, ab) / denom)) : 0.0f;
+
+    return (ap - t * ab).magnitude();
+  }
+}
+
+astral::detail::DistanceFieldGenerator::
+DistanceFieldGenerator(const Path &path, enum fill_rule_t fill_rule,
+                       const BoundingBox<float> &bb,
+                       uvec2 image_size, unsigned int padding):
+  m_fill_rule(fill_rule),
+  m_image_size(image_size)
+{
+  vec2 scale, bb_size(bb.size());
+  vec2 inner(image_size.x() - 2u * padding, image_size.y() - 2u * padding);
+
+  ASTRALassert(image_size.x() > 2u * padding);
+  ASTRALassert(image_size.y() > 2u * padding);
+
+  scale.x() = inner.x() / t_max(bb_size.x(), 1e-6f);
+  scale.y() = inner.y() / t_max(bb_size.y(), 1e-6f);
+
+  for (unsigned int c = 0, endc = path.number_contours(); c < endc; ++c)
+    {
+      c_array<const ContourCurve> curves(path.contour(c).curves());
+      vec2 first_pt, last_pt;
+
+      if (curves.empty())
+        {
+          continue;
+        }
+
+      for (const ContourCurve &curve : curves)
+        {
+          vecN<vec2, 4> pts;
+          unsigned int num_pts(0);
+
+          pts[num_pts++] = curve.start_pt();
+          for (unsigned int i = 0, endi = curve.number_control_pts(); i < endi; ++i)
+            {
+              pts[num_pts++] = curve.control_pt(i);
+            }
+          pts[num_pts++] = curve.end_pt();
+
+          /* map from path coordinates to level 0 texel coordinates */
+          for (unsigned int i = 0; i < num_pts; ++i)
+            {
+              pts[i] = vec2(padding) + scale * (pts[i] - bb.min_point());
+            }
+
+          if (curve.type() == ContourCurve::line_segment)
+            {
+              add_segment(pts[0], pts[num_pts - 1u]);
+            }
+          else
+            {
+              float max_second_difference(0.0f);
+              unsigned int num_segments;
+              vec2 prev;
+
+              /* the error of approximating a curve by N segments is
+               * bounded by a multiple of the second differences of its
+               * control points divided by N^2
+               */
+              for (unsigned int i = 2; i < num_pts; ++i)
+                {
+                  vec2 d(pts[i] - 2.0f * pts[i - 1u] + pts[i - 2u]);
+                  max_second_difference = t_max(max_second_difference, d.magnitude());
+                }
+
+              num_segments = static_cast<unsigned int>(std::ceil(std::sqrt(max_second_difference / flatten_tolerance)));
+              num_segments = t_max(1u, t_min(max_segments_per_curve, num_segments));
+
+              prev = pts[0];
+              for (unsigned int i = 1; i <= num_segments; ++i)
+                {
+                  vec2 q;
+
+                  if (i == num_segments)
+                    {
+                      q = pts[num_pts - 1u];
+                    }
+                  else
+                    {
+                      float t;
+
+                      t = static_cast<float>(i) / static_cast<float>(num_segments);
+                      q = vec2(padding) + scale * (curve.eval_at(t) - bb.min_point());
+                    }
+                  add_segment(prev, q);
+                  prev = q;
+                }
+            }
+        }
+
+      /* filling implicitely closes each contour */
+      first_pt = vec2(padding) + scale * (curves.front().start_pt() - bb.min_point());
+      last_pt = vec2(padding) + scale * (curves.back().end_pt() - bb.min_point());
+      add_segment(last_pt, first_pt);
+    }
+}
+
+void
+astral::detail::DistanceFieldGenerator::
+add_segment(const vec2 &p0, const vec2 &p1)
+{
+  if (p0 != p1)
+    {
+      Segment S;
+
+      S.m_p0 = p0;
+      S.m_p1 = p1;
+      m_segments.push_back(S);
+    }
+}
+
+void
+astral::detail::DistanceFieldGenerator::
+generate(unsigned int L, c_array<uint8_t> dst)
+{
+  uvec2 sz(level_size(L));
+  vec2 level_scale;
+
+  ASTRALassert(dst.size() == sz.x() * sz.y());
+
+  level_scale.x() = static_cast<float>(sz.x()) / static_cast<float>(m_image_size.x());
+  level_scale.y() = static_cast<float>(sz.y()) / static_cast<float>(m_image_size.y());
+
+  /* The distance is clamped to one texel, so only the texels
+   * within one texel of a segment need the distance to the
+   * segment.
+   */
+  m_distances.assign(sz.x() * sz.y(), 1.0f);
+  for (const Segment &S : m_segments)
+    {
+      vec2 q0(level_scale * S.m_p0), q1(level_scale * S.m_p1);
+      int min_x, max_x, min_y, max_y;
+
+      min_x = t_max(0, static_cast<int>(std::ceil(t_min(q0.x(), q1.x()) - 1.5f)));
+      max_x = t_min(static_cast<int>(sz.x()) - 1, static_cast<int>(std::floor(t_max(q0.x(), q1.x()) + 0.5f)));
+      min_y = t_max(0, static_cast<int>(std::ceil(t_min(q0.y(), q1.y()) - 1.5f)));
+      max_y = t_min(static_cast<int>(sz.y()) - 1, static_cast<int>(std::floor(t_max(q0.y(), q1.y()) + 0.5f)));
+
+      for (int y = min_y; y <= max_y; ++y)
+        {
+          for (int x = min_x; x <= max_x; ++x)
+            {
+              float &d(m_distances[x + y * sz.x()]);
+              vec2 p(static_cast<float>(x) + 0.5f, static_cast<float>(y) + 0.5f);
+
+              d = t_min(d, distance_to_segment(p, q0, q1));
+            }
+        }
+    }
+
+  /* The sign is from the winding number at the texel center
+   * computed by walking the crossings of the segments with
+   * the horizontal line through the center of each row.
+   */
+  for (unsigned int y = 0; y < sz.y(); ++y)
+    {
+      float yc(static_cast<float>(y) + 0.5f);
+      unsigned int crossing(0);
+      int winding(0);
+
+      m_crossings.clear();
+      for (const Segment &S : m_segments)
+        {
+          vec2 q0(level_scale * S.m_p0), q1(level_scale * S.m_p1);
+
+          if ((q0.y() <= yc) != (q1.y() <= yc))
+            {
+              float x;
+
+              x = q0.x() + (yc - q0.y()) * (q1.x() - q0.x()) / (q1.y() - q0.y());
+              m_crossings.push_back(std::make_pair(x, (q1.y() > q0.y()) ? 1 : -1));
+            }
+        }
+      std::sort(m_crossings.begin(), m_crossings.end());
+
+      for (unsigned int x = 0; x < sz.x(); ++x)
+        {
+          float xc(static_cast<float>(x) + 0.5f), d;
+
+          for (; crossing < m_crossings.size() && m_crossings[crossing].first < xc; ++crossing)
+            {
+              winding += m_crossings[crossing].second;
+            }
+
+          d = m_distances[x + y * sz.x()];
+          if (!apply_fill_rule(m_fill_rule, winding))
+            {
+              d = -d;
+            }
+
+          dst[x + y * sz.x()] = static_cast<uint8_t>(255.0f * (0.5f + 0.5f * d) + 0.5f);
+        }
+    }
+}
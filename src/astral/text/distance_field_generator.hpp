@@ -0,0 +1,97 @@
+/*!
+ * \file distance_field_generator.hpp
+ * \brief file distance_field_generator.hpp
+ *
+ * Copyright 2020 by InvisionApp.
+ *
+ * Contact: kevinrogovin@invisionapp.com
+ *
+ * This Source Code Form is subject to the
+ * terms of the Mozilla Public License, v. 2.0.
+ * If a copy of the MPL was not distributed with
+ * this file, You can obtain one at
+ * http://mozilla.org/MPL/2.0/.
+ *
+ */
+
+#ifndef ASTRAL_DISTANCE_FIELD_GENERATOR_HPP
+#define ASTRAL_DISTANCE_FIELD_GENERATOR_HPP
+
+#include <vector>
+#include <astral/util/vecN.hpp>
+#include <astral/util/c_array.hpp>
+#include <astral/util/bounding_box.hpp>
+#include <astral/renderer/render_enums.hpp>
+
+namespace astral
+{
+  class Path;
+
+  namespace detail
+  {
+    /* A DistanceFieldGenerator computes, on the CPU, the signed distance
+     * field of a filled astral::Path in the encoding of
+     * astral::mask_type_distance_field: the distance is measured in texels,
+     * is positive inside of the fill, is clamped to [-1, 1] and is stored
+     * as 0.5 + 0.5 * distance. The path is flattened into line segments
+     * once and each level of a mipmap chain is computed from the segments
+     * at its own resolution rather than by down sampling the level above
+     * it, so that every level is a distance field.
+     */
+    class DistanceFieldGenerator
+    {
+    public:
+      /* Flatten the path.
+       * \param path path to flatten
+       * \param fill_rule fill rule applied to the path
+       * \param bb region of the path mapped to the image
+       * \param image_size size of the level 0 image
+       * \param padding number of texels of level 0 on each side of the
+       *                image between the boundary of the image and
+       *                the region mapped from bb
+       */
+      DistanceFieldGenerator(const Path &path, enum fill_rule_t fill_rule,
+                             const BoundingBox<float> &bb,
+                             uvec2 image_size, unsigned int padding);
+
+      /* Compute the named level of the mipmap chain, the size of
+       * the level is the size of the level 0 image divided by 2^L.
+       * \param L which mipmap level
+       * \param dst location to which to write the texels, one value per
+       *            texel with rows in order of increasing y
+       */
+      void
+      generate(unsigned int L, c_array<uint8_t> dst);
+
+      /* size of the named level */
+      uvec2
+      level_size(unsigned int L) const
+      {
+        return uvec2(t_max(1u, m_image_size.x() >> L),
+                     t_max(1u, m_image_size.y() >> L));
+      }
+
+    private:
+      class Segment
+      {
+      public:
+        vec2 m_p0, m_p1;
+      };
+
+      void
+      add_segment(const vec2 &p0, const vec2 &p1);
+
+      enum fill_rule_t m_fill_rule;
+      uvec2 m_image_size;
+
+      /* segments in the coordinates of level 0 texels */
+      std::vector<Segment> m_segments;
+
+      /* work room for generate() */
+      std::vector<float> m_distances;
+      std::vector<std::pair<float, int>> m_crossings;
+    };
+  }
+}
+
+#endif
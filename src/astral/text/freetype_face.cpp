@@ -16,9 +16,86 @@
  *
  */
 #include <iostream>
+#include <sstream>
+#include <iomanip>
+#include <sys/stat.h>
 #include <astral/text/freetype_face.hpp>
 #include <astral/util/static_resource.hpp>
 
+namespace
+{
+  /* Hash the bytes of data with astral::Hash64, which mixes
+   * 32-bit values, four bytes at a time; trailing bytes are
+   * mixed one at a time.
+   */
+  uint64_t
+  hash_bytes(astral::c_array<const uint8_t> data)
+  {
+    astral::Hash64 hash;
+    unsigned int i(0);
+
+    for (; i + 4u <= data.size(); i += 4u)
+      {
+        hash.mix(static_cast<uint32_t>(data[i])
+                 | (static_cast<uint32_t>(data[i + 1u]) << 8u)
+                 | (static_cast<uint32_t>(data[i + 2u]) << 16u)
+                 | (static_cast<uint32_t>(data[i + 3u]) << 24u));
+      }
+
+    for (; i < data.size(); ++i)
+      {
+        hash.mix(data[i]);
+      }
+
+    return hash.value();
+  }
+
+  /* Make the cache key of font data from a 64-bit hash
+   * of the data, the size of the data and the face index.
+   */
+  std::string
+  make_cache_key(astral::c_array<const uint8_t> data, int face_index)
+  {
+    std::ostringstream str;
+
+    if (data.empty())
+      {
+        return std::string();
+      }
+
+    str << std::hex << std::setfill('0') << std::setw(16) << hash_bytes(data)
+        << std::dec << "-" << data.size() << "-" << face_index;
+
+    return str.str();
+  }
+
+  /* Make the cache key of a font file without reading it from
+   * a hash of the path, the size and modification time of the
+   * file and the face index.
+   */
+  std::string
+  make_file_cache_key(const std::string &filename, int face_index)
+  {
+    std::ostringstream str;
+    struct stat info;
+    astral::c_array<const uint8_t> path;
+
+    if (filename.empty() || ::stat(filename.c_str(), &info) != 0)
+      {
+        return std::string();
+      }
+
+    path = astral::c_array<const uint8_t>(reinterpret_cast<const uint8_t*>(filename.data()),
+                                          filename.size());
+    str << "file-" << std::hex << std::setfill('0') << std::setw(16) << hash_bytes(path)
+        << std::dec << "-" << static_cast<long long>(info.st_size)
+        << "-" << static_cast<long long>(info.st_mtime)
+        << "-" << face_index;
+
+    return str.str();
+  }
+}
+
 //////////////////////////////////////////////////
 // astral::FreetypeFace::GeneratorBase methods
 astral::reference_counted_ptr<astral::FreetypeFace>
@@ -60,6 +137,13 @@ check_creation(reference_counted_ptr<FreetypeLib> lib) const
 
 //////////////////////////////////////////////////
 // astral::FreetypeFace::GeneratorFile methods
+std::string
+astral::FreetypeFace::GeneratorFile::
+cache_key(void) const
+{
+  return make_file_cache_key(m_filename, m_face_index);
+}
+
 FT_Face
 astral::FreetypeFace::GeneratorFile::
 create_face_implement(FT_Library lib) const
@@ -78,6 +162,17 @@ create_face_implement(FT_Library lib) const
 
 /////////////////////////////////////////////////
 // astral::FreetypeFace::GeneratorMemory methods
+std::string
+astral::FreetypeFace::GeneratorMemory::
+cache_key(void) const
+{
+  std::call_once(m_cache_key_once, [this]()
+                 {
+                   m_cache_key = make_cache_key(m_buffer->data_ro(), m_face_index);
+                 });
+  return m_cache_key;
+}
+
 astral::FreetypeFace::GeneratorMemory::
 GeneratorMemory(const reference_counted_ptr<const DataBufferBase> &src,
                 int face_index):
@@ -116,6 +211,17 @@ create_face_implement(FT_Library lib) const
 
 /////////////////////////////////////////////////
 // astral::FreetypeFace::GeneratorResource methods
+std::string
+astral::FreetypeFace::GeneratorResource::
+cache_key(void) const
+{
+  std::call_once(m_cache_key_once, [this]()
+                 {
+                   m_cache_key = make_cache_key(m_buffer, m_face_index);
+                 });
+  return m_cache_key;
+}
+
 astral::FreetypeFace::GeneratorResource::
 GeneratorResource(c_string resource_name, int face_index):
   m_buffer(fetch_static_resource(resource_name)),
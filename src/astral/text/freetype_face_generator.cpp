@@ -188,6 +188,14 @@ namespace
                      astral::ivec2 *out_image_size,
                      std::vector<astral::FixedPointColor_sRGB> *out_pixels) const override;
 
+    virtual
+    std::string
+    cache_key(void) const override
+    {
+      std::string src_key(m_src->cache_key());
+      return (src_key.empty()) ? src_key : "freetype-" + src_key;
+    }
+
   private:
     static
     void
@@ -218,6 +226,7 @@ namespace
     FT_Int m_load_flags;
     std::vector<astral::reference_counted_ptr<astral::FreetypeFace>> m_faces;
     astral::GlyphColors m_palettes;
+    astral::reference_counted_ptr<const astral::FreetypeFace::GeneratorBase> m_src;
   };
 }
 
@@ -226,7 +235,8 @@ namespace
 GlyphGeneratorFreetype::
 GlyphGeneratorFreetype(astral::reference_counted_ptr<astral::FreetypeLib> lib,
                        unsigned int number_threads,
-                       astral::reference_counted_ptr<const astral::FreetypeFace::GeneratorBase> src)
+                       astral::reference_counted_ptr<const astral::FreetypeFace::GeneratorBase> src):
+  m_src(src)
 {
   using namespace astral;
 
@@ -21,9 +21,28 @@
 #include <astral/text/glyph.hpp>
 #include <astral/text/text_item.hpp>
 
+namespace
+{
+  /* A glyph is drawn from its distance field only if the
+   * average number of curves per pixel evaluated to draw it
+   * from its ItemPath is at least this value; sampling the
+   * distance field costs the reads of the image sampler and
+   * index tiles of the image together with a filtered texel
+   * fetch which is roughly the cost of evaluating this many
+   * curves.
+   */
+  const float distance_field_min_render_cost = 4.0f;
+}
+
 class astral::TextItem::PerGlyph
 {
 public:
+  PerGlyph(const Glyph &glyph, vec2 position, GlyphPaletteID palette):
+    m_glyph(glyph),
+    m_palette(palette),
+    m_position(position)
+  {}
+
   Glyph m_glyph;
   GlyphPaletteID m_palette;
   vec2 m_position;
@@ -62,6 +81,20 @@ public:
   }
 };
 
+class astral::TextItem::PendingGlyph
+{
+public:
+  PendingGlyph(GlyphIndex glyph_index, vec2 position, GlyphPaletteID palette):
+    m_glyph_index(glyph_index),
+    m_palette(palette),
+    m_position(position)
+  {}
+
+  GlyphIndex m_glyph_index;
+  GlyphPaletteID m_palette;
+  vec2 m_position;
+};
+
 class astral::TextItem::PerRenderSize
 {
 public:
@@ -69,26 +102,60 @@ public:
   explicit
   PerRenderSize(const astral::Font &font):
     m_strike(font.fixed_size_index()),
-    m_pixel_size(font.pixel_size())
+    m_pixel_size(font.pixel_size()),
+    m_distance_field(false)
   {
   }
 
   /* ctor for non-scalable typeface */
   PerRenderSize(const astral::Typeface &face, int strike):
     m_strike(strike),
-    m_pixel_size(face.fixed_metrics()[strike].m_pixel_size)
+    m_pixel_size(face.fixed_metrics()[strike].m_pixel_size),
+    m_distance_field(false)
+  {}
+
+  /* ctor for scalable typeface */
+  PerRenderSize(float pixel_size, bool distance_field):
+    m_strike(-1),
+    m_pixel_size(pixel_size),
+    m_distance_field(distance_field)
   {}
 
+  /* Returns true if the glyph is to be drawn
+   * from its distance field
+   */
+  bool
+  use_distance_field(const PerGlyph &glyph) const
+  {
+    reference_counted_ptr<const ItemPath> item_path;
+    enum fill_rule_t fill_rule;
+    vec2 cost;
+
+    if (!m_distance_field || glyph.m_glyph.is_colored())
+      {
+        return false;
+      }
+
+    glyph.m_glyph.path(0, &fill_rule, &item_path);
+    cost = item_path->properties().m_average_render_cost;
+
+    return t_min(cost.x(), cost.y()) >= distance_field_min_render_cost;
+  }
+
   uint32_t
-  render_data_location(RenderEngine &engine, const PerGlyph &glyph) const
+  render_data_location(RenderEngine &engine, const PerGlyph &glyph, uint32_t flags) const
   {
-    if (m_strike == -1)
+    if (m_strike != -1)
       {
-        return glyph.m_glyph.render_data(engine, glyph.m_palette)->location();
+        return glyph.m_glyph.image_render_data(engine, m_strike)->location();
+      }
+    else if (flags & GlyphShader::is_distance_field_glyph)
+      {
+        return glyph.m_glyph.distance_field_render_data(engine)->location();
       }
     else
       {
-        return glyph.m_glyph.image_render_data(engine, m_strike)->location();
+        return glyph.m_glyph.render_data(engine, glyph.m_palette)->location();
       }
   }
 
@@ -104,6 +171,11 @@ public:
   int m_strike;
   float m_pixel_size;
 
+  /* if true, glyphs for which use_distance_field()
+   * returns true are drawn from their distance field
+   */
+  bool m_distance_field;
+
   RenderData m_render_data;
   std::vector<gvec4> m_static_values;
   std::vector<Vertex> m_verts;
@@ -134,12 +206,23 @@ public:
           vec2 *out_pen_position,
           uint32_t *out_shared_data_location) const override final
   {
-    m_src.m_glyphs[idx].compute_positions(m_src.m_font, out_position, out_pen_position);
-    *out_shared_data_location = m_dst.render_data_location(m_engine, m_src.m_glyphs[idx]);
+    const PerGlyph &glyph(m_src.m_glyphs[idx]);
+    uint32_t flags(0u);
+
+    if (glyph.m_glyph.is_colored())
+      {
+        flags |= GlyphShader::is_colored_glyph;
+      }
+
+    if (m_dst.use_distance_field(glyph))
+      {
+        flags |= GlyphShader::is_distance_field_glyph;
+      }
+
+    glyph.compute_positions(m_src.m_font, out_position, out_pen_position);
+    *out_shared_data_location = m_dst.render_data_location(m_engine, glyph, flags);
 
-    return (m_src.m_glyphs[idx].m_glyph.is_colored()) ?
-      astral::GlyphShader::is_colored_glyph :
-      0u;
+    return flags;
   }
 
 private:
@@ -177,68 +260,114 @@ public:
         return;
       }
 
-    for (PerRenderSize &prs : m_dst.m_per_render_size)
+    Typeface &typeface(m_dst.m_font.typeface());
+    bool skip_pending(m_dst.m_pending_glyph_handling == skip_pending_glyphs);
+
+    if (skip_pending)
       {
-        prs.m_render_data.clear();
+        typeface.prefetch_glyphs(glyph_indices);
       }
 
-    float f(1.0f);
-
-    if (m_dst.font().typeface().is_scalable())
+    clear_render_data();
+    for (unsigned int i = 0; i < glyph_indices.size(); ++i)
       {
-        f = 1.0f / m_dst.font().scaling_factor();
+        vec2 pos;
+
+        pos = position_value(glyph_positions[i]);
+        if (skip_pending && !typeface.glyph_ready(glyph_indices[i]))
+          {
+            m_dst.m_pending_glyphs.push_back(PendingGlyph(glyph_indices[i], pos, P));
+          }
+        else
+          {
+            add_glyph(typeface.fetch_glyph(glyph_indices[i]), pos, P);
+          }
       }
+  }
 
-    for (unsigned int i = 0; i < glyph_indices.size(); ++i)
+  unsigned int
+  update_pending_glyphs(void)
+  {
+    Typeface &typeface(m_dst.m_font.typeface());
+    bool wait(m_dst.m_pending_glyph_handling == wait_for_glyphs);
+    unsigned int dst(0);
+
+    /* compact the pending glyphs not ready in place */
+    for (unsigned int i = 0, endi = m_dst.m_pending_glyphs.size(); i < endi; ++i)
       {
-        Glyph g(m_dst.m_font.typeface().fetch_glyph(glyph_indices[i]));
-        const GlyphMetrics &metrics(m_dst.m_font.glyph_metrics(g));
+        const PendingGlyph &g(m_dst.m_pending_glyphs[i]);
 
-        if (metrics.m_size.x() > 0.0f && metrics.m_size.y() > 0.0f)
+        if (wait || typeface.glyph_ready(g.m_glyph_index))
+          {
+            add_glyph(typeface.fetch_glyph(g.m_glyph_index), g.m_position, g.m_palette);
+          }
+        else
           {
-            Rect pts;
-            vec2 pos;
+            m_dst.m_pending_glyphs[dst++] = g;
+          }
+      }
 
-            pos = position_value(glyph_positions[i]);
+    if (dst != m_dst.m_pending_glyphs.size())
+      {
+        clear_render_data();
+        m_dst.m_pending_glyphs.erase(m_dst.m_pending_glyphs.begin() + dst, m_dst.m_pending_glyphs.end());
+      }
 
-            m_dst.m_glyphs.push_back(PerGlyph());
+    return m_dst.m_pending_glyphs.size();
+  }
 
-            m_dst.m_glyphs.back().m_glyph = g;
-            m_dst.m_glyphs.back().m_position = pos;
-            m_dst.m_glyphs.back().m_palette = P;
+private:
+  void
+  clear_render_data(void)
+  {
+    for (PerRenderSize &prs : m_dst.m_per_render_size)
+      {
+        prs.m_render_data.clear();
+      }
+  }
+
+  void
+  add_glyph(const Glyph &g, const vec2 &pos, GlyphPaletteID P)
+  {
+    const GlyphMetrics &metrics(m_dst.m_font.glyph_metrics(g));
+
+    if (metrics.m_size.x() > 0.0f && metrics.m_size.y() > 0.0f)
+      {
+        Rect pts;
 
-            m_dst.m_glyphs.back().compute_translated_rect(m_dst.m_font, &pts);
-            m_dst.m_bb.union_box(pts);
+        m_dst.m_glyphs.push_back(PerGlyph(g, pos, P));
+        m_dst.m_glyphs.back().compute_translated_rect(m_dst.m_font, &pts);
+        m_dst.m_bb.union_box(pts);
 
-            if (m_dst.font().typeface().is_scalable())
+        if (m_dst.font().typeface().is_scalable())
+          {
+            if (g.is_colored())
               {
-                if (g.is_colored())
-                  {
-                    m_dst.m_color_glyphs.push_back(m_dst.m_glyphs.size() - 1u);
-                  }
-                else
+                m_dst.m_color_glyphs.push_back(m_dst.m_glyphs.size() - 1u);
+              }
+            else
+              {
+                const Path *path;
+                enum fill_rule_t fill_rule;
+                unsigned int layer(0);
+
+                path = g.path(layer, &fill_rule);
+                if (path)
                   {
-                    const Path *path;
-                    enum fill_rule_t fill_rule;
-                    unsigned int layer(0);
-
-                    path = g.path(layer, &fill_rule);
-                    if (path)
-                      {
-                        /* The position is multiplied by the reciprocal of the position
-                         * because the caller is expected to scale the rendering of the
-                         * paths BEFORE drawing the CombinedPath values.
-                         */
-                        m_dst.m_combined_path_backings[fill_rule].push_back(path);
-                        m_dst.m_combined_path_translate_backings[fill_rule].push_back(pos * f);
-                      }
+                    /* The position is multiplied by the reciprocal of the position
+                     * because the caller is expected to scale the rendering of the
+                     * paths BEFORE drawing the CombinedPath values.
+                     */
+                    float f(1.0f / m_dst.font().scaling_factor());
+
+                    m_dst.m_combined_path_backings[fill_rule].push_back(path);
+                    m_dst.m_combined_path_translate_backings[fill_rule].push_back(pos * f);
                   }
               }
           }
       }
   }
 
-private:
   TextItem &m_dst;
 };
 
@@ -246,7 +375,9 @@ private:
 // astral::TextItem methods
 astral::TextItem::
 TextItem(const Font &font, enum image_glyph_handing_t handling):
-  m_font(font)
+  m_font(font),
+  m_pending_glyph_handling(wait_for_glyphs),
+  m_scalable_glyph_handling(use_item_path_glyphs)
 {
   Typeface &typeface(font.typeface());
   if (typeface.is_scalable() || handling == use_strike_as_indicated_by_font)
@@ -293,6 +424,7 @@ clear(void)
   m_glyphs.clear();
   m_bb.clear();
   m_color_glyphs.clear();
+  m_pending_glyphs.clear();
   for (unsigned int i = 0; i < number_fill_rule; ++i)
     {
       m_combined_path_backings[i].clear();
@@ -313,6 +445,39 @@ clear(const Font &font)
   m_font = font;
 }
 
+void
+astral::TextItem::
+scalable_glyph_handling(enum scalable_glyph_handling_t v)
+{
+  if (v == m_scalable_glyph_handling)
+    {
+      return;
+    }
+
+  m_scalable_glyph_handling = v;
+  if (!m_font.typeface().is_scalable())
+    {
+      return;
+    }
+
+  /* The distance field of a glyph is used when the glyph
+   * appears at a pixel size less than twice that of the
+   * distance field, i.e. at most 2x magnification.
+   */
+  m_per_render_size.clear();
+  if (v == use_distance_field_glyphs_when_cheaper)
+    {
+      float max_pixel_size(2.0f * static_cast<float>(Glyph::distance_field_pixel_size));
+
+      m_per_render_size.push_back(PerRenderSize(0.0f, true));
+      m_per_render_size.push_back(PerRenderSize(max_pixel_size, false));
+    }
+  else
+    {
+      m_per_render_size.push_back(PerRenderSize(m_font));
+    }
+}
+
 void
 astral::TextItem::
 add_glyphs(c_array<const GlyphIndex> glyph_indices,
@@ -331,6 +496,43 @@ add_glyphs(c_array<const GlyphIndex> glyph_indices,
   Helper(*this).add_glyphs(glyph_indices, glyph_positions, P);
 }
 
+unsigned int
+astral::TextItem::
+update_pending_glyphs(void)
+{
+  return Helper(*this).update_pending_glyphs();
+}
+
+unsigned int
+astral::TextItem::
+number_pending_glyphs(void) const
+{
+  return m_pending_glyphs.size();
+}
+
+void
+astral::TextItem::
+pending_glyph(unsigned int idx, GlyphIndex *out_glyph_index,
+              vec2 *out_position, GlyphPaletteID *out_palette) const
+{
+  ASTRALassert(idx < m_pending_glyphs.size());
+
+  if (out_glyph_index)
+    {
+      *out_glyph_index = m_pending_glyphs[idx].m_glyph_index;
+    }
+
+  if (out_position)
+    {
+      *out_position = m_pending_glyphs[idx].m_position;
+    }
+
+  if (out_palette)
+    {
+      *out_palette = m_pending_glyphs[idx].m_palette;
+    }
+}
+
 int
 astral::TextItem::
 compute_render_size_index(float zoom_factor) const
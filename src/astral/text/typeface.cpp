@@ -14,57 +14,108 @@
  *
  */
 
-#include <thread>
-#include <iostream>
-
-#if !defined(__EMSCRIPTEN__) || defined(__EMSCRIPTEN_PTHREADS__)
+#include <deque>
+#include <mutex>
 #include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <iostream>
+#include <condition_variable>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define ASTRAL_GLYPH_CACHE_MMAP
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #endif
 
 #include <astral/path.hpp>
 #include <astral/util/util.hpp>
+#include <astral/util/thread_pool.hpp>
 #include <astral/text/font.hpp>
 #include <astral/text/typeface.hpp>
 #include <astral/renderer/combined_path.hpp>
 #include <astral/renderer/render_engine.hpp>
 
+#include "../serialized_data.hpp"
+#include "distance_field_generator.hpp"
+
 #ifdef __EMSCRIPTEN__
 #include <emscripten.h>
 #include <emscripten/threading.h>
 #endif
 
-/* TODO: if too many glyphs are realized on GPU is getting too big,
- *       walk the  (not yet made) list of ejectable glyphs and
- *       eject some glyphs.
- */
+namespace
+{
+  /* Returns the name of a temporary file next to filename that
+   * is unique to the process and to the call so that two writers
+   * of the same glyph cache file never write the same file.
+   */
+  std::string
+  make_temporary_filename(const std::string &filename)
+  {
+    static std::atomic<unsigned int> counter(0u);
+    std::ostringstream str;
+
+    str << filename << ".";
+    #ifdef ASTRAL_GLYPH_CACHE_MMAP
+      {
+        str << ::getpid() << ".";
+      }
+    #endif
+    str << counter.fetch_add(1u) << ".tmp";
+
+    return str.str();
+  }
+}
 
 class astral::Typeface::Implement:public astral::Typeface
 {
 public:
+  /* Job added to the glyph thread pool by prefetch_glyphs(),
+   * it generates glyphs from m_prefetch_queue until the queue
+   * is empty.
+   */
+  class PrefetchJob;
+
+  /* A glyph cache file loaded, i.e. memory mapped, from disk */
+  class CacheFile;
+
   explicit
   Implement(const reference_counted_ptr<const GlyphGenerator> &generator,
             const ItemPath::GenerationParams &params);
 
   ~Implement();
 
+  /* Returns the glyph, generating it on the calling thread
+   * if its generation has not yet started and waiting for
+   * it if it is being generated by a worker thread. Only
+   * to be called from the thread that owns the Typeface.
+   */
   Glyph::Private&
-  fetch_glyph(unsigned int thread_slot, GlyphIndex glyph_code);
-
-  void
-  instance_glyph(unsigned int thread_slot, GlyphIndex glyph_code)
-  {
-    const Glyph::Private &G(fetch_glyph(thread_slot, glyph_code));
-    ASTRALunused(G);
-  }
+  fetch_glyph(GlyphIndex glyph_code);
 
-  void
-  add_to_list(std::vector<GlyphIndex> *dst, GlyphIndex glyph_code);
+  bool
+  glyph_inited(GlyphIndex glyph_code) const;
 
+  /* Add the glyphs to m_prefetch_queue and add jobs to the
+   * glyph thread pool so that at most max_jobs jobs drain
+   * the queue.
+   */
   void
-  remove_from_list(GlyphIndex glyph_code);
+  prefetch_glyphs(c_array<const GlyphIndex> glyph_indices,
+                  unsigned int max_jobs);
 
-  bool
-  glyph_inited(GlyphIndex glyph_code);
+  unsigned int
+  number_glyphs_pending(void) const
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_number_glyphs_pending;
+  }
 
   unsigned int
   number_threads(void) const
@@ -120,11 +171,6 @@ public:
     return *m_generator;
   }
 
-  void
-  parallel_fetch_glyphs(unsigned int number_threads,
-                        c_array<const GlyphIndex> glyph_indices,
-                        c_array<Glyph> out_glyphs);
-
   const ItemPath::GenerationParams&
   implement_item_path_params(void) const
   {
@@ -139,9 +185,138 @@ public:
     return R;
   }
 
+  static
+  std::string&
+  glyph_cache_directory_storage(void)
+  {
+    static std::string R;
+    return R;
+  }
+
+  /* Write the glyph data to dst as a SerializedGlyph followed by the
+   * arrays it refers to; returns false if the ItemPath data is no
+   * longer on the CPU.
+   */
+  static
+  bool
+  serialize_glyph(const GlyphMetrics &metrics, const Path &path,
+                  enum fill_rule_t fill_rule, const ItemPath &item_path,
+                  std::vector<uint8_t> *dst);
+
+  /* Read the glyph data written by serialize_glyph() */
+  static
+  bool
+  deserialize_glyph(c_array<const uint8_t> src, GlyphMetrics *out_metrics,
+                    Path *out_path, enum fill_rule_t *out_fill_rule,
+                    reference_counted_ptr<ItemPath> *out_item_path);
+
+  /* implements Typeface::save_glyph_cache() */
+  enum return_code
+  save_glyph_cache(void);
+
+  /* mark that the cache file does not have all the
+   * glyphs generated, i.e. save_glyph_cache() is to
+   * write the file
+   */
+  void
+  mark_cache_dirty(void)
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_cache_dirty = true;
+  }
+
+  /* Add the glyph to the memory accounting, called by the thread
+   * owning the Typeface the first time a glyph is fetched after
+   * it is generated.
+   */
+  void
+  account_glyph(Glyph::Private &G);
+
+  /* Account the glyphs generated by a PrefetchJob that are not
+   * yet accounted, called by the thread owning the Typeface.
+   */
+  void
+  account_prefetched_glyphs(void);
+
+  /* Update the memory accounting of an accounted glyph whose
+   * data changed and release glyphs if over budget.
+   */
+  void
+  update_resident_bytes(Glyph::Private &G);
+
+  /* called when the lock count of an accounted glyph changes
+   * between zero and non-zero; an accounted glyph is on the
+   * list of evictable glyphs exactly when its lock count is
+   * zero.
+   */
+  void
+  glyph_locked(Glyph::Private *G);
+
+  void
+  glyph_unlocked(Glyph::Private *G);
+
+  /* release the data of the least recently used
+   * unlocked glyphs until within the budget
+   */
+  void
+  enforce_glyph_memory_budget(void);
+
+  void
+  glyph_memory_budget(uint64_t v)
+  {
+    m_glyph_memory_budget = v;
+    account_prefetched_glyphs();
+    enforce_glyph_memory_budget();
+  }
+
+  uint64_t
+  glyph_memory_budget(void) const
+  {
+    return m_glyph_memory_budget;
+  }
+
+  const GlyphMemoryStats&
+  glyph_memory_stats(void) const
+  {
+    return m_glyph_memory_stats;
+  }
+
+  static
+  uint64_t&
+  default_glyph_memory_budget_storage(void)
+  {
+    static uint64_t R(0u);
+    return R;
+  }
+
+  static
+  std::mutex&
+  glyph_thread_pool_mutex(void)
+  {
+    static std::mutex R;
+    return R;
+  }
+
+  static
+  reference_counted_ptr<ThreadPool>&
+  glyph_thread_pool_storage(void)
+  {
+    static reference_counted_ptr<ThreadPool> R;
+    return R;
+  }
+
 private:
+  /* Generate a glyph whose state has been set to Glyph::Private::state_generating;
+   * m_mutex must be locked by lock before calling and is locked by lock on return.
+   * The thread slot passed to the generator is taken from m_free_thread_slots
+   * for the duration of the generation.
+   */
+  void
+  generate_glyph(std::unique_lock<std::mutex> &lock, GlyphIndex glyph_code);
+
+  /* executes the work of a PrefetchJob */
   void
-  parallel_fetch_glyphs_execute(unsigned int thread_slot);
+  prefetch_job_execute(void);
 
   reference_counted_ptr<const GlyphGenerator> m_generator;
   CharacterMapping m_mapping;
@@ -156,24 +331,94 @@ private:
    */
   unsigned int m_smallest_strike;
 
-  /* data for parallel glyph fetching */
-  std::vector<GlyphIndex> m_parallel_fetch_glyph_list;
-  std::vector<std::thread> m_parallel_fetch_threads;
-  std::vector<int> m_parallel_fetch_stats;
-#ifdef __EMSCRIPTEN__
-  std::vector<range_type<unsigned int>> m_parallel_fetch_ranges;
-#else
-  std::atomic<int> m_parallel_fetch_current;
-#endif
+  /* Protects the glyph states, m_prefetch_queue, m_free_thread_slots,
+   * m_number_prefetch_jobs and m_number_glyphs_pending. Once the state
+   * of a glyph is Glyph::Private::state_ready, the glyph is only
+   * accessed by the thread that owns the Typeface and the lock is
+   * not needed.
+   */
+  mutable std::mutex m_mutex;
+
+  /* signaled when a glyph becomes ready, when a thread slot
+   * is released or when a PrefetchJob finishes
+   */
+  std::condition_variable m_condition;
+
+  /* glyphs waiting to be generated by a PrefetchJob; an element
+   * whose glyph is no longer in state_queued is skipped.
+   */
+  std::deque<GlyphIndex> m_prefetch_queue;
+
+  /* thread slots of m_generator not in use */
+  std::vector<unsigned int> m_free_thread_slots;
+
+  /* number of PrefetchJob objects added to m_thread_pool that
+   * have not yet finished
+   */
+  unsigned int m_number_prefetch_jobs;
+
+  /* number of glyphs in state_queued or state_generating */
+  unsigned int m_number_glyphs_pending;
+
+  /* the value of glyph_thread_pool() at the first prefetch */
+  reference_counted_ptr<ThreadPool> m_thread_pool;
+
+  /* glyphs generated by a PrefetchJob to be accounted by
+   * account_prefetched_glyphs(); protected by m_mutex, the
+   * flag allows to skip locking when the list is empty.
+   */
+  std::vector<GlyphIndex> m_prefetched_glyphs;
+  std::atomic<bool> m_has_prefetched_glyphs;
+
+  /* The on-disk glyph cache; m_cache_filename is empty if the
+   * cache is not used and m_cache_file is null if the file
+   * did not exist or was not valid. The value of m_cache_file
+   * is protected by m_mutex; a thread generating a glyph keeps
+   * a reference to the CacheFile it reads from. The value of
+   * m_cache_dirty is true if a glyph was generated that is not
+   * in the cache file, it is also protected by m_mutex.
+   */
+  std::string m_cache_key, m_cache_filename;
+  reference_counted_ptr<const CacheFile> m_cache_file;
+  bool m_cache_dirty;
+
+  /* The glyphs that are accounted and unlocked ordered from least
+   * recently to most recently used; the list and the memory
+   * accounting are only accessed by the thread that owns the
+   * Typeface.
+   */
+  Glyph::Private *m_lru_head, *m_lru_tail;
+  uint64_t m_glyph_memory_budget;
+  GlyphMemoryStats m_glyph_memory_stats;
 };
 
 class astral::Glyph::Private
 {
 public:
+  enum state_t
+    {
+      /* glyph data not generated */
+      state_uninit,
+
+      /* glyph is on Typeface::Implement::m_prefetch_queue */
+      state_queued,
+
+      /* glyph data is being generated */
+      state_generating,
+
+      /* glyph data is generated */
+      state_ready,
+    };
+
   Private(void):
-    m_init_called(false),
+    m_state(state_uninit),
     m_lock_counter(0),
-    m_on_list(false),
+    m_lru_prev(nullptr),
+    m_lru_next(nullptr),
+    m_on_lru(false),
+    m_accounted(false),
+    m_evicted(false),
+    m_resident_bytes(0u),
     m_typeface(nullptr)
   {}
 
@@ -183,9 +428,21 @@ public:
   }
 
   bool
-  inited(void)
+  inited(void) const
+  {
+    return state() == state_ready;
+  }
+
+  enum state_t
+  state(void) const
+  {
+    return static_cast<enum state_t>(m_state.load(std::memory_order_acquire));
+  }
+
+  void
+  state(enum state_t v)
   {
-    return m_init_called;
+    m_state.store(v, std::memory_order_release);
   }
 
   void
@@ -200,6 +457,30 @@ public:
                   unsigned int thread_slot,
                   GlyphIndex idx);
 
+  /* Initialize the glyph from the data of a glyph cache
+   * file; returns false, leaving the glyph unchanged, if
+   * the data is not valid.
+   */
+  bool
+  init_scalable_from_cache(Typeface::Implement *typeface,
+                           GlyphIndex idx,
+                           c_array<const uint8_t> src);
+
+  /* Write the data of the glyph for the glyph cache file to
+   * cache_data(); nothing is written for colored glyphs.
+   */
+  void
+  create_cache_data(void);
+
+  /* data written by create_cache_data() that is not yet
+   * written to the glyph cache file
+   */
+  std::vector<uint8_t>&
+  cache_data(void)
+  {
+    return m_cache_data;
+  }
+
   const GlyphMetrics&
   scalable_metrics(void) const
   {
@@ -279,47 +560,52 @@ public:
   image_render_data(RenderEngine &engine, unsigned int strike_index,
                     reference_counted_ptr<const Image> *out_image);
 
+  reference_counted_ptr<const StaticData>
+  distance_field_render_data(RenderEngine &engine,
+                             reference_counted_ptr<const Image> *out_image);
+
+  /* Release the data of the glyph, returning it to state_uninit;
+   * the caller must have m_mutex of the Typeface locked.
+   */
   void
   eject(void);
 
+  /* Returns an estimate of the number of bytes used by the
+   * data of the glyph, see Typeface::GlyphMemoryStats
+   */
+  uint64_t
+  compute_resident_bytes(void) const;
+
+  bool
+  accounted(void) const
+  {
+    return m_accounted;
+  }
+
   void
   increment_lock(void)
   {
-    /* TODO: if m_lock_counter increments from zero
-     *       to non-zero, remove it from the (not yet
-     *       made) list of ejectable glyphs.
-     */
+    if (m_lock_counter == 0u && m_on_lru)
+      {
+        m_typeface->glyph_locked(this);
+      }
     ++m_lock_counter;
   }
 
   void
   decrement_lock(void)
   {
-    /* TODO: if m_lock_counter decrements from non-zero
-     *       to zero, add it to the (not yet made) list
-     *       of ejectable glyphs.
-     */
     ASTRALassert(m_lock_counter > 0);
     --m_lock_counter;
-  }
-
-  void
-  add_to_list(std::vector<GlyphIndex> *dst, GlyphIndex idx)
-  {
-    if (!m_on_list)
+    if (m_lock_counter == 0u && m_accounted)
       {
-        m_on_list = true;
-        dst->push_back(GlyphIndex(idx));
+        m_typeface->glyph_unlocked(this);
       }
   }
 
-  void
-  remove_from_list(void)
-  {
-    m_on_list = false;
-  }
-
 private:
+  friend class Typeface::Implement;
+
   class PerStrike
   {
   public:
@@ -332,14 +618,25 @@ private:
   void
   generate_image(RenderEngine &engine, unsigned int strike_index);
 
-  bool m_init_called;
+  void
+  generate_distance_field(RenderEngine &engine);
+
+  /* value is an enumeration of state_t; the state is
+   * only modified with Typeface::Implement::m_mutex
+   * locked, but it is read without the lock to quickly
+   * check if a glyph is ready.
+   */
+  std::atomic<int> m_state;
   unsigned int m_lock_counter;
 
-  /* when doing parallel glyph loading, this marks the
-   * glyph as already on the list to prevent it being
-   * on a list twice.
+  /* memory accounting of the glyph, only accessed by
+   * the thread that owns the Typeface; m_evicted is
+   * true if the data was released by eject() and the
+   * glyph has not been accounted since.
    */
-  bool m_on_list;
+  Private *m_lru_prev, *m_lru_next;
+  bool m_on_lru, m_accounted, m_evicted;
+  uint64_t m_resident_bytes;
 
   GlyphIndex m_glyph_index;
   std::vector<GlyphMetrics> m_metrics;
@@ -359,15 +656,209 @@ private:
   std::vector<reference_counted_ptr<ItemPath>> m_item_paths;
   std::vector<reference_counted_ptr<const StaticData>> m_render_data;
 
+  /* distance field image of a non-colored scalable glyph */
+  reference_counted_ptr<const Image> m_distance_field_image;
+  reference_counted_ptr<const StaticData> m_distance_field_data;
+
   /* data for image rendering */
   std::vector<PerStrike> m_strikes;
 
+  /* data for the glyph cache file */
+  std::vector<uint8_t> m_cache_data;
+
   /* transformation that maps [0, 1]x[0, 1]
    * to the coordinate system of the input paths
    */
   ScaleTranslate m_tr;
 };
 
+class astral::Typeface::Implement::PrefetchJob:public astral::ThreadPool::Job
+{
+public:
+  explicit
+  PrefetchJob(Implement *p):
+    m_typeface(p)
+  {}
+
+  virtual
+  void
+  execute(void) override
+  {
+    m_typeface->prefetch_job_execute();
+  }
+
+private:
+  /* raw pointer because the reference count of a Typeface is
+   * not thread safe; the dtor of Typeface::Implement waits for
+   * all of its PrefetchJob objects to finish.
+   */
+  Implement *m_typeface;
+};
+
+class astral::Typeface::Implement::CacheFile:public reference_counted<CacheFile>::concurrent
+{
+public:
+  ~CacheFile();
+
+  /* Returns nullptr if the file does not exist or if it is
+   * not a glyph cache file for the key, number of glyphs and
+   * generation parameters.
+   */
+  static
+  reference_counted_ptr<const CacheFile>
+  load(const std::string &filename, const std::string &key,
+       unsigned int number_glyphs, const ItemPath::GenerationParams &params);
+
+  /* Returns the data of the named glyph, an empty
+   * array if the glyph is not in the file.
+   */
+  c_array<const uint8_t>
+  glyph(GlyphIndex glyph_code) const;
+
+private:
+  CacheFile(void)
+  {}
+
+  bool
+  check(const std::string &key, unsigned int number_glyphs,
+        const ItemPath::GenerationParams &params);
+
+  c_array<const uint8_t> m_data;
+  c_array<const detail::SerializedGlyphLocation> m_locations;
+
+#ifndef ASTRAL_GLYPH_CACHE_MMAP
+  std::vector<uint8_t> m_backing;
+#endif
+};
+
+/////////////////////////////////////////////////////
+// astral::Typeface::Implement::CacheFile methods
+astral::Typeface::Implement::CacheFile::
+~CacheFile()
+{
+  #ifdef ASTRAL_GLYPH_CACHE_MMAP
+    {
+      if (!m_data.empty())
+        {
+          munmap(const_cast<uint8_t*>(m_data.c_ptr()), m_data.size());
+        }
+    }
+  #endif
+}
+
+astral::reference_counted_ptr<const astral::Typeface::Implement::CacheFile>
+astral::Typeface::Implement::CacheFile::
+load(const std::string &filename, const std::string &key,
+     unsigned int number_glyphs, const ItemPath::GenerationParams &params)
+{
+  reference_counted_ptr<CacheFile> return_value;
+
+  return_value = ASTRALnew CacheFile();
+  #ifdef ASTRAL_GLYPH_CACHE_MMAP
+    {
+      int fd;
+      struct stat st;
+      void *p(MAP_FAILED);
+
+      fd = open(filename.c_str(), O_RDONLY);
+      if (fd == -1)
+        {
+          return nullptr;
+        }
+
+      if (fstat(fd, &st) == 0 && st.st_size > 0)
+        {
+          p = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        }
+      close(fd);
+
+      if (p == MAP_FAILED)
+        {
+          return nullptr;
+        }
+      return_value->m_data = c_array<const uint8_t>(static_cast<const uint8_t*>(p), st.st_size);
+    }
+  #else
+    {
+      std::ifstream file(filename.c_str(), std::ios::binary);
+      std::ifstream::pos_type sz;
+
+      if (!file)
+        {
+          return nullptr;
+        }
+
+      file.seekg(0, std::ios::end);
+      sz = file.tellg();
+      file.seekg(0, std::ios::beg);
+      return_value->m_backing.resize(sz);
+      file.read(reinterpret_cast<char*>(return_value->m_backing.data()), sz);
+      if (!file)
+        {
+          return nullptr;
+        }
+      return_value->m_data = make_c_array(return_value->m_backing);
+    }
+  #endif
+
+  if (!return_value->check(key, number_glyphs, params))
+    {
+      return nullptr;
+    }
+
+  return return_value;
+}
+
+bool
+astral::Typeface::Implement::CacheFile::
+check(const std::string &key, unsigned int number_glyphs,
+      const ItemPath::GenerationParams &params)
+{
+  detail::SerializedReader reader(m_data);
+  detail::SerializedGlyphCacheHeader header;
+  c_array<const char> file_key;
+
+  return reader.read(0u, &header)
+    && header.m_magic == detail::serialized_glyph_cache_magic
+    && header.m_version == detail::serialized_version
+    && header.m_byte_order == detail::serialized_byte_order
+    && header.m_curve_size == sizeof(ContourCurve)
+    && header.m_size == m_data.size()
+    && header.m_number_glyphs == number_glyphs
+    && header.m_params_cost == params.m_cost
+    && header.m_params_max_recursion == params.m_max_recursion
+    && reader.read_array(header.m_key, header.m_key_size, &file_key)
+    && file_key.size() == key.size()
+    && std::memcmp(file_key.c_ptr(), key.data(), key.size()) == 0
+    && reader.read_array(header.m_glyphs, header.m_number_glyphs, &m_locations);
+}
+
+astral::c_array<const uint8_t>
+astral::Typeface::Implement::CacheFile::
+glyph(GlyphIndex glyph_code) const
+{
+  const detail::SerializedGlyphLocation *L;
+
+  if (glyph_code.m_value >= m_locations.size())
+    {
+      return c_array<const uint8_t>();
+    }
+
+  /* the data of a glyph must be aligned for reading the
+   * arrays it holds in place
+   */
+  L = &m_locations[glyph_code.m_value];
+  if (L->m_size == 0u
+      || L->m_offset % detail::serialized_alignment != 0u
+      || L->m_offset > m_data.size()
+      || L->m_size > m_data.size() - L->m_offset)
+    {
+      return c_array<const uint8_t>();
+    }
+
+  return m_data.sub_array(L->m_offset, L->m_size);
+}
+
 ///////////////////////////////////////////
 // astral::Typeface::Implement methods
 astral::Typeface::Implement::
@@ -378,11 +869,28 @@ Implement(const reference_counted_ptr<const GlyphGenerator> &generator,
   m_number_threads(m_generator->number_threads()),
   m_glyphs(m_generator->number_glyphs()),
   m_item_path_params(item_path_params),
-  m_smallest_strike(0)
+  m_smallest_strike(0),
+  m_number_prefetch_jobs(0u),
+  m_number_glyphs_pending(0u),
+  m_has_prefetched_glyphs(false),
+  m_cache_dirty(false),
+  m_lru_head(nullptr),
+  m_lru_tail(nullptr),
+  m_glyph_memory_budget(default_glyph_memory_budget_storage())
 {
   unsigned int thread_slot(0);
   c_array<const TypefaceMetricsFixedSize> fm(m_generator->fixed_metrics());
 
+  ASTRALassert(m_number_threads > 0u);
+
+  /* the slots are popped from the back, put slot 0 last so
+   * that it is the first used by the thread owning the Typeface
+   */
+  for (unsigned int i = m_number_threads; i > 0u; --i)
+    {
+      m_free_thread_slots.push_back(i - 1u);
+    }
+
   m_generator->fill_character_mapping(thread_slot, m_mapping);
   if (!fm.empty())
     {
@@ -400,61 +908,526 @@ Implement(const reference_counted_ptr<const GlyphGenerator> &generator,
             }
         }
     }
+
+  if (m_scalable && !glyph_cache_directory_storage().empty())
+    {
+      m_cache_key = m_generator->cache_key();
+      if (!m_cache_key.empty())
+        {
+          std::ostringstream str;
+          uint32_t cost_bits;
+
+          /* the generation parameters are part of the filename
+           * so that typefaces of the same font data but with
+           * different parameters use different files
+           */
+          std::memcpy(&cost_bits, &m_item_path_params.m_cost, sizeof(cost_bits));
+          str << glyph_cache_directory_storage() << "/" << m_cache_key
+              << "-" << std::hex << cost_bits << std::dec
+              << "-" << m_item_path_params.m_max_recursion << ".astral_glyphs";
+
+          m_cache_filename = str.str();
+          m_cache_file = CacheFile::load(m_cache_filename, m_cache_key,
+                                         m_glyphs.size(), m_item_path_params);
+        }
+    }
 }
 
 astral::Typeface::Implement::
 ~Implement()
 {
+  std::unique_lock<std::mutex> lock(m_mutex);
+
+  /* drop the glyphs not yet started and wait for the
+   * PrefetchJob objects to finish since they reference
+   * this Typeface
+   */
+  for (GlyphIndex g : m_prefetch_queue)
+    {
+      Glyph::Private &G(m_glyphs[g.m_value]);
+      if (G.state() == Glyph::Private::state_queued)
+        {
+          G.state(Glyph::Private::state_uninit);
+          --m_number_glyphs_pending;
+        }
+    }
+  m_prefetch_queue.clear();
+  m_condition.wait(lock, [this] { return m_number_prefetch_jobs == 0u; });
+  lock.unlock();
+
+  if (m_cache_dirty)
+    {
+      save_glyph_cache();
+    }
 }
 
 void
 astral::Typeface::Implement::
-add_to_list(std::vector<GlyphIndex> *dst, GlyphIndex glyph_code)
+generate_glyph(std::unique_lock<std::mutex> &lock, GlyphIndex glyph_code)
 {
-  ASTRALassert(glyph_code.m_value < m_glyphs.size());
-
   Glyph::Private &G(m_glyphs[glyph_code.m_value]);
-  if (!G.inited())
+  unsigned int thread_slot;
+  bool made_cache_data(false);
+
+  ASTRALassert(G.state() == Glyph::Private::state_generating);
+  m_condition.wait(lock, [this] { return !m_free_thread_slots.empty(); });
+  thread_slot = m_free_thread_slots.back();
+  m_free_thread_slots.pop_back();
+
+  /* keep a reference to the cache file in case
+   * save_glyph_cache() replaces it
+   */
+  reference_counted_ptr<const CacheFile> cache_file(m_cache_file);
+
+  lock.unlock();
+  if (m_scalable)
+    {
+      c_array<const uint8_t> cached;
+
+      if (cache_file)
+        {
+          cached = cache_file->glyph(glyph_code);
+        }
+
+      if (cached.empty() || !G.init_scalable_from_cache(this, glyph_code, cached))
+        {
+          G.init_scalable(this, *m_generator, thread_slot, glyph_code);
+          if (!m_cache_filename.empty())
+            {
+              G.create_cache_data();
+              made_cache_data = !G.cache_data().empty();
+            }
+        }
+    }
+  else
     {
-      G.add_to_list(dst, glyph_code);
+      G.init_fixed_size(this, *m_generator, thread_slot, glyph_code);
     }
+  cache_file.clear();
+  lock.lock();
+
+  m_cache_dirty = m_cache_dirty || made_cache_data;
+  m_free_thread_slots.push_back(thread_slot);
+  G.state(Glyph::Private::state_ready);
+
+  ASTRALassert(m_number_glyphs_pending > 0u);
+  --m_number_glyphs_pending;
+  m_condition.notify_all();
 }
 
-void
+bool
 astral::Typeface::Implement::
-remove_from_list(GlyphIndex glyph_code)
+serialize_glyph(const GlyphMetrics &metrics, const Path &path,
+                enum fill_rule_t fill_rule, const ItemPath &item_path,
+                std::vector<uint8_t> *dst)
 {
-  ASTRALassert(glyph_code.m_value < m_glyphs.size());
+  detail::SerializedWriter writer(dst);
+  detail::SerializedGlyph record;
+  std::vector<uint8_t> path_data;
+  uint64_t record_offset;
+
+  std::memset(&record, 0, sizeof(record));
+  record_offset = writer.allocate<detail::SerializedGlyph>();
+  if (!item_path.serialize(writer, &record.m_item_path))
+    {
+      dst->clear();
+      return false;
+    }
 
-  Glyph::Private &G(m_glyphs[glyph_code.m_value]);
-  G.remove_from_list();
+  path.serialize(&path_data);
+  record.m_path = writer.write_array(make_c_array(path_data));
+  record.m_path_size = path_data.size();
+  record.m_fill_rule = fill_rule;
+
+  record.m_horizontal_layout_offset[0] = metrics.m_horizontal_layout_offset.x();
+  record.m_horizontal_layout_offset[1] = metrics.m_horizontal_layout_offset.y();
+  record.m_vertical_layout_offset[0] = metrics.m_vertical_layout_offset.x();
+  record.m_vertical_layout_offset[1] = metrics.m_vertical_layout_offset.y();
+  record.m_size[0] = metrics.m_size.x();
+  record.m_size[1] = metrics.m_size.y();
+  record.m_advance[0] = metrics.m_advance.x();
+  record.m_advance[1] = metrics.m_advance.y();
+  record.m_bb.set(metrics.m_bb);
+
+  writer.write(record_offset, record);
+  return true;
+}
+
+bool
+astral::Typeface::Implement::
+deserialize_glyph(c_array<const uint8_t> src, GlyphMetrics *out_metrics,
+                  Path *out_path, enum fill_rule_t *out_fill_rule,
+                  reference_counted_ptr<ItemPath> *out_item_path)
+{
+  detail::SerializedReader reader(src);
+  detail::SerializedGlyph record;
+  c_array<const uint8_t> path_data;
+
+  if (!reader.read(0u, &record)
+      || record.m_fill_rule >= number_fill_rule
+      || !reader.read_array(record.m_path, record.m_path_size, &path_data)
+      || routine_fail == out_path->deserialize(path_data))
+    {
+      return false;
+    }
+
+  *out_item_path = ItemPath::deserialize(reader, record.m_item_path);
+  if (!*out_item_path)
+    {
+      return false;
+    }
+
+  *out_fill_rule = static_cast<enum fill_rule_t>(record.m_fill_rule);
+  out_metrics->m_horizontal_layout_offset = vec2(record.m_horizontal_layout_offset[0], record.m_horizontal_layout_offset[1]);
+  out_metrics->m_vertical_layout_offset = vec2(record.m_vertical_layout_offset[0], record.m_vertical_layout_offset[1]);
+  out_metrics->m_size = vec2(record.m_size[0], record.m_size[1]);
+  out_metrics->m_advance = vec2(record.m_advance[0], record.m_advance[1]);
+  out_metrics->m_bb = record.m_bb.get();
+
+  return true;
+}
+
+enum astral::return_code
+astral::Typeface::Implement::
+save_glyph_cache(void)
+{
+  reference_counted_ptr<const CacheFile> old_file, new_file;
+  std::vector<unsigned int> new_glyphs;
+  std::vector<uint8_t> data;
+  std::string tmp_filename;
+
+  if (m_cache_filename.empty())
+    {
+      return routine_fail;
+    }
+
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (!m_cache_dirty)
+      {
+        return routine_success;
+      }
+
+    /* only the glyphs that are ready; the cache data of
+     * a ready glyph is only accessed by this thread; a glyph
+     * still generating marks the cache dirty when it is done
+     */
+    m_cache_dirty = false;
+    old_file = m_cache_file;
+    for (unsigned int i = 0, endi = m_glyphs.size(); i < endi; ++i)
+      {
+        if (m_glyphs[i].inited() && !m_glyphs[i].cache_data().empty())
+          {
+            new_glyphs.push_back(i);
+          }
+      }
+  }
+
+  if (new_glyphs.empty())
+    {
+      return routine_success;
+    }
+
+  detail::SerializedWriter writer(&data);
+  detail::SerializedGlyphCacheHeader header;
+  uint64_t header_offset, locations_offset;
+
+  std::memset(&header, 0, sizeof(header));
+  header.m_magic = detail::serialized_glyph_cache_magic;
+  header.m_version = detail::serialized_version;
+  header.m_byte_order = detail::serialized_byte_order;
+  header.m_curve_size = sizeof(ContourCurve);
+  header.m_number_glyphs = m_glyphs.size();
+  header.m_params_cost = m_item_path_params.m_cost;
+  header.m_params_max_recursion = m_item_path_params.m_max_recursion;
+
+  header_offset = writer.allocate<detail::SerializedGlyphCacheHeader>();
+  header.m_key = writer.write_array(c_array<const char>(m_cache_key.data(), m_cache_key.size()));
+  header.m_key_size = m_cache_key.size();
+
+  locations_offset = writer.allocate<detail::SerializedGlyphLocation>(m_glyphs.size());
+  header.m_glyphs = locations_offset;
+
+  for (unsigned int i = 0, endi = m_glyphs.size(); i < endi; ++i)
+    {
+      detail::SerializedGlyphLocation L;
+      c_array<const uint8_t> glyph_data;
+
+      if (m_glyphs[i].inited() && !m_glyphs[i].cache_data().empty())
+        {
+          glyph_data = make_c_array(m_glyphs[i].cache_data());
+        }
+      else if (old_file)
+        {
+          glyph_data = old_file->glyph(GlyphIndex(i));
+        }
+
+      if (!glyph_data.empty())
+        {
+          L.m_offset = writer.write_array(glyph_data);
+          L.m_size = glyph_data.size();
+          writer.write(locations_offset, i, L);
+        }
+    }
+
+  header.m_size = writer.size();
+  writer.write(header_offset, header);
+
+  /* write to a temporary file and then rename it so that
+   * the cache file is never seen partially written
+   */
+  tmp_filename = make_temporary_filename(m_cache_filename);
+  {
+    std::ofstream file(tmp_filename.c_str(), std::ios::binary | std::ios::trunc);
+
+    file.write(reinterpret_cast<const char*>(data.data()), data.size());
+    if (!file)
+      {
+        std::remove(tmp_filename.c_str());
+        mark_cache_dirty();
+        return routine_fail;
+      }
+  }
+
+  if (std::rename(tmp_filename.c_str(), m_cache_filename.c_str()) != 0)
+    {
+      std::remove(tmp_filename.c_str());
+      mark_cache_dirty();
+      return routine_fail;
+    }
+
+  /* the glyphs written are now read from the new file */
+  new_file = CacheFile::load(m_cache_filename, m_cache_key, m_glyphs.size(), m_item_path_params);
+  if (new_file)
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+
+      m_cache_file = new_file;
+      for (unsigned int i : new_glyphs)
+        {
+          std::vector<uint8_t> tmp;
+          m_glyphs[i].cache_data().swap(tmp);
+        }
+    }
+  else
+    {
+      /* the glyphs still hold their cache data, keep
+       * them for the next save
+       */
+      mark_cache_dirty();
+    }
+
+  if (new_file)
+    {
+      for (unsigned int i : new_glyphs)
+        {
+          if (m_glyphs[i].accounted())
+            {
+              update_resident_bytes(m_glyphs[i]);
+            }
+        }
+    }
+
+  return routine_success;
 }
 
 astral::Glyph::Private&
 astral::Typeface::Implement::
-fetch_glyph(unsigned int thread_slot, GlyphIndex glyph_code)
+fetch_glyph(GlyphIndex glyph_code)
 {
   ASTRALassert(glyph_code.m_value < m_glyphs.size());
 
   Glyph::Private &G(m_glyphs[glyph_code.m_value]);
   if (!G.inited())
     {
-      if (m_scalable)
+      std::unique_lock<std::mutex> lock(m_mutex);
+
+      switch (G.state())
         {
-          G.init_scalable(this, *m_generator, thread_slot, glyph_code);
+        case Glyph::Private::state_uninit:
+          ++m_number_glyphs_pending;
+          /* fall through */
+
+        case Glyph::Private::state_queued:
+          /* generation has not started, generate it here;
+           * its entry in m_prefetch_queue is skipped by
+           * the PrefetchJob objects
+           */
+          G.state(Glyph::Private::state_generating);
+          generate_glyph(lock, glyph_code);
+          break;
+
+        default:
+          m_condition.wait(lock, [&G] { return G.inited(); });
         }
-      else
+    }
+  ASTRALassert(G.inited());
+  return G;
+}
+
+void
+astral::Typeface::Implement::
+account_glyph(Glyph::Private &G)
+{
+  ASTRALassert(G.inited());
+  ASTRALassert(!G.m_accounted);
+
+  G.m_accounted = true;
+  G.m_resident_bytes = G.compute_resident_bytes();
+  m_glyph_memory_stats.m_resident_bytes += G.m_resident_bytes;
+  ++m_glyph_memory_stats.m_resident_glyphs;
+
+  if (G.m_evicted)
+    {
+      G.m_evicted = false;
+      ++m_glyph_memory_stats.m_number_regenerations;
+    }
+
+  if (G.m_lock_counter == 0u)
+    {
+      glyph_unlocked(&G);
+    }
+  else
+    {
+      enforce_glyph_memory_budget();
+    }
+}
+
+void
+astral::Typeface::Implement::
+account_prefetched_glyphs(void)
+{
+  std::vector<GlyphIndex> glyphs;
+
+  if (!m_has_prefetched_glyphs)
+    {
+      return;
+    }
+
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    glyphs.swap(m_prefetched_glyphs);
+    m_has_prefetched_glyphs = false;
+  }
+
+  /* a glyph may have been fetched, and thus accounted, since it
+   * was generated or it may have been evicted since; the glyphs
+   * are unlocked and so are put on the LRU by account_glyph().
+   */
+  for (GlyphIndex g : glyphs)
+    {
+      Glyph::Private &G(m_glyphs[g.m_value]);
+      if (G.inited() && !G.accounted())
         {
-          G.init_fixed_size(this, *m_generator, thread_slot, glyph_code);
+          account_glyph(G);
         }
     }
-  ASTRALassert(G.inited());
-  return G;
+}
+
+void
+astral::Typeface::Implement::
+update_resident_bytes(Glyph::Private &G)
+{
+  uint64_t v;
+
+  ASTRALassert(G.m_accounted);
+  v = G.compute_resident_bytes();
+
+  ASTRALassert(m_glyph_memory_stats.m_resident_bytes >= G.m_resident_bytes);
+  m_glyph_memory_stats.m_resident_bytes -= G.m_resident_bytes;
+  m_glyph_memory_stats.m_resident_bytes += v;
+  G.m_resident_bytes = v;
+
+  enforce_glyph_memory_budget();
+}
+
+void
+astral::Typeface::Implement::
+glyph_locked(Glyph::Private *G)
+{
+  ASTRALassert(G->m_on_lru);
+
+  if (G->m_lru_prev)
+    {
+      G->m_lru_prev->m_lru_next = G->m_lru_next;
+    }
+  else
+    {
+      ASTRALassert(m_lru_head == G);
+      m_lru_head = G->m_lru_next;
+    }
+
+  if (G->m_lru_next)
+    {
+      G->m_lru_next->m_lru_prev = G->m_lru_prev;
+    }
+  else
+    {
+      ASTRALassert(m_lru_tail == G);
+      m_lru_tail = G->m_lru_prev;
+    }
+
+  G->m_lru_prev = G->m_lru_next = nullptr;
+  G->m_on_lru = false;
+}
+
+void
+astral::Typeface::Implement::
+glyph_unlocked(Glyph::Private *G)
+{
+  ASTRALassert(!G->m_on_lru);
+  ASTRALassert(G->m_accounted);
+
+  G->m_lru_prev = m_lru_tail;
+  G->m_lru_next = nullptr;
+  if (m_lru_tail)
+    {
+      m_lru_tail->m_lru_next = G;
+    }
+  else
+    {
+      m_lru_head = G;
+    }
+  m_lru_tail = G;
+  G->m_on_lru = true;
+
+  enforce_glyph_memory_budget();
+}
+
+void
+astral::Typeface::Implement::
+enforce_glyph_memory_budget(void)
+{
+  if (m_glyph_memory_budget == 0u
+      || m_glyph_memory_stats.m_resident_bytes <= m_glyph_memory_budget
+      || !m_lru_head)
+    {
+      return;
+    }
+
+  /* the state of a glyph is only modified with m_mutex locked */
+  std::lock_guard<std::mutex> lock(m_mutex);
+  while (m_lru_head && m_glyph_memory_stats.m_resident_bytes > m_glyph_memory_budget)
+    {
+      Glyph::Private *G(m_lru_head);
+
+      glyph_locked(G);
+
+      ASTRALassert(m_glyph_memory_stats.m_resident_bytes >= G->m_resident_bytes);
+      ASTRALassert(m_glyph_memory_stats.m_resident_glyphs > 0u);
+      m_glyph_memory_stats.m_resident_bytes -= G->m_resident_bytes;
+      --m_glyph_memory_stats.m_resident_glyphs;
+      ++m_glyph_memory_stats.m_number_evictions;
+
+      G->eject();
+    }
 }
 
 bool
 astral::Typeface::Implement::
-glyph_inited(GlyphIndex glyph_code)
+glyph_inited(GlyphIndex glyph_code) const
 {
   ASTRALassert(glyph_code.m_value < m_glyphs.size());
   return m_glyphs[glyph_code.m_value].inited();
@@ -462,111 +1435,111 @@ glyph_inited(GlyphIndex glyph_code)
 
 void
 astral::Typeface::Implement::
-parallel_fetch_glyphs_execute(unsigned int thread_slot)
+prefetch_job_execute(void)
 {
-  unsigned int w;
+  std::unique_lock<std::mutex> lock(m_mutex);
 
-  m_parallel_fetch_stats[thread_slot] = 0u;
-  #ifndef __EMSCRIPTEN__
-    {
-      while ((w = m_parallel_fetch_current.fetch_add(1u, std::memory_order_relaxed)) < m_parallel_fetch_glyph_list.size())
-        {
-          instance_glyph(thread_slot, m_parallel_fetch_glyph_list[w]);
-          ++m_parallel_fetch_stats[thread_slot];
-        }
-    }
-  #else
+  while (!m_prefetch_queue.empty())
     {
-      for (w = m_parallel_fetch_ranges[thread_slot].m_begin; w < m_parallel_fetch_ranges[thread_slot].m_end; ++w)
+      GlyphIndex g(m_prefetch_queue.front());
+      Glyph::Private &G(m_glyphs[g.m_value]);
+
+      m_prefetch_queue.pop_front();
+      if (G.state() == Glyph::Private::state_queued)
         {
-          instance_glyph(thread_slot, m_parallel_fetch_glyph_list[w]);
-          ++m_parallel_fetch_stats[thread_slot];
+          G.state(Glyph::Private::state_generating);
+          generate_glyph(lock, g);
+          m_prefetched_glyphs.push_back(g);
+          m_has_prefetched_glyphs = true;
         }
     }
-  #endif
+
+  /* the check that the queue is empty and the decrement are
+   * in the same critical section so that prefetch_glyphs()
+   * never sees a job counted that will not drain the glyphs
+   * it adds.
+   */
+  ASTRALassert(m_number_prefetch_jobs > 0u);
+  --m_number_prefetch_jobs;
+  m_condition.notify_all();
 }
 
 void
 astral::Typeface::Implement::
-parallel_fetch_glyphs(unsigned int pnumber_threads,
-                      c_array<const GlyphIndex> glyph_indices,
-                      c_array<Glyph> out_glyphs)
+prefetch_glyphs(c_array<const GlyphIndex> glyph_indices,
+                unsigned int max_jobs)
 {
-  ASTRALassert(pnumber_threads <= number_threads());
-
-  #if defined(__EMSCRIPTEN__) && defined(EMSCRIPTEN_NUMBER_THREADS)
+  #if defined(__EMSCRIPTEN__) && !defined(__EMSCRIPTEN_PTHREADS__)
     {
-      const unsigned int v(EMSCRIPTEN_NUMBER_THREADS);
-      pnumber_threads = t_min(pnumber_threads, v);
+      /* build does not have pthreads, glyphs are
+       * generated when they are fetched
+       */
+      ASTRALunused(glyph_indices);
+      ASTRALunused(max_jobs);
     }
-  #endif
-
-  /* For a list of the glyphs needed without repetition */
-  ASTRALassert(m_parallel_fetch_threads.empty());
-  ASTRALassert(m_parallel_fetch_glyph_list.empty());
-
-  for (GlyphIndex g : glyph_indices)
+  #else
     {
-      add_to_list(&m_parallel_fetch_glyph_list, g);
-    }
-  m_parallel_fetch_stats.resize(pnumber_threads);
+      reference_counted_ptr<ThreadPool> pool;
+      unsigned int number_new_jobs(0u);
 
-  #ifdef __EMSCRIPTEN__
-    {
-      /* Relying on an atomic counter fetch_add() to get a
-       * glyph to instance under Emscripten starves all of
-       * the other threads (unless the main thread calls
-       * often emscripten_main_thread_process_queued_calls()
-       * which has wierd performance impact). So instead,
-       * just say up front what glyphs each thread gets.
-       * The only issue with the below simple ranges is that
-       * if one thread has a high percentage of heavy glyphs,
-       * then the load across threads will be unbalanced.
-       * Oh well.
-       */
-      unsigned int cnt = m_parallel_fetch_glyph_list.size() / pnumber_threads;
+      {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        for (GlyphIndex g : glyph_indices)
+          {
+            ASTRALassert(g.m_value < m_glyphs.size());
+
+            Glyph::Private &G(m_glyphs[g.m_value]);
+            if (G.state() == Glyph::Private::state_uninit)
+              {
+                G.state(Glyph::Private::state_queued);
+                m_prefetch_queue.push_back(g);
+                ++m_number_glyphs_pending;
+              }
+          }
+
+        if (m_prefetch_queue.empty())
+          {
+            return;
+          }
+
+        if (!m_thread_pool)
+          {
+            m_thread_pool = Typeface::glyph_thread_pool();
+          }
+        pool = m_thread_pool;
+
+        /* When the generator has more than one thread slot, leave
+         * a slot for the thread that owns the Typeface so that
+         * fetch_glyph() does not wait for a slot.
+         */
+        max_jobs = t_min(max_jobs, t_max(1u, m_number_threads - 1u));
+        max_jobs = t_min(max_jobs, t_max(1u, pool->number_threads()));
+
+        #if defined(__EMSCRIPTEN__) && defined(EMSCRIPTEN_NUMBER_THREADS)
+          {
+            const unsigned int v(EMSCRIPTEN_NUMBER_THREADS);
+            max_jobs = t_min(max_jobs, v);
+          }
+        #endif
+
+        while (m_number_prefetch_jobs < max_jobs
+               && m_number_prefetch_jobs < m_prefetch_queue.size())
+          {
+            ++m_number_prefetch_jobs;
+            ++number_new_jobs;
+          }
+      }
 
-      m_parallel_fetch_ranges.clear();
-      for (unsigned int i = 0; i < pnumber_threads; ++i)
+      /* add the jobs without the lock because a pool without
+       * worker threads executes the job within add_job()
+       */
+      for (unsigned int i = 0; i < number_new_jobs; ++i)
         {
-          range_type<unsigned int> R;
-
-          R.m_begin = i * cnt;
-          R.m_end = i * cnt + cnt;
-          m_parallel_fetch_ranges.push_back(R);
+          pool->add_job(ASTRALnew PrefetchJob(this));
         }
-      m_parallel_fetch_ranges.back().m_end = m_parallel_fetch_glyph_list.size();
-    }
-  #else
-    {
-      m_parallel_fetch_current.store(0);
     }
   #endif
-
-  for (unsigned int i = 1; i < pnumber_threads; ++i)
-    {
-      m_parallel_fetch_threads.push_back(std::thread(&Implement::parallel_fetch_glyphs_execute, this, i));
-    }
-
-  parallel_fetch_glyphs_execute(0);
-  for (auto &T : m_parallel_fetch_threads)
-    {
-      T.join();
-    }
-
-  for (GlyphIndex g : m_parallel_fetch_glyph_list)
-    {
-      remove_from_list(g);
-    }
-
-  m_parallel_fetch_threads.clear();
-  m_parallel_fetch_glyph_list.clear();
-
-  /* now set the glyph output */
-  for (unsigned int i = 0; i < glyph_indices.size(); ++i)
-    {
-      out_glyphs[i] = Glyph(&fetch_glyph(0, glyph_indices[i]));
-    }
 }
 
 ////////////////////////////////////////////////////
@@ -578,7 +1551,6 @@ init_scalable(Typeface::Implement *typeface,
               unsigned int thread_slot,
               GlyphIndex idx)
 {
-  m_init_called = true;
   m_glyph_index = idx;
   m_typeface = typeface;
 
@@ -619,6 +1591,60 @@ init_scalable(Typeface::Implement *typeface,
   m_tr.m_translate = m_metrics[0].m_bb.min_point();
 }
 
+bool
+astral::Glyph::Private::
+init_scalable_from_cache(Typeface::Implement *typeface,
+                         GlyphIndex idx,
+                         c_array<const uint8_t> src)
+{
+  GlyphMetrics metrics;
+  Path path;
+  enum fill_rule_t fill_rule;
+  reference_counted_ptr<ItemPath> item_path;
+
+  if (!Typeface::Implement::deserialize_glyph(src, &metrics, &path, &fill_rule, &item_path))
+    {
+      return false;
+    }
+
+  m_glyph_index = idx;
+  m_typeface = typeface;
+  m_is_colored = false;
+  m_colors.clear();
+
+  m_metrics.resize(1);
+  m_metrics[0] = metrics;
+
+  m_paths.resize(1);
+  m_paths[0].swap(path);
+
+  m_fill_rules.resize(1);
+  m_fill_rules[0] = fill_rule;
+
+  m_item_paths.resize(1);
+  m_item_paths[0] = item_path;
+
+  m_render_data.resize(1);
+
+  /* map [0, 1]x[0, 1] to bb */
+  m_tr.m_scale = m_metrics[0].m_bb.size();
+  m_tr.m_translate = m_metrics[0].m_bb.min_point();
+
+  return true;
+}
+
+void
+astral::Glyph::Private::
+create_cache_data(void)
+{
+  m_cache_data.clear();
+  if (!m_is_colored && m_paths.size() == 1u)
+    {
+      Typeface::Implement::serialize_glyph(m_metrics[0], m_paths[0], m_fill_rules[0],
+                                           *m_item_paths[0], &m_cache_data);
+    }
+}
+
 astral::reference_counted_ptr<const astral::StaticData>
 astral::Glyph::Private::
 render_data(RenderEngine &engine, GlyphPaletteID palette)
@@ -656,6 +1682,10 @@ render_data(RenderEngine &engine, GlyphPaletteID palette)
       ItemPath::pack_data(engine, make_const_c_array(layers), tmp);
 
       m_render_data[palette.m_value] = engine.static_data_allocator32().create(tmp);
+      if (m_accounted)
+        {
+          m_typeface->update_resident_bytes(*this);
+        }
     }
   return m_render_data[palette.m_value];
 }
@@ -667,7 +1697,6 @@ init_fixed_size(Typeface::Implement *typeface,
                 unsigned int thread_slot,
                 GlyphIndex idx)
 {
-  m_init_called = true;
   m_glyph_index = idx;
   m_typeface = typeface;
   m_is_colored = false;
@@ -698,16 +1727,87 @@ void
 astral::Glyph::Private::
 eject(void)
 {
-  if (m_lock_counter == 0)
+  if (m_lock_counter == 0 && inited())
     {
-      m_init_called = false;
+      state(state_uninit);
       m_colors.clear();
       m_paths.clear();
       m_fill_rules.clear();
       m_item_paths.clear();
       m_render_data.clear();
+      m_distance_field_image.clear();
+      m_distance_field_data.clear();
       m_strikes.clear();
+
+      /* the data has not been written to the glyph cache
+       * file; the glyph is written when it is generated
+       * again.
+       */
+      std::vector<uint8_t>().swap(m_cache_data);
+
+      ASTRALassert(!m_on_lru);
+      m_accounted = false;
+      m_evicted = true;
+      m_resident_bytes = 0u;
+    }
+}
+
+uint64_t
+astral::Glyph::Private::
+compute_resident_bytes(void) const
+{
+  uint64_t return_value(m_cache_data.size());
+
+  for (const Path &P : m_paths)
+    {
+      for (unsigned int c = 0, endc = P.number_contours(); c < endc; ++c)
+        {
+          return_value += P.contour(c).number_curves() * sizeof(ContourCurve);
+        }
+    }
+
+  for (const auto &I : m_item_paths)
+    {
+      if (I)
+        {
+          const ItemPath::Properties &props(I->properties());
+
+          /* fp16 data is four 16-bit values per element */
+          return_value += props.m_fp16_data_size * 4u * sizeof(uint16_t);
+          return_value += props.m_generic_data_size * sizeof(gvec4);
+        }
+    }
+
+  for (const auto &R : m_render_data)
+    {
+      if (R)
+        {
+          return_value += R->size() * sizeof(gvec4);
+        }
+    }
+
+  if (m_distance_field_image)
+    {
+      uvec2 sz(m_distance_field_image->size());
+      return_value += sz.x() * sz.y() * sizeof(FixedPointColor_sRGB);
+    }
+
+  if (m_distance_field_data)
+    {
+      return_value += m_distance_field_data->size() * sizeof(gvec4);
+    }
+
+  for (const PerStrike &S : m_strikes)
+    {
+      return_value += S.m_image_data.size() * sizeof(FixedPointColor_sRGB);
+      if (S.m_image)
+        {
+          uvec2 sz(S.m_image->size());
+          return_value += sz.x() * sz.y() * sizeof(FixedPointColor_sRGB);
+        }
     }
+
+  return return_value;
 }
 
 astral::reference_counted_ptr<const astral::StaticData>
@@ -720,6 +1820,10 @@ image_render_data(RenderEngine &engine, unsigned int strike_index,
   if (!m_strikes[strike_index].m_image)
     {
       generate_image(engine, strike_index);
+      if (m_accounted)
+        {
+          m_typeface->update_resident_bytes(*this);
+        }
     }
   if (out_image)
     {
@@ -833,6 +1937,86 @@ generate_image(RenderEngine &engine, unsigned int strike_index)
   m_strikes[strike_index].m_static_data = engine.pack_image_sampler_as_static_data(image_sampler);
 }
 
+astral::reference_counted_ptr<const astral::StaticData>
+astral::Glyph::Private::
+distance_field_render_data(RenderEngine &engine,
+                           reference_counted_ptr<const Image> *out_image)
+{
+  ASTRALassert(is_scalable());
+  ASTRALassert(!is_colored());
+  if (!m_distance_field_data)
+    {
+      generate_distance_field(engine);
+      if (m_accounted)
+        {
+          m_typeface->update_resident_bytes(*this);
+        }
+    }
+  if (out_image)
+    {
+      *out_image = m_distance_field_image;
+    }
+
+  return m_distance_field_data;
+}
+
+void
+astral::Glyph::Private::
+generate_distance_field(RenderEngine &engine)
+{
+  const unsigned int padding(Glyph::distance_field_padding);
+  const unsigned int number_levels(Glyph::distance_field_number_mipmap_levels);
+  const unsigned int alignment(1u << (number_levels - 1u));
+  const BoundingBox<float> &bb(m_metrics[0].m_bb);
+  reference_counted_ptr<Image> im;
+  std::vector<uint8_t> values;
+  std::vector<u8vec4> pixels;
+  float texels_per_unit;
+  uvec2 sz;
+
+  ASTRALassert(!m_distance_field_image);
+  ASTRALassert(!m_distance_field_data);
+  ASTRALassert(m_paths.size() == 1u);
+
+  /* The size of the glyph region is rounded up so that the
+   * size of each mipmap level is exactly half of the level
+   * before it; the rounding stretches the glyph by less than
+   * a texel of the last level.
+   */
+  texels_per_unit = static_cast<float>(Glyph::distance_field_pixel_size)
+    / m_typeface->scalable_metrics().m_units_per_EM;
+  for (unsigned int c = 0; c < 2; ++c)
+    {
+      unsigned int v;
+
+      v = static_cast<unsigned int>(std::ceil(texels_per_unit * bb.size()[c])) + 2u * padding;
+      v = t_max(v, 2u * padding + 1u);
+      sz[c] = alignment * ((v + alignment - 1u) / alignment);
+    }
+
+  detail::DistanceFieldGenerator generator(m_paths[0], m_fill_rules[0], bb, sz, padding);
+
+  im = engine.image_atlas().create_image(number_levels, sz, colorspace_linear);
+  for (unsigned int L = 0; L < im->number_mipmap_levels(); ++L)
+    {
+      uvec2 level_sz(generator.level_size(L));
+
+      values.resize(level_sz.x() * level_sz.y());
+      pixels.resize(values.size());
+      generator.generate(L, make_c_array(values));
+      for (unsigned int i = 0, endi = values.size(); i < endi; ++i)
+        {
+          pixels[i] = u8vec4(values[i]);
+        }
+      im->set_pixels(L, ivec2(0, 0), ivec2(level_sz), level_sz.x(), make_c_array(pixels));
+    }
+
+  m_distance_field_image = im;
+  m_distance_field_data = engine.pack_image_sampler_as_static_data(ImageSampler(*im, mask_type_distance_field,
+                                                                                mask_channel_red, filter_linear,
+                                                                                mipmap_ceiling));
+}
+
 /////////////////////////////////////
 // astral::Glyph methods
 astral::Glyph::
@@ -988,6 +2172,24 @@ image_render_data(RenderEngine &engine, unsigned int strike_index,
   return m_private->image_render_data(engine, strike_index, out_image);
 }
 
+astral::reference_counted_ptr<const astral::StaticData>
+astral::Glyph::
+distance_field_render_data(RenderEngine &engine,
+                           reference_counted_ptr<const Image> *out_image) const
+{
+  ASTRALassert(valid());
+  if (!is_scalable() || is_colored())
+    {
+      if (out_image)
+        {
+          *out_image = nullptr;
+        }
+      return nullptr;
+    }
+
+  return m_private->distance_field_render_data(engine, out_image);
+}
+
 /////////////////////////////////////
 // astral::Typeface methods
 astral::reference_counted_ptr<astral::Typeface>
@@ -1080,8 +2282,19 @@ fetch_glyph(GlyphIndex glyph_code)
   Glyph::Private *g;
 
   p = static_cast<Implement*>(this);
-  g = &p->fetch_glyph(0, glyph_code);
-  return Glyph(g);
+  g = &p->fetch_glyph(glyph_code);
+
+  /* account the glyph after the handle is made so that
+   * it is locked and cannot be evicted by the accounting
+   */
+  Glyph return_value(g);
+  if (!g->accounted())
+    {
+      p->account_glyph(*g);
+    }
+  p->account_prefetched_glyphs();
+
+  return return_value;
 }
 
 void
@@ -1104,25 +2317,141 @@ fetch_glyphs_parallel(unsigned int number_threads,
 {
   Typeface::Implement *p;
 
+  ASTRALassert(glyph_indices.size() == out_glyphs.size());
   p = static_cast<Typeface::Implement*>(this);
+  number_threads = t_min(number_threads, p->number_threads());
 
-  #if defined(__EMSCRIPTEN__) && !defined(__EMSCRIPTEN_PTHREADS__)
-    {
-      /* build does not have pthreads, just do unparallel fetching */
-      number_threads = 1;
-    }
-  #else
+  /* the calling thread is one of the threads; it generates
+   * the glyphs the workers of the pool have not yet started
+   * as it fetches them in order.
+   */
+  if (number_threads > 1u)
     {
-      number_threads = t_min(number_threads, p->number_threads());
+      p->prefetch_glyphs(glyph_indices, number_threads - 1u);
     }
-  #endif
+  fetch_glyphs(glyph_indices, out_glyphs);
+}
 
-  if (number_threads > 1)
-    {
-      p->parallel_fetch_glyphs(number_threads, glyph_indices, out_glyphs);
-    }
-  else
+void
+astral::Typeface::
+prefetch_glyphs(c_array<const GlyphIndex> glyph_indices)
+{
+  Implement *p;
+
+  p = static_cast<Implement*>(this);
+  p->account_prefetched_glyphs();
+  p->prefetch_glyphs(glyph_indices, p->number_threads());
+  p->account_prefetched_glyphs();
+}
+
+bool
+astral::Typeface::
+glyph_ready(GlyphIndex glyph_code) const
+{
+  const Implement *p;
+
+  p = static_cast<const Implement*>(this);
+  return p->glyph_inited(glyph_code);
+}
+
+unsigned int
+astral::Typeface::
+number_glyphs_pending(void) const
+{
+  const Implement *p;
+
+  p = static_cast<const Implement*>(this);
+  return p->number_glyphs_pending();
+}
+
+void
+astral::Typeface::
+glyph_cache_directory(c_string dir)
+{
+  Implement::glyph_cache_directory_storage() = (dir) ? dir : "";
+}
+
+astral::c_string
+astral::Typeface::
+glyph_cache_directory(void)
+{
+  return Implement::glyph_cache_directory_storage().c_str();
+}
+
+enum astral::return_code
+astral::Typeface::
+save_glyph_cache(void)
+{
+  Implement *p;
+
+  p = static_cast<Implement*>(this);
+  return p->save_glyph_cache();
+}
+
+void
+astral::Typeface::
+glyph_memory_budget(uint64_t bytes)
+{
+  Implement *p;
+
+  p = static_cast<Implement*>(this);
+  p->glyph_memory_budget(bytes);
+}
+
+uint64_t
+astral::Typeface::
+glyph_memory_budget(void) const
+{
+  const Implement *p;
+
+  p = static_cast<const Implement*>(this);
+  return p->glyph_memory_budget();
+}
+
+astral::Typeface::GlyphMemoryStats
+astral::Typeface::
+glyph_memory_stats(void) const
+{
+  Implement *p;
+
+  /* the glyphs realized by prefetching are part of
+   * the memory used even if not yet fetched
+   */
+  p = static_cast<Implement*>(const_cast<Typeface*>(this));
+  p->account_prefetched_glyphs();
+  return p->glyph_memory_stats();
+}
+
+uint64_t
+astral::Typeface::
+default_glyph_memory_budget(void)
+{
+  return Implement::default_glyph_memory_budget_storage();
+}
+
+void
+astral::Typeface::
+default_glyph_memory_budget(uint64_t bytes)
+{
+  Implement::default_glyph_memory_budget_storage() = bytes;
+}
+
+void
+astral::Typeface::
+glyph_thread_pool(const reference_counted_ptr<ThreadPool> &pool)
+{
+  std::lock_guard<std::mutex> lock(Implement::glyph_thread_pool_mutex());
+  Implement::glyph_thread_pool_storage() = pool;
+}
+
+astral::reference_counted_ptr<astral::ThreadPool>
+astral::Typeface::
+glyph_thread_pool(void)
+{
+  std::lock_guard<std::mutex> lock(Implement::glyph_thread_pool_mutex());
+  if (!Implement::glyph_thread_pool_storage())
     {
-      fetch_glyphs(glyph_indices, out_glyphs);
+      Implement::glyph_thread_pool_storage() = ThreadPool::create();
     }
+  return Implement::glyph_thread_pool_storage();
 }
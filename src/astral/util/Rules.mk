@@ -15,7 +15,8 @@ ASTRAL_SOURCES += $(call filelist, static_resource.cpp \
         data_buffer.cpp api_callback.cpp matrix.cpp \
 	clip_util.cpp interval_allocator.cpp \
 	layered_rect_atlas.cpp tile_allocator.cpp \
-	transformed_bounding_box.cpp)
+	transformed_bounding_box.cpp thread_pool.cpp \
+	texel_processing.cpp polynomial_batch.cpp)
 
 # Begin standard footer
 d		:= $(dirstack_$(sp))
@@ -23,10 +23,17 @@ class astral::IntervalAllocator::Layer
 public:
   Layer(void):
     m_head(nullptr),
-    m_tail(nullptr)
+    m_tail(nullptr),
+    m_number_allocated(0u),
+    m_space_allocated(0u)
   {}
 
   IntervalImplement *m_head, *m_tail;
+
+  /* number and total length of the intervals
+   * allocated on the layer
+   */
+  unsigned int m_number_allocated, m_space_allocated;
 };
 
 class astral::IntervalAllocator::IntervalImplement:public astral::IntervalAllocator::Interval
@@ -452,7 +459,8 @@ astral::IntervalAllocator::
 IntervalAllocator(unsigned int length, unsigned int number_layers):
   m_layer_length(0),
   m_number_layers(0),
-  m_number_allocated(0)
+  m_number_allocated(0),
+  m_space_allocated(0u)
 {
   m_pool = ASTRALnew MemoryPool();
   clear(length, number_layers);
@@ -489,6 +497,7 @@ clear(unsigned int new_length, unsigned int new_number_layers)
   ASTRALassert(m_free_list.size() == new_length + 1);
 
   m_number_allocated = 0;
+  m_space_allocated = 0u;
   m_layer_length = new_length;
   m_number_layers = new_number_layers;
   m_layer.clear();
@@ -514,10 +523,22 @@ void
 astral::IntervalAllocator::
 number_layers(unsigned int L)
 {
-  ASTRALassert(L > m_number_layers);
-
   unsigned int old_size(m_number_layers);
 
+  /* the removed layers have nothing allocated, so each
+   * of them is a single free interval
+   */
+  for (unsigned int layer = L; layer < m_number_layers; ++layer)
+    {
+      IntervalImplement *q(m_layer[layer].m_head);
+
+      ASTRALassert(m_layer[layer].m_number_allocated == 0u);
+      ASTRALassert(q && q == m_layer[layer].m_tail && q->is_free());
+
+      q->remove_from_free_list(*this);
+      m_pool->reclaim(q);
+    }
+
   m_layer.resize(L);
   m_number_layers = L;
   for (; old_size < m_number_layers; ++old_size)
@@ -574,6 +595,9 @@ allocate(int size)
   return_value = m_pool->create(*this, q, size);
 
   ++m_number_allocated;
+  m_space_allocated += size;
+  ++m_layer[return_value->layer()].m_number_allocated;
+  m_layer[return_value->layer()].m_space_allocated += size;
   return return_value;
 }
 
@@ -584,6 +608,12 @@ release(const Interval *p)
   IntervalImplement *pp;
 
   pp = static_cast<IntervalImplement*>(const_cast<Interval*>(p));
+
+  ASTRALassert(m_layer[pp->layer()].m_number_allocated > 0u);
+  --m_layer[pp->layer()].m_number_allocated;
+  m_layer[pp->layer()].m_space_allocated -= pp->size();
+  m_space_allocated -= pp->size();
+
   pp->add_to_free_list(*this);
 
   if (pp->prev_is_free())
@@ -598,6 +628,22 @@ release(const Interval *p)
   --m_number_allocated;
 }
 
+unsigned int
+astral::IntervalAllocator::
+number_allocated(unsigned int layer) const
+{
+  ASTRALassert(layer < m_layer.size());
+  return m_layer[layer].m_number_allocated;
+}
+
+unsigned int
+astral::IntervalAllocator::
+space_allocated(unsigned int layer) const
+{
+  ASTRALassert(layer < m_layer.size());
+  return m_layer[layer].m_space_allocated;
+}
+
 unsigned int
 astral::IntervalAllocator::
 check(unsigned int layer)
@@ -0,0 +1,325 @@
+/*!
+ * \file polynomial_batch.cpp
+ * \brief file polynomial_batch.cpp
+ *
+ * Copyright 2020 by InvisionApp.
+ *
+ * Contact: kevinrogovin@invisionapp.com
+ *
+ * This Source Code Form is subject to the
+ * terms of the Mozilla Public License, v. 2.0.
+ * If a copy of the MPL was not distributed with
+ * this file, You can obtain one at
+ * http://mozilla.org/MPL/2.0/.
+ *
+ */
+
+#include <astral/util/polynomial.hpp>
+#include <astral/util/polynomial_batch.hpp>
+#include "simd.hpp"
+
+namespace
+{
+  using namespace astral::detail::simd;
+
+  /* The vectorized routines below must perform the same operations
+   * in the same order as solve_quadratic() and solve_cubic() so that
+   * the results are the same as solving each polynomial by itself.
+   * They need exact division and square root, so ARMv7 NEON takes
+   * the scalar path.
+   */
+  /* Solve Q(t) = v for a single quadratic Q */
+  void
+  solve_quadratic_scalar(astral::vecN<float, 3> Q, float v,
+                         astral::vecN<float, 2> *out_solutions,
+                         unsigned int *out_number_solutions)
+  {
+    Q[0] -= v;
+    *out_number_solutions = astral::solve_quadratic<float>(Q, *out_solutions);
+  }
+
+  /* Solve P(t) = v for a single cubic P */
+  void
+  solve_cubic_scalar(astral::vecN<float, 4> P, float v,
+                     astral::vecN<float, 3> *out_solutions,
+                     unsigned int *out_number_solutions)
+  {
+    P[0] -= v;
+    *out_number_solutions = astral::solve_cubic<float>(P, *out_solutions);
+  }
+
+#if defined(ASTRAL_SIMD_NATIVE_DIV_SQRT)
+  /* Solve 4 quadratic equations at once; Q[k] holds the coefficient
+   * of t^k of each of the 4 equations, the coefficient of t^0 has
+   * already had the value subtracted from it. Both branches of
+   * solve_quadratic() are computed and the one taken by each lane
+   * is selected afterwards.
+   */
+  void
+  solve_quadratic4(const astral::vecN<astral::vecN<float, 4>, 3> &Q,
+                   astral::vecN<float, 2> *out_solutions,
+                   unsigned int *out_number_solutions)
+  {
+    simd_float q0, q1, q2, zero, inverse_quad, descr, root_descr;
+    simd_float neg_q1, plus_root, minus_root, half_inverse, two_q0;
+    simd_float s0, s1;
+    simd_mask q1_negative, linear;
+    unsigned int linear_bits, no_linear_root_bits, no_quad_root_bits;
+    float r0[4], r1[4];
+
+    q0 = simd_load(Q[0].c_ptr());
+    q1 = simd_load(Q[1].c_ptr());
+    q2 = simd_load(Q[2].c_ptr());
+    zero = simd_splat(0.0f);
+
+    inverse_quad = simd_div(simd_splat(1.0f), q2);
+    descr = simd_sub(simd_mul(q1, q1), simd_mul(simd_mul(simd_splat(4.0f), q0), q2));
+
+    /* t_max(0, descr) */
+    root_descr = simd_sqrt(simd_select(simd_less(zero, descr), descr, zero));
+
+    neg_q1 = simd_neg(q1);
+    plus_root = simd_add(neg_q1, root_descr);
+    minus_root = simd_sub(neg_q1, root_descr);
+    half_inverse = simd_mul(simd_splat(0.5f), inverse_quad);
+    two_q0 = simd_mul(simd_splat(2.0f), q0);
+
+    q1_negative = simd_less(q1, zero);
+    s0 = simd_select(q1_negative,
+                     simd_mul(half_inverse, plus_root),
+                     simd_div(two_q0, minus_root));
+    s1 = simd_select(q1_negative,
+                     simd_div(two_q0, plus_root),
+                     simd_mul(half_inverse, minus_root));
+
+    /* lanes where the leading coefficient is zero are linear */
+    linear = simd_equal(q2, zero);
+    s0 = simd_select(linear, simd_div(simd_neg(q0), q1), s0);
+
+    linear_bits = simd_mask_bits(linear);
+    no_linear_root_bits = simd_mask_bits(simd_equal(q1, zero));
+    no_quad_root_bits = simd_mask_bits(simd_less(descr, zero));
+
+    simd_store(r0, s0);
+    simd_store(r1, s1);
+    for (unsigned int k = 0; k < 4; ++k)
+      {
+        unsigned int bit(1u << k);
+
+        out_solutions[k][0] = r0[k];
+        out_solutions[k][1] = r1[k];
+        if (linear_bits & bit)
+          {
+            out_number_solutions[k] = (no_linear_root_bits & bit) ? 0u : 1u;
+          }
+        else
+          {
+            out_number_solutions[k] = (no_quad_root_bits & bit) ? 0u : 2u;
+          }
+      }
+  }
+
+  /* Solve 4 cubic equations at once; P[k] holds the coefficient
+   * of t^k of each of the 4 equations, the coefficient of t^0 has
+   * already had the value subtracted from it. The reduction to a
+   * depressed cubic is done with SIMD, the trigonometric and cube
+   * root evaluation of solve_depressed_cubic() is done per lane.
+   */
+  void
+  solve_cubic4(const astral::vecN<astral::vecN<float, 4>, 4> &P,
+               astral::vecN<float, 3> *out_solutions,
+               unsigned int *out_number_solutions)
+  {
+    simd_float inverse_a, b, c, d, b3, q, p, offset;
+    float pp[4], qq[4], oo[4];
+
+    inverse_a = simd_div(simd_splat(1.0f), simd_load(P[3].c_ptr()));
+    b = simd_mul(simd_load(P[2].c_ptr()), inverse_a);
+    c = simd_mul(simd_load(P[1].c_ptr()), inverse_a);
+    d = simd_mul(simd_load(P[0].c_ptr()), inverse_a);
+    b3 = simd_mul(simd_mul(b, b), b);
+
+    q = simd_div(simd_add(simd_sub(simd_mul(simd_splat(2.0f), b3),
+                                   simd_mul(simd_mul(simd_splat(9.0f), b), c)),
+                          simd_mul(simd_splat(27.0f), d)),
+                 simd_splat(54.0f));
+    p = simd_div(simd_sub(simd_mul(b, b), simd_mul(simd_splat(3.0f), c)),
+                 simd_splat(9.0f));
+    offset = simd_div(simd_neg(b), simd_splat(3.0f));
+
+    simd_store(pp, p);
+    simd_store(qq, q);
+    simd_store(oo, offset);
+    for (unsigned int k = 0; k < 4; ++k)
+      {
+        if (P[3][k] == 0.0f)
+          {
+            astral::vecN<float, 3> Q(P[0][k], P[1][k], P[2][k]);
+            out_number_solutions[k] = astral::solve_quadratic<float>(Q, out_solutions[k]);
+          }
+        else
+          {
+            out_number_solutions[k] = astral::solve_depressed_cubic<float>(pp[k], qq[k], oo[k],
+                                                                           out_solutions[k]);
+          }
+      }
+  }
+#endif
+}
+
+astral::c_string
+astral::detail::
+polynomial_batch_instruction_set(void)
+{
+  #if defined(ASTRAL_SIMD_SSE2)
+    {
+      return "SSE2";
+    }
+  #elif defined(ASTRAL_SIMD_NEON) && defined(ASTRAL_SIMD_NATIVE_DIV_SQRT)
+    {
+      return "NEON";
+    }
+  #else
+    {
+      return "scalar";
+    }
+  #endif
+}
+
+void
+astral::detail::
+solve_quadratic_batch(c_array<const vecN<float, 3>> Q, float v,
+                      c_array<vecN<float, 2>> out_solutions,
+                      c_array<unsigned int> out_number_solutions)
+{
+  unsigned int i(0);
+
+  ASTRALassert(out_solutions.size() == Q.size());
+  ASTRALassert(out_number_solutions.size() == Q.size());
+
+  #if defined(ASTRAL_SIMD_NATIVE_DIV_SQRT)
+    {
+      for (; i + 4u <= Q.size(); i += 4u)
+        {
+          vecN<vecN<float, 4>, 3> coeffs;
+
+          for (unsigned int k = 0; k < 4; ++k)
+            {
+              coeffs[0][k] = Q[i + k][0] - v;
+              coeffs[1][k] = Q[i + k][1];
+              coeffs[2][k] = Q[i + k][2];
+            }
+          solve_quadratic4(coeffs, &out_solutions[i], &out_number_solutions[i]);
+        }
+    }
+  #endif
+
+  for (; i < Q.size(); ++i)
+    {
+      solve_quadratic_scalar(Q[i], v, &out_solutions[i], &out_number_solutions[i]);
+    }
+}
+
+void
+astral::detail::
+solve_quadratic_batch(const vecN<float, 3> &Q, c_array<const float> v,
+                      c_array<vecN<float, 2>> out_solutions,
+                      c_array<unsigned int> out_number_solutions)
+{
+  unsigned int i(0);
+
+  ASTRALassert(out_solutions.size() == v.size());
+  ASTRALassert(out_number_solutions.size() == v.size());
+
+  #if defined(ASTRAL_SIMD_NATIVE_DIV_SQRT)
+    {
+      vecN<vecN<float, 4>, 3> coeffs;
+
+      coeffs[1] = vecN<float, 4>(Q[1]);
+      coeffs[2] = vecN<float, 4>(Q[2]);
+      for (; i + 4u <= v.size(); i += 4u)
+        {
+          for (unsigned int k = 0; k < 4; ++k)
+            {
+              coeffs[0][k] = Q[0] - v[i + k];
+            }
+          solve_quadratic4(coeffs, &out_solutions[i], &out_number_solutions[i]);
+        }
+    }
+  #endif
+
+  for (; i < v.size(); ++i)
+    {
+      solve_quadratic_scalar(Q, v[i], &out_solutions[i], &out_number_solutions[i]);
+    }
+}
+
+void
+astral::detail::
+solve_cubic_batch(c_array<const vecN<float, 4>> P, float v,
+                  c_array<vecN<float, 3>> out_solutions,
+                  c_array<unsigned int> out_number_solutions)
+{
+  unsigned int i(0);
+
+  ASTRALassert(out_solutions.size() == P.size());
+  ASTRALassert(out_number_solutions.size() == P.size());
+
+  #if defined(ASTRAL_SIMD_NATIVE_DIV_SQRT)
+    {
+      for (; i + 4u <= P.size(); i += 4u)
+        {
+          vecN<vecN<float, 4>, 4> coeffs;
+
+          for (unsigned int k = 0; k < 4; ++k)
+            {
+              coeffs[0][k] = P[i + k][0] - v;
+              coeffs[1][k] = P[i + k][1];
+              coeffs[2][k] = P[i + k][2];
+              coeffs[3][k] = P[i + k][3];
+            }
+          solve_cubic4(coeffs, &out_solutions[i], &out_number_solutions[i]);
+        }
+    }
+  #endif
+
+  for (; i < P.size(); ++i)
+    {
+      solve_cubic_scalar(P[i], v, &out_solutions[i], &out_number_solutions[i]);
+    }
+}
+
+void
+astral::detail::
+solve_cubic_batch(const vecN<float, 4> &P, c_array<const float> v,
+                  c_array<vecN<float, 3>> out_solutions,
+                  c_array<unsigned int> out_number_solutions)
+{
+  unsigned int i(0);
+
+  ASTRALassert(out_solutions.size() == v.size());
+  ASTRALassert(out_number_solutions.size() == v.size());
+
+  #if defined(ASTRAL_SIMD_NATIVE_DIV_SQRT)
+    {
+      vecN<vecN<float, 4>, 4> coeffs;
+
+      coeffs[1] = vecN<float, 4>(P[1]);
+      coeffs[2] = vecN<float, 4>(P[2]);
+      coeffs[3] = vecN<float, 4>(P[3]);
+      for (; i + 4u <= v.size(); i += 4u)
+        {
+          for (unsigned int k = 0; k < 4; ++k)
+            {
+              coeffs[0][k] = P[0] - v[i + k];
+            }
+          solve_cubic4(coeffs, &out_solutions[i], &out_number_solutions[i]);
+        }
+    }
+  #endif
+
+  for (; i < v.size(); ++i)
+    {
+      solve_cubic_scalar(P, v[i], &out_solutions[i], &out_number_solutions[i]);
+    }
+}
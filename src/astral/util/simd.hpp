@@ -0,0 +1,291 @@
+/*!
+ * \file simd.hpp
+ * \brief file simd.hpp
+ *
+ * Copyright 2020 by InvisionApp.
+ *
+ * Contact: kevinrogovin@invisionapp.com
+ *
+ * This Source Code Form is subject to the
+ * terms of the Mozilla Public License, v. 2.0.
+ * If a copy of the MPL was not distributed with
+ * this file, You can obtain one at
+ * http://mozilla.org/MPL/2.0/.
+ *
+ */
+
+#ifndef ASTRAL_SIMD_HPP
+#define ASTRAL_SIMD_HPP
+
+#include <cmath>
+#include <stdint.h>
+#include <astral/util/util.hpp>
+
+/* Exactly one of ASTRAL_SIMD_SSE2, ASTRAL_SIMD_NEON or
+ * ASTRAL_SIMD_SCALAR is defined. ASTRAL_SIMD_SCALAR emulates
+ * the 4 lanes with plain floats so that code written against
+ * the wrappers below still compiles without SIMD; callers that
+ * have a faster scalar path should use it instead under
+ * ASTRAL_SIMD_SCALAR.
+ *
+ * ASTRAL_SIMD_NATIVE_DIV_SQRT is defined when simd_div() and
+ * simd_sqrt() are single instructions. ARMv7 NEON has no exact
+ * division or square root, there they are done one lane at a
+ * time.
+ */
+#if defined(__SSE2__) || defined(_M_X64)
+  #include <emmintrin.h>
+  #define ASTRAL_SIMD_SSE2
+  #define ASTRAL_SIMD_NATIVE_DIV_SQRT
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+  #include <arm_neon.h>
+  #define ASTRAL_SIMD_NEON
+  #if defined(__aarch64__)
+    #define ASTRAL_SIMD_NATIVE_DIV_SQRT
+  #endif
+#else
+  #define ASTRAL_SIMD_SCALAR
+#endif
+
+namespace astral
+{
+  namespace detail
+  {
+    /* Thin wrappers over 4 lanes of float; every wrapper is a
+     * single IEEE operation per lane so that code written with
+     * them gives the same values as the same operations done
+     * one float at a time. A simd_mask has all bits of a lane
+     * up where a comparison is true.
+     */
+    namespace simd
+    {
+      enum
+        {
+          simd_width = 4
+        };
+
+#if defined(ASTRAL_SIMD_SSE2)
+      typedef __m128 simd_float;
+      typedef __m128 simd_mask;
+
+      inline simd_float simd_load(const float *p) { return _mm_loadu_ps(p); }
+      inline void simd_store(float *p, simd_float v) { _mm_storeu_ps(p, v); }
+      inline simd_float simd_splat(float v) { return _mm_set1_ps(v); }
+      inline simd_float simd_add(simd_float a, simd_float b) { return _mm_add_ps(a, b); }
+      inline simd_float simd_sub(simd_float a, simd_float b) { return _mm_sub_ps(a, b); }
+      inline simd_float simd_mul(simd_float a, simd_float b) { return _mm_mul_ps(a, b); }
+      inline simd_float simd_div(simd_float a, simd_float b) { return _mm_div_ps(a, b); }
+      inline simd_float simd_sqrt(simd_float a) { return _mm_sqrt_ps(a); }
+      inline simd_float simd_min(simd_float a, simd_float b) { return _mm_min_ps(a, b); }
+      inline simd_float simd_max(simd_float a, simd_float b) { return _mm_max_ps(a, b); }
+      inline simd_float simd_neg(simd_float a) { return _mm_xor_ps(a, _mm_set1_ps(-0.0f)); }
+      inline simd_float simd_abs(simd_float a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+
+      inline simd_mask simd_less(simd_float a, simd_float b) { return _mm_cmplt_ps(a, b); }
+      inline simd_mask simd_le(simd_float a, simd_float b) { return _mm_cmple_ps(a, b); }
+      inline simd_mask simd_ge(simd_float a, simd_float b) { return _mm_cmpge_ps(a, b); }
+      inline simd_mask simd_equal(simd_float a, simd_float b) { return _mm_cmpeq_ps(a, b); }
+      inline simd_mask simd_and(simd_mask a, simd_mask b) { return _mm_and_ps(a, b); }
+      inline simd_mask simd_or(simd_mask a, simd_mask b) { return _mm_or_ps(a, b); }
+      inline unsigned int simd_mask_bits(simd_mask m) { return _mm_movemask_ps(m); }
+
+      /* returns a where m is set and b otherwise */
+      inline
+      simd_float
+      simd_select(simd_mask m, simd_float a, simd_float b)
+      {
+        return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b));
+      }
+#elif defined(ASTRAL_SIMD_NEON)
+      typedef float32x4_t simd_float;
+      typedef uint32x4_t simd_mask;
+
+      inline simd_float simd_load(const float *p) { return vld1q_f32(p); }
+      inline void simd_store(float *p, simd_float v) { vst1q_f32(p, v); }
+      inline simd_float simd_splat(float v) { return vdupq_n_f32(v); }
+      inline simd_float simd_add(simd_float a, simd_float b) { return vaddq_f32(a, b); }
+      inline simd_float simd_sub(simd_float a, simd_float b) { return vsubq_f32(a, b); }
+      inline simd_float simd_mul(simd_float a, simd_float b) { return vmulq_f32(a, b); }
+      inline simd_float simd_min(simd_float a, simd_float b) { return vminq_f32(a, b); }
+      inline simd_float simd_max(simd_float a, simd_float b) { return vmaxq_f32(a, b); }
+      inline simd_float simd_neg(simd_float a) { return vnegq_f32(a); }
+      inline simd_float simd_abs(simd_float a) { return vabsq_f32(a); }
+
+      inline simd_mask simd_less(simd_float a, simd_float b) { return vcltq_f32(a, b); }
+      inline simd_mask simd_le(simd_float a, simd_float b) { return vcleq_f32(a, b); }
+      inline simd_mask simd_ge(simd_float a, simd_float b) { return vcgeq_f32(a, b); }
+      inline simd_mask simd_equal(simd_float a, simd_float b) { return vceqq_f32(a, b); }
+      inline simd_mask simd_and(simd_mask a, simd_mask b) { return vandq_u32(a, b); }
+      inline simd_mask simd_or(simd_mask a, simd_mask b) { return vorrq_u32(a, b); }
+      inline simd_float simd_select(simd_mask m, simd_float a, simd_float b) { return vbslq_f32(m, a, b); }
+
+      inline
+      unsigned int
+      simd_mask_bits(simd_mask m)
+      {
+        return (vgetq_lane_u32(m, 0) & 1u)
+          | (vgetq_lane_u32(m, 1) & 2u)
+          | (vgetq_lane_u32(m, 2) & 4u)
+          | (vgetq_lane_u32(m, 3) & 8u);
+      }
+
+  #if defined(ASTRAL_SIMD_NATIVE_DIV_SQRT)
+      inline simd_float simd_div(simd_float a, simd_float b) { return vdivq_f32(a, b); }
+      inline simd_float simd_sqrt(simd_float a) { return vsqrtq_f32(a); }
+  #else
+      inline
+      simd_float
+      simd_div(simd_float a, simd_float b)
+      {
+        float x[4], y[4];
+
+        vst1q_f32(x, a);
+        vst1q_f32(y, b);
+        for (unsigned int i = 0; i < 4; ++i)
+          {
+            x[i] /= y[i];
+          }
+        return vld1q_f32(x);
+      }
+
+      inline
+      simd_float
+      simd_sqrt(simd_float a)
+      {
+        float x[4];
+
+        vst1q_f32(x, a);
+        for (unsigned int i = 0; i < 4; ++i)
+          {
+            x[i] = std::sqrt(x[i]);
+          }
+        return vld1q_f32(x);
+      }
+  #endif
+#else
+      class simd_float
+      {
+      public:
+        float m_v[4];
+      };
+
+      /* bit i is up if the comparison is true for lane i */
+      typedef unsigned int simd_mask;
+
+      inline
+      simd_float
+      simd_load(const float *p)
+      {
+        simd_float R;
+        for (unsigned int i = 0; i < 4; ++i)
+          {
+            R.m_v[i] = p[i];
+          }
+        return R;
+      }
+
+      inline
+      void
+      simd_store(float *p, simd_float v)
+      {
+        for (unsigned int i = 0; i < 4; ++i)
+          {
+            p[i] = v.m_v[i];
+          }
+      }
+
+      inline
+      simd_float
+      simd_splat(float v)
+      {
+        simd_float R;
+        for (unsigned int i = 0; i < 4; ++i)
+          {
+            R.m_v[i] = v;
+          }
+        return R;
+      }
+
+      #define ASTRAL_SIMD_SCALAR_UNARY(name, expr)              \
+        inline                                                  \
+        simd_float                                              \
+        name(simd_float a)                                      \
+        {                                                       \
+          simd_float R;                                         \
+          for (unsigned int i = 0; i < 4; ++i)                  \
+            {                                                   \
+              float x(a.m_v[i]);                                \
+              R.m_v[i] = expr;                                  \
+            }                                                   \
+          return R;                                             \
+        }
+
+      #define ASTRAL_SIMD_SCALAR_OP(name, expr)                 \
+        inline                                                  \
+        simd_float                                              \
+        name(simd_float a, simd_float b)                        \
+        {                                                       \
+          simd_float R;                                         \
+          for (unsigned int i = 0; i < 4; ++i)                  \
+            {                                                   \
+              float x(a.m_v[i]), y(b.m_v[i]);                   \
+              R.m_v[i] = expr;                                  \
+            }                                                   \
+          return R;                                             \
+        }
+
+      #define ASTRAL_SIMD_SCALAR_CMP(name, expr)                \
+        inline                                                  \
+        simd_mask                                               \
+        name(simd_float a, simd_float b)                        \
+        {                                                       \
+          simd_mask R(0u);                                      \
+          for (unsigned int i = 0; i < 4; ++i)                  \
+            {                                                   \
+              float x(a.m_v[i]), y(b.m_v[i]);                   \
+              R |= (expr) ? (1u << i) : 0u;                     \
+            }                                                   \
+          return R;                                             \
+        }
+
+      ASTRAL_SIMD_SCALAR_OP(simd_add, x + y)
+      ASTRAL_SIMD_SCALAR_OP(simd_sub, x - y)
+      ASTRAL_SIMD_SCALAR_OP(simd_mul, x * y)
+      ASTRAL_SIMD_SCALAR_OP(simd_div, x / y)
+      ASTRAL_SIMD_SCALAR_OP(simd_min, astral::t_min(x, y))
+      ASTRAL_SIMD_SCALAR_OP(simd_max, astral::t_max(x, y))
+      ASTRAL_SIMD_SCALAR_UNARY(simd_sqrt, std::sqrt(x))
+      ASTRAL_SIMD_SCALAR_UNARY(simd_neg, -x)
+      ASTRAL_SIMD_SCALAR_UNARY(simd_abs, std::abs(x))
+
+      ASTRAL_SIMD_SCALAR_CMP(simd_less, x < y)
+      ASTRAL_SIMD_SCALAR_CMP(simd_le, x <= y)
+      ASTRAL_SIMD_SCALAR_CMP(simd_ge, x >= y)
+      ASTRAL_SIMD_SCALAR_CMP(simd_equal, x == y)
+
+      #undef ASTRAL_SIMD_SCALAR_UNARY
+      #undef ASTRAL_SIMD_SCALAR_OP
+      #undef ASTRAL_SIMD_SCALAR_CMP
+
+      inline simd_mask simd_and(simd_mask a, simd_mask b) { return a & b; }
+      inline simd_mask simd_or(simd_mask a, simd_mask b) { return a | b; }
+      inline unsigned int simd_mask_bits(simd_mask m) { return m; }
+
+      /* returns a where m is set and b otherwise */
+      inline
+      simd_float
+      simd_select(simd_mask m, simd_float a, simd_float b)
+      {
+        simd_float R;
+        for (unsigned int i = 0; i < 4; ++i)
+          {
+            R.m_v[i] = (m & (1u << i)) ? a.m_v[i] : b.m_v[i];
+          }
+        return R;
+      }
+#endif
+    }
+  }
+}
+
+#endif
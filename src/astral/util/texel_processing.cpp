@@ -0,0 +1,634 @@
+/*!
+ * \file texel_processing.cpp
+ * \brief file texel_processing.cpp
+ *
+ * Copyright 2021 by InvisionApp.
+ *
+ * Contact: kevinrogovin@invisionapp.com
+ *
+ * This Source Code Form is subject to the
+ * terms of the Mozilla Public License, v. 2.0.
+ * If a copy of the MPL was not distributed with
+ * this file, You can obtain one at
+ * http://mozilla.org/MPL/2.0/.
+ *
+ */
+
+#include <cstring>
+#include <astral/util/texel_processing.hpp>
+
+#if defined(__AVX2__)
+  #include <immintrin.h>
+  #define ASTRAL_TEXEL_AVX2
+  #define ASTRAL_TEXEL_SSE2
+#elif defined(__SSE2__) || defined(_M_X64)
+  #include <emmintrin.h>
+  #define ASTRAL_TEXEL_SSE2
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+  #include <arm_neon.h>
+  #define ASTRAL_TEXEL_NEON
+#endif
+
+namespace
+{
+  /* The sRGB transfer functions are applied through look-up
+   * tables; a 256-entry table is faster than any vectorized
+   * evaluation of pow() and is exact w.r.t. the float routines
+   * of color.hpp. Linear values used for gamma-correct averaging
+   * are stored with 12-bits of precision so that the sum of four
+   * of them fits in 16-bits.
+   */
+  class ColorspaceTables
+  {
+  public:
+    enum
+      {
+        linear_bits = 12,
+        linear_max = (1u << linear_bits) - 1u,
+      };
+
+    ColorspaceTables(void)
+    {
+      for (unsigned int i = 0; i < 256u; ++i)
+        {
+          float f;
+
+          f = static_cast<float>(i) / 255.0f;
+          m_linear8_from_srgb8[i] = to_uint(astral::linear_from_srgb(f), 255u);
+          m_srgb8_from_linear8[i] = to_uint(astral::srgb_from_linear(f), 255u);
+          m_linear12_from_srgb8[i] = to_uint(astral::linear_from_srgb(f), linear_max);
+        }
+
+      for (unsigned int i = 0; i <= linear_max; ++i)
+        {
+          float f;
+
+          f = static_cast<float>(i) / static_cast<float>(linear_max);
+          m_srgb8_from_linear12[i] = to_uint(astral::srgb_from_linear(f), 255u);
+        }
+    }
+
+    static
+    const ColorspaceTables&
+    get(void)
+    {
+      static ColorspaceTables R;
+      return R;
+    }
+
+    astral::vecN<uint8_t, 256> m_linear8_from_srgb8;
+    astral::vecN<uint8_t, 256> m_srgb8_from_linear8;
+    astral::vecN<uint16_t, 256> m_linear12_from_srgb8;
+    astral::vecN<uint8_t, linear_max + 1> m_srgb8_from_linear12;
+
+  private:
+    static
+    unsigned int
+    to_uint(float v, unsigned int max_value)
+    {
+      v = astral::t_max(0.0f, astral::t_min(1.0f, v));
+      return static_cast<unsigned int>(v * static_cast<float>(max_value) + 0.5f);
+    }
+  };
+
+  inline
+  uint8_t
+  premultiply_channel(unsigned int c, unsigned int a)
+  {
+    unsigned int x;
+
+    /* exact rounded value of (c * a) / 255 */
+    x = c * a + 128u;
+    return (x + (x >> 8u)) >> 8u;
+  }
+
+  inline
+  void
+  premultiply_texels_scalar(astral::u8vec4 *texels, unsigned int count)
+  {
+    for (unsigned int i = 0; i < count; ++i)
+      {
+        astral::u8vec4 &t(texels[i]);
+
+        t.x() = premultiply_channel(t.x(), t.w());
+        t.y() = premultiply_channel(t.y(), t.w());
+        t.z() = premultiply_channel(t.z(), t.w());
+      }
+  }
+
+  inline
+  void
+  downsample_row_scalar(const astral::u8vec4 *row0, const astral::u8vec4 *row1,
+                        astral::u8vec4 *dst, unsigned int count)
+  {
+    for (unsigned int x = 0; x < count; ++x, row0 += 2, row1 += 2)
+      {
+        for (unsigned int c = 0; c < 4u; ++c)
+          {
+            unsigned int sum;
+
+            sum = row0[0][c] + row0[1][c] + row1[0][c] + row1[1][c];
+            dst[x][c] = (sum + 2u) >> 2u;
+          }
+      }
+  }
+
+  /* inverse of premultiply_channel(), i.e. the rounded value
+   * of (p * 255) / a clamped to 255; a must be non-zero.
+   */
+  inline
+  unsigned int
+  unpremultiply_channel(unsigned int p, unsigned int a)
+  {
+    ASTRALassert(a != 0u);
+    return astral::t_min(255u, (p * 255u + (a >> 1u)) / a);
+  }
+
+  /* The texels are pre-multiplied by alpha with the rgb channels
+   * sRGB encoded. Averaging the linear values of pre-multiplied
+   * sRGB values is incorrect since the alpha multiply happened
+   * after the encoding. Instead, each texel is un-premultiplied and
+   * linearized, the linear values are averaged weighted by alpha,
+   * and the result is re-encoded and pre-multiplied by the average
+   * alpha. For opaque texels this is the same as averaging the
+   * linear values directly: every weight is 255 and un-premultiply
+   * and premultiply by 255 are the identity, so the result is the
+   * rounded average of the four linear values re-encoded, with no
+   * division. The SIMD kernels below take that path for blocks of
+   * opaque texels and fall back to this routine otherwise.
+   */
+  void
+  downsample_row_gamma_correct_scalar(const ColorspaceTables &tables,
+                                      const astral::u8vec4 *row0, const astral::u8vec4 *row1,
+                                      astral::u8vec4 *dst, unsigned int count)
+  {
+    for (unsigned int x = 0; x < count; ++x, row0 += 2, row1 += 2)
+      {
+        const astral::u8vec4 *texels[4] = { &row0[0], &row0[1], &row1[0], &row1[1] };
+        unsigned int alpha_sum, alpha;
+
+        alpha_sum = row0[0].w() + row0[1].w() + row1[0].w() + row1[1].w();
+        alpha = (alpha_sum + 2u) >> 2u;
+        if (alpha_sum == 0u)
+          {
+            dst[x] = astral::u8vec4(0u, 0u, 0u, 0u);
+            continue;
+          }
+
+        for (unsigned int c = 0; c < 3u; ++c)
+          {
+            unsigned int weighted_sum(0u), linear;
+
+            for (const astral::u8vec4 *t : texels)
+              {
+                if (t->w() != 0u)
+                  {
+                    unsigned int v;
+
+                    v = unpremultiply_channel((*t)[c], t->w());
+                    weighted_sum += tables.m_linear12_from_srgb8[v] * t->w();
+                  }
+              }
+
+            linear = (weighted_sum + (alpha_sum >> 1u)) / alpha_sum;
+            dst[x][c] = premultiply_channel(tables.m_srgb8_from_linear12[linear], alpha);
+          }
+
+        dst[x].w() = alpha;
+      }
+  }
+
+#ifdef ASTRAL_TEXEL_SSE2
+  /* premultiply 4 texels held as 8-bit channels in v */
+  inline
+  __m128i
+  premultiply_sse2(__m128i v)
+  {
+    const __m128i zero(_mm_setzero_si128());
+    const __m128i round(_mm_set1_epi16(128));
+    const __m128i alpha_mask(_mm_set_epi16(-1, 0, 0, 0, -1, 0, 0, 0));
+    __m128i lo, hi, alo, ahi;
+
+    lo = _mm_unpacklo_epi8(v, zero);
+    hi = _mm_unpackhi_epi8(v, zero);
+
+    alo = _mm_shufflehi_epi16(_mm_shufflelo_epi16(lo, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+    ahi = _mm_shufflehi_epi16(_mm_shufflelo_epi16(hi, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+
+    /* alpha lanes multiply by 255 so that they are unchanged */
+    alo = _mm_or_si128(_mm_andnot_si128(alpha_mask, alo), _mm_and_si128(alpha_mask, _mm_set1_epi16(255)));
+    ahi = _mm_or_si128(_mm_andnot_si128(alpha_mask, ahi), _mm_and_si128(alpha_mask, _mm_set1_epi16(255)));
+
+    lo = _mm_add_epi16(_mm_mullo_epi16(lo, alo), round);
+    hi = _mm_add_epi16(_mm_mullo_epi16(hi, ahi), round);
+    lo = _mm_srli_epi16(_mm_add_epi16(lo, _mm_srli_epi16(lo, 8)), 8);
+    hi = _mm_srli_epi16(_mm_add_epi16(hi, _mm_srli_epi16(hi, 8)), 8);
+
+    return _mm_packus_epi16(lo, hi);
+  }
+
+  /* downsample 4 texels of each of two rows to 2 texels */
+  inline
+  __m128i
+  downsample_sse2(__m128i r0, __m128i r1)
+  {
+    const __m128i zero(_mm_setzero_si128());
+    const __m128i two(_mm_set1_epi16(2));
+    __m128i lo, hi;
+
+    /* lo holds the sums of texels 0 and 1 of each row, hi of texels 2 and 3 */
+    lo = _mm_add_epi16(_mm_unpacklo_epi8(r0, zero), _mm_unpacklo_epi8(r1, zero));
+    hi = _mm_add_epi16(_mm_unpackhi_epi8(r0, zero), _mm_unpackhi_epi8(r1, zero));
+
+    /* add the horizontal neighbor */
+    lo = _mm_add_epi16(lo, _mm_srli_si128(lo, 8));
+    hi = _mm_add_epi16(hi, _mm_srli_si128(hi, 8));
+
+    lo = _mm_srli_epi16(_mm_add_epi16(_mm_unpacklo_epi64(lo, hi), two), 2);
+    return _mm_packus_epi16(lo, lo);
+  }
+
+  /* If the 4 texels of each of row0 and row1 are opaque, write
+   * their gamma-correct downsample, 2 texels, to dst and return
+   * true; see downsample_row_gamma_correct_scalar() for why the
+   * opaque case is a plain average of the linear values. The
+   * table look-ups are done one channel at a time since SSE2
+   * has no gather.
+   */
+  inline
+  bool
+  downsample_gamma_correct_opaque_sse2(const ColorspaceTables &tables,
+                                       const astral::u8vec4 *row0, const astral::u8vec4 *row1,
+                                       astral::u8vec4 *dst)
+  {
+    const __m128i alpha(_mm_set1_epi32(static_cast<int>(0xff000000u)));
+    const __m128i two(_mm_set1_epi16(2));
+    __m128i r0, r1, lo, hi;
+    uint16_t lin0[16], lin1[16], avg[8];
+
+    r0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row0));
+    r1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1));
+    if (_mm_movemask_epi8(_mm_cmpeq_epi32(_mm_and_si128(_mm_and_si128(r0, r1), alpha), alpha)) != 0xffff)
+      {
+        return false;
+      }
+
+    for (unsigned int i = 0; i < 4u; ++i)
+      {
+        for (unsigned int c = 0; c < 3u; ++c)
+          {
+            lin0[4u * i + c] = tables.m_linear12_from_srgb8[row0[i][c]];
+            lin1[4u * i + c] = tables.m_linear12_from_srgb8[row1[i][c]];
+          }
+        lin0[4u * i + 3u] = lin1[4u * i + 3u] = 0u;
+      }
+
+    /* lo holds the sums of texels 0 and 1 of each row, hi of texels 2 and 3 */
+    lo = _mm_add_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(lin0)),
+                       _mm_loadu_si128(reinterpret_cast<const __m128i*>(lin1)));
+    hi = _mm_add_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(lin0 + 8)),
+                       _mm_loadu_si128(reinterpret_cast<const __m128i*>(lin1 + 8)));
+
+    /* add the horizontal neighbor */
+    lo = _mm_add_epi16(lo, _mm_srli_si128(lo, 8));
+    hi = _mm_add_epi16(hi, _mm_srli_si128(hi, 8));
+
+    lo = _mm_srli_epi16(_mm_add_epi16(_mm_unpacklo_epi64(lo, hi), two), 2);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(avg), lo);
+
+    for (unsigned int k = 0; k < 2u; ++k)
+      {
+        dst[k] = astral::u8vec4(tables.m_srgb8_from_linear12[avg[4u * k]],
+                                tables.m_srgb8_from_linear12[avg[4u * k + 1u]],
+                                tables.m_srgb8_from_linear12[avg[4u * k + 2u]],
+                                255u);
+      }
+
+    return true;
+  }
+#endif
+
+#ifdef ASTRAL_TEXEL_AVX2
+  /* premultiply 8 texels held as 8-bit channels in v */
+  inline
+  __m256i
+  premultiply_avx2(__m256i v)
+  {
+    const __m256i zero(_mm256_setzero_si256());
+    const __m256i round(_mm256_set1_epi16(128));
+    const __m256i alpha_mask(_mm256_set_epi16(-1, 0, 0, 0, -1, 0, 0, 0, -1, 0, 0, 0, -1, 0, 0, 0));
+    const __m256i alpha_one(_mm256_and_si256(alpha_mask, _mm256_set1_epi16(255)));
+    __m256i lo, hi, alo, ahi;
+
+    lo = _mm256_unpacklo_epi8(v, zero);
+    hi = _mm256_unpackhi_epi8(v, zero);
+
+    alo = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(lo, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+    ahi = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(hi, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+    alo = _mm256_or_si256(_mm256_andnot_si256(alpha_mask, alo), alpha_one);
+    ahi = _mm256_or_si256(_mm256_andnot_si256(alpha_mask, ahi), alpha_one);
+
+    lo = _mm256_add_epi16(_mm256_mullo_epi16(lo, alo), round);
+    hi = _mm256_add_epi16(_mm256_mullo_epi16(hi, ahi), round);
+    lo = _mm256_srli_epi16(_mm256_add_epi16(lo, _mm256_srli_epi16(lo, 8)), 8);
+    hi = _mm256_srli_epi16(_mm256_add_epi16(hi, _mm256_srli_epi16(hi, 8)), 8);
+
+    /* the unpack and pack both act within 128-bit lanes, so the order is preserved */
+    return _mm256_packus_epi16(lo, hi);
+  }
+
+  /* downsample 8 texels of each of two rows to 4 texels */
+  inline
+  __m128i
+  downsample_avx2(__m256i r0, __m256i r1)
+  {
+    const __m256i zero(_mm256_setzero_si256());
+    const __m256i two(_mm256_set1_epi16(2));
+    __m256i lo, hi;
+
+    lo = _mm256_add_epi16(_mm256_unpacklo_epi8(r0, zero), _mm256_unpacklo_epi8(r1, zero));
+    hi = _mm256_add_epi16(_mm256_unpackhi_epi8(r0, zero), _mm256_unpackhi_epi8(r1, zero));
+    lo = _mm256_add_epi16(lo, _mm256_srli_si256(lo, 8));
+    hi = _mm256_add_epi16(hi, _mm256_srli_si256(hi, 8));
+
+    /* lane 0 holds output texels 0 and 1, lane 1 holds output texels 2 and 3 */
+    lo = _mm256_srli_epi16(_mm256_add_epi16(_mm256_unpacklo_epi64(lo, hi), two), 2);
+    lo = _mm256_packus_epi16(lo, lo);
+    lo = _mm256_permute4x64_epi64(lo, _MM_SHUFFLE(3, 1, 2, 0));
+
+    return _mm256_castsi256_si128(lo);
+  }
+#endif
+
+#ifdef ASTRAL_TEXEL_NEON
+  /* If the 8 texels of each of row0 and row1 are opaque, write
+   * their gamma-correct downsample, 4 texels, to dst and return
+   * true; see downsample_gamma_correct_opaque_sse2().
+   */
+  inline
+  bool
+  downsample_gamma_correct_opaque_neon(const ColorspaceTables &tables,
+                                       const astral::u8vec4 *row0, const astral::u8vec4 *row1,
+                                       astral::u8vec4 *dst)
+  {
+    uint8x8x4_t r0, r1;
+    uint16_t lin0[3][8], lin1[3][8], avg[3][4];
+
+    r0 = vld4_u8(reinterpret_cast<const uint8_t*>(row0));
+    r1 = vld4_u8(reinterpret_cast<const uint8_t*>(row1));
+    if (vget_lane_u64(vreinterpret_u64_u8(vand_u8(r0.val[3], r1.val[3])), 0) != ~uint64_t(0))
+      {
+        return false;
+      }
+
+    for (unsigned int c = 0; c < 3u; ++c)
+      {
+        uint16x8_t sum;
+
+        for (unsigned int i = 0; i < 8u; ++i)
+          {
+            lin0[c][i] = tables.m_linear12_from_srgb8[row0[i][c]];
+            lin1[c][i] = tables.m_linear12_from_srgb8[row1[i][c]];
+          }
+
+        /* pair-wise add of horizontal neighbors followed by (sum + 2) >> 2 */
+        sum = vaddq_u16(vld1q_u16(lin0[c]), vld1q_u16(lin1[c]));
+        vst1_u16(avg[c], vrshrn_n_u32(vpaddlq_u16(sum), 2));
+      }
+
+    for (unsigned int k = 0; k < 4u; ++k)
+      {
+        dst[k] = astral::u8vec4(tables.m_srgb8_from_linear12[avg[0][k]],
+                                tables.m_srgb8_from_linear12[avg[1][k]],
+                                tables.m_srgb8_from_linear12[avg[2][k]],
+                                255u);
+      }
+
+    return true;
+  }
+#endif
+
+  void
+  premultiply_texels(astral::u8vec4 *texels, unsigned int count)
+  {
+    unsigned int i(0);
+
+    #if defined(ASTRAL_TEXEL_AVX2)
+      {
+        for (; i + 8u <= count; i += 8u)
+          {
+            __m256i *ptr(reinterpret_cast<__m256i*>(texels + i));
+            _mm256_storeu_si256(ptr, premultiply_avx2(_mm256_loadu_si256(ptr)));
+          }
+      }
+    #endif
+
+    #if defined(ASTRAL_TEXEL_SSE2)
+      {
+        for (; i + 4u <= count; i += 4u)
+          {
+            __m128i *ptr(reinterpret_cast<__m128i*>(texels + i));
+            _mm_storeu_si128(ptr, premultiply_sse2(_mm_loadu_si128(ptr)));
+          }
+      }
+    #elif defined(ASTRAL_TEXEL_NEON)
+      {
+        for (; i + 8u <= count; i += 8u)
+          {
+            uint8_t *ptr(reinterpret_cast<uint8_t*>(texels + i));
+            uint8x8x4_t v(vld4_u8(ptr));
+
+            for (unsigned int c = 0; c < 3u; ++c)
+              {
+                uint16x8_t t;
+
+                /* (t + ((t + 128) >> 8) + 128) >> 8 is exactly premultiply_channel() */
+                t = vmull_u8(v.val[c], v.val[3]);
+                v.val[c] = vrshrn_n_u16(vrsraq_n_u16(t, t, 8), 8);
+              }
+            vst4_u8(ptr, v);
+          }
+      }
+    #endif
+
+    premultiply_texels_scalar(texels + i, count - i);
+  }
+
+  void
+  downsample_row(const astral::u8vec4 *row0, const astral::u8vec4 *row1,
+                 astral::u8vec4 *dst, unsigned int count)
+  {
+    unsigned int x(0);
+
+    #if defined(ASTRAL_TEXEL_AVX2)
+      {
+        for (; x + 4u <= count; x += 4u)
+          {
+            __m256i r0, r1;
+
+            r0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row0 + 2u * x));
+            r1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row1 + 2u * x));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x), downsample_avx2(r0, r1));
+          }
+      }
+    #endif
+
+    #if defined(ASTRAL_TEXEL_SSE2)
+      {
+        for (; x + 2u <= count; x += 2u)
+          {
+            __m128i r0, r1;
+
+            r0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row0 + 2u * x));
+            r1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1 + 2u * x));
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(dst + x), downsample_sse2(r0, r1));
+          }
+      }
+    #elif defined(ASTRAL_TEXEL_NEON)
+      {
+        for (; x + 8u <= count; x += 8u)
+          {
+            uint8x16x4_t r0, r1;
+            uint8x8x4_t v;
+
+            r0 = vld4q_u8(reinterpret_cast<const uint8_t*>(row0 + 2u * x));
+            r1 = vld4q_u8(reinterpret_cast<const uint8_t*>(row1 + 2u * x));
+            for (unsigned int c = 0; c < 4u; ++c)
+              {
+                uint16x8_t sum;
+
+                /* pair-wise add of horizontal neighbors followed by (sum + 2) >> 2 */
+                sum = vaddq_u16(vpaddlq_u8(r0.val[c]), vpaddlq_u8(r1.val[c]));
+                v.val[c] = vrshrn_n_u16(sum, 2);
+              }
+            vst4_u8(reinterpret_cast<uint8_t*>(dst + x), v);
+          }
+      }
+    #endif
+
+    downsample_row_scalar(row0 + 2u * x, row1 + 2u * x, dst + x, count - x);
+  }
+  void
+  downsample_row_gamma_correct(const ColorspaceTables &tables,
+                               const astral::u8vec4 *row0, const astral::u8vec4 *row1,
+                               astral::u8vec4 *dst, unsigned int count)
+  {
+    unsigned int x(0);
+
+    #if defined(ASTRAL_TEXEL_SSE2)
+      {
+        for (; x + 2u <= count; x += 2u)
+          {
+            if (!downsample_gamma_correct_opaque_sse2(tables, row0 + 2u * x, row1 + 2u * x, dst + x))
+              {
+                downsample_row_gamma_correct_scalar(tables, row0 + 2u * x, row1 + 2u * x, dst + x, 2u);
+              }
+          }
+      }
+    #elif defined(ASTRAL_TEXEL_NEON)
+      {
+        for (; x + 4u <= count; x += 4u)
+          {
+            if (!downsample_gamma_correct_opaque_neon(tables, row0 + 2u * x, row1 + 2u * x, dst + x))
+              {
+                downsample_row_gamma_correct_scalar(tables, row0 + 2u * x, row1 + 2u * x, dst + x, 4u);
+              }
+          }
+      }
+    #endif
+
+    downsample_row_gamma_correct_scalar(tables, row0 + 2u * x, row1 + 2u * x, dst + x, count - x);
+  }
+}
+
+astral::c_string
+astral::
+texel_processing_instruction_set(void)
+{
+  #if defined(ASTRAL_TEXEL_AVX2)
+    {
+      return "AVX2";
+    }
+  #elif defined(ASTRAL_TEXEL_SSE2)
+    {
+      return "SSE2";
+    }
+  #elif defined(ASTRAL_TEXEL_NEON)
+    {
+      return "NEON";
+    }
+  #else
+    {
+      return "scalar";
+    }
+  #endif
+}
+
+void
+astral::
+premultiply_alpha_texels(c_array<u8vec4> texels)
+{
+  premultiply_texels(texels.c_ptr(), texels.size());
+}
+
+void
+astral::
+convert_colorspace_texels(enum colorspace_t dst, enum colorspace_t src,
+                          c_array<u8vec4> texels)
+{
+  if (dst == src)
+    {
+      return;
+    }
+
+  const ColorspaceTables &tables(ColorspaceTables::get());
+  const uint8_t *table;
+
+  table = (dst == colorspace_linear) ?
+    tables.m_linear8_from_srgb8.c_ptr() :
+    tables.m_srgb8_from_linear8.c_ptr();
+
+  for (u8vec4 &t : texels)
+    {
+      t.x() = table[t.x()];
+      t.y() = table[t.y()];
+      t.z() = table[t.z()];
+    }
+}
+
+astral::uvec2
+astral::
+downsample_texels(uvec2 src_size, unsigned int src_row_width,
+                  c_array<const u8vec4> src, c_array<u8vec4> dst,
+                  bool gamma_correct)
+{
+  uvec2 dst_size(src_size.x() >> 1u, src_size.y() >> 1u);
+  const ColorspaceTables *tables(nullptr);
+
+  ASTRALassert(src_row_width >= src_size.x());
+  ASTRALassert(dst.size() >= dst_size.x() * dst_size.y());
+  ASTRALassert(dst_size.y() == 0u || src.size() >= (2u * dst_size.y() - 1u) * src_row_width + 2u * dst_size.x());
+
+  if (gamma_correct)
+    {
+      tables = &ColorspaceTables::get();
+    }
+
+  for (unsigned int y = 0; y < dst_size.y(); ++y)
+    {
+      const u8vec4 *row0(src.c_ptr() + 2u * y * src_row_width);
+      const u8vec4 *row1(row0 + src_row_width);
+      u8vec4 *dst_row(dst.c_ptr() + y * dst_size.x());
+
+      if (tables)
+        {
+          downsample_row_gamma_correct(*tables, row0, row1, dst_row, dst_size.x());
+        }
+      else
+        {
+          downsample_row(row0, row1, dst_row, dst_size.x());
+        }
+    }
+
+  return dst_size;
+}
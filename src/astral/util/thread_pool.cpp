@@ -0,0 +1,312 @@
+/*!
+ * \file thread_pool.cpp
+ * \brief file thread_pool.cpp
+ *
+ * Copyright 2020 by InvisionApp.
+ *
+ * Contact: kevinrogovin@invisionapp.com
+ *
+ * This Source Code Form is subject to the
+ * terms of the Mozilla Public License, v. 2.0.
+ * If a copy of the MPL was not distributed with
+ * this file, You can obtain one at
+ * http://mozilla.org/MPL/2.0/.
+ *
+ */
+
+#include <deque>
+#include <algorithm>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <astral/util/thread_pool.hpp>
+
+class astral::ThreadPool::Implement:public astral::ThreadPool
+{
+public:
+  explicit
+  Implement(unsigned int number_threads);
+
+  ~Implement();
+
+  /* A job waiting to be started together with the
+   * Batch it belongs to, if any.
+   */
+  class Entry
+  {
+  public:
+    Entry(const reference_counted_ptr<Job> &job, Batch *batch):
+      m_job(job),
+      m_batch(batch)
+    {}
+
+    reference_counted_ptr<Job> m_job;
+    Batch *m_batch;
+  };
+
+  /* Remove the named job from m_jobs and execute it, m_mutex
+   * must be locked by lock before calling and is locked
+   * by lock on return.
+   */
+  void
+  execute_job(std::unique_lock<std::mutex> &lock, std::deque<Entry>::iterator iter);
+
+  void
+  execute_next_job(std::unique_lock<std::mutex> &lock)
+  {
+    ASTRALassert(!m_jobs.empty());
+    execute_job(lock, m_jobs.begin());
+  }
+
+  void
+  worker_main(void);
+
+  mutable std::mutex m_mutex;
+
+  /* signaled when a job is added or when the pool is shutting down */
+  std::condition_variable m_job_added;
+
+  /* signaled when the last running job finishes and there are no more jobs */
+  std::condition_variable m_all_done;
+
+  /* signaled when the last job of a Batch finishes */
+  std::condition_variable m_batch_done;
+
+  /* jobs not yet started */
+  std::deque<Entry> m_jobs;
+
+  /* number of jobs currently executing */
+  unsigned int m_number_running;
+
+  /* set to true in the dtor to stop the worker threads */
+  bool m_quit;
+
+  std::vector<std::thread> m_threads;
+};
+
+//////////////////////////////////////////
+// astral::ThreadPool::Implement methods
+astral::ThreadPool::Implement::
+Implement(unsigned int number_threads):
+  m_number_running(0u),
+  m_quit(false)
+{
+  m_threads.reserve(number_threads);
+  for (unsigned int i = 0; i < number_threads; ++i)
+    {
+      m_threads.push_back(std::thread(&Implement::worker_main, this));
+    }
+}
+
+astral::ThreadPool::Implement::
+~Implement()
+{
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_quit = true;
+  }
+
+  m_job_added.notify_all();
+  for (std::thread &T : m_threads)
+    {
+      T.join();
+    }
+
+  ASTRALassert(m_jobs.empty());
+}
+
+void
+astral::ThreadPool::Implement::
+execute_job(std::unique_lock<std::mutex> &lock, std::deque<Entry>::iterator iter)
+{
+  reference_counted_ptr<Job> job;
+  Batch *batch;
+
+  ASTRALassert(iter != m_jobs.end());
+  job.swap(iter->m_job);
+  batch = iter->m_batch;
+  m_jobs.erase(iter);
+  ++m_number_running;
+
+  lock.unlock();
+  job->execute();
+
+  /* release the job before taking the lock so that
+   * the destruction of the job is not under the lock
+   */
+  job.clear();
+  lock.lock();
+
+  ASTRALassert(m_number_running > 0u);
+  --m_number_running;
+  if (m_number_running == 0u && m_jobs.empty())
+    {
+      m_all_done.notify_all();
+    }
+
+  if (batch)
+    {
+      ASTRALassert(batch->m_number_pending > 0u);
+      --batch->m_number_pending;
+      if (batch->m_number_pending == 0u)
+        {
+          m_batch_done.notify_all();
+        }
+    }
+}
+
+void
+astral::ThreadPool::Implement::
+worker_main(void)
+{
+  std::unique_lock<std::mutex> lock(m_mutex);
+
+  for (;;)
+    {
+      m_job_added.wait(lock, [this] { return m_quit || !m_jobs.empty(); });
+
+      /* finish all of the jobs before quitting */
+      if (m_jobs.empty())
+        {
+          ASTRALassert(m_quit);
+          return;
+        }
+
+      execute_next_job(lock);
+    }
+}
+
+//////////////////////////////////////////
+// astral::ThreadPool methods
+astral::reference_counted_ptr<astral::ThreadPool>
+astral::ThreadPool::
+create(unsigned int number_threads)
+{
+  return ASTRALnew Implement(number_threads);
+}
+
+unsigned int
+astral::ThreadPool::
+default_number_threads(void)
+{
+  unsigned int N;
+
+  N = std::thread::hardware_concurrency();
+  N = (N > 1u) ? N - 1u : 1u;
+
+  return t_min(N, 8u);
+}
+
+unsigned int
+astral::ThreadPool::
+number_threads(void) const
+{
+  const Implement *p;
+
+  p = static_cast<const Implement*>(this);
+  return p->m_threads.size();
+}
+
+unsigned int
+astral::ThreadPool::
+number_jobs_pending(void) const
+{
+  const Implement *p;
+
+  p = static_cast<const Implement*>(this);
+
+  std::lock_guard<std::mutex> lock(p->m_mutex);
+  return p->m_jobs.size() + p->m_number_running;
+}
+
+void
+astral::ThreadPool::
+add_job(const reference_counted_ptr<Job> &job)
+{
+  Implement *p;
+
+  ASTRALassert(job);
+  p = static_cast<Implement*>(this);
+  if (p->m_threads.empty())
+    {
+      job->execute();
+      return;
+    }
+
+  {
+    std::lock_guard<std::mutex> lock(p->m_mutex);
+    p->m_jobs.push_back(Implement::Entry(job, nullptr));
+  }
+  p->m_job_added.notify_one();
+}
+
+void
+astral::ThreadPool::
+add_job(const reference_counted_ptr<Job> &job, Batch &batch)
+{
+  Implement *p;
+
+  ASTRALassert(job);
+  p = static_cast<Implement*>(this);
+  if (p->m_threads.empty())
+    {
+      job->execute();
+      return;
+    }
+
+  {
+    std::lock_guard<std::mutex> lock(p->m_mutex);
+    ++batch.m_number_pending;
+    p->m_jobs.push_back(Implement::Entry(job, &batch));
+  }
+  p->m_job_added.notify_one();
+}
+
+void
+astral::ThreadPool::
+wait_all(void)
+{
+  Implement *p;
+
+  p = static_cast<Implement*>(this);
+
+  std::unique_lock<std::mutex> lock(p->m_mutex);
+  while (!p->m_jobs.empty())
+    {
+      p->execute_next_job(lock);
+    }
+
+  p->m_all_done.wait(lock, [p] { return p->m_number_running == 0u && p->m_jobs.empty(); });
+}
+
+void
+astral::ThreadPool::
+wait(Batch &batch)
+{
+  Implement *p;
+
+  p = static_cast<Implement*>(this);
+
+  std::unique_lock<std::mutex> lock(p->m_mutex);
+  while (batch.m_number_pending > 0u)
+    {
+      std::deque<Implement::Entry>::iterator iter;
+
+      /* execute a job of the batch not yet started, if there
+       * is none, the remaining jobs of the batch are running
+       * on the worker threads.
+       */
+      iter = std::find_if(p->m_jobs.begin(), p->m_jobs.end(),
+                          [&batch](const Implement::Entry &E) { return E.m_batch == &batch; });
+
+      if (iter != p->m_jobs.end())
+        {
+          p->execute_job(lock, iter);
+        }
+      else
+        {
+          p->m_batch_done.wait(lock);
+        }
+    }
+}
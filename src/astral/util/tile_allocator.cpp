@@ -210,6 +210,48 @@ public:
     return m_values.empty();
   }
 
+  /* Remove and return the last element of the list whose
+   * layer is less than the named layer; returns nullptr
+   * if there is no such element.
+   */
+  TileImplement*
+  pop_back_below_layer(unsigned int layer)
+  {
+    for (unsigned int i = m_values.size(); i > 0u; --i)
+      {
+        TileImplement *p(m_values[i - 1u]);
+
+        if (p->m_location.z() < layer)
+          {
+            remove(p);
+            return p;
+          }
+      }
+    return nullptr;
+  }
+
+  /* Remove all elements whose layer is atleast the named
+   * layer, adding them to dst.
+   */
+  void
+  remove_from_layer(unsigned int layer, std::vector<TileImplement*> *dst)
+  {
+    for (unsigned int i = 0; i < m_values.size();)
+      {
+        TileImplement *p(m_values[i]);
+
+        if (p->m_location.z() >= layer)
+          {
+            remove(p);
+            dst->push_back(p);
+          }
+        else
+          {
+            ++i;
+          }
+      }
+  }
+
 private:
   std::vector<TileImplement*> m_values;
 };
@@ -323,9 +365,11 @@ TileAllocator(uvec2 log2_max_tile_size,
   m_log2_max_tile_size(log2_max_tile_size),
   m_number_tiles_per_layer(number_tiles_per_layer),
   m_number_layers(number_layers),
+  m_preferred_layer_limit(~0u),
   m_alloc_tile_counter(0, 0, 0),
   m_num_tiles_allocated(0u),
-  m_space_allocated(0u)
+  m_space_allocated(0u),
+  m_space_allocated_per_layer(number_layers, 0u)
 {
   m_pool = ASTRALnew MemoryPool();
   ready_lists();
@@ -347,7 +391,7 @@ change_size(uvec2 log2_max_tile_size,
       ready_lists();
     }
   m_number_layers = number_layers;
-
+  m_space_allocated_per_layer.resize(m_number_layers, 0u);
 }
 
 void
@@ -490,6 +534,10 @@ release_tile(const Tile *cp)
   --m_num_tiles_allocated;
   m_space_allocated -= p->area();
 
+  ASTRALassert(p->m_location.z() < m_space_allocated_per_layer.size());
+  ASTRALassert(m_space_allocated_per_layer[p->m_location.z()] >= p->area());
+  m_space_allocated_per_layer[p->m_location.z()] -= p->area();
+
   ASTRALassert(p);
   ASTRALassert(!p->m_available);
   ASTRALassert(!p->has_children());
@@ -587,6 +635,11 @@ allocate_tile(unsigned int log2_width, unsigned int log2_height)
   c_array<const uvec2> szs(make_c_array(m_order[log2_width][log2_height]));
   TileImplement *tile(nullptr);
 
+  if (m_preferred_layer_limit < m_number_layers)
+    {
+      tile = allocate_tile_below_limit(szs);
+    }
+
   /* TODO: we should maintain a list of what TileList's are non-empty
    *       instead of incrementing through every single one that
    *       is big enough
@@ -623,9 +676,36 @@ allocate_tile(unsigned int log2_width, unsigned int log2_height)
   ++m_num_tiles_allocated;
   m_space_allocated += tile->area();
 
+  ASTRALassert(tile->m_location.z() < m_space_allocated_per_layer.size());
+  m_space_allocated_per_layer[tile->m_location.z()] += tile->area();
+
   return tile;
 }
 
+astral::TileAllocator::TileImplement*
+astral::TileAllocator::
+allocate_tile_below_limit(c_array<const uvec2> szs)
+{
+  for (unsigned int i = 0; i < szs.size(); ++i)
+    {
+      const uvec2 &e(szs[i]);
+      TileImplement *tile;
+
+      tile = m_free_tiles[e.x()][e.y()].pop_back_below_layer(m_preferred_layer_limit);
+      if (tile)
+        {
+          return tile;
+        }
+    }
+
+  if (m_alloc_tile_counter.z() < m_preferred_layer_limit)
+    {
+      return create_base_tile();
+    }
+
+  return nullptr;
+}
+
 void
 astral::TileAllocator::
 split_add_tile(unsigned int coordinate, TileImplement *tile,
@@ -768,8 +848,49 @@ void
 astral::TileAllocator::
 number_layers(unsigned int new_value)
 {
-  ASTRALassert(new_value >= m_number_layers);
+  if (new_value < m_number_layers)
+    {
+      std::vector<TileImplement*> &removed(m_pool->m_workroom);
+
+      /* When all the tiles of a layer are released, the tiles
+       * get merged back into the base tiles of the layer; thus
+       * the only tiles on the free lists from the layers being
+       * removed are base tiles which we remove and recycle.
+       */
+      ASTRALassert(removed.empty());
+      for (unsigned int L = new_value; L < m_number_layers; ++L)
+        {
+          ASTRALassert(m_space_allocated_per_layer[L] == 0u);
+        }
+
+      for (unsigned int x = 0; x <= m_log2_max_tile_size.x(); ++x)
+        {
+          for (unsigned int y = 0; y <= m_log2_max_tile_size.y(); ++y)
+            {
+              m_free_tiles[x][y].remove_from_layer(new_value, &removed);
+            }
+        }
+
+      for (TileImplement *p : removed)
+        {
+          ASTRALassert(!p->m_parent);
+          ASTRALassert(!p->has_children());
+          free_tile(p);
+        }
+      removed.clear();
+
+      /* the layers below new_value are completely carved into
+       * base tiles, so the next base tile starts at the start
+       * of the layer new_value.
+       */
+      if (m_alloc_tile_counter.z() >= new_value)
+        {
+          m_alloc_tile_counter = uvec3(0u, 0u, new_value);
+        }
+    }
+
   m_number_layers = new_value;
+  m_space_allocated_per_layer.resize(m_number_layers, 0u);
 }
 
 void
@@ -786,5 +907,7 @@ release_all(void)
   m_pool->m_tile_pool.clear();
   m_pool->m_region_pool.clear();
   m_num_tiles_allocated = 0;
+  m_space_allocated = 0;
   m_alloc_tile_counter = uvec3(0u, 0u, 0u);
+  std::fill(m_space_allocated_per_layer.begin(), m_space_allocated_per_layer.end(), 0u);
 }